@@ -632,6 +632,13 @@ function(_ep_write_downloadfile_script
     set(NETRC_FILE_CODE "set(CMAKE_NETRC_FILE \"${netrc_file}\")")
   endif()
 
+  set(DOWNLOAD_CACHE_CODE "")
+  if(DEFINED CMAKE_DOWNLOAD_CACHE)
+    set(DOWNLOAD_CACHE_CODE
+      "set(CMAKE_DOWNLOAD_CACHE \"${CMAKE_DOWNLOAD_CACHE}\")"
+    )
+  endif()
+
   if(userpwd STREQUAL ":")
     set(USERPWD_ARGS)
   else()
@@ -651,6 +658,7 @@ function(_ep_write_downloadfile_script
   # * TLS_VERSION_CODE
   # * TLS_VERIFY_CODE
   # * TLS_CAINFO_CODE
+  # * DOWNLOAD_CACHE_CODE
   # * ALGO
   # * EXPECT_VALUE
   # * REMOTE
@@ -1852,6 +1852,7 @@ ExternalProject_Add_Step(${contentName}-populate copyfile
 
   set(__FETCHCONTENT_CACHED_INFO "")
   set(__passthrough_vars
+    CMAKE_DOWNLOAD_CACHE
     CMAKE_EP_GIT_REMOTE_UPDATE_STRATEGY
     CMAKE_TLS_VERSION
     CMAKE_TLS_VERIFY
@@ -223,6 +223,10 @@ int cmCPackArchiveGenerator::InitializeInternal()
                     << this->OutputExtension << std::endl);
     this->OutputExtension = std::move(newExtension);
   }
+  if (this->Compress == cmArchiveWrite::CompressZstd &&
+      this->IsOn("CPACK_ARCHIVE_ZSTD_SEEKABLE")) {
+    this->Compress = cmArchiveWrite::CompressZstdSeekable;
+  }
   return this->Superclass::InitializeInternal();
 }
 
@@ -319,6 +323,21 @@ int cmCPackArchiveGenerator::addOneComponentToArchive(
     }                                                                         \
   } while (false)
 
+/*
+ * The macro will finish the cmArchiveWrite 'archive' object
+ * opened by DECLARE_AND_OPEN_ARCHIVE.
+ */
+#define CLOSE_ARCHIVE(filename, archive)                                      \
+  do {                                                                        \
+    if (!(archive).Close()) {                                                 \
+      cmCPackLogger(cmCPackLog::LOG_ERROR,                                    \
+                    "Problem to close archive <"                              \
+                      << (filename) << ">, ERROR = " << (archive).GetError()  \
+                      << std::endl);                                          \
+      return 0;                                                               \
+    }                                                                         \
+  } while (false)
+
 int cmCPackArchiveGenerator::PackageComponents(bool ignoreGroup)
 {
   this->packageFileNames.clear();
@@ -334,8 +353,6 @@ int cmCPackArchiveGenerator::PackageComponents(bool ignoreGroup)
 
       Deduplicator deduplicator;
 
-      // open a block in order to automatically close archive
-      // at the end of the block
       {
         DECLARE_AND_OPEN_ARCHIVE(packageFileName, archive);
         // now iterate over the component of this group
@@ -343,6 +360,7 @@ int cmCPackArchiveGenerator::PackageComponents(bool ignoreGroup)
           // Add the files of this component to the archive
           this->addOneComponentToArchive(archive, comp, &deduplicator);
         }
+        CLOSE_ARCHIVE(packageFileName, archive);
       }
       // add the generated package to package file names list
       this->packageFileNames.push_back(std::move(packageFileName));
@@ -365,6 +383,7 @@ int cmCPackArchiveGenerator::PackageComponents(bool ignoreGroup)
           DECLARE_AND_OPEN_ARCHIVE(packageFileName, archive);
           // Add the files of this component to the archive
           this->addOneComponentToArchive(archive, &(comp.second), nullptr);
+          CLOSE_ARCHIVE(packageFileName, archive);
         }
         // add the generated package to package file names list
         this->packageFileNames.push_back(std::move(packageFileName));
@@ -383,6 +402,7 @@ int cmCPackArchiveGenerator::PackageComponents(bool ignoreGroup)
         DECLARE_AND_OPEN_ARCHIVE(packageFileName, archive);
         // Add the files of this component to the archive
         this->addOneComponentToArchive(archive, &(comp.second), nullptr);
+        CLOSE_ARCHIVE(packageFileName, archive);
       }
       // add the generated package to package file names list
       this->packageFileNames.push_back(std::move(packageFileName));
@@ -420,7 +440,7 @@ int cmCPackArchiveGenerator::PackageComponentsAllInOne()
     this->addOneComponentToArchive(archive, &(comp.second), &deduplicator);
   }
 
-  // archive goes out of scope so it will finalized and closed.
+  CLOSE_ARCHIVE(packageFileNames[0], archive);
   return 1;
 }
 
@@ -466,7 +486,7 @@ int cmCPackArchiveGenerator::PackageFiles()
       return 0;
     }
   }
-  // The destructor of cmArchiveWrite will close and finish the write
+  CLOSE_ARCHIVE(packageFileNames[0], archive);
   return 1;
 }
 
@@ -45,8 +45,9 @@ public:
 private:
   void generateDebianBinaryFile() const;
   void generateControlFile() const;
-  bool generateDataTar() const;
-  std::string generateMD5File() const;
+  bool generateDataTar(std::map<std::string, std::string>& md5sums) const;
+  std::string generateMD5File(
+    std::map<std::string, std::string> const& md5sums) const;
   bool generateControlTar(std::string const& md5Filename) const;
   bool generateDeb() const;
 
@@ -141,10 +142,11 @@ bool DebGenerator::generate() const
 {
   this->generateDebianBinaryFile();
   this->generateControlFile();
-  if (!this->generateDataTar()) {
+  std::map<std::string, std::string> md5sums;
+  if (!this->generateDataTar(md5sums)) {
     return false;
   }
-  std::string md5Filename = this->generateMD5File();
+  std::string md5Filename = this->generateMD5File(md5sums);
   if (!this->generateControlTar(md5Filename)) {
     return false;
   }
@@ -179,7 +181,8 @@ void DebGenerator::generateControlFile() const
   out << "Installed-Size: " << (totalSize + 1023) / 1024 << "\n\n";
 }
 
-bool DebGenerator::generateDataTar() const
+bool DebGenerator::generateDataTar(
+  std::map<std::string, std::string>& md5sums) const
 {
   std::string filename_data_tar =
     this->WorkDir + "/data.tar" + this->CompressionSuffix;
@@ -206,6 +209,8 @@ bool DebGenerator::generateDataTar() const
   // always uid/gid equal to 0.
   data_tar.SetUIDAndGID(0U, 0U);
   data_tar.SetUNAMEAndGNAME("root", "root");
+  // hash the files for md5sums while reading them for the archive
+  data_tar.SetContentHash(cmCryptoHash::AlgoMD5);
 
   // now add all directories which have to be compressed
   // collect all top level install dirs for that
@@ -272,10 +277,19 @@ bool DebGenerator::generateDataTar() const
       return false;
     }
   }
+  if (!data_tar.Close()) {
+    cmCPackLogger(cmCPackLog::LOG_ERROR,
+                  "Error closing the archive \""
+                    << filename_data_tar
+                    << "\", ERROR = " << data_tar.GetError() << std::endl);
+    return false;
+  }
+  md5sums = data_tar.GetContentHashes();
   return true;
 }
 
-std::string DebGenerator::generateMD5File() const
+std::string DebGenerator::generateMD5File(
+  std::map<std::string, std::string> const& md5sums) const
 {
   std::string md5filename = this->WorkDir + "/md5sums";
 
@@ -290,8 +304,15 @@ std::string DebGenerator::generateMD5File() const
       continue;
     }
 
-    cmCryptoHash hasher(cmCryptoHash::AlgoMD5);
-    std::string output = hasher.HashFile(file);
+    // the data archive normally hashed the file already
+    std::string output;
+    auto const it = md5sums.find(file);
+    if (it != md5sums.end()) {
+      output = it->second;
+    } else {
+      cmCryptoHash hasher(cmCryptoHash::AlgoMD5);
+      output = hasher.HashFile(file);
+    }
     if (output.empty()) {
       cmCPackLogger(cmCPackLog::LOG_ERROR,
                     "Problem computing the md5 of " << file << std::endl);
@@ -455,6 +476,13 @@ bool DebGenerator::generateControlTar(std::string const& md5Filename) const
     }
   }
 
+  if (!control_tar.Close()) {
+    cmCPackLogger(cmCPackLog::LOG_ERROR,
+                  "Error closing the archive \""
+                    << filename_control_tar
+                    << "\", ERROR = " << control_tar.GetError() << std::endl);
+    return false;
+  }
   return true;
 }
 
@@ -498,6 +526,13 @@ bool DebGenerator::generateDeb() const
                     << deb.GetError() << std::endl);
     return false;
   }
+  if (!deb.Close()) {
+    cmCPackLogger(cmCPackLog::LOG_ERROR,
+                  "Error closing the archive \""
+                    << outputPath << "\", ERROR = " << deb.GetError()
+                    << std::endl);
+    return false;
+  }
   return true;
 }
 
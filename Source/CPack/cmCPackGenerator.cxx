@@ -5,6 +5,7 @@
 #include <algorithm>
 #include <cstring>
 #include <memory>
+#include <set>
 #include <utility>
 
 #include <cmext/string_view>
@@ -38,6 +39,71 @@
 #  include <StorageDefs.h>
 #endif
 
+namespace {
+bool IsInstallSubDirectory(std::string const& dir)
+{
+  return !dir.empty() && dir != "/" && dir != ".";
+}
+
+// Find the files, symlinks and directories below an installation.
+std::vector<std::string> FindInstalledFiles(std::string const& findExpr)
+{
+  cmsys::Glob gl;
+  gl.RecurseOn();
+  gl.SetRecurseListDirs(true);
+  gl.SetRecurseThroughSymlinks(false);
+  gl.FindFiles(findExpr);
+  std::vector<std::string> files = gl.GetFiles();
+  std::sort(files.begin(), files.end());
+  return files;
+}
+
+// Create a directory like one of the staging installation, and its
+// parents.  Their permissions are applied once their content is in place.
+bool MirrorDirectory(std::string const& from, std::string const& to,
+                     std::vector<std::pair<std::string, mode_t>>& dirs)
+{
+  if (cmSystemTools::FileIsDirectory(to)) {
+    return true;
+  }
+  if (!MirrorDirectory(cmSystemTools::GetFilenamePath(from),
+                       cmSystemTools::GetFilenamePath(to), dirs) ||
+      !cmSystemTools::MakeDirectory(to)) {
+    return false;
+  }
+  mode_t mode = 0;
+  if (cmSystemTools::GetPermissions(from, mode)) {
+    dirs.emplace_back(to, mode);
+  }
+  return true;
+}
+
+// Put an entry of the staging installation into a component installation.
+// Files are hard linked unless another component already took them.
+bool MirrorEntry(std::string const& from, std::string const& to, bool link,
+                 std::vector<std::pair<std::string, mode_t>>& dirs)
+{
+  if (!MirrorDirectory(cmSystemTools::GetFilenamePath(from),
+                       cmSystemTools::GetFilenamePath(to), dirs)) {
+    return false;
+  }
+  std::string target;
+  if (cmSystemTools::ReadSymlink(from, target)) {
+    cmSystemTools::RemoveFile(to);
+    return cmSystemTools::CreateSymlinkQuietly(target, to).IsSuccess();
+  }
+  if (cmSystemTools::FileIsDirectory(from)) {
+    return MirrorDirectory(from, to, dirs);
+  }
+  cmSystemTools::RemoveFile(to);
+  if (link && cmSystemTools::CreateLinkQuietly(from, to)) {
+    return true;
+  }
+  return cmSystemTools::CopyAFile(from, to, true) &&
+    cmFileTimes::Copy(from, to);
+}
+}
+
 cmCPackGenerator::cmCPackGenerator()
 {
   this->GeneratorVerbose = cmSystemTools::OUTPUT_NONE;
@@ -665,6 +731,24 @@ int cmCPackGenerator::InstallProjectViaInstallCMakeProjects(
                       "- Install project: " << project.ProjectName << " ["
                                             << buildConfig << ']'
                                             << std::endl);
+        // Run the installation once for all components if possible.
+        int installed = -1;
+        if (componentInstall && componentsList.size() > 1) {
+          installed = this->InstallCMakeProjectComponents(
+            setDestDir, project.Directory, baseTempInstallDirectory,
+            default_dir_mode, componentsList, project.SubDirectory,
+            buildConfig);
+          if (!installed) {
+            return 0;
+          }
+          if (installed < 0) {
+            cmCPackLogger(cmCPackLog::LOG_DEBUG,
+                          "- Install components one at a time" << std::endl);
+          }
+        }
+        if (installed > 0) {
+          continue;
+        }
         // Run the installation for each component
         for (std::string const& component : componentsList) {
           if (!this->InstallCMakeProject(
@@ -748,24 +832,12 @@ int cmCPackGenerator::InstallCMakeProject(
   cm.SetTraceExpand(this->TraceExpand);
   cmGlobalGenerator gg(&cm);
   cmMakefile mf(&gg, cm.GetCurrentSnapshot());
-  if (!installSubDirectory.empty() && installSubDirectory != "/" &&
-      installSubDirectory != ".") {
+  if (IsInstallSubDirectory(installSubDirectory)) {
     tempInstallDirectory += installSubDirectory;
   }
   if (componentInstall) {
-    tempInstallDirectory += "/";
-    // Some CPack generators would rather chose
-    // the local installation directory suffix.
-    // Some (e.g. RPM) use
-    //  one install directory for each component **GROUP**
-    // instead of the default
-    //  one install directory for each component.
-    tempInstallDirectory += this->GetComponentInstallDirNameSuffix(component);
-
-    if (this->IsOn("CPACK_COMPONENT_INCLUDE_TOPLEVEL_DIRECTORY")) {
-      tempInstallDirectory += "/";
-      tempInstallDirectory += *this->GetOption("CPACK_PACKAGE_FILE_NAME");
-    }
+    tempInstallDirectory =
+      this->GetComponentInstallDirectory(tempInstallDirectory, component);
   }
 
   cmValue default_dir_inst_permissions =
@@ -876,14 +948,8 @@ int cmCPackGenerator::InstallCMakeProject(
   std::vector<std::string> filesBefore;
   std::string findExpr = tempInstallDirectory;
   if (componentInstall) {
-    cmsys::Glob glB;
     findExpr += "/*";
-    glB.RecurseOn();
-    glB.SetRecurseListDirs(true);
-    glB.SetRecurseThroughSymlinks(false);
-    glB.FindFiles(findExpr);
-    filesBefore = glB.GetFiles();
-    std::sort(filesBefore.begin(), filesBefore.end());
+    filesBefore = FindInstalledFiles(findExpr);
   }
 
   // If CPack was asked to warn on ABSOLUTE INSTALL DESTINATION
@@ -915,8 +981,31 @@ int cmCPackGenerator::InstallCMakeProject(
     mf.AddDefinition(custom_variable.substr(0, i), value);
   }
 
+  // Run the rules of the recorded components, and only those.  As when
+  // installing all components, CMAKE_INSTALL_COMPONENT is not set.
+  if (!this->RecordComponents.empty()) {
+    mf.AddDefinition("CMAKE_INSTALL_RECORD_COMPONENTS", "1");
+    for (std::string const& recordComponent : this->RecordComponents) {
+      mf.AddDefinition(
+        cmStrCat("CMAKE_INSTALL_RECORD_COMPONENT_", recordComponent), "1");
+    }
+  }
+
   // do installation
   bool res = mf.ReadListFile(installFile);
+
+  if (!this->RecordComponents.empty()) {
+    cm::string_view const prefix = "CMAKE_INSTALL_COMPONENT_MANIFEST_"_s;
+    for (std::string const& name : mf.GetDefinitions()) {
+      if (cmHasPrefix(name, prefix)) {
+        cmList const manifestFiles{ mf.GetDefinition(name) };
+        std::vector<std::string>& manifest =
+          this->ComponentManifests[name.substr(prefix.size())];
+        manifest.insert(manifest.end(), manifestFiles.begin(),
+                        manifestFiles.end());
+      }
+    }
+  }
   // forward definition of CMAKE_ABSOLUTE_DESTINATION_FILES
   // to CPack (may be used by generators like CPack RPM or DEB)
   // in order to transparently handle ABSOLUTE PATH
@@ -927,31 +1016,8 @@ int cmCPackGenerator::InstallCMakeProject(
   // Now rebuild the list of files after installation
   // of the current component (if we are in component install)
   if (componentInstall) {
-    cmsys::Glob glA;
-    glA.RecurseOn();
-    glA.SetRecurseListDirs(true);
-    glA.SetRecurseThroughSymlinks(false);
-    glA.FindFiles(findExpr);
-    std::vector<std::string> filesAfter = glA.GetFiles();
-    std::sort(filesAfter.begin(), filesAfter.end());
-    std::vector<std::string>::iterator diff;
-    std::vector<std::string> result(filesAfter.size());
-    diff = std::set_difference(filesAfter.begin(), filesAfter.end(),
-                               filesBefore.begin(), filesBefore.end(),
-                               result.begin());
-
-    std::vector<std::string>::iterator fit;
-    std::string localFileName;
-    // Populate the File field of each component
-    for (fit = result.begin(); fit != diff; ++fit) {
-      localFileName = cmSystemTools::RelativePath(InstallPrefix, *fit);
-      localFileName =
-        localFileName.substr(localFileName.find_first_not_of('/'));
-      this->Components[component].Files.push_back(localFileName);
-      cmCPackLogger(cmCPackLog::LOG_DEBUG,
-                    "Adding file <" << localFileName << "> to component <"
-                                    << component << ">" << std::endl);
-    }
+    this->AddComponentFiles(component, InstallPrefix, filesBefore,
+                            FindInstalledFiles(findExpr));
   }
 
   if (cmValue d = mf.GetDefinition("CPACK_ABSOLUTE_DESTINATION_FILES")) {
@@ -984,6 +1050,186 @@ int cmCPackGenerator::InstallCMakeProject(
   return 1;
 }
 
+int cmCPackGenerator::InstallCMakeProjectComponents(
+  bool setDestDir, const std::string& installDirectory,
+  const std::string& baseTempInstallDirectory, const mode_t* default_dir_mode,
+  const std::vector<std::string>& components,
+  const std::string& installSubDirectory, const std::string& buildConfig)
+{
+  std::string const stagingDirectory =
+    cmStrCat(baseTempInstallDirectory, ".staging");
+  cmSystemTools::RemoveADirectory(stagingDirectory);
+
+  // Install all components, recording the files of each.
+  cmCPackLogger(cmCPackLog::LOG_DEBUG,
+                "- Install all components into: " << stagingDirectory
+                                                  << std::endl);
+  std::string absoluteDestFiles;
+  this->RecordComponents = components;
+  this->ComponentManifests.clear();
+  int const res = this->InstallCMakeProject(
+    setDestDir, installDirectory, stagingDirectory, default_dir_mode, "ALL",
+    false, installSubDirectory, buildConfig, absoluteDestFiles);
+  this->RecordComponents.clear();
+  std::map<std::string, std::vector<std::string>> manifests;
+  std::swap(manifests, this->ComponentManifests);
+  // The components are installed one at a time if this fails, which also
+  // reports the problem if it is not specific to installing them at once.
+  if (!res) {
+    cmSystemTools::ResetErrorOccurredFlag();
+    cmSystemTools::RemoveADirectory(stagingDirectory);
+    return -1;
+  }
+
+  std::string stagingRoot = stagingDirectory;
+  std::string componentsRoot = baseTempInstallDirectory;
+  if (IsInstallSubDirectory(installSubDirectory)) {
+    stagingRoot += installSubDirectory;
+    componentsRoot += installSubDirectory;
+  }
+  stagingRoot = cmSystemTools::CollapseFullPath(stagingRoot);
+
+  // Every file installed must belong to exactly one component.  Otherwise
+  // the scripts install files by other means, were generated by an older
+  // version, or components install different files at the same path.  In
+  // those cases the components are installed one at a time instead.
+  bool covered = true;
+  std::set<std::string> recorded;
+  std::set<std::string> parents;
+  for (auto& manifest : manifests) {
+    std::set<std::string> componentFiles;
+    for (std::string& file : manifest.second) {
+      file = cmSystemTools::CollapseFullPath(file);
+      if (componentFiles.insert(file).second &&
+          !recorded.insert(file).second &&
+          !cmSystemTools::FileIsDirectory(file)) {
+        cmCPackLogger(cmCPackLog::LOG_DEBUG,
+                      "- Installed by several components: " << file
+                                                            << std::endl);
+        covered = false;
+      }
+      for (std::string dir = cmSystemTools::GetFilenamePath(file);
+           dir.size() > stagingRoot.size() && parents.insert(dir).second;
+           dir = cmSystemTools::GetFilenamePath(dir)) {
+      }
+    }
+  }
+  covered = covered && absoluteDestFiles.empty();
+  for (std::string const& file :
+       FindInstalledFiles(cmStrCat(stagingRoot, "/*"))) {
+    if (!covered) {
+      break;
+    }
+    std::string const path = cmSystemTools::CollapseFullPath(file);
+    if (recorded.count(path) == 0 && parents.count(path) == 0) {
+      cmCPackLogger(cmCPackLog::LOG_DEBUG,
+                    "- No component installed: " << path << std::endl);
+      covered = false;
+    }
+  }
+  if (!covered) {
+    cmSystemTools::RemoveADirectory(stagingDirectory);
+    return -1;
+  }
+
+  // Put the files of each component into its own installation directory.
+  std::set<std::string> linked;
+  for (std::string const& component : components) {
+    cmCPackLogger(cmCPackLog::LOG_OUTPUT,
+                  "-   Install component: " << component << std::endl);
+    std::string const componentRoot =
+      this->GetComponentInstallDirectory(componentsRoot, component);
+    std::string installPrefix = componentRoot;
+    std::string dir;
+    if (setDestDir) {
+      dir = this->GetOption("CPACK_INSTALL_PREFIX");
+      dir = cmHasLiteralPrefix(dir, "/") ? cmStrCat(componentRoot, dir)
+                                         : cmStrCat(componentRoot, '/', dir);
+    } else {
+      installPrefix += this->GetPackagingInstallPrefix();
+      dir = installPrefix;
+    }
+    if (!cmsys::SystemTools::MakeDirectory(dir, default_dir_mode)) {
+      cmCPackLogger(cmCPackLog::LOG_ERROR,
+                    "Problem creating temporary directory: " << dir
+                                                             << std::endl);
+      cmSystemTools::RemoveADirectory(stagingDirectory);
+      return 0;
+    }
+    std::string const findExpr = cmStrCat(installPrefix, "/*");
+    std::vector<std::string> const filesBefore = FindInstalledFiles(findExpr);
+
+    std::set<std::string> componentFiles;
+    auto const found = manifests.find(component);
+    if (found != manifests.end()) {
+      componentFiles.insert(found->second.begin(), found->second.end());
+    }
+    std::vector<std::pair<std::string, mode_t>> dirs;
+    for (std::string const& file : componentFiles) {
+      std::string const to =
+        cmStrCat(componentRoot, file.substr(stagingRoot.size()));
+      if (!MirrorEntry(file, to, linked.insert(file).second, dirs)) {
+        cmCPackLogger(cmCPackLog::LOG_ERROR,
+                      "Problem installing component file: " << to
+                                                            << std::endl);
+        cmSystemTools::RemoveADirectory(stagingDirectory);
+        return 0;
+      }
+    }
+    for (auto it = dirs.rbegin(); it != dirs.rend(); ++it) {
+      cmSystemTools::SetPermissions(it->first, it->second);
+    }
+
+    this->AddComponentFiles(component, installPrefix, filesBefore,
+                            FindInstalledFiles(findExpr));
+  }
+
+  cmSystemTools::RemoveADirectory(stagingDirectory);
+  return 1;
+}
+
+std::string cmCPackGenerator::GetComponentInstallDirectory(
+  std::string dir, const std::string& component)
+{
+  dir += "/";
+  // Some CPack generators would rather chose
+  // the local installation directory suffix.
+  // Some (e.g. RPM) use
+  //  one install directory for each component **GROUP**
+  // instead of the default
+  //  one install directory for each component.
+  dir += this->GetComponentInstallDirNameSuffix(component);
+
+  if (this->IsOn("CPACK_COMPONENT_INCLUDE_TOPLEVEL_DIRECTORY")) {
+    dir += "/";
+    dir += *this->GetOption("CPACK_PACKAGE_FILE_NAME");
+  }
+  return dir;
+}
+
+void cmCPackGenerator::AddComponentFiles(
+  const std::string& component, const std::string& installPrefix,
+  const std::vector<std::string>& filesBefore,
+  const std::vector<std::string>& filesAfter)
+{
+  std::vector<std::string> result(filesAfter.size());
+  auto const diff =
+    std::set_difference(filesAfter.begin(), filesAfter.end(),
+                        filesBefore.begin(), filesBefore.end(),
+                        result.begin());
+
+  std::string localFileName;
+  // Populate the File field of each component
+  for (auto fit = result.begin(); fit != diff; ++fit) {
+    localFileName = cmSystemTools::RelativePath(installPrefix, *fit);
+    localFileName = localFileName.substr(localFileName.find_first_not_of('/'));
+    this->Components[component].Files.push_back(localFileName);
+    cmCPackLogger(cmCPackLog::LOG_DEBUG,
+                  "Adding file <" << localFileName << "> to component <"
+                                  << component << ">" << std::endl);
+  }
+}
+
 bool cmCPackGenerator::GenerateChecksumFile(cmCryptoHash& crypto,
                                             cm::string_view filename) const
 {
@@ -241,6 +241,20 @@ protected:
     bool componentInstall, const std::string& installSubDirectory,
     const std::string& buildConfig, std::string& absoluteDestFiles);
 
+  /**
+   * Install the given components of a project at once into a staging
+   * directory, and then link the files of each component into its own
+   * installation directory.  Returns -1 without installing anything if
+   * the install scripts fail or do not record which component installs
+   * each file, in which case the components are installed one at a time.
+   */
+  int InstallCMakeProjectComponents(
+    bool setDestDir, const std::string& installDirectory,
+    const std::string& baseTempInstallDirectory,
+    const mode_t* default_dir_mode,
+    const std::vector<std::string>& components,
+    const std::string& installSubDirectory, const std::string& buildConfig);
+
   /**
    * The various level of support of
    * CPACK_SET_DESTDIR used by the generator.
@@ -368,6 +382,17 @@ protected:
   cmMakefile* MakefileMap;
 
 private:
+  std::string GetComponentInstallDirectory(std::string dir,
+                                           const std::string& component);
+  void AddComponentFiles(const std::string& component,
+                         const std::string& installPrefix,
+                         const std::vector<std::string>& filesBefore,
+                         const std::vector<std::string>& filesAfter);
+
+  // The components installed at once, and the files of each.
+  std::vector<std::string> RecordComponents;
+  std::map<std::string, std::vector<std::string>> ComponentManifests;
+
   template <typename ValueType>
   void StoreOption(const std::string& op, ValueType value);
   template <typename ValueType>
@@ -202,10 +202,7 @@ void cmCTestBuildHandler::Initialize()
   this->ReallyCustomWarningExceptions.clear();
   this->ErrorWarningFileLineRegex.clear();
 
-  this->ErrorMatchRegex.clear();
-  this->ErrorExceptionRegex.clear();
-  this->WarningMatchRegex.clear();
-  this->WarningExceptionRegex.clear();
+  this->ErrorWarningRegex.Clear();
   this->BuildProcessingQueue.clear();
   this->BuildProcessingErrorQueue.clear();
   this->BuildOutputLogSize = 0;
@@ -373,27 +370,24 @@ int cmCTestBuildHandler::ProcessHandler()
 
   // Pre-compile regular expressions objects for all regular expressions
 
-#define cmCTestBuildHandlerPopulateRegexVector(strings, regexes)              \
-  do {                                                                        \
-    regexes.clear();                                                          \
-    cmCTestOptionalLog(this->CTest, DEBUG,                                    \
-                       this << "Add " #regexes << std::endl, this->Quiet);    \
-    for (std::string const& s : (strings)) {                                  \
-      cmCTestOptionalLog(this->CTest, DEBUG,                                  \
-                         "Add " #strings ": " << s << std::endl,              \
-                         this->Quiet);                                        \
-      (regexes).emplace_back(s);                                              \
-    }                                                                         \
-  } while (false)
-
-  cmCTestBuildHandlerPopulateRegexVector(this->CustomErrorMatches,
-                                         this->ErrorMatchRegex);
-  cmCTestBuildHandlerPopulateRegexVector(this->CustomErrorExceptions,
-                                         this->ErrorExceptionRegex);
-  cmCTestBuildHandlerPopulateRegexVector(this->CustomWarningMatches,
-                                         this->WarningMatchRegex);
-  cmCTestBuildHandlerPopulateRegexVector(this->CustomWarningExceptions,
-                                         this->WarningExceptionRegex);
+  auto addRegexes = [this](std::vector<std::string> const& strings,
+                           const char* label) {
+    for (std::string const& s : strings) {
+      cmCTestOptionalLog(this->CTest, DEBUG,
+                         "Add " << label << ": " << s << std::endl,
+                         this->Quiet);
+      this->ErrorWarningRegex.Add(s);
+    }
+  };
+
+  this->ErrorWarningRegex.Clear();
+  addRegexes(this->CustomErrorMatches, "error match");
+  this->ErrorExceptionRegexBegin = this->ErrorWarningRegex.Size();
+  addRegexes(this->CustomErrorExceptions, "error exception");
+  this->WarningMatchRegexBegin = this->ErrorWarningRegex.Size();
+  addRegexes(this->CustomWarningMatches, "warning match");
+  this->WarningExceptionRegexBegin = this->ErrorWarningRegex.Size();
+  addRegexes(this->CustomWarningExceptions, "warning exception");
 
   // Determine source and binary tree substitutions to simplify the output.
   this->SimplifySourceDir.clear();
@@ -1147,69 +1141,64 @@ int cmCTestBuildHandler::ProcessSingleLine(const char* data)
   int errorLine = 0;
 
   // Check for regular expressions
+  this->ErrorWarningRegex.Scan(line);
+  std::size_t const errorMatchEnd = this->ErrorExceptionRegexBegin;
+  std::size_t const errorExceptionEnd = this->WarningMatchRegexBegin;
+  std::size_t const warningMatchEnd = this->WarningExceptionRegexBegin;
+  std::size_t const warningExceptionEnd = this->ErrorWarningRegex.Size();
 
   if (!this->ErrorQuotaReached) {
     // Errors
-    int wrxCnt = 0;
-    for (cmsys::RegularExpression& rx : this->ErrorMatchRegex) {
-      if (rx.find(line.c_str())) {
-        errorLine = 1;
-        cmCTestOptionalLog(this->CTest, DEBUG,
-                           "  Error Line: " << line << " (matches: "
-                                            << this->CustomErrorMatches[wrxCnt]
-                                            << ")" << std::endl,
-                           this->Quiet);
-        break;
-      }
-      wrxCnt++;
+    std::size_t i = this->ErrorWarningRegex.Find(0, errorMatchEnd);
+    if (i != errorMatchEnd) {
+      errorLine = 1;
+      cmCTestOptionalLog(this->CTest, DEBUG,
+                         "  Error Line: " << line << " (matches: "
+                                          << this->CustomErrorMatches[i]
+                                          << ")" << std::endl,
+                         this->Quiet);
     }
     // Error exceptions
-    wrxCnt = 0;
-    for (cmsys::RegularExpression& rx : this->ErrorExceptionRegex) {
-      if (rx.find(line.c_str())) {
-        errorLine = 0;
-        cmCTestOptionalLog(this->CTest, DEBUG,
-                           "  Not an error Line: "
-                             << line << " (matches: "
-                             << this->CustomErrorExceptions[wrxCnt] << ")"
-                             << std::endl,
-                           this->Quiet);
-        break;
-      }
-      wrxCnt++;
+    i = this->ErrorWarningRegex.Find(this->ErrorExceptionRegexBegin,
+                                     errorExceptionEnd);
+    if (i != errorExceptionEnd) {
+      errorLine = 0;
+      cmCTestOptionalLog(
+        this->CTest, DEBUG,
+        "  Not an error Line: "
+          << line << " (matches: "
+          << this->CustomErrorExceptions[i - this->ErrorExceptionRegexBegin]
+          << ")" << std::endl,
+        this->Quiet);
     }
   }
   if (!this->WarningQuotaReached) {
     // Warnings
-    int wrxCnt = 0;
-    for (cmsys::RegularExpression& rx : this->WarningMatchRegex) {
-      if (rx.find(line.c_str())) {
-        warningLine = 1;
-        cmCTestOptionalLog(this->CTest, DEBUG,
-                           "  Warning Line: "
-                             << line << " (matches: "
-                             << this->CustomWarningMatches[wrxCnt] << ")"
-                             << std::endl,
-                           this->Quiet);
-        break;
-      }
-      wrxCnt++;
+    std::size_t i = this->ErrorWarningRegex.Find(this->WarningMatchRegexBegin,
+                                                 warningMatchEnd);
+    if (i != warningMatchEnd) {
+      warningLine = 1;
+      cmCTestOptionalLog(
+        this->CTest, DEBUG,
+        "  Warning Line: "
+          << line << " (matches: "
+          << this->CustomWarningMatches[i - this->WarningMatchRegexBegin]
+          << ")" << std::endl,
+        this->Quiet);
     }
 
-    wrxCnt = 0;
     // Warning exceptions
-    for (cmsys::RegularExpression& rx : this->WarningExceptionRegex) {
-      if (rx.find(line.c_str())) {
-        warningLine = 0;
-        cmCTestOptionalLog(this->CTest, DEBUG,
-                           "  Not a warning Line: "
-                             << line << " (matches: "
-                             << this->CustomWarningExceptions[wrxCnt] << ")"
-                             << std::endl,
-                           this->Quiet);
-        break;
-      }
-      wrxCnt++;
+    i = this->ErrorWarningRegex.Find(this->WarningExceptionRegexBegin,
+                                     warningExceptionEnd);
+    if (i != warningExceptionEnd) {
+      warningLine = 0;
+      cmCTestOptionalLog(this->CTest, DEBUG,
+                         "  Not a warning Line: "
+                           << line << " (matches: "
+                           << this->CustomWarningExceptions
+                                [i - this->WarningExceptionRegexBegin]
+                           << ")" << std::endl,
+                         this->Quiet);
     }
   }
   if (errorLine) {
@@ -14,6 +14,7 @@
 #include "cmsys/RegularExpression.hxx"
 
 #include "cmCTestGenericHandler.h"
+#include "cmCTestRegexSet.h"
 #include "cmDuration.h"
 #include "cmProcessOutput.h"
 
@@ -106,10 +107,12 @@ private:
   std::vector<std::string> ReallyCustomWarningExceptions;
   std::vector<cmCTestCompileErrorWarningRex> ErrorWarningFileLineRegex;
 
-  std::vector<cmsys::RegularExpression> ErrorMatchRegex;
-  std::vector<cmsys::RegularExpression> ErrorExceptionRegex;
-  std::vector<cmsys::RegularExpression> WarningMatchRegex;
-  std::vector<cmsys::RegularExpression> WarningExceptionRegex;
+  // The error matches, error exceptions, warning matches and warning
+  // exceptions, in this order, matched after one scan of each line.
+  cmCTestRegexSet ErrorWarningRegex;
+  std::size_t ErrorExceptionRegexBegin = 0;
+  std::size_t WarningMatchRegexBegin = 0;
+  std::size_t WarningExceptionRegexBegin = 0;
 
   using t_BuildProcessingQueueType = std::deque<char>;
 
@@ -8,18 +8,27 @@
 #include <cstdlib>
 #include <cstring>
 #include <iomanip>
+#include <ios>
 #include <iterator>
+#include <limits>
 #include <memory>
 #include <ratio>
 #include <sstream>
 #include <type_traits>
 #include <utility>
 
+#include <cm/memory>
+#include <cm/optional>
 #include <cmext/algorithm>
 
+#include <cm3p/json/reader.h>
+#include <cm3p/json/value.h>
+#include <cm3p/uv.h>
+
 #include "cmsys/FStream.hxx"
 #include "cmsys/Glob.hxx"
 #include "cmsys/RegularExpression.hxx"
+#include "cmsys/SystemInformation.hxx"
 
 #include "cmCTest.h"
 #include "cmDuration.h"
@@ -31,9 +40,12 @@
 #include "cmParseGTMCoverage.h"
 #include "cmParseJacocoCoverage.h"
 #include "cmParsePHPCoverage.h"
+#include "cmProcessOutput.h"
 #include "cmStringAlgorithms.h"
 #include "cmSystemTools.h"
+#include "cmUVHandlePtr.h"
 #include "cmUVProcessChain.h"
+#include "cmUVStream.h"
 #include "cmWorkingDirectory.h"
 #include "cmXMLWriter.h"
 
@@ -41,6 +53,9 @@ class cmMakefile;
 
 #define SAFEDIV(x, y) (((y) != 0) ? ((x) / (y)) : (0))
 
+// Start a new coverage log file once the current one is this large.
+static std::streamoff const CoverageLogFileSize = 4 * 1024 * 1024;
+
 cmCTestCoverageHandler::cmCTestCoverageHandler() = default;
 
 void cmCTestCoverageHandler::Initialize()
@@ -342,7 +357,6 @@ int cmCTestCoverageHandler::ProcessHandler()
     return -1;
   }
   this->StartCoverageLogXML(covLogXML);
-  int cnt = 0;
   long total_tested = 0;
   long total_untested = 0;
   // std::string fullSourceDir = sourceDir + "/";
@@ -357,7 +371,7 @@ int cmCTestCoverageHandler::ProcessHandler()
   std::vector<std::string> errorsWhileAccumulating;
 
   file_count = 0;
-  for (auto const& file : cont.TotalCoverage) {
+  for (auto& file : cont.TotalCoverage) {
     cmCTestOptionalLog(this->CTest, HANDLER_OUTPUT, "." << std::flush,
                        this->Quiet);
     file_count++;
@@ -391,7 +405,7 @@ int cmCTestCoverageHandler::ProcessHandler()
       continue;
     }
 
-    if (++cnt % 100 == 0) {
+    if (covLogFile.tellp() >= std::streampos(CoverageLogFileSize)) {
       this->EndCoverageLogXML(covLogXML);
       this->EndCoverageLogFile(covLogFile, logFileCount);
       logFileCount++;
@@ -404,8 +418,9 @@ int cmCTestCoverageHandler::ProcessHandler()
     const std::string fileName = cmSystemTools::GetFilenameName(fullFileName);
     const std::string shortFileName =
       this->CTest->GetShortPathToFile(fullFileName);
-    const cmCTestCoverageHandlerContainer::SingleFileCoverageVector& fcov =
-      file.second;
+    // Release the line counts of each file once it is logged.
+    const cmCTestCoverageHandlerContainer::SingleFileCoverageVector fcov =
+      std::move(file.second);
     covLogXML.StartElement("File");
     covLogXML.Attribute("Name", fileName);
     covLogXML.Attribute("FullPath", shortFileName);
@@ -486,6 +501,16 @@ int cmCTestCoverageHandler::ProcessHandler()
     std::string fileName = cmSystemTools::GetFilenameName(u);
     std::string fullPath = cont.SourceDir + "/" + u;
 
+    if (covLogFile.tellp() >= std::streampos(CoverageLogFileSize)) {
+      this->EndCoverageLogXML(covLogXML);
+      this->EndCoverageLogFile(covLogFile, logFileCount);
+      logFileCount++;
+      if (!this->StartCoverageLogFile(covLogFile, logFileCount)) {
+        return -1;
+      }
+      this->StartCoverageLogXML(covLogXML);
+    }
+
     covLogXML.StartElement("File");
     covLogXML.Attribute("Name", fileName);
     covLogXML.Attribute("FullPath", u);
@@ -816,6 +841,164 @@ static std::string joinCommandLine(const std::vector<std::string>& args)
   return ret;
 }
 
+namespace {
+// Runs gcov on the coverage data files, several at a time.  The runs are
+// waited for in the order of the files, and may get ahead of the file
+// waited for by a bounded number of files.  Each run that may be ahead
+// gets a directory of its own because gcov writes its .gcov files to the
+// working directory and those of two data files may have the same name.
+// These directories are removed when the runner is destroyed.
+class GCovRunner
+{
+public:
+  struct Run
+  {
+    std::string Directory;
+    std::unique_ptr<cmUVProcessChain> Chain;
+    cm::uv_pipe_ptr OutputPipe;
+    cm::uv_pipe_ptr ErrorPipe;
+    std::unique_ptr<cmUVStreamReadHandle> OutputHandle;
+    std::unique_ptr<cmUVStreamReadHandle> ErrorHandle;
+    std::vector<char> Output;
+    std::vector<char> Errors;
+    bool OutputFinished = false;
+    bool ErrorFinished = false;
+    bool Running = false;
+
+    /** Whether the process chain could be set up.  If not, there is no
+        status to query and no output to read.  */
+    bool Valid() const { return this->Chain->Valid(); }
+
+    bool Finished() const
+    {
+      return !this->Valid() ||
+        (this->OutputFinished && this->ErrorFinished &&
+         this->Chain->Finished());
+    }
+  };
+
+  GCovRunner(std::vector<std::vector<std::string>> const& commands,
+             std::string const& directory, std::size_t parallel);
+  ~GCovRunner();
+
+  GCovRunner(GCovRunner const&) = delete;
+  GCovRunner& operator=(GCovRunner const&) = delete;
+
+  /** Wait for the run of a command, starting the runs of the following
+      commands meanwhile.  The run stays valid until the next call.  */
+  Run& Wait(std::size_t index);
+
+private:
+  void Start(std::size_t index);
+
+  std::vector<std::vector<std::string>> const& Commands;
+  std::size_t Parallel;
+  std::size_t Window;
+  std::size_t Next = 0;
+  std::size_t Running = 0;
+  cm::uv_loop_ptr Loop;
+  std::vector<std::unique_ptr<Run>> Runs;
+  std::vector<std::string> Directories;
+};
+
+GCovRunner::GCovRunner(std::vector<std::vector<std::string>> const& commands,
+                       std::string const& directory, std::size_t parallel)
+  : Commands(commands)
+  , Parallel(std::max<std::size_t>(parallel, 1))
+  , Window(std::max<std::size_t>(
+      std::min(this->Parallel == 1 ? 1 : 4 * this->Parallel, commands.size()),
+      1))
+{
+  this->Loop.init();
+  this->Runs.resize(this->Window);
+  if (this->Window == 1) {
+    this->Directories.push_back(directory);
+    return;
+  }
+  for (std::size_t i = 0; i < this->Window; ++i) {
+    this->Directories.push_back(cmStrCat(directory, "/gcov-", i));
+    cmSystemTools::MakeDirectory(this->Directories.back());
+  }
+}
+
+GCovRunner::~GCovRunner()
+{
+  // Let runs that were started ahead finish before removing their
+  // directories.
+  for (std::unique_ptr<Run> const& run : this->Runs) {
+    while (run && run->Running && !run->Finished()) {
+      uv_run(this->Loop, UV_RUN_ONCE);
+    }
+  }
+  if (this->Window > 1) {
+    for (std::string const& directory : this->Directories) {
+      cmSystemTools::RemoveADirectory(directory);
+    }
+  }
+}
+
+GCovRunner::Run& GCovRunner::Wait(std::size_t index)
+{
+  for (;;) {
+    // Count the runs that finished and start others in their place.
+    for (std::size_t i = index; i < this->Next; ++i) {
+      Run& run = *this->Runs[i % this->Window];
+      if (run.Running && run.Finished()) {
+        run.Running = false;
+        --this->Running;
+      }
+    }
+    while (this->Running < this->Parallel &&
+           this->Next < this->Commands.size() &&
+           this->Next < index + this->Window) {
+      this->Start(this->Next++);
+    }
+    Run& run = *this->Runs[index % this->Window];
+    if (!run.Running) {
+      return run;
+    }
+    uv_run(this->Loop, UV_RUN_ONCE);
+  }
+}
+
+void GCovRunner::Start(std::size_t index)
+{
+  // The run in this place was waited for already.
+  auto run = cm::make_unique<Run>();
+  run->Directory = this->Directories[index % this->Window];
+
+  cmUVProcessChainBuilder builder;
+  builder.AddCommand(this->Commands[index])
+    .SetExternalLoop(*this->Loop)
+    .SetBuiltinStream(cmUVProcessChainBuilder::Stream_OUTPUT)
+    .SetBuiltinStream(cmUVProcessChainBuilder::Stream_ERROR)
+    .SetWorkingDirectory(run->Directory);
+  run->Chain = cm::make_unique<cmUVProcessChain>(builder.Start());
+  if (!run->Valid()) {
+    this->Runs[index % this->Window] = std::move(run);
+    return;
+  }
+
+  Run* r = run.get();
+  run->OutputPipe.init(*this->Loop, 0);
+  uv_pipe_open(run->OutputPipe, run->Chain->OutputStream());
+  run->OutputHandle = cmUVStreamRead(
+    run->OutputPipe,
+    [r](std::vector<char> data) { cm::append(r->Output, data); },
+    [r]() { r->OutputFinished = true; });
+  run->ErrorPipe.init(*this->Loop, 0);
+  uv_pipe_open(run->ErrorPipe, run->Chain->ErrorStream());
+  run->ErrorHandle = cmUVStreamRead(
+    run->ErrorPipe,
+    [r](std::vector<char> data) { cm::append(r->Errors, data); },
+    [r]() { r->ErrorFinished = true; });
+
+  run->Running = true;
+  ++this->Running;
+  this->Runs[index % this->Window] = std::move(run);
+}
+}
+
 int cmCTestCoverageHandler::HandleBlanketJSCoverage(
   cmCTestCoverageHandlerContainer* cont)
 {
@@ -938,6 +1121,16 @@ int cmCTestCoverageHandler::HandleGCovCoverage(
 
   std::vector<std::string> basecovargs =
     cmSystemTools::ParseArguments(gcovExtraFlags);
+
+  // With the JSON intermediate format, have gcov write it to stdout
+  // instead of to files.
+  bool const jsonFormat = cm::contains(basecovargs, "--json-format") ||
+    cm::contains(basecovargs, "-j");
+  if (jsonFormat && !cm::contains(basecovargs, "--stdout") &&
+      !cm::contains(basecovargs, "-t")) {
+    basecovargs.emplace_back("--stdout");
+  }
+
   basecovargs.insert(basecovargs.begin(), gcovCommand);
   basecovargs.emplace_back("-o");
 
@@ -945,29 +1138,66 @@ int cmCTestCoverageHandler::HandleGCovCoverage(
   // These are binary files that you give as input to gcov so that it will
   // give us text output we can analyze to summarize coverage.
   //
+  std::vector<std::vector<std::string>> commands;
+  commands.reserve(files.size());
   for (std::string const& f : files) {
+    commands.push_back(basecovargs);
+    commands.back().push_back(cmSystemTools::GetFilenamePath(f));
+    commands.back().push_back(f);
+  }
+
+  // Run gcov on as many files at a time as tests would run in parallel.
+  cm::optional<std::size_t> parallelLevel = this->CTest->GetParallelLevel();
+  std::size_t parallel = parallelLevel ? *parallelLevel : 0;
+  if (parallel == 0) {
+    cmsys::SystemInformation info;
+    info.RunCPUCheck();
+    parallel = info.GetNumberOfLogicalCPU();
+  }
+  GCovRunner runner(commands, tempDir, parallel);
+
+  for (std::size_t fi = 0; fi < files.size(); ++fi) {
+    std::string const& f = files[fi];
     cmCTestOptionalLog(this->CTest, HANDLER_OUTPUT, "." << std::flush,
                        this->Quiet);
 
     // Call gcov to get coverage data for this *.gcda file:
     //
-    std::string fileDir = cmSystemTools::GetFilenamePath(f);
-    std::vector<std::string> covargs = basecovargs;
-    covargs.push_back(fileDir);
-    covargs.push_back(f);
+    std::vector<std::string> const& covargs = commands[fi];
+    std::string const& fileDir = covargs[covargs.size() - 2];
     const std::string command = joinCommandLine(covargs);
 
     cmCTestOptionalLog(this->CTest, HANDLER_VERBOSE_OUTPUT,
                        command << std::endl, this->Quiet);
 
-    std::string output;
-    std::string errors;
-    int retVal = 0;
     *cont->OFS << "* Run coverage for: " << fileDir << std::endl;
     *cont->OFS << "  Command: " << command << std::endl;
-    int res = this->CTest->RunCommand(covargs, &output, &errors, &retVal,
-                                      tempDir.c_str(),
-                                      cmDuration::zero() /*this->TimeOut*/);
+
+    GCovRunner::Run& run = runner.Wait(fi);
+    cmProcessOutput processOutput;
+    processOutput.DecodeText(run.Output, run.Output);
+    processOutput.DecodeText(run.Errors, run.Errors);
+    std::string output(run.Output.begin(), run.Output.end());
+    std::string errors(run.Errors.begin(), run.Errors.end());
+    int retVal = 0;
+    bool res = true;
+    if (!run.Valid()) {
+      cmCTestLog(this->CTest, ERROR_MESSAGE,
+                 "Failed to start coverage command" << std::endl);
+      errors += "Failed to start coverage command";
+      res = false;
+    } else {
+      auto const& status = run.Chain->GetStatus(0);
+      auto exception = status.GetException();
+      if (exception.first == cmUVProcessChain::ExceptionCode::None) {
+        retVal = static_cast<int>(status.ExitStatus);
+      } else {
+        cmCTestLog(this->CTest, ERROR_MESSAGE,
+                   exception.second << std::endl);
+        errors += exception.second;
+        res = false;
+      }
+    }
 
     *cont->OFS << "  Output: " << output << std::endl;
     *cont->OFS << "  Errors: " << errors << std::endl;
@@ -996,7 +1226,11 @@ int cmCTestCoverageHandler::HandleGCovCoverage(
       this->Quiet);
 
     std::vector<std::string> lines;
-    cmsys::SystemTools::Split(output, lines);
+    if (jsonFormat) {
+      this->HandleGCovJSON(cont, output, missingFiles);
+    } else {
+      cmsys::SystemTools::Split(output, lines);
+    }
 
     for (std::string const& line : lines) {
       std::string sourceFile;
@@ -1138,7 +1372,9 @@ int cmCTestCoverageHandler::HandleGCovCoverage(
                            "   in gcovFile: " << gcovFile << std::endl,
                            this->Quiet);
 
-        cmsys::ifstream ifile(gcovFile.c_str());
+        // gcov names its output relative to its working directory.
+        cmsys::ifstream ifile(
+          cmSystemTools::CollapseFullPath(gcovFile, run.Directory).c_str());
         if (!ifile) {
           cmCTestLog(this->CTest, ERROR_MESSAGE,
                      "Cannot open file: " << gcovFile << std::endl);
@@ -1196,49 +1432,8 @@ int cmCTestCoverageHandler::HandleGCovCoverage(
 
       if (!sourceFile.empty() && actualSourceFile.empty()) {
         gcovFile.clear();
-
-        // Is it in the source dir or the binary dir?
-        //
-        if (IsFileInDir(sourceFile, cont->SourceDir)) {
-          cmCTestOptionalLog(this->CTest, HANDLER_VERBOSE_OUTPUT,
-                             "   produced s: " << sourceFile << std::endl,
-                             this->Quiet);
-          *cont->OFS << "  produced in source dir: " << sourceFile
-                     << std::endl;
-          actualSourceFile = cmSystemTools::CollapseFullPath(sourceFile);
-        } else if (IsFileInDir(sourceFile, cont->BinaryDir)) {
-          cmCTestOptionalLog(this->CTest, HANDLER_VERBOSE_OUTPUT,
-                             "   produced b: " << sourceFile << std::endl,
-                             this->Quiet);
-          *cont->OFS << "  produced in binary dir: " << sourceFile
-                     << std::endl;
-          actualSourceFile = cmSystemTools::CollapseFullPath(sourceFile);
-        }
-
-        if (actualSourceFile.empty()) {
-          if (missingFiles.find(sourceFile) == missingFiles.end()) {
-            cmCTestOptionalLog(this->CTest, HANDLER_VERBOSE_OUTPUT,
-                               "Something went wrong" << std::endl,
-                               this->Quiet);
-            cmCTestOptionalLog(this->CTest, HANDLER_VERBOSE_OUTPUT,
-                               "Cannot find file: [" << sourceFile << "]"
-                                                     << std::endl,
-                               this->Quiet);
-            cmCTestOptionalLog(this->CTest, HANDLER_VERBOSE_OUTPUT,
-                               " in source dir: [" << cont->SourceDir << "]"
-                                                   << std::endl,
-                               this->Quiet);
-            cmCTestOptionalLog(this->CTest, HANDLER_VERBOSE_OUTPUT,
-                               " or binary dir: [" << cont->BinaryDir.size()
-                                                   << "]" << std::endl,
-                               this->Quiet);
-            *cont->OFS << "  Something went wrong. Cannot find file: "
-                       << sourceFile << " in source dir: " << cont->SourceDir
-                       << " or binary dir: " << cont->BinaryDir << std::endl;
-
-            missingFiles.insert(sourceFile);
-          }
-        }
+        actualSourceFile =
+          this->FindGCovSourceFile(cont, sourceFile, missingFiles);
       }
     }
 
@@ -1256,6 +1451,116 @@ int cmCTestCoverageHandler::HandleGCovCoverage(
   return file_count;
 }
 
+std::string cmCTestCoverageHandler::FindGCovSourceFile(
+  cmCTestCoverageHandlerContainer* cont, std::string const& sourceFile,
+  std::set<std::string>& missingFiles)
+{
+  // Is it in the source dir or the binary dir?
+  //
+  if (IsFileInDir(sourceFile, cont->SourceDir)) {
+    cmCTestOptionalLog(this->CTest, HANDLER_VERBOSE_OUTPUT,
+                       "   produced s: " << sourceFile << std::endl,
+                       this->Quiet);
+    *cont->OFS << "  produced in source dir: " << sourceFile << std::endl;
+    return cmSystemTools::CollapseFullPath(sourceFile);
+  }
+  if (IsFileInDir(sourceFile, cont->BinaryDir)) {
+    cmCTestOptionalLog(this->CTest, HANDLER_VERBOSE_OUTPUT,
+                       "   produced b: " << sourceFile << std::endl,
+                       this->Quiet);
+    *cont->OFS << "  produced in binary dir: " << sourceFile << std::endl;
+    return cmSystemTools::CollapseFullPath(sourceFile);
+  }
+
+  if (missingFiles.find(sourceFile) == missingFiles.end()) {
+    cmCTestOptionalLog(this->CTest, HANDLER_VERBOSE_OUTPUT,
+                       "Something went wrong" << std::endl, this->Quiet);
+    cmCTestOptionalLog(this->CTest, HANDLER_VERBOSE_OUTPUT,
+                       "Cannot find file: [" << sourceFile << "]"
+                                             << std::endl,
+                       this->Quiet);
+    cmCTestOptionalLog(this->CTest, HANDLER_VERBOSE_OUTPUT,
+                       " in source dir: [" << cont->SourceDir << "]"
+                                           << std::endl,
+                       this->Quiet);
+    cmCTestOptionalLog(this->CTest, HANDLER_VERBOSE_OUTPUT,
+                       " or binary dir: [" << cont->BinaryDir.size() << "]"
+                                           << std::endl,
+                       this->Quiet);
+    *cont->OFS << "  Something went wrong. Cannot find file: " << sourceFile
+               << " in source dir: " << cont->SourceDir
+               << " or binary dir: " << cont->BinaryDir << std::endl;
+
+    missingFiles.insert(sourceFile);
+  }
+  return std::string();
+}
+
+void cmCTestCoverageHandler::HandleGCovJSON(
+  cmCTestCoverageHandlerContainer* cont, std::string const& output,
+  std::set<std::string>& missingFiles)
+{
+  // gcov writes one JSON document per line, one for each data file.
+  std::string::size_type pos = 0;
+  while (pos < output.size()) {
+    std::string::size_type end = output.find('\n', pos);
+    if (end == std::string::npos) {
+      end = output.size();
+    }
+    std::string const document = output.substr(pos, end - pos);
+    pos = end + 1;
+    if (cmTrimWhitespace(document).empty()) {
+      continue;
+    }
+
+    Json::Value json;
+    Json::Reader reader;
+    if (!reader.parse(document, json) || !json.isObject()) {
+      cmCTestLog(this->CTest, ERROR_MESSAGE,
+                 "Cannot parse gcov JSON output:\n"
+                   << reader.getFormattedErrorMessages() << std::endl);
+      cont->Error++;
+      continue;
+    }
+
+    // Source files are named relative to the directory of the compiler.
+    std::string const workingDirectory =
+      json["current_working_directory"].asString();
+    for (Json::Value const& file : json["files"]) {
+      std::string const sourceFile = cmSystemTools::CollapseFullPath(
+        file["file"].asString(), workingDirectory);
+      std::string const actualSourceFile =
+        this->FindGCovSourceFile(cont, sourceFile, missingFiles);
+      if (actualSourceFile.empty()) {
+        continue;
+      }
+
+      cmCTestCoverageHandlerContainer::SingleFileCoverageVector& vec =
+        cont->TotalCoverage[actualSourceFile];
+      for (Json::Value const& line : file["lines"]) {
+        int lineIdx = line["line_number"].asInt() - 1;
+        if (lineIdx < 0) {
+          continue;
+        }
+        Json::LargestInt const count =
+          std::max<Json::LargestInt>(line["count"].asLargestInt(), 0);
+        int cov = static_cast<int>(std::min<Json::LargestInt>(
+          count, std::numeric_limits<int>::max()));
+        while (vec.size() <= static_cast<size_t>(lineIdx)) {
+          vec.push_back(-1);
+        }
+
+        // Lines listed are executable, so they are covered at least zero
+        // times.
+        if (vec[lineIdx] < 0) {
+          vec[lineIdx] = 0;
+        }
+        vec[lineIdx] += cov;
+      }
+    }
+  }
+}
+
 int cmCTestCoverageHandler::HandleLCovCoverage(
   cmCTestCoverageHandlerContainer* cont)
 {
@@ -69,6 +69,12 @@ private:
   //! Handle coverage using GCC's GCov
   int HandleGCovCoverage(cmCTestCoverageHandlerContainer* cont);
   void FindGCovFiles(std::vector<std::string>& files);
+  std::string FindGCovSourceFile(cmCTestCoverageHandlerContainer* cont,
+                                 std::string const& sourceFile,
+                                 std::set<std::string>& missingFiles);
+  void HandleGCovJSON(cmCTestCoverageHandlerContainer* cont,
+                      std::string const& output,
+                      std::set<std::string>& missingFiles);
 
   //! Handle coverage using Intel's LCov
   int HandleLCovCoverage(cmCTestCoverageHandlerContainer* cont);
@@ -628,6 +628,30 @@ bool cmCTestGIT::LoadRevisions()
   return true;
 }
 
+bool cmCTestGIT::GetChangedFiles(std::string const& revisions,
+                                 std::vector<std::string>& files)
+{
+  std::string git = this->CommandLineTool;
+  std::string const top_dir = this->FindTopDir();
+
+  // Use 'git diff --raw' to get the changed files.  A rename changes
+  // both its source and its destination.
+  std::vector<std::string> git_diff = {
+    git, "diff", "--raw", "-z", "--no-ext-diff", revisions, "--"
+  };
+  DiffParser out(this, "diff-out> ");
+  OutputLogger err(this->Log, "diff-err> ");
+  if (!this->RunChild(git_diff, &out, &err, top_dir,
+                      cmProcessOutput::UTF8)) {
+    return false;
+  }
+
+  for (Change const& c : out.Changes) {
+    files.push_back(cmStrCat(top_dir, '/', c.Path));
+  }
+  return true;
+}
+
 bool cmCTestGIT::LoadModifications()
 {
   std::string git = this->CommandLineTool;
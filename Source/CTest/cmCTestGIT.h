@@ -6,6 +6,7 @@
 
 #include <iosfwd>
 #include <string>
+#include <vector>
 
 #include "cmCTestGlobalVC.h"
 
@@ -23,6 +24,11 @@ public:
 
   ~cmCTestGIT() override;
 
+  /** Get the full paths of the files that differ between the revisions
+      given as to 'git diff', such as a commit or a range of commits.  */
+  bool GetChangedFiles(std::string const& revisions,
+                       std::vector<std::string>& files);
+
 private:
   unsigned int CurrentGitVersion;
   unsigned int GetGitVersion();
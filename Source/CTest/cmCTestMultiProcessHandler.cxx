@@ -33,11 +33,12 @@
 #include "cmCTest.h"
 #include "cmCTestBinPacker.h"
 #include "cmCTestRunTest.h"
+#include "cmCTestSystemPressure.h"
+#include "cmCTestTestEventStream.h"
 #include "cmCTestTestHandler.h"
 #include "cmDuration.h"
 #include "cmJSONState.h"
 #include "cmListFileCache.h"
-#include "cmRange.h"
 #include "cmStringAlgorithms.h"
 #include "cmSystemTools.h"
 #include "cmUVJobServerClient.h"
@@ -52,6 +53,13 @@ constexpr unsigned long kParallelLevelMinimum = 2u;
 // Under a job server, parallelism is effectively limited
 // only by available job server tokens.
 constexpr unsigned long kParallelLevelUnbounded = 0x10000u;
+
+// Estimated duration in seconds of tests with no recorded cost.
+constexpr double kMinimumEstimatedDuration = 1e-3;
+
+// Fraction of the cgroup memory limit above which memory is considered
+// under pressure.
+constexpr double kMemoryUsageHigh = 0.9;
 }
 
 namespace cmsys {
@@ -140,7 +148,8 @@ void cmCTestMultiProcessHandler::SetParallelLevel(cm::optional<size_t> level)
 size_t cmCTestMultiProcessHandler::GetParallelLevel() const
 {
   if ((this->ParallelLevel && *this->ParallelLevel == 0) ||
-      (!this->ParallelLevel && this->JobServerClient)) {
+      (!this->ParallelLevel && this->JobServerClient) ||
+      !this->ShardEndpoint.empty()) {
     return kParallelLevelUnbounded;
   }
   if (this->ParallelLevel) {
@@ -163,6 +172,98 @@ void cmCTestMultiProcessHandler::SetTestLoad(unsigned long load)
   }
 }
 
+void cmCTestMultiProcessHandler::SetTestPressure(double threshold)
+{
+  this->TestPressure = threshold;
+
+  std::string root;
+  cmSystemTools::GetEnv("__CTEST_FAKE_PRESSURE_ROOT_FOR_TESTING", root);
+  this->Pressure = cm::make_unique<cmCTestSystemPressure>(root);
+}
+
+size_t cmCTestMultiProcessHandler::GetPressureParallelLevel(size_t limit)
+{
+  // The stall times only change meaningfully over a second or so.
+  auto const now = std::chrono::steady_clock::now();
+  if (this->PressureParallelLevel != 0 &&
+      now - this->LastPressureSample < std::chrono::seconds(1)) {
+    return std::min(this->PressureParallelLevel, limit);
+  }
+  this->LastPressureSample = now;
+  cmCTestSystemPressure::Sample const sample = this->Pressure->Take();
+
+  size_t level = this->PressureParallelLevel;
+  if (level == 0) {
+    if (limit < kParallelLevelUnbounded) {
+      level = limit;
+    } else {
+      cmsys::SystemInformation info;
+      info.RunCPUCheck();
+      level = info.GetNumberOfLogicalCPU();
+    }
+  }
+
+  // Back off quickly while tasks stall, and recover slowly while the
+  // tests use all the processors they may.
+  double const threshold = *this->TestPressure;
+  double stall = 0;
+  std::ostringstream report;
+  for (auto const& resource :
+       { std::make_pair("cpu", sample.Cpu),
+         std::make_pair("memory", sample.Memory),
+         std::make_pair("io", sample.Io) }) {
+    if (resource.second) {
+      stall = std::max(stall, *resource.second);
+      report << resource.first << ' ' << std::fixed << std::setprecision(1)
+             << *resource.second << "%, ";
+    }
+  }
+  if (stall > threshold) {
+    level -= std::min(level, std::max<size_t>(1, level / 4));
+  } else if (stall < threshold / 2 && this->RunningCount >= level) {
+    ++level;
+  }
+
+  // Never use more processors than the cgroup may.
+  size_t cap = limit;
+  if (sample.CpuLimit) {
+    cap = std::min(
+      cap, std::max<size_t>(1, static_cast<size_t>(ceil(*sample.CpuLimit))));
+  }
+  level = std::max<size_t>(1, std::min(level, cap));
+
+  this->MemoryPressure = (sample.Memory && *sample.Memory > threshold) ||
+    (sample.MemoryUsage && *sample.MemoryUsage > kMemoryUsageHigh);
+  if (sample.MemoryUsage) {
+    report << "memory usage " << std::fixed << std::setprecision(1)
+           << *sample.MemoryUsage * 100 << "%, ";
+  }
+
+  if (level != this->PressureParallelLevel) {
+    cmCTestLog(this->CTest, HANDLER_VERBOSE_OUTPUT,
+               "System pressure: " << report.str() << "running up to "
+                                   << level << " processors at once"
+                                   << std::endl);
+  }
+  this->PressureParallelLevel = level;
+  return level;
+}
+
+bool cmCTestMultiProcessHandler::IsMemoryHeavy(int test) const
+{
+  auto const& groups = this->Properties.at(test)->ResourceGroups;
+  return std::any_of(
+    groups.begin(), groups.end(),
+    [](std::vector<cmCTestTestHandler::cmCTestTestResourceRequirement> const&
+         group) {
+      return std::any_of(
+        group.begin(), group.end(),
+        [](cmCTestTestHandler::cmCTestTestResourceRequirement const& r) {
+          return r.ResourceType == "memory";
+        });
+    });
+}
+
 bool cmCTestMultiProcessHandler::Complete()
 {
   return this->Completed == this->Total;
@@ -174,6 +275,16 @@ void cmCTestMultiProcessHandler::InitializeLoop()
   this->StartNextTestsOnIdle_.init(*this->Loop, this);
   this->StartNextTestsOnTimer_.init(*this->Loop, this);
 
+  if (!this->ShardEndpoint.empty()) {
+    // The shard workers limit how many tests run at once.
+    this->ShardCoordinator = cm::make_unique<cmCTestShardCoordinator>(
+      this->CTest, this->ShardEndpoint);
+    this->ShardCoordinator->Listen(
+      *this->Loop,
+      /*onGrant=*/[this](int test) { this->StartTestProcess(test); });
+    return;
+  }
+
   this->JobServerClient = cmUVJobServerClient::Connect(
     *this->Loop, /*onToken=*/[this]() { this->JobServerReceivedToken(); },
     /*onDisconnect=*/nullptr);
@@ -186,6 +297,7 @@ void cmCTestMultiProcessHandler::InitializeLoop()
 void cmCTestMultiProcessHandler::FinalizeLoop()
 {
   this->JobServerClient.reset();
+  this->ShardCoordinator.reset();
   this->StartNextTestsOnTimer_.reset();
   this->StartNextTestsOnIdle_.reset();
   this->Loop.reset();
@@ -199,11 +311,28 @@ void cmCTestMultiProcessHandler::RunTests()
   }
   this->TestHandler->SetMaxIndex(this->FindMaxIndex());
 
+  if (!this->TestEventsFile.empty()) {
+    this->TestEvents = cm::make_unique<cmCTestTestEventStream>();
+    if (this->TestEvents->Open(this->TestEventsFile)) {
+      this->TestEvents->RunStarted(this->Total);
+    } else {
+      cmCTestLog(this->CTest, ERROR_MESSAGE,
+                 "Problem opening test events file: " << this->TestEventsFile
+                                                       << std::endl);
+      this->TestEvents.reset();
+    }
+  }
+
   this->InitializeLoop();
   this->StartNextTestsOnIdle();
   uv_run(this->Loop, UV_RUN_DEFAULT);
   this->FinalizeLoop();
 
+  if (this->TestEvents) {
+    this->TestEvents->RunFinished();
+    this->TestEvents.reset();
+  }
+
   if (!this->StopTimePassed && !this->CheckStopOnFailure()) {
     assert(this->Complete());
     assert(this->PendingTests.empty());
@@ -321,6 +450,10 @@ bool cmCTestMultiProcessHandler::AllocateResources(int index)
     }
   }
 
+  if (this->TestEvents) {
+    this->TestEvents->TestResourcesAllocated(*this->Properties[index],
+                                             allocatedResources);
+  }
   return true;
 }
 
@@ -523,7 +656,11 @@ std::string cmCTestMultiProcessHandler::GetName(int test)
 
 void cmCTestMultiProcessHandler::StartTest(int test)
 {
-  if (this->JobServerClient) {
+  if (this->ShardCoordinator) {
+    // Run the test when a shard worker has a slot for it.
+    this->ShardCoordinator->RequestSlots(
+      test, static_cast<size_t>(this->Properties[test]->Processors));
+  } else if (this->JobServerClient) {
     // There is a job server.  Request a token and queue the test to run
     // when a token is received.  Note that if we do not get a token right
     // away it's possible that the system load will be higher when the
@@ -560,7 +697,15 @@ void cmCTestMultiProcessHandler::StartNextTests()
 
   size_t numToStart = 0;
 
-  size_t const parallelLevel = this->GetParallelLevel();
+  size_t parallelLevel = this->GetParallelLevel();
+  if (this->Pressure) {
+    size_t const limit = parallelLevel;
+    parallelLevel = this->GetPressureParallelLevel(limit);
+    if (parallelLevel < limit || this->MemoryPressure) {
+      // Sample the pressure again later even if no test finishes.
+      this->StartNextTestsOnTimer();
+    }
+  }
   if (this->RunningCount < parallelLevel) {
     numToStart = parallelLevel - this->RunningCount;
   }
@@ -648,10 +793,21 @@ void cmCTestMultiProcessHandler::StartNextTests()
     }
 
     // Exclude tests that are too big to fit in the concurrency limit.
+    // A limit lowered by pressure still lets a test run on its own.
+    if (this->Pressure && this->RunningCount == 0) {
+      processors = std::min(processors, numToStart);
+    }
     if (processors > numToStart) {
       continue;
     }
 
+    // Hold back tests that need memory while memory is under pressure,
+    // unless nothing else runs.
+    if (this->MemoryPressure && this->RunningCount > 0 &&
+        this->IsMemoryHeavy(test)) {
+      continue;
+    }
+
     // Exclude tests that depend on currently-locked project resources.
     if (!this->ResourceLocksAvailable(test)) {
       continue;
@@ -749,6 +905,9 @@ void cmCTestMultiProcessHandler::FinishTestProcess(
   if (testResult.StopTimePassed) {
     this->SetStopTimePassed();
   }
+  if (this->TestEvents) {
+    this->TestEvents->TestFinished(runner->GetTestResults());
+  }
   if (started) {
     if (!this->StopTimePassed &&
         cmCTestRunTest::StartAgain(std::move(runner), this->Completed)) {
@@ -776,6 +935,9 @@ void cmCTestMultiProcessHandler::FinishTestProcess(
   if (this->JobServerClient) {
     this->JobServerClient->ReleaseToken();
   }
+  if (this->ShardCoordinator) {
+    this->ShardCoordinator->ReleaseSlots(test);
+  }
   this->StartNextTestsOnIdle();
 }
 
@@ -806,15 +968,19 @@ void cmCTestMultiProcessHandler::UpdateCostData()
       std::string name = parts[0];
       int prev = atoi(parts[1].c_str());
       float cost = static_cast<float>(atof(parts[2].c_str()));
+      float variance =
+        parts.size() > 3 ? static_cast<float>(atof(parts[3].c_str())) : 0;
 
       int index = this->SearchByName(name);
       if (index == -1) {
         // This test is not in memory. We just rewrite the entry
-        fout << name << " " << prev << " " << cost << "\n";
+        fout << name << " " << prev << " " << cost << " " << variance
+             << "\n";
       } else {
         // Update with our new average cost
         fout << name << " " << this->Properties[index]->PreviousRuns << " "
-             << this->Properties[index]->Cost << "\n";
+             << this->Properties[index]->Cost << " "
+             << this->Properties[index]->CostVariance << "\n";
         temp.erase(index);
       }
     }
@@ -825,7 +991,7 @@ void cmCTestMultiProcessHandler::UpdateCostData()
   // Add all tests not previously listed in the file
   for (auto const& i : temp) {
     fout << i.second->Name << " " << i.second->PreviousRuns << " "
-         << i.second->Cost << "\n";
+         << i.second->Cost << " " << i.second->CostVariance << "\n";
   }
 
   // Write list of failed tests
@@ -858,9 +1024,12 @@ void cmCTestMultiProcessHandler::ReadCostData()
         return;
       }
 
+      // Format: <name> <previous_runs> <avg_cost> [<cost_variance>]
       std::string name = parts[0];
       int prev = atoi(parts[1].c_str());
       float cost = static_cast<float>(atof(parts[2].c_str()));
+      float variance =
+        parts.size() > 3 ? static_cast<float>(atof(parts[3].c_str())) : 0;
 
       int index = this->SearchByName(name);
       if (index == -1) {
@@ -872,6 +1041,7 @@ void cmCTestMultiProcessHandler::ReadCostData()
       if (this->GetParallelLevel() > 1 && this->Properties[index] &&
           this->Properties[index]->Cost == 0) {
         this->Properties[index]->Cost = cost;
+        this->Properties[index]->CostVariance = variance;
       }
     }
     // Next part of the file is the failed tests
@@ -908,10 +1078,7 @@ void cmCTestMultiProcessHandler::CreateTestCostList()
 void cmCTestMultiProcessHandler::CreateParallelTestCostList()
 {
   TestSet alreadyOrderedTests;
-
-  std::list<TestSet> priorityStack;
-  priorityStack.emplace_back();
-  TestSet& topLevel = priorityStack.back();
+  TestList remainingTests;
 
   // In parallel test runs add previously failed tests to the front
   // of the cost list and queue other tests for further sorting
@@ -921,46 +1088,89 @@ void cmCTestMultiProcessHandler::CreateParallelTestCostList()
       this->OrderedTests.push_back(t.first);
       alreadyOrderedTests.insert(t.first);
     } else {
-      topLevel.insert(t.first);
+      remainingTests.push_back(t.first);
     }
   }
 
-  // In parallel test runs repeatedly move dependencies of the tests on
-  // the current dependency level to the next level until no
-  // further dependencies exist.
-  while (!priorityStack.back().empty()) {
-    TestSet& previousSet = priorityStack.back();
-    priorityStack.emplace_back();
-    TestSet& currentSet = priorityStack.back();
+  // Prefer the tests at the head of the longest remaining chain of
+  // dependent tests, so that the critical path starts as early as possible.
+  // Among equally urgent tests prefer those occupying the most processor
+  // time, which packs tests needing several processors first.
+  std::map<int, double> const criticalPath =
+    this->ComputeCriticalPathLengths();
+  std::stable_sort(
+    remainingTests.begin(), remainingTests.end(), [&](int a, int b) {
+      double const pathA = criticalPath.at(a);
+      double const pathB = criticalPath.at(b);
+      if (pathA != pathB) {
+        return pathA > pathB;
+      }
+      return this->GetEstimatedDuration(a) *
+        static_cast<double>(this->GetProcessorsUsed(a)) >
+        this->GetEstimatedDuration(b) *
+        static_cast<double>(this->GetProcessorsUsed(b));
+    });
+  cm::append(this->OrderedTests, remainingTests);
+}
 
-    for (auto const& i : previousSet) {
-      TestSet const& dependencies = this->PendingTests[i].Depends;
-      currentSet.insert(dependencies.begin(), dependencies.end());
-    }
+double cmCTestMultiProcessHandler::GetEstimatedDuration(int test)
+{
+  auto const* p = this->Properties[test];
+  // Tests with unstable durations are estimated pessimistically so that
+  // a slow run does not end up in the tail of the schedule.  Tests
+  // without any history still contribute to the length of a chain.
+  double const estimate = static_cast<double>(p->Cost) +
+    std::sqrt(static_cast<double>(p->CostVariance));
+  return std::max(estimate, kMinimumEstimatedDuration);
+}
 
-    for (auto const& i : currentSet) {
-      previousSet.erase(i);
+std::map<int, double> cmCTestMultiProcessHandler::ComputeCriticalPathLengths()
+{
+  // Count the pending tests depending on each test.
+  std::map<int, size_t> dependents;
+  for (auto const& t : this->PendingTests) {
+    dependents.emplace(t.first, 0);
+  }
+  for (auto const& t : this->PendingTests) {
+    for (int d : t.second.Depends) {
+      auto i = dependents.find(d);
+      if (i != dependents.end()) {
+        ++i->second;
+      }
     }
   }
 
-  // Remove the empty dependency level
-  priorityStack.pop_back();
-
-  // Reverse iterate over the different dependency levels (deepest first).
-  // Sort tests within each level by COST and append them to the cost list.
-  for (TestSet const& currentSet : cmReverseRange(priorityStack)) {
-    TestList sortedCopy;
-    cm::append(sortedCopy, currentSet);
-    std::stable_sort(sortedCopy.begin(), sortedCopy.end(),
-                     TestComparator(this));
-
-    for (auto const& j : sortedCopy) {
-      if (!cm::contains(alreadyOrderedTests, j)) {
-        this->OrderedTests.push_back(j);
-        alreadyOrderedTests.insert(j);
+  // Visit each test after all tests depending on it.  The length of its
+  // critical path is its own estimated duration plus the longest path
+  // through the tests depending on it.  CheckCycles has already ruled
+  // out cycles, so every test is visited.
+  std::map<int, double> pathLengths;
+  std::map<int, double> longestDependentPath;
+  std::stack<int> ready;
+  for (auto const& d : dependents) {
+    if (d.second == 0) {
+      ready.push(d.first);
+    }
+  }
+  while (!ready.empty()) {
+    int const test = ready.top();
+    ready.pop();
+    double const length =
+      this->GetEstimatedDuration(test) + longestDependentPath[test];
+    pathLengths[test] = length;
+    for (int d : this->PendingTests[test].Depends) {
+      auto i = dependents.find(d);
+      if (i == dependents.end()) {
+        continue;
+      }
+      double& longest = longestDependentPath[d];
+      longest = std::max(longest, length);
+      if (--i->second == 0) {
+        ready.push(d);
       }
     }
   }
+  return pathLengths;
 }
 
 void cmCTestMultiProcessHandler::GetAllTestDependencies(int test,
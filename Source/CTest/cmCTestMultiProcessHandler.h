@@ -4,6 +4,7 @@
 
 #include "cmConfigure.h" // IWYU pragma: keep
 
+#include <chrono>
 #include <cstddef>
 #include <list>
 #include <map>
@@ -17,12 +18,15 @@
 #include "cmCTest.h"
 #include "cmCTestResourceAllocator.h"
 #include "cmCTestResourceSpec.h"
+#include "cmCTestShardCoordinator.h"
 #include "cmCTestTestHandler.h"
 #include "cmUVHandlePtr.h"
 #include "cmUVJobServerClient.h"
 
 struct cmCTestBinPackerAllocation;
 class cmCTestRunTest;
+class cmCTestSystemPressure;
+class cmCTestTestEventStream;
 
 /** \class cmCTestMultiProcessHandler
  * \brief run parallel ctest
@@ -65,6 +69,8 @@ public:
   // Set the max number of tests that can be run at the same time.
   void SetParallelLevel(cm::optional<size_t> level);
   void SetTestLoad(unsigned long load);
+  // Adapt the number of tests run at once to the pressure on the system.
+  void SetTestPressure(double threshold);
   virtual void RunTests();
   void PrintOutputAsJson();
   void PrintTestList();
@@ -94,6 +100,16 @@ public:
     this->ResourceSpecFile = resourceSpecFile;
   }
 
+  void SetShardCoordinator(std::string const& endpoint)
+  {
+    this->ShardEndpoint = endpoint;
+  }
+
+  void SetTestEventsFile(std::string const& file)
+  {
+    this->TestEventsFile = file;
+  }
+
   void SetQuiet(bool b) { this->Quiet = b; }
 
   void CheckResourceAvailability();
@@ -118,6 +134,10 @@ protected:
   void CreateSerialTestCostList();
 
   void CreateParallelTestCostList();
+  double GetEstimatedDuration(int test);
+  // Length of the longest chain of estimated durations from each pending
+  // test through the tests that depend on it.
+  std::map<int, double> ComputeCriticalPathLengths();
 
   // Removes the checkpoint file
   void MarkFinished();
@@ -220,8 +240,31 @@ private:
   // Callback invoked when a token is received.
   void JobServerReceivedToken();
 
+  // Endpoint on which to listen for shard workers, if any.  If set, the
+  // processes of tests run on the workers that connect to it.
+  std::string ShardEndpoint;
+  std::unique_ptr<cmCTestShardCoordinator> ShardCoordinator;
+
+  // File to which the events of the run are written as they happen, if
+  // any.
+  std::string TestEventsFile;
+  std::unique_ptr<cmCTestTestEventStream> TestEvents;
+
   unsigned long TestLoad = 0;
   unsigned long FakeLoadForTesting = 0;
+
+  // Get the number of processors the pressure on the system allows tests
+  // to use at once, at most the given limit.
+  size_t GetPressureParallelLevel(size_t limit);
+  // Whether a test asks for memory in its resource groups.
+  bool IsMemoryHeavy(int test) const;
+
+  // Stall percentage above which fewer tests run at once, if any.
+  cm::optional<double> TestPressure;
+  std::unique_ptr<cmCTestSystemPressure> Pressure;
+  size_t PressureParallelLevel = 0;
+  bool MemoryPressure = false;
+  std::chrono::steady_clock::time_point LastPressureSample;
   cm::uv_loop_ptr Loop;
   cm::uv_idle_ptr StartNextTestsOnIdle_;
   cm::uv_timer_ptr StartNextTestsOnTimer_;
@@ -0,0 +1,178 @@
+/* Distributed under the OSI-approved BSD 3-Clause License.  See accompanying
+   file Copyright.txt or https://cmake.org/licensing for details.  */
+#include "cmCTestOutputCapture.h"
+
+#include <algorithm>
+#include <ios>
+#include <ostream>
+#include <sstream>
+#include <utility>
+
+#include <cm/memory>
+
+#include "cmSystemTools.h"
+
+namespace {
+// Bytes kept beyond the limit at both ends.  Truncating the output must
+// not split a UTF-8 encoded character, so the truncation looks at a few
+// bytes around the cut to find the character boundaries.
+std::size_t const kContextSize = 8;
+}
+
+cmCTestOutputCapture::~cmCTestOutputCapture()
+{
+  this->RemoveSpill();
+}
+
+void cmCTestOutputCapture::Start(std::size_t limit, std::string spillFile)
+{
+  this->RemoveSpill();
+  this->Capacity = limit ? limit + kContextSize : 0;
+  this->Text.clear();
+  this->Ring.clear();
+  this->RingStart = 0;
+  this->RingSize = 0;
+  this->Dropped = 0;
+  this->HeadSize = 0;
+  this->SpillFile = std::move(spillFile);
+  this->SpillFailed = false;
+}
+
+void cmCTestOutputCapture::Append(cm::string_view text)
+{
+  // Fill the head first.
+  if (this->Capacity == 0 || this->Text.size() < this->Capacity) {
+    std::size_t n = this->Capacity == 0
+      ? text.size()
+      : std::min(text.size(), this->Capacity - this->Text.size());
+    this->Text.append(text.data(), n);
+    text.remove_prefix(n);
+  }
+  if (text.empty()) {
+    return;
+  }
+
+  // The rest goes into the ring, spilling the oldest bytes.
+  if (this->Ring.empty()) {
+    this->Ring.resize(this->Capacity);
+  }
+  if (text.size() >= this->Capacity) {
+    this->SpillRing(this->RingSize);
+    this->Spill(text.substr(0, text.size() - this->Capacity));
+    text.remove_prefix(text.size() - this->Capacity);
+    std::copy(text.begin(), text.end(), this->Ring.begin());
+    this->RingStart = 0;
+    this->RingSize = this->Capacity;
+    return;
+  }
+  if (this->RingSize + text.size() > this->Capacity) {
+    this->SpillRing(this->RingSize + text.size() - this->Capacity);
+  }
+  std::size_t end = (this->RingStart + this->RingSize) % this->Capacity;
+  std::size_t first = std::min(text.size(), this->Capacity - end);
+  std::copy(text.begin(), text.begin() + first, this->Ring.begin() + end);
+  std::copy(text.begin() + first, text.end(), this->Ring.begin());
+  this->RingSize += text.size();
+}
+
+void cmCTestOutputCapture::KeepAll()
+{
+  if (this->Capacity == 0) {
+    return;
+  }
+  this->Capacity = 0;
+  std::string text = this->Finish();
+  this->Text = this->GetFull(text);
+  this->RemoveSpill();
+  this->Dropped = 0;
+}
+
+std::string cmCTestOutputCapture::Finish()
+{
+  this->HeadSize = this->Text.size();
+  std::size_t first =
+    std::min(this->RingSize, this->Ring.size() - this->RingStart);
+  this->Text.append(this->Ring.data() + this->RingStart, first);
+  this->Text.append(this->Ring.data(), this->RingSize - first);
+  this->Ring.clear();
+  this->Ring.shrink_to_fit();
+  this->RingStart = 0;
+  this->RingSize = 0;
+  if (this->SpillStream) {
+    this->SpillStream->close();
+    this->SpillFailed = this->SpillFailed || this->SpillStream->fail();
+    this->SpillStream.reset();
+  }
+  std::string text;
+  text.swap(this->Text);
+  return text;
+}
+
+void cmCTestOutputCapture::WriteFull(std::ostream& os,
+                                     std::string const& text) const
+{
+  if (!this->Dropped) {
+    os << text;
+    return;
+  }
+  os.write(text.data(), static_cast<std::streamsize>(this->HeadSize));
+  cmsys::ifstream fin;
+  if (!this->SpillFailed) {
+    fin.open(this->SpillFile.c_str(), std::ios::in | std::ios::binary);
+  }
+  if (fin.is_open()) {
+    os << fin.rdbuf();
+  } else {
+    os << "\n[" << this->Dropped
+       << " bytes of the test output could not be kept.]\n";
+  }
+  os.write(text.data() + this->HeadSize,
+           static_cast<std::streamsize>(text.size() - this->HeadSize));
+}
+
+std::string cmCTestOutputCapture::GetFull(std::string const& text) const
+{
+  if (!this->Dropped) {
+    return text;
+  }
+  std::ostringstream os;
+  this->WriteFull(os, text);
+  return os.str();
+}
+
+void cmCTestOutputCapture::SpillRing(std::size_t n)
+{
+  std::size_t first = std::min(n, this->Capacity - this->RingStart);
+  this->Spill(cm::string_view(this->Ring.data() + this->RingStart, first));
+  this->Spill(cm::string_view(this->Ring.data(), n - first));
+  this->RingStart = (this->RingStart + n) % this->Capacity;
+  this->RingSize -= n;
+}
+
+void cmCTestOutputCapture::Spill(cm::string_view text)
+{
+  if (text.empty()) {
+    return;
+  }
+  this->Dropped += text.size();
+  if (this->SpillFailed || this->SpillFile.empty()) {
+    this->SpillFailed = true;
+    return;
+  }
+  if (!this->SpillStream) {
+    this->SpillStream = cm::make_unique<cmsys::ofstream>(
+      this->SpillFile.c_str(), std::ios::out | std::ios::binary);
+  }
+  if (!this->SpillStream->write(text.data(),
+                                static_cast<std::streamsize>(text.size()))) {
+    this->SpillFailed = true;
+  }
+}
+
+void cmCTestOutputCapture::RemoveSpill()
+{
+  this->SpillStream.reset();
+  if (this->Dropped && !this->SpillFile.empty()) {
+    cmSystemTools::RemoveFile(this->SpillFile);
+  }
+}
@@ -0,0 +1,77 @@
+/* Distributed under the OSI-approved BSD 3-Clause License.  See accompanying
+   file Copyright.txt or https://cmake.org/licensing for details.  */
+#pragma once
+
+#include "cmConfigure.h" // IWYU pragma: keep
+
+#include <cstddef>
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <cm/string_view>
+
+#include "cmsys/FStream.hxx"
+
+/** \class cmCTestOutputCapture
+ * \brief Bounded capture of the output of a test.
+ *
+ * With a limit, only the first and the last bytes of the output are kept
+ * in memory, the latter in a fixed-size ring buffer.  The bytes in between
+ * are written to a spill file, if any, so that the full output can still
+ * be written to the log.  The kept text truncates to any size up to the
+ * limit exactly as the full output does.
+ */
+class cmCTestOutputCapture
+{
+public:
+  cmCTestOutputCapture() = default;
+  ~cmCTestOutputCapture();
+
+  cmCTestOutputCapture(cmCTestOutputCapture const&) = delete;
+  cmCTestOutputCapture& operator=(cmCTestOutputCapture const&) = delete;
+
+  /** Start a new capture.  A limit of zero keeps all output in memory.
+      An empty spill file name drops the bytes that are not kept.  */
+  void Start(std::size_t limit, std::string spillFile = std::string());
+
+  void Append(cm::string_view text);
+
+  /** Stop bounding the capture and bring back any output not kept in
+      memory so far.  */
+  void KeepAll();
+
+  /** The captured output, while nothing has been dropped from memory.  */
+  std::string const& GetText() const { return this->Text; }
+
+  /** Whether output has been dropped from memory.  */
+  bool IsTruncated() const { return this->Dropped != 0; }
+
+  /** End the capture and return the text kept in memory.  */
+  std::string Finish();
+
+  /** Write the full output given the text returned by Finish.  */
+  void WriteFull(std::ostream& os, std::string const& text) const;
+  std::string GetFull(std::string const& text) const;
+
+private:
+  void SpillRing(std::size_t n);
+  void Spill(cm::string_view text);
+  void RemoveSpill();
+
+  // Zero if the capture is not bounded.
+  std::size_t Capacity = 0;
+  // The head of the output, or all of it if not bounded.
+  std::string Text;
+  // The tail of the output.
+  std::vector<char> Ring;
+  std::size_t RingStart = 0;
+  std::size_t RingSize = 0;
+  // Number of bytes between the head and the tail.
+  std::size_t Dropped = 0;
+  std::size_t HeadSize = 0;
+  std::string SpillFile;
+  std::unique_ptr<cmsys::ofstream> SpillStream;
+  bool SpillFailed = false;
+};
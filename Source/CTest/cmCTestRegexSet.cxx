@@ -0,0 +1,320 @@
+/* Distributed under the OSI-approved BSD 3-Clause License.  See accompanying
+   file Copyright.txt or https://cmake.org/licensing for details.  */
+#include "cmCTestRegexSet.h"
+
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <utility>
+
+namespace {
+// Parses the syntax of cmsys::RegularExpression to find the literals that
+// any match contains.  An empty list means there are none.
+class LiteralParser
+{
+public:
+  explicit LiteralParser(char const* p)
+    : P(p)
+  {
+  }
+
+  std::vector<std::string> Parse()
+  {
+    std::vector<std::string> literals = this->ParseAlternation();
+    if (this->Failed || *this->P != '\0') {
+      return std::vector<std::string>();
+    }
+    return literals;
+  }
+
+private:
+  static std::size_t Quality(std::vector<std::string> const& literals)
+  {
+    std::size_t quality = 0;
+    for (std::string const& literal : literals) {
+      if (quality == 0 || literal.size() < quality) {
+        quality = literal.size();
+      }
+    }
+    return quality;
+  }
+
+  static void Consider(std::vector<std::string>& best,
+                       std::vector<std::string> candidate)
+  {
+    std::size_t const quality = Quality(candidate);
+    std::size_t const bestQuality = Quality(best);
+    if (quality > bestQuality ||
+        (quality == bestQuality && quality != 0 &&
+         candidate.size() < best.size())) {
+      best = std::move(candidate);
+    }
+  }
+
+  char SkipQuantifier()
+  {
+    char const q = *this->P;
+    if (q == '*' || q == '?' || q == '+') {
+      ++this->P;
+      return q;
+    }
+    return '\0';
+  }
+
+  std::vector<std::string> ParseAlternation()
+  {
+    std::vector<std::string> literals;
+    bool any = true;
+    for (;;) {
+      std::vector<std::string> branch = this->ParseBranch();
+      if (branch.empty()) {
+        any = false;
+      }
+      literals.insert(literals.end(), branch.begin(), branch.end());
+      if (*this->P != '|') {
+        break;
+      }
+      ++this->P;
+    }
+    if (!any) {
+      // A branch without literals can match anything.
+      return std::vector<std::string>();
+    }
+    return literals;
+  }
+
+  std::vector<std::string> ParseBranch()
+  {
+    std::vector<std::string> best;
+    std::string run;
+    auto flush = [&best, &run]() {
+      if (!run.empty()) {
+        Consider(best, { run });
+        run.clear();
+      }
+    };
+    while (*this->P != '\0' && *this->P != '|' && *this->P != ')') {
+      char c = *this->P++;
+      switch (c) {
+        case '(': {
+          std::vector<std::string> group = this->ParseAlternation();
+          if (*this->P != ')') {
+            this->Failed = true;
+            return std::vector<std::string>();
+          }
+          ++this->P;
+          flush();
+          char const q = this->SkipQuantifier();
+          if (q == '\0' || q == '+') {
+            Consider(best, std::move(group));
+          }
+          continue;
+        }
+        case '[':
+          if (*this->P == '^') {
+            ++this->P;
+          }
+          if (*this->P == ']') {
+            ++this->P;
+          }
+          while (*this->P != '\0' && *this->P != ']') {
+            ++this->P;
+          }
+          if (*this->P != ']') {
+            this->Failed = true;
+            return std::vector<std::string>();
+          }
+          ++this->P;
+          flush();
+          this->SkipQuantifier();
+          continue;
+        case '.':
+          flush();
+          this->SkipQuantifier();
+          continue;
+        case '^':
+        case '$':
+          flush();
+          continue;
+        case '*':
+        case '?':
+        case '+':
+          // Not valid here, so the expression will not compile.
+          this->Failed = true;
+          return std::vector<std::string>();
+        case '\\':
+          if (*this->P == '\0') {
+            this->Failed = true;
+            return std::vector<std::string>();
+          }
+          c = *this->P++;
+          break;
+        default:
+          break;
+      }
+
+      // A quantifier applies to the last character only.
+      switch (this->SkipQuantifier()) {
+        case '*':
+        case '?':
+          flush();
+          break;
+        case '+':
+          run += c;
+          flush();
+          break;
+        default:
+          run += c;
+          break;
+      }
+    }
+    flush();
+    return best;
+  }
+
+  char const* P;
+  bool Failed = false;
+};
+}
+
+std::vector<std::string> cmCTestRegexSet::GetLiterals(
+  std::string const& pattern)
+{
+  return LiteralParser(pattern.c_str()).Parse();
+}
+
+std::size_t cmCTestRegexSet::Add(std::string const& pattern)
+{
+  Pattern p;
+  p.Regex.compile(pattern);
+  for (std::string const& literal : GetLiterals(pattern)) {
+    auto it =
+      std::find(this->Literals.begin(), this->Literals.end(), literal);
+    p.Literals.push_back(
+      static_cast<std::size_t>(it - this->Literals.begin()));
+    if (it == this->Literals.end()) {
+      this->Literals.push_back(literal);
+    }
+  }
+  this->Patterns.push_back(std::move(p));
+  this->Compiled = false;
+  return this->Patterns.size() - 1;
+}
+
+void cmCTestRegexSet::Clear()
+{
+  this->Patterns.clear();
+  this->Literals.clear();
+  this->Compiled = false;
+  this->Line = nullptr;
+}
+
+void cmCTestRegexSet::Compile()
+{
+  // Map the bytes occurring in literals to classes.
+  std::memset(this->ByteClass, 0, sizeof(this->ByteClass));
+  this->Classes = 1;
+  for (std::string const& literal : this->Literals) {
+    for (char c : literal) {
+      unsigned short& byteClass =
+        this->ByteClass[static_cast<unsigned char>(c)];
+      if (byteClass == 0) {
+        byteClass = static_cast<unsigned short>(this->Classes++);
+      }
+    }
+  }
+
+  // Build the trie of the literals.  State 0 is the root.
+  std::size_t const classes = this->Classes;
+  std::size_t const none = static_cast<std::size_t>(-1);
+  this->Next.assign(classes, none);
+  this->Found.assign(1, std::vector<std::size_t>());
+  for (std::size_t i = 0; i < this->Literals.size(); ++i) {
+    std::size_t state = 0;
+    for (char c : this->Literals[i]) {
+      std::size_t const edge =
+        state * classes + this->ByteClass[static_cast<unsigned char>(c)];
+      if (this->Next[edge] == none) {
+        this->Next[edge] = this->Found.size();
+        this->Found.emplace_back();
+        this->Next.resize(this->Next.size() + classes, none);
+      }
+      state = this->Next[edge];
+    }
+    this->Found[state].push_back(i);
+  }
+
+  // Turn the trie into an automaton, following the failure links of the
+  // states breadth first.
+  std::vector<std::size_t> fail(this->Found.size(), 0);
+  std::deque<std::size_t> queue;
+  for (std::size_t c = 0; c < classes; ++c) {
+    std::size_t& next = this->Next[c];
+    if (next == none) {
+      next = 0;
+    } else {
+      queue.push_back(next);
+    }
+  }
+  while (!queue.empty()) {
+    std::size_t const state = queue.front();
+    queue.pop_front();
+    std::vector<std::size_t> const& inherited = this->Found[fail[state]];
+    this->Found[state].insert(this->Found[state].end(), inherited.begin(),
+                              inherited.end());
+    for (std::size_t c = 0; c < classes; ++c) {
+      std::size_t& next = this->Next[state * classes + c];
+      std::size_t const fallback = this->Next[fail[state] * classes + c];
+      if (next == none) {
+        next = fallback;
+      } else {
+        fail[next] = fallback;
+        queue.push_back(next);
+      }
+    }
+  }
+
+  this->Seen.assign(this->Literals.size(), 0);
+  this->ScanCount = 0;
+  this->Compiled = true;
+}
+
+void cmCTestRegexSet::Scan(std::string const& line)
+{
+  if (!this->Compiled) {
+    this->Compile();
+  }
+  this->Line = &line;
+  ++this->ScanCount;
+
+  std::size_t const classes = this->Classes;
+  std::size_t state = 0;
+  for (char c : line) {
+    state = this->Next[state * classes +
+                       this->ByteClass[static_cast<unsigned char>(c)]];
+    for (std::size_t literal : this->Found[state]) {
+      this->Seen[literal] = this->ScanCount;
+    }
+  }
+}
+
+std::size_t cmCTestRegexSet::Find(std::size_t begin, std::size_t end)
+{
+  if (!this->Line) {
+    return end;
+  }
+  for (std::size_t i = begin; i < end; ++i) {
+    Pattern& p = this->Patterns[i];
+    if (!p.Literals.empty() &&
+        std::none_of(p.Literals.begin(), p.Literals.end(),
+                     [this](std::size_t literal) {
+                       return this->Seen[literal] == this->ScanCount;
+                     })) {
+      continue;
+    }
+    if (p.Regex.find(*this->Line)) {
+      return i;
+    }
+  }
+  return end;
+}
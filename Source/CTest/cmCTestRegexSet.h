@@ -0,0 +1,68 @@
+/* Distributed under the OSI-approved BSD 3-Clause License.  See accompanying
+   file Copyright.txt or https://cmake.org/licensing for details.  */
+#pragma once
+
+#include "cmConfigure.h" // IWYU pragma: keep
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "cmsys/RegularExpression.hxx"
+
+/** \class cmCTestRegexSet
+ * \brief Match a line against many regular expressions at once.
+ *
+ * Most regular expressions can only match text that contains one of a
+ * few literal strings.  The literals of all expressions in the set are
+ * compiled into one automaton, which scans a line once to find those that
+ * occur in it.  Only expressions whose literals occur, or that have none,
+ * are then tried on the line.  The results are those of trying each
+ * expression in turn.
+ */
+class cmCTestRegexSet
+{
+public:
+  /** Add an expression to the set.  Returns its index.  */
+  std::size_t Add(std::string const& pattern);
+
+  std::size_t Size() const { return this->Patterns.size(); }
+  void Clear();
+
+  /** Scan a line for the literals of the expressions.  The line must
+      stay valid while Find is called for it.  */
+  void Scan(std::string const& line);
+
+  /** Index of the first expression in [begin, end) that matches the line
+      scanned last, or end if there is none.  */
+  std::size_t Find(std::size_t begin, std::size_t end);
+
+  /** Literals one of which any match of an expression contains, or none
+      if there are no such literals.  */
+  static std::vector<std::string> GetLiterals(std::string const& pattern);
+
+private:
+  struct Pattern
+  {
+    cmsys::RegularExpression Regex;
+    std::vector<std::size_t> Literals;
+  };
+
+  void Compile();
+
+  std::vector<Pattern> Patterns;
+  std::vector<std::string> Literals;
+
+  // The automaton over the literals.  Bytes are mapped to classes, of
+  // which class 0 holds the bytes that occur in no literal.
+  bool Compiled = false;
+  unsigned short ByteClass[256];
+  std::size_t Classes = 0;
+  std::vector<std::size_t> Next;
+  std::vector<std::vector<std::size_t>> Found;
+
+  // The scan in which each literal was seen last.
+  std::vector<std::size_t> Seen;
+  std::size_t ScanCount = 0;
+  std::string const* Line = nullptr;
+};
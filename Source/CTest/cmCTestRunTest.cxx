@@ -18,9 +18,12 @@
 
 #include "cmsys/RegularExpression.hxx"
 
+#include <cm3p/uv.h>
+
 #include "cmCTest.h"
 #include "cmCTestMemCheckHandler.h"
 #include "cmCTestMultiProcessHandler.h"
+#include "cmCTestTestEventStream.h"
 #include "cmDuration.h"
 #include "cmProcess.h"
 #include "cmStringAlgorithms.h"
@@ -74,13 +77,23 @@ void cmCTestRunTest::CheckOutput(std::string const& line)
     }
   }
 
-  this->ProcessOutput += line;
-  this->ProcessOutput += "\n";
+  // Truncation and measurements need all of the output if it has these.
+  if (line.find("CTEST_FULL_OUTPUT") != std::string::npos ||
+      line.find("<DartMeasurement") != std::string::npos ||
+      line.find("<CTestMeasurement") != std::string::npos) {
+    this->OutputCapture.KeepAll();
+  }
+  this->OutputCapture.Append(line);
+  this->OutputCapture.Append("\n");
+  if (this->MultiTestHandler.TestEvents) {
+    this->MultiTestHandler.TestEvents->TestOutput(*this->TestProperties,
+                                                  cmStrCat(line, '\n'));
+  }
 
   // Check for TIMEOUT_AFTER_MATCH property.
   if (!this->TestProperties->TimeoutRegularExpressions.empty()) {
     for (auto& reg : this->TestProperties->TimeoutRegularExpressions) {
-      if (reg.first.find(this->ProcessOutput)) {
+      if (reg.first.find(this->OutputCapture.GetText())) {
         cmCTestLog(this->CTest, HANDLER_VERBOSE_OUTPUT,
                    this->GetIndex()
                      << ": "
@@ -103,6 +116,7 @@ cmCTestRunTest::EndTestResult cmCTestRunTest::EndTest(size_t completed,
                                                       size_t total,
                                                       bool started)
 {
+  this->ProcessOutput = this->OutputCapture.Finish();
   this->WriteLogOutputTop(completed, total);
   std::string reason;
   bool passed = true;
@@ -273,7 +287,8 @@ cmCTestRunTest::EndTestResult cmCTestRunTest::EndTest(size_t completed,
   }
 
   if (outputTestErrorsToConsole) {
-    cmCTestLog(this->CTest, HANDLER_OUTPUT, this->ProcessOutput << std::endl);
+    cmCTestLog(this->CTest, HANDLER_OUTPUT,
+               this->OutputCapture.GetFull(this->ProcessOutput) << std::endl);
   }
 
   if (!resourceSpecParseError.empty()) {
@@ -372,7 +387,7 @@ cmCTestRunTest::EndTestResult cmCTestRunTest::EndTest(size_t completed,
   // If the test does not need to rerun push the current TestResult onto the
   // TestHandler vector
   if (!this->NeedsToRepeat()) {
-    this->TestHandler->TestResults.push_back(this->TestResult);
+    this->TestHandler->RecordTestResult(this->TestResult);
   }
   cmCTestRunTest::EndTestResult testResult;
   testResult.Passed = passed || skipped;
@@ -439,11 +454,16 @@ void cmCTestRunTest::ComputeWeightedCost()
 {
   double prev = static_cast<double>(this->TestProperties->PreviousRuns);
   double avgcost = static_cast<double>(this->TestProperties->Cost);
+  double variance = static_cast<double>(this->TestProperties->CostVariance);
   double current = this->TestResult.ExecutionTime.count();
 
   if (this->TestResult.Status == cmCTestTestHandler::COMPLETED) {
-    this->TestProperties->Cost =
-      static_cast<float>(((prev * avgcost) + current) / (prev + 1.0));
+    // Update the running mean and variance of the test duration.
+    double newcost = ((prev * avgcost) + current) / (prev + 1.0);
+    this->TestProperties->Cost = static_cast<float>(newcost);
+    this->TestProperties->CostVariance = static_cast<float>(
+      ((prev * variance) + (current - avgcost) * (current - newcost)) /
+      (prev + 1.0));
     this->TestProperties->PreviousRuns++;
   }
 }
@@ -488,8 +508,12 @@ void cmCTestRunTest::StartFailure(size_t total, std::string const& output,
                  << this->TestProperties->Index << ": "
                  << this->TestProperties->Name << std::endl);
   }
+  if (this->MultiTestHandler.TestEvents) {
+    this->MultiTestHandler.TestEvents->TestStarted(*this->TestProperties);
+  }
 
   this->ProcessOutput.clear();
+  this->OutputCapture.Start(0);
   if (!output.empty()) {
     *this->TestHandler->LogFile << output << std::endl;
     cmCTestLog(this->CTest, ERROR_MESSAGE, output << std::endl);
@@ -558,8 +582,12 @@ bool cmCTestRunTest::StartTest(size_t completed, size_t total)
       this->TestProperties->Name + "\n";
     cmCTestLog(this->CTest, HANDLER_TEST_PROGRESS_OUTPUT, testName);
   }
+  if (this->MultiTestHandler.TestEvents) {
+    this->MultiTestHandler.TestEvents->TestStarted(*this->TestProperties);
+  }
 
   this->ProcessOutput.clear();
+  this->StartOutputCapture();
 
   this->TestResult.Properties = this->TestProperties;
   this->TestResult.ExecutionTime = cmDuration::zero();
@@ -745,6 +773,31 @@ void cmCTestRunTest::ComputeArguments()
   }
 }
 
+void cmCTestRunTest::StartOutputCapture()
+{
+  // Keep only as much output in memory as the test can report, unless
+  // all of it is needed to match the test's regular expressions.
+  std::size_t limit = 0;
+  int const passedSize = this->TestHandler->CustomMaximumPassedTestOutputSize;
+  int const failedSize = this->TestHandler->CustomMaximumFailedTestOutputSize;
+  if (!this->TestHandler->MemCheck && passedSize > 0 && failedSize > 0 &&
+      this->TestProperties->RequiredRegularExpressions.empty() &&
+      this->TestProperties->ErrorRegularExpressions.empty() &&
+      this->TestProperties->SkipRegularExpressions.empty() &&
+      this->TestProperties->TimeoutRegularExpressions.empty()) {
+    limit = static_cast<std::size_t>(std::max(passedSize, failedSize));
+  }
+
+  // Output that is not kept in memory is still needed for the log.
+  std::string spillFile;
+  if (limit) {
+    spillFile = cmStrCat(this->CTest->GetBinaryDir(),
+                         "/Testing/Temporary/TestOutput-", this->Index, '-',
+                         uv_os_getpid(), ".tmp");
+  }
+  this->OutputCapture.Start(limit, std::move(spillFile));
+}
+
 void cmCTestRunTest::ParseOutputForMeasurements()
 {
   if (!this->ProcessOutput.empty() &&
@@ -871,16 +924,24 @@ bool cmCTestRunTest::ForkProcess()
     diff.ApplyToCurrentEnv(&envMeasurement);
   }
 
+  // A shard worker applies the same changes to its own environment.
+  std::vector<std::string> remoteEnvironmentModification =
+    this->TestProperties->EnvironmentModification;
   if (this->UseAllocatedResources) {
     std::vector<std::string> envLog;
     this->SetupResourcesEnvironment(&envLog);
     for (auto const& var : envLog) {
       envMeasurement << var << std::endl;
+      std::string::size_type const eq = var.find('=');
+      remoteEnvironmentModification.push_back(
+        cmStrCat(var.substr(0, eq), "=set:", var.substr(eq + 1)));
     }
   } else {
     cmSystemTools::UnsetEnv("CTEST_RESOURCE_GROUP_COUNT");
     // Signify that this variable is being actively unset
     envMeasurement << "#CTEST_RESOURCE_GROUP_COUNT=" << std::endl;
+    remoteEnvironmentModification.emplace_back(
+      "CTEST_RESOURCE_GROUP_COUNT=unset:");
   }
 
   this->TestResult.Environment = envMeasurement.str();
@@ -888,6 +949,11 @@ bool cmCTestRunTest::ForkProcess()
   this->TestResult.Environment.erase(this->TestResult.Environment.length() -
                                      1);
 
+  if (this->MultiTestHandler.ShardCoordinator) {
+    return this->TestProcess->StartRemoteProcess(
+      *this->MultiTestHandler.Loop, *this->MultiTestHandler.ShardCoordinator,
+      this->TestProperties->Environment, remoteEnvironmentModification);
+  }
   return this->TestProcess->StartProcess(*this->MultiTestHandler.Loop,
                                          &this->TestProperties->Affinity);
 }
@@ -1003,8 +1069,9 @@ void cmCTestRunTest::WriteLogOutputTop(size_t completed, size_t total)
     << "Output:" << std::endl
     << "----------------------------------------------------------"
     << std::endl;
-  *this->TestHandler->LogFile << this->ProcessOutput << "<end of output>"
-                              << std::endl;
+  this->OutputCapture.WriteFull(*this->TestHandler->LogFile,
+                                this->ProcessOutput);
+  *this->TestHandler->LogFile << "<end of output>" << std::endl;
 
   if (!this->CTest->GetTestProgressOutput()) {
     cmCTestLog(this->CTest, HANDLER_OUTPUT, outputStream.str());
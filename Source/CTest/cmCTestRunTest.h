@@ -13,6 +13,7 @@
 
 #include "cmCTest.h"
 #include "cmCTestMultiProcessHandler.h"
+#include "cmCTestOutputCapture.h"
 #include "cmCTestTestHandler.h"
 #include "cmProcess.h"
 
@@ -48,7 +49,7 @@ public:
 
   std::string GetProcessOutput() { return this->ProcessOutput; }
 
-  cmCTestTestHandler::cmCTestTestResult GetTestResults()
+  cmCTestTestHandler::cmCTestTestResult const& GetTestResults() const
   {
     return this->TestResult;
   }
@@ -106,6 +107,7 @@ public:
 
 private:
   bool NeedsToRepeat();
+  void StartOutputCapture();
   void ParseOutputForMeasurements();
   void ExeNotFound(std::string exe);
   bool ForkProcess();
@@ -125,6 +127,7 @@ private:
   cmCTestTestHandler::cmCTestTestProperties* TestProperties;
 
   std::unique_ptr<cmProcess> TestProcess;
+  cmCTestOutputCapture OutputCapture;
   std::string ProcessOutput;
   cmCTestTestHandler::cmCTestTestResult TestResult;
   std::set<std::string> FailedDependencies;
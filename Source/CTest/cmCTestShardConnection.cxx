@@ -0,0 +1,248 @@
+/* Distributed under the OSI-approved BSD 3-Clause License.  See accompanying
+   file Copyright.txt or https://cmake.org/licensing for details.  */
+#include "cmCTestShardConnection.h"
+
+#include <memory>
+
+#include <cm/memory>
+
+#include "cmStringAlgorithms.h"
+
+namespace {
+std::size_t const kHeaderSize = 5;
+// No message comes close to this size.  A larger frame means the peer
+// does not speak our protocol.
+std::uint32_t const kMaxPayloadSize = 64 * 1024 * 1024;
+std::size_t const kReadBufferSize = 65536;
+
+struct WriteRequest : public uv_write_t
+{
+  std::string Data;
+};
+
+void OnWriteCB(uv_write_t* req, int /*status*/)
+{
+  // A failed write means the peer has gone away.  Reading from the
+  // connection reports that, so there is nothing else to do here.
+  std::unique_ptr<WriteRequest> self(static_cast<WriteRequest*>(req));
+}
+}
+
+cmCTestShardConnection::cmCTestShardConnection(FrameCallback onFrame,
+                                               CloseCallback onClose)
+  : OnFrame(std::move(onFrame))
+  , OnClose(std::move(onClose))
+{
+}
+
+cmCTestShardConnection::~cmCTestShardConnection() = default;
+
+int cmCTestShardConnection::Open(cm::uv_pipe_ptr pipe)
+{
+  this->Pipe = std::move(pipe);
+  this->Pipe->data = this;
+  int status = uv_read_start(this->Pipe, &cmCTestShardConnection::OnAllocateCB,
+                             &cmCTestShardConnection::OnReadCB);
+  if (status != 0) {
+    this->Pipe.reset();
+  }
+  return status;
+}
+
+void cmCTestShardConnection::Close()
+{
+  this->Pipe.reset();
+  this->Pending.clear();
+}
+
+void cmCTestShardConnection::Send(Message type, std::string payload)
+{
+  if (!this->Pipe) {
+    return;
+  }
+  auto req = cm::make_unique<WriteRequest>();
+  req->Data.reserve(kHeaderSize + payload.size());
+  req->Data.push_back(static_cast<char>(type));
+  Writer header;
+  header.UInt32(static_cast<std::uint32_t>(payload.size()));
+  req->Data += header.Release();
+  req->Data += payload;
+
+  uv_buf_t buf = uv_buf_init(&req->Data[0],
+                             static_cast<unsigned int>(req->Data.size()));
+  if (uv_write(req.get(), this->Pipe, &buf, 1, OnWriteCB) == 0) {
+    // Ownership has been transferred to the event loop.
+    static_cast<void>(req.release());
+  }
+}
+
+void cmCTestShardConnection::SetActive(bool active)
+{
+  if (!this->Pipe) {
+    return;
+  }
+  if (active) {
+    uv_ref(this->Pipe);
+  } else {
+    uv_unref(this->Pipe);
+  }
+}
+
+std::string cmCTestShardConnection::GetPipeName(std::string const& endpoint)
+{
+#ifdef _WIN32
+  if (!cmHasLiteralPrefix(endpoint, "\\\\")) {
+    return cmStrCat("\\\\.\\pipe\\", endpoint);
+  }
+#endif
+  return endpoint;
+}
+
+void cmCTestShardConnection::OnAllocateCB(uv_handle_t* handle,
+                                          size_t /*suggested_size*/,
+                                          uv_buf_t* buf)
+{
+  auto* self = static_cast<cmCTestShardConnection*>(handle->data);
+  self->Buf.resize(kReadBufferSize);
+  *buf = uv_buf_init(self->Buf.data(),
+                     static_cast<unsigned int>(self->Buf.size()));
+}
+
+void cmCTestShardConnection::OnReadCB(uv_stream_t* stream, ssize_t nread,
+                                      uv_buf_t const* buf)
+{
+  auto* self = static_cast<cmCTestShardConnection*>(stream->data);
+  self->OnRead(nread, buf);
+}
+
+void cmCTestShardConnection::OnRead(ssize_t nread, uv_buf_t const* buf)
+{
+  if (nread == 0) {
+    return;
+  }
+  int status = UV_EOF;
+  if (nread > 0) {
+    this->Pending.append(buf->base, static_cast<std::size_t>(nread));
+    std::size_t offset = 0;
+    while (this->Pending.size() - offset >= kHeaderSize) {
+      auto type = static_cast<Message>(this->Pending[offset]);
+      Reader header(cm::string_view(this->Pending).substr(offset + 1, 4));
+      std::uint32_t size = header.UInt32();
+      if (size > kMaxPayloadSize) {
+        status = UV_EPROTO;
+        break;
+      }
+      if (this->Pending.size() - offset - kHeaderSize < size) {
+        break;
+      }
+      // Take the frame out of the buffer in case the callback sends
+      // more data or closes the connection.
+      std::string payload =
+        this->Pending.substr(offset + kHeaderSize, size);
+      offset += kHeaderSize + size;
+      this->OnFrame(type, payload);
+      if (!this->Pipe) {
+        return;
+      }
+    }
+    if (status != UV_EPROTO) {
+      this->Pending.erase(0, offset);
+      return;
+    }
+  } else {
+    status = static_cast<int>(nread);
+  }
+
+  // The peer will provide no more frames.
+  this->Close();
+  this->OnClose(status);
+}
+
+cmCTestShardConnection::Writer& cmCTestShardConnection::Writer::UInt32(
+  std::uint32_t value)
+{
+  for (int i = 0; i < 4; ++i) {
+    this->Data.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+  }
+  return *this;
+}
+
+cmCTestShardConnection::Writer& cmCTestShardConnection::Writer::Int64(
+  std::int64_t value)
+{
+  auto bits = static_cast<std::uint64_t>(value);
+  for (int i = 0; i < 8; ++i) {
+    this->Data.push_back(static_cast<char>((bits >> (8 * i)) & 0xFF));
+  }
+  return *this;
+}
+
+cmCTestShardConnection::Writer& cmCTestShardConnection::Writer::String(
+  cm::string_view value)
+{
+  this->UInt32(static_cast<std::uint32_t>(value.size()));
+  return this->Bytes(value);
+}
+
+cmCTestShardConnection::Writer& cmCTestShardConnection::Writer::Bytes(
+  cm::string_view value)
+{
+  this->Data.append(value.data(), value.size());
+  return *this;
+}
+
+bool cmCTestShardConnection::Reader::Take(std::size_t n, cm::string_view& out)
+{
+  if (!this->Ok || this->Data.size() < n) {
+    this->Ok = false;
+    return false;
+  }
+  out = this->Data.substr(0, n);
+  this->Data.remove_prefix(n);
+  return true;
+}
+
+std::uint32_t cmCTestShardConnection::Reader::UInt32()
+{
+  cm::string_view bytes;
+  std::uint32_t value = 0;
+  if (this->Take(4, bytes)) {
+    for (int i = 0; i < 4; ++i) {
+      value |= static_cast<std::uint32_t>(
+                 static_cast<unsigned char>(bytes[static_cast<size_t>(i)]))
+        << (8 * i);
+    }
+  }
+  return value;
+}
+
+std::int64_t cmCTestShardConnection::Reader::Int64()
+{
+  cm::string_view bytes;
+  std::uint64_t value = 0;
+  if (this->Take(8, bytes)) {
+    for (int i = 0; i < 8; ++i) {
+      value |= static_cast<std::uint64_t>(
+                 static_cast<unsigned char>(bytes[static_cast<size_t>(i)]))
+        << (8 * i);
+    }
+  }
+  return static_cast<std::int64_t>(value);
+}
+
+std::string cmCTestShardConnection::Reader::String()
+{
+  std::uint32_t size = this->UInt32();
+  cm::string_view bytes;
+  if (!this->Take(size, bytes)) {
+    return std::string();
+  }
+  return std::string(bytes);
+}
+
+cm::string_view cmCTestShardConnection::Reader::Rest()
+{
+  cm::string_view rest = this->Data;
+  this->Data = cm::string_view();
+  return rest;
+}
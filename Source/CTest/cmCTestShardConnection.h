@@ -0,0 +1,117 @@
+/* Distributed under the OSI-approved BSD 3-Clause License.  See accompanying
+   file Copyright.txt or https://cmake.org/licensing for details.  */
+#pragma once
+
+#include "cmConfigure.h" // IWYU pragma: keep
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <cm/string_view>
+
+#include <cm3p/uv.h>
+
+#include "cmUVHandlePtr.h"
+
+/** \class cmCTestShardConnection
+ * \brief Framed messages between a ctest shard coordinator and a worker.
+ *
+ * Each frame is a one-byte message type, a four-byte little-endian payload
+ * size, and the payload.  Integers in payloads are little-endian and strings
+ * are prefixed by their four-byte size.
+ */
+class cmCTestShardConnection
+{
+public:
+  enum class Message : unsigned char
+  {
+    // Worker to coordinator: protocol version and number of slots.
+    Hello = 1,
+    // Coordinator to worker: job id, command, working directory,
+    // arguments and environment.
+    Run = 2,
+    // Worker to coordinator: job id and output bytes.
+    Output = 3,
+    // Worker to coordinator: job id, whether the process started,
+    // exit status and terminating signal.
+    Exit = 4,
+    // Coordinator to worker: job id and signal, or 0 to kill the job.
+    Kill = 5,
+  };
+
+  static std::uint32_t const Version = 2;
+
+  using FrameCallback = std::function<void(Message, cm::string_view)>;
+  using CloseCallback = std::function<void(int)>;
+
+  cmCTestShardConnection(FrameCallback onFrame, CloseCallback onClose);
+  ~cmCTestShardConnection();
+
+  cmCTestShardConnection(cmCTestShardConnection const&) = delete;
+  cmCTestShardConnection& operator=(cmCTestShardConnection const&) = delete;
+
+  /** Take over a connected pipe and start reading frames.  */
+  int Open(cm::uv_pipe_ptr pipe);
+  bool IsOpen() const { return static_cast<bool>(this->Pipe); }
+  void Close();
+
+  void Send(Message type, std::string payload);
+
+  /** Set whether the connection keeps the event loop running.  */
+  void SetActive(bool active);
+
+  /** Name of the pipe to bind or connect to for an endpoint.  */
+  static std::string GetPipeName(std::string const& endpoint);
+
+  class Writer
+  {
+  public:
+    Writer& UInt32(std::uint32_t value);
+    Writer& Int64(std::int64_t value);
+    Writer& String(cm::string_view value);
+    Writer& Bytes(cm::string_view value);
+    std::string Release() { return std::move(this->Data); }
+
+  private:
+    std::string Data;
+  };
+
+  class Reader
+  {
+  public:
+    Reader(cm::string_view data)
+      : Data(data)
+    {
+    }
+    std::uint32_t UInt32();
+    std::int64_t Int64();
+    std::string String();
+    cm::string_view Rest();
+    /** Whether all values read so far were present.  */
+    bool Good() const { return this->Ok; }
+
+  private:
+    bool Take(std::size_t n, cm::string_view& out);
+
+    cm::string_view Data;
+    bool Ok = true;
+  };
+
+private:
+  static void OnAllocateCB(uv_handle_t* handle, size_t suggested_size,
+                           uv_buf_t* buf);
+  static void OnReadCB(uv_stream_t* stream, ssize_t nread,
+                       uv_buf_t const* buf);
+  void OnRead(ssize_t nread, uv_buf_t const* buf);
+
+  cm::uv_pipe_ptr Pipe;
+  std::vector<char> Buf;
+  // Bytes of frames not yet complete.
+  std::string Pending;
+  FrameCallback OnFrame;
+  CloseCallback OnClose;
+};
@@ -0,0 +1,363 @@
+/* Distributed under the OSI-approved BSD 3-Clause License.  See accompanying
+   file Copyright.txt or https://cmake.org/licensing for details.  */
+#include "cmCTestShardCoordinator.h"
+
+#include <algorithm>
+#include <limits>
+#include <ostream>
+#include <utility>
+
+#include <cm/memory>
+
+#include "cmCTest.h"
+#include "cmCTestRunTest.h" // IWYU pragma: keep
+#include "cmProcess.h"
+#include "cmSystemTools.h"
+
+namespace {
+// How long tests wait for a worker before they are not run.
+uint64_t const kWaitTimeoutMs = 60000;
+}
+
+std::size_t const cmCTestShardCoordinator::NoWorker =
+  std::numeric_limits<std::size_t>::max();
+
+cmCTestShardCoordinator::cmCTestShardCoordinator(cmCTest* ctest,
+                                                 std::string endpoint)
+  : CTest(ctest)
+  , Endpoint(std::move(endpoint))
+{
+}
+
+cmCTestShardCoordinator::~cmCTestShardCoordinator()
+{
+  if (!this->Bound) {
+    return;
+  }
+  // Do not leave the endpoint behind for workers to connect to.
+  this->Server.reset();
+#ifndef _WIN32
+  cmSystemTools::RemoveFile(
+    cmCTestShardConnection::GetPipeName(this->Endpoint));
+#endif
+}
+
+bool cmCTestShardCoordinator::Listen(uv_loop_t& loop, GrantCallback onGrant)
+{
+  this->Loop = &loop;
+  this->OnGrant = std::move(onGrant);
+  this->WaitTimer.init(loop, this);
+
+  std::string const name =
+    cmCTestShardConnection::GetPipeName(this->Endpoint);
+  this->Server.init(loop, 0, this);
+  int status = uv_pipe_bind(this->Server, name.c_str());
+  if (status == 0) {
+    this->Bound = true;
+    status = uv_listen(this->Server, 16,
+                       &cmCTestShardCoordinator::OnConnectionCB);
+  }
+  if (status != 0) {
+    cmCTestLog(this->CTest, ERROR_MESSAGE,
+               "Failed to listen for shard workers on \""
+                 << this->Endpoint << "\": " << uv_strerror(status)
+                 << std::endl);
+    this->Server.reset();
+    this->GaveUp = true;
+    return false;
+  }
+  // Waiting for workers alone does not keep the event loop running.
+  uv_unref(this->Server);
+  cmCTestLog(this->CTest, HANDLER_VERBOSE_OUTPUT,
+             "Listening for shard workers on \"" << this->Endpoint << "\""
+                                                 << std::endl);
+  return true;
+}
+
+void cmCTestShardCoordinator::RequestSlots(int test, std::size_t slots)
+{
+  this->Requests.push_back({ test, std::max<std::size_t>(slots, 1) });
+  this->GrantSlots();
+}
+
+void cmCTestShardCoordinator::ReleaseSlots(int test)
+{
+  auto it = this->Grants.find(test);
+  if (it == this->Grants.end()) {
+    return;
+  }
+  if (it->second.Worker != NoWorker) {
+    this->Workers[it->second.Worker].Used -= it->second.Slots;
+  }
+  this->Grants.erase(it);
+  this->GrantSlots();
+}
+
+std::uint32_t cmCTestShardCoordinator::StartJob(
+  int test, cmProcess* process, std::string const& command,
+  std::vector<std::string> const& arguments,
+  std::string const& workingDirectory,
+  std::vector<std::string> const& environment,
+  std::vector<std::string> const& environmentModification)
+{
+  auto grant = this->Grants.find(test);
+  if (grant == this->Grants.end() || grant->second.Worker == NoWorker ||
+      !this->IsReady(this->Workers[grant->second.Worker])) {
+    cmCTestLog(this->CTest, ERROR_MESSAGE,
+               "No shard worker is connected to \""
+                 << this->Endpoint << "\" to run:\n " << command
+                 << std::endl);
+    return 0;
+  }
+  std::size_t const worker = grant->second.Worker;
+  std::uint32_t const job = this->NextJob++;
+
+  cmCTestShardConnection::Writer w;
+  w.UInt32(job).String(command).String(workingDirectory);
+  w.UInt32(static_cast<std::uint32_t>(arguments.size()));
+  for (std::string const& arg : arguments) {
+    w.String(arg);
+  }
+  w.UInt32(static_cast<std::uint32_t>(environment.size()));
+  for (std::string const& var : environment) {
+    w.String(var);
+  }
+  w.UInt32(static_cast<std::uint32_t>(environmentModification.size()));
+  for (std::string const& envmod : environmentModification) {
+    w.String(envmod);
+  }
+  this->Workers[worker].Connection->Send(
+    cmCTestShardConnection::Message::Run, w.Release());
+  this->Jobs[job] = { worker, process };
+  return job;
+}
+
+void cmCTestShardCoordinator::KillJob(std::uint32_t job, int signal)
+{
+  auto it = this->Jobs.find(job);
+  if (it == this->Jobs.end()) {
+    return;
+  }
+  cmCTestShardConnection::Writer w;
+  w.UInt32(job).Int64(signal);
+  this->Workers[it->second.Worker].Connection->Send(
+    cmCTestShardConnection::Message::Kill, w.Release());
+}
+
+void cmCTestShardCoordinator::ForgetJob(std::uint32_t job)
+{
+  this->KillJob(job, 0);
+  this->Jobs.erase(job);
+}
+
+void cmCTestShardCoordinator::OnConnectionCB(uv_stream_t* server, int status)
+{
+  auto* self = static_cast<cmCTestShardCoordinator*>(server->data);
+  self->OnConnection(status);
+}
+
+void cmCTestShardCoordinator::OnConnection(int status)
+{
+  if (status != 0) {
+    cmCTestLog(this->CTest, ERROR_MESSAGE,
+               "Failed to accept a shard worker: " << uv_strerror(status)
+                                                   << std::endl);
+    return;
+  }
+  cm::uv_pipe_ptr pipe;
+  pipe.init(*this->Loop, 0);
+  if (uv_accept(this->Server, pipe) != 0) {
+    return;
+  }
+
+  std::size_t const worker = this->Workers.size();
+  this->Workers.emplace_back();
+  this->Workers.back().Connection = cm::make_unique<cmCTestShardConnection>(
+    [this, worker](cmCTestShardConnection::Message type,
+                   cm::string_view payload) {
+      this->OnFrame(worker, type, payload);
+    },
+    [this, worker](int closeStatus) {
+      this->OnWorkerLost(worker, closeStatus);
+    });
+  if (this->Workers.back().Connection->Open(std::move(pipe)) == 0) {
+    // The worker keeps the event loop running only while it runs tests.
+    this->Workers.back().Connection->SetActive(false);
+  }
+}
+
+void cmCTestShardCoordinator::OnFrame(std::size_t worker,
+                                      cmCTestShardConnection::Message type,
+                                      cm::string_view payload)
+{
+  Worker& w = this->Workers[worker];
+  cmCTestShardConnection::Reader r(payload);
+  switch (type) {
+    case cmCTestShardConnection::Message::Hello: {
+      std::uint32_t const version = r.UInt32();
+      std::uint32_t const slots = r.UInt32();
+      if (!r.Good() || version != cmCTestShardConnection::Version ||
+          w.Slots != 0) {
+        break;
+      }
+      w.Slots = std::max<std::size_t>(slots, 1);
+      cmCTestLog(this->CTest, HANDLER_VERBOSE_OUTPUT,
+                 "Shard worker " << worker << " connected with " << w.Slots
+                                 << (w.Slots == 1 ? " slot" : " slots")
+                                 << std::endl);
+      this->GrantSlots();
+      return;
+    }
+    case cmCTestShardConnection::Message::Output: {
+      std::uint32_t const job = r.UInt32();
+      cm::string_view const output = r.Rest();
+      if (!r.Good()) {
+        break;
+      }
+      // The job may have been forgotten while its output was on the way.
+      auto it = this->Jobs.find(job);
+      if (it != this->Jobs.end() && it->second.Worker == worker) {
+        it->second.Process->OnRemoteOutput(output);
+      }
+      return;
+    }
+    case cmCTestShardConnection::Message::Exit: {
+      std::uint32_t const job = r.UInt32();
+      std::uint32_t const started = r.UInt32();
+      std::int64_t const exitStatus = r.Int64();
+      std::int64_t const termSignal = r.Int64();
+      if (!r.Good()) {
+        break;
+      }
+      auto it = this->Jobs.find(job);
+      if (it != this->Jobs.end() && it->second.Worker == worker) {
+        cmProcess* process = it->second.Process;
+        this->Jobs.erase(it);
+        process->OnRemoteExit(started != 0, exitStatus,
+                              static_cast<int>(termSignal));
+      }
+      return;
+    }
+    default:
+      break;
+  }
+
+  // The worker does not speak our protocol.
+  w.Connection->Close();
+  this->OnWorkerLost(worker, UV_EPROTO);
+}
+
+void cmCTestShardCoordinator::OnWorkerLost(std::size_t worker, int status)
+{
+  Worker& w = this->Workers[worker];
+  if (w.Slots != 0 || status != UV_EOF) {
+    cmCTestLog(this->CTest, ERROR_MESSAGE,
+               "Lost connection to shard worker "
+                 << worker << ": " << uv_strerror(status) << std::endl);
+  }
+  w.Slots = 0;
+
+  std::vector<cmProcess*> lost;
+  for (auto it = this->Jobs.begin(); it != this->Jobs.end();) {
+    if (it->second.Worker == worker) {
+      lost.push_back(it->second.Process);
+      it = this->Jobs.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  for (cmProcess* process : lost) {
+    process->OnRemoteOutput("\nLost connection to the shard worker running "
+                            "this test.\n");
+    process->OnRemoteExit(true, 1, 0);
+  }
+  this->GrantSlots();
+}
+
+void cmCTestShardCoordinator::OnWaitTimeoutCB(uv_timer_t* timer)
+{
+  auto* self = static_cast<cmCTestShardCoordinator*>(timer->data);
+  self->OnWaitTimeout();
+}
+
+void cmCTestShardCoordinator::OnWaitTimeout()
+{
+  cmCTestLog(this->CTest, ERROR_MESSAGE,
+             "No shard worker connected to \""
+               << this->Endpoint << "\" within "
+               << kWaitTimeoutMs / 1000 << " seconds" << std::endl);
+  this->GaveUp = true;
+  this->GrantSlots();
+}
+
+bool cmCTestShardCoordinator::IsReady(Worker const& worker) const
+{
+  return worker.Slots != 0 && worker.Connection &&
+    worker.Connection->IsOpen();
+}
+
+void cmCTestShardCoordinator::GrantSlots()
+{
+  // Granting slots starts tests, which may finish right away and
+  // release their slots again.
+  if (this->Granting) {
+    this->GrantAgain = true;
+    return;
+  }
+  this->Granting = true;
+  do {
+    this->GrantAgain = false;
+    bool const haveWorker =
+      std::any_of(this->Workers.begin(), this->Workers.end(),
+                  [this](Worker const& w) { return this->IsReady(w); });
+    for (auto it = this->Requests.begin(); it != this->Requests.end();) {
+      Grant grant = { NoWorker, 0 };
+      if (haveWorker) {
+        std::size_t mostFree = 0;
+        for (std::size_t i = 0; i < this->Workers.size(); ++i) {
+          Worker const& w = this->Workers[i];
+          if (!this->IsReady(w) || w.Used >= w.Slots) {
+            continue;
+          }
+          std::size_t const free = w.Slots - w.Used;
+          if (free >= std::min(it->Slots, w.Slots) && free > mostFree) {
+            mostFree = free;
+            grant = { i, std::min(it->Slots, w.Slots) };
+          }
+        }
+        if (grant.Worker == NoWorker) {
+          ++it;
+          continue;
+        }
+        this->Workers[grant.Worker].Used += grant.Slots;
+      } else if (!this->GaveUp) {
+        break;
+      }
+      int const test = it->Test;
+      it = this->Requests.erase(it);
+      this->Grants[test] = grant;
+      this->OnGrant(test);
+    }
+  } while (this->GrantAgain);
+  this->Granting = false;
+  this->Update();
+}
+
+void cmCTestShardCoordinator::Update()
+{
+  // Keep the event loop running while workers run tests, and while
+  // tests wait for a worker to connect.
+  bool haveWorker = false;
+  for (Worker& w : this->Workers) {
+    if (this->IsReady(w)) {
+      haveWorker = true;
+      w.Connection->SetActive(w.Used != 0);
+    }
+  }
+  if (this->Requests.empty() || haveWorker) {
+    this->WaitTimer.stop();
+  } else if (!uv_is_active(this->WaitTimer)) {
+    this->WaitTimer.start(&cmCTestShardCoordinator::OnWaitTimeoutCB,
+                          kWaitTimeoutMs, 0);
+  }
+}
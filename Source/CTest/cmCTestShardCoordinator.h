@@ -0,0 +1,124 @@
+/* Distributed under the OSI-approved BSD 3-Clause License.  See accompanying
+   file Copyright.txt or https://cmake.org/licensing for details.  */
+#pragma once
+
+#include "cmConfigure.h" // IWYU pragma: keep
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <cm/string_view>
+
+#include <cm3p/uv.h>
+
+#include "cmCTestShardConnection.h"
+#include "cmUVHandlePtr.h"
+
+class cmCTest;
+class cmProcess;
+
+/** \class cmCTestShardCoordinator
+ * \brief Run test processes on ctest shard workers.
+ *
+ * The coordinator listens on a local endpoint for worker ctest processes.
+ * Each worker announces a number of slots.  Tests request slots and are
+ * granted them on the worker with the most free slots.  The processes of
+ * tests run on the workers, which stream their output and exit status back
+ * to the coordinator.  Scheduling and reporting stay in the coordinator.
+ */
+class cmCTestShardCoordinator
+{
+public:
+  using GrantCallback = std::function<void(int)>;
+
+  cmCTestShardCoordinator(cmCTest* ctest, std::string endpoint);
+  ~cmCTestShardCoordinator();
+
+  cmCTestShardCoordinator(cmCTestShardCoordinator const&) = delete;
+  cmCTestShardCoordinator& operator=(cmCTestShardCoordinator const&) = delete;
+
+  /** Start listening for workers.  The callback is called with a test
+      when the slots it requested have been granted.  */
+  bool Listen(uv_loop_t& loop, GrantCallback onGrant);
+
+  /** Request slots for a test.  A test asking for more slots than any
+      worker has is granted all slots of one worker.  */
+  void RequestSlots(int test, std::size_t slots);
+  void ReleaseSlots(int test);
+
+  /** Run the process of a test that has been granted slots.  The worker
+      applies the given ENVIRONMENT and ENVIRONMENT_MODIFICATION entries
+      to its own environment.  Returns the id of the job, or 0 if no
+      worker can run it.  */
+  std::uint32_t StartJob(
+    int test, cmProcess* process, std::string const& command,
+    std::vector<std::string> const& arguments,
+    std::string const& workingDirectory,
+    std::vector<std::string> const& environment,
+    std::vector<std::string> const& environmentModification);
+  void KillJob(std::uint32_t job, int signal);
+  void ForgetJob(std::uint32_t job);
+
+  static std::size_t const NoWorker;
+
+private:
+  struct Worker
+  {
+    std::unique_ptr<cmCTestShardConnection> Connection;
+    std::size_t Slots = 0;
+    std::size_t Used = 0;
+  };
+  struct Request
+  {
+    int Test;
+    std::size_t Slots;
+  };
+  struct Grant
+  {
+    std::size_t Worker;
+    std::size_t Slots;
+  };
+  struct Job
+  {
+    std::size_t Worker;
+    cmProcess* Process;
+  };
+
+  static void OnConnectionCB(uv_stream_t* server, int status);
+  static void OnWaitTimeoutCB(uv_timer_t* timer);
+  void OnConnection(int status);
+  void OnWaitTimeout();
+  void OnFrame(std::size_t worker, cmCTestShardConnection::Message type,
+               cm::string_view payload);
+  void OnWorkerLost(std::size_t worker, int status);
+
+  bool IsReady(Worker const& worker) const;
+  void GrantSlots();
+  void Update();
+
+  cmCTest* CTest;
+  std::string Endpoint;
+  uv_loop_t* Loop = nullptr;
+  cm::uv_pipe_ptr Server;
+  // Whether the endpoint was created by listening on it.
+  bool Bound = false;
+  cm::uv_timer_ptr WaitTimer;
+  GrantCallback OnGrant;
+
+  std::vector<Worker> Workers;
+  std::list<Request> Requests;
+  std::map<int, Grant> Grants;
+  std::map<std::uint32_t, Job> Jobs;
+  std::uint32_t NextJob = 1;
+
+  // Whether to stop waiting for a worker to grant slots.
+  bool GaveUp = false;
+  bool Granting = false;
+  bool GrantAgain = false;
+};
@@ -0,0 +1,346 @@
+/* Distributed under the OSI-approved BSD 3-Clause License.  See accompanying
+   file Copyright.txt or https://cmake.org/licensing for details.  */
+#include "cmCTestShardWorker.h"
+
+#include <ostream>
+#include <utility>
+#include <vector>
+
+#include <cm/memory>
+
+#include "cmsys/Process.h"
+
+#include "cmCTest.h"
+#include "cmGetPipes.h"
+#include "cmStringAlgorithms.h"
+#include "cmSystemTools.h"
+
+namespace {
+// How long to wait for the coordinator to listen.
+std::chrono::seconds const kConnectTimeout(60);
+uint64_t const kRetryIntervalMs = 100;
+std::size_t const kReadBufferSize = 65536;
+}
+
+struct cmCTestShardWorker::Job
+{
+  cmCTestShardWorker* Worker = nullptr;
+  std::uint32_t Id = 0;
+  cm::uv_process_ptr Process;
+  cm::uv_pipe_ptr Reader;
+  std::vector<char> Buf;
+  bool Exited = false;
+  bool ReadClosed = false;
+  int64_t ExitStatus = 0;
+  int TermSignal = 0;
+
+  static void OnExitCB(uv_process_t* process, int64_t exit_status,
+                       int term_signal)
+  {
+    auto* self = static_cast<Job*>(process->data);
+    self->Exited = true;
+    self->ExitStatus = exit_status;
+    self->TermSignal = term_signal;
+    if (self->ReadClosed) {
+      self->Worker->FinishJob(self->Id);
+    }
+  }
+
+  static void OnAllocateCB(uv_handle_t* handle, size_t /*suggested_size*/,
+                           uv_buf_t* buf)
+  {
+    auto* self = static_cast<Job*>(handle->data);
+    self->Buf.resize(kReadBufferSize);
+    *buf = uv_buf_init(self->Buf.data(),
+                       static_cast<unsigned int>(self->Buf.size()));
+  }
+
+  static void OnReadCB(uv_stream_t* stream, ssize_t nread,
+                       uv_buf_t const* buf)
+  {
+    auto* self = static_cast<Job*>(stream->data);
+    if (nread > 0) {
+      cmCTestShardConnection::Writer w;
+      w.UInt32(self->Id).Bytes(
+        cm::string_view(buf->base, static_cast<std::size_t>(nread)));
+      self->Worker->Connection->Send(cmCTestShardConnection::Message::Output,
+                                     w.Release());
+      return;
+    }
+    if (nread == 0) {
+      return;
+    }
+    // The process will provide no more output.
+    self->ReadClosed = true;
+    self->Reader.reset();
+    if (self->Exited) {
+      self->Worker->FinishJob(self->Id);
+    }
+  }
+};
+
+cmCTestShardWorker::cmCTestShardWorker(cmCTest* ctest, std::string endpoint,
+                                       std::size_t slots)
+  : CTest(ctest)
+  , Endpoint(std::move(endpoint))
+  , Slots(slots)
+{
+}
+
+cmCTestShardWorker::~cmCTestShardWorker() = default;
+
+int cmCTestShardWorker::Run()
+{
+  this->Loop.init();
+  this->RetryTimer.init(*this->Loop, this);
+  this->Deadline = std::chrono::steady_clock::now() + kConnectTimeout;
+  this->Connect();
+  uv_run(this->Loop, UV_RUN_DEFAULT);
+
+  this->Jobs.clear();
+  this->Connection.reset();
+  this->RetryTimer.reset();
+  this->Pipe.reset();
+  this->Loop.reset();
+  return this->Result;
+}
+
+void cmCTestShardWorker::Connect()
+{
+  std::string const name =
+    cmCTestShardConnection::GetPipeName(this->Endpoint);
+  this->Pipe.init(*this->Loop, 0, this);
+  this->ConnectReq.data = this;
+  uv_pipe_connect(&this->ConnectReq, this->Pipe, name.c_str(),
+                  &cmCTestShardWorker::OnConnectCB);
+}
+
+void cmCTestShardWorker::OnConnectCB(uv_connect_t* req, int status)
+{
+  auto* self = static_cast<cmCTestShardWorker*>(req->data);
+  self->OnConnect(status);
+}
+
+void cmCTestShardWorker::OnRetryCB(uv_timer_t* timer)
+{
+  auto* self = static_cast<cmCTestShardWorker*>(timer->data);
+  self->Connect();
+}
+
+void cmCTestShardWorker::OnConnect(int status)
+{
+  if (status != 0) {
+    this->Pipe.reset();
+    if (std::chrono::steady_clock::now() < this->Deadline) {
+      // The coordinator may not be listening yet.
+      this->RetryTimer.start(&cmCTestShardWorker::OnRetryCB,
+                             kRetryIntervalMs, 0);
+    } else {
+      cmCTestLog(this->CTest, ERROR_MESSAGE,
+                 "Failed to connect to shard coordinator at \""
+                   << this->Endpoint << "\": " << uv_strerror(status)
+                   << std::endl);
+    }
+    return;
+  }
+
+  this->Connection = cm::make_unique<cmCTestShardConnection>(
+    [this](cmCTestShardConnection::Message type, cm::string_view payload) {
+      this->OnFrame(type, payload);
+    },
+    [this](int closeStatus) { this->OnClose(closeStatus); });
+  status = this->Connection->Open(std::move(this->Pipe));
+  if (status != 0) {
+    this->OnClose(status);
+    return;
+  }
+
+  cmCTestShardConnection::Writer w;
+  w.UInt32(cmCTestShardConnection::Version)
+    .UInt32(static_cast<std::uint32_t>(this->Slots));
+  this->Connection->Send(cmCTestShardConnection::Message::Hello,
+                         w.Release());
+  cmCTestLog(this->CTest, HANDLER_OUTPUT,
+             "Connected to shard coordinator at \""
+               << this->Endpoint << "\" with " << this->Slots
+               << (this->Slots == 1 ? " slot" : " slots") << std::endl);
+}
+
+void cmCTestShardWorker::OnFrame(cmCTestShardConnection::Message type,
+                                 cm::string_view payload)
+{
+  switch (type) {
+    case cmCTestShardConnection::Message::Run:
+      this->StartJob(payload);
+      break;
+    case cmCTestShardConnection::Message::Kill:
+      this->KillJob(payload);
+      break;
+    default:
+      // The coordinator does not speak our protocol.
+      this->Connection->Close();
+      this->OnClose(UV_EPROTO);
+      break;
+  }
+}
+
+void cmCTestShardWorker::OnClose(int status)
+{
+  if (status == UV_EOF) {
+    this->Result = 0;
+  } else {
+    cmCTestLog(this->CTest, ERROR_MESSAGE,
+               "Lost connection to shard coordinator at \""
+                 << this->Endpoint << "\": " << uv_strerror(status)
+                 << std::endl);
+  }
+
+  // Nobody is interested in the jobs still running.
+  for (auto const& job : this->Jobs) {
+    if (!job.second->Exited) {
+      cmsysProcess_KillPID(
+        static_cast<unsigned long>(job.second->Process->pid));
+    }
+  }
+}
+
+void cmCTestShardWorker::StartJob(cm::string_view payload)
+{
+  cmCTestShardConnection::Reader r(payload);
+  std::uint32_t const id = r.UInt32();
+  std::string const command = r.String();
+  std::string const workingDirectory = r.String();
+  std::vector<std::string> arguments(r.UInt32());
+  for (std::string& arg : arguments) {
+    arg = r.String();
+  }
+  std::vector<std::string> testEnvironment(r.UInt32());
+  for (std::string& var : testEnvironment) {
+    var = r.String();
+  }
+  std::vector<std::string> testEnvironmentModification(r.UInt32());
+  for (std::string& envmod : testEnvironmentModification) {
+    envmod = r.String();
+  }
+  if (!r.Good()) {
+    this->Connection->Close();
+    this->OnClose(UV_EPROTO);
+    return;
+  }
+
+  // Apply the changes of the test to the environment of this worker, as
+  // the coordinator would to its own.  The coordinator checked them.
+  std::vector<std::string> environment;
+  {
+    cmSystemTools::SaveRestoreEnvironment sre;
+    if (!testEnvironment.empty()) {
+      cmSystemTools::EnvDiff diff;
+      diff.AppendEnv(testEnvironment);
+      diff.ApplyToCurrentEnv();
+    }
+    if (!testEnvironmentModification.empty()) {
+      cmSystemTools::EnvDiff diff;
+      for (std::string const& envmod : testEnvironmentModification) {
+        diff.ParseOperation(envmod);
+      }
+      diff.ApplyToCurrentEnv();
+    }
+    environment = cmSystemTools::GetEnvironmentVariables();
+  }
+
+  std::vector<char const*> args;
+  args.push_back(command.c_str());
+  for (std::string const& arg : arguments) {
+    args.push_back(arg.c_str());
+  }
+  args.push_back(nullptr);
+  std::vector<char const*> env;
+  for (std::string const& var : environment) {
+    env.push_back(var.c_str());
+  }
+  env.push_back(nullptr);
+
+  auto job = cm::make_unique<Job>();
+  job->Worker = this;
+  job->Id = id;
+
+  cm::uv_pipe_ptr pipe_writer;
+  pipe_writer.init(*this->Loop, 0);
+  job->Reader.init(*this->Loop, 0, job.get());
+
+  int fds[2] = { -1, -1 };
+  int status = cmGetPipes(fds);
+  if (status == 0) {
+    uv_pipe_open(job->Reader, fds[0]);
+    uv_pipe_open(pipe_writer, fds[1]);
+
+    uv_stdio_container_t stdio[3];
+    stdio[0].flags = UV_INHERIT_FD;
+    stdio[0].data.fd = 0;
+    stdio[1].flags = UV_INHERIT_STREAM;
+    stdio[1].data.stream = pipe_writer;
+    stdio[2] = stdio[1];
+
+    uv_process_options_t options = uv_process_options_t();
+    options.file = command.c_str();
+    options.args = const_cast<char**>(args.data());
+    options.env = const_cast<char**>(env.data());
+    if (!workingDirectory.empty()) {
+      options.cwd = workingDirectory.c_str();
+    }
+    options.stdio_count = 3;
+    options.exit_cb = &Job::OnExitCB;
+    options.stdio = stdio;
+
+    status =
+      uv_read_start(job->Reader, &Job::OnAllocateCB, &Job::OnReadCB);
+    if (status == 0) {
+      status = job->Process.spawn(*this->Loop, options, job.get());
+    }
+  }
+
+  if (status != 0) {
+    cmCTestShardConnection::Writer out;
+    out.UInt32(id).Bytes(cmStrCat("Process not started\n ", command, "\n[",
+                                  uv_strerror(status), "]\n"));
+    this->Connection->Send(cmCTestShardConnection::Message::Output,
+                           out.Release());
+    cmCTestShardConnection::Writer exit;
+    exit.UInt32(id).UInt32(0).Int64(0).Int64(0);
+    this->Connection->Send(cmCTestShardConnection::Message::Exit,
+                           exit.Release());
+    return;
+  }
+
+  this->Jobs[id] = std::move(job);
+}
+
+void cmCTestShardWorker::KillJob(cm::string_view payload)
+{
+  cmCTestShardConnection::Reader r(payload);
+  std::uint32_t const id = r.UInt32();
+  auto const signal = static_cast<int>(r.Int64());
+  auto it = this->Jobs.find(id);
+  if (!r.Good() || it == this->Jobs.end() || it->second->Exited) {
+    return;
+  }
+  if (signal == 0) {
+    cmsysProcess_KillPID(
+      static_cast<unsigned long>(it->second->Process->pid));
+  } else {
+    uv_process_kill(it->second->Process, signal);
+  }
+}
+
+void cmCTestShardWorker::FinishJob(std::uint32_t id)
+{
+  auto it = this->Jobs.find(id);
+  if (it == this->Jobs.end()) {
+    return;
+  }
+  cmCTestShardConnection::Writer w;
+  w.UInt32(id).UInt32(1).Int64(it->second->ExitStatus).Int64(
+    it->second->TermSignal);
+  this->Connection->Send(cmCTestShardConnection::Message::Exit, w.Release());
+  this->Jobs.erase(it);
+}
@@ -0,0 +1,68 @@
+/* Distributed under the OSI-approved BSD 3-Clause License.  See accompanying
+   file Copyright.txt or https://cmake.org/licensing for details.  */
+#pragma once
+
+#include "cmConfigure.h" // IWYU pragma: keep
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+
+#include <cm/string_view>
+
+#include <cm3p/uv.h>
+
+#include "cmCTestShardConnection.h"
+#include "cmUVHandlePtr.h"
+
+class cmCTest;
+
+/** \class cmCTestShardWorker
+ * \brief Run test processes for a ctest shard coordinator.
+ *
+ * The worker connects to the endpoint of a coordinator, retrying until the
+ * coordinator listens, and offers a number of slots.  It runs the processes
+ * the coordinator sends, streams their output back, and reports their exit
+ * status.  It finishes when the coordinator closes the connection.
+ */
+class cmCTestShardWorker
+{
+public:
+  cmCTestShardWorker(cmCTest* ctest, std::string endpoint, std::size_t slots);
+  ~cmCTestShardWorker();
+
+  cmCTestShardWorker(cmCTestShardWorker const&) = delete;
+  cmCTestShardWorker& operator=(cmCTestShardWorker const&) = delete;
+
+  /** Serve the coordinator.  Returns the process exit code.  */
+  int Run();
+
+private:
+  struct Job;
+
+  void Connect();
+  static void OnConnectCB(uv_connect_t* req, int status);
+  static void OnRetryCB(uv_timer_t* timer);
+  void OnConnect(int status);
+  void OnFrame(cmCTestShardConnection::Message type, cm::string_view payload);
+  void OnClose(int status);
+
+  void StartJob(cm::string_view payload);
+  void KillJob(cm::string_view payload);
+  void FinishJob(std::uint32_t id);
+
+  cmCTest* CTest;
+  std::string Endpoint;
+  std::size_t Slots;
+  cm::uv_loop_ptr Loop;
+  cm::uv_pipe_ptr Pipe;
+  uv_connect_t ConnectReq;
+  cm::uv_timer_ptr RetryTimer;
+  std::chrono::steady_clock::time_point Deadline;
+  std::unique_ptr<cmCTestShardConnection> Connection;
+  std::map<std::uint32_t, std::unique_ptr<Job>> Jobs;
+  int Result = 1;
+};
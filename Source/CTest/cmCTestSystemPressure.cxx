@@ -0,0 +1,203 @@
+/* Distributed under the OSI-approved BSD 3-Clause License.  See accompanying
+   file Copyright.txt or https://cmake.org/licensing for details.  */
+#include "cmCTestSystemPressure.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <utility>
+
+#include "cmsys/FStream.hxx"
+
+#include "cmStringAlgorithms.h"
+#include "cmSystemTools.h"
+
+namespace {
+bool ReadFirstLine(std::string const& file, std::string& line)
+{
+  cmsys::ifstream fin(file.c_str());
+  return fin && cmSystemTools::GetLineFromStream(fin, line);
+}
+
+// Read a value of a cgroup interface file, which is "max" if unlimited.
+cm::optional<double> ReadLimit(std::string const& file,
+                               std::string* second = nullptr)
+{
+  std::string line;
+  if (!ReadFirstLine(file, line)) {
+    return cm::nullopt;
+  }
+  std::string::size_type const space = line.find(' ');
+  std::string const first = line.substr(0, space);
+  if (second) {
+    *second =
+      space == std::string::npos ? std::string() : line.substr(space + 1);
+  }
+  char* end = nullptr;
+  double const value = std::strtod(first.c_str(), &end);
+  if (first.empty() || *end != '\0') {
+    return cm::nullopt;
+  }
+  return value;
+}
+}
+
+cmCTestSystemPressure::cmCTestSystemPressure(std::string root)
+{
+  // Find the cgroup of this process in the unified hierarchy.
+  std::string path;
+  {
+    cmsys::ifstream fin(cmStrCat(root, "/proc/self/cgroup").c_str());
+    std::string line;
+    while (cmSystemTools::GetLineFromStream(fin, line)) {
+      if (cmHasLiteralPrefix(line, "0::")) {
+        path = line.substr(3);
+        break;
+      }
+    }
+  }
+  for (char const* mount : { "/sys/fs/cgroup", "/sys/fs/cgroup/unified" }) {
+    std::string dir = cmStrCat(root, mount);
+    if (cmSystemTools::FileExists(cmStrCat(dir, "/cgroup.controllers"))) {
+      this->CgroupMount = std::move(dir);
+      break;
+    }
+  }
+  if (!this->CgroupMount.empty() && cmHasLiteralPrefix(path, "/")) {
+    this->CgroupDir = cmStrCat(this->CgroupMount, path);
+    if (this->CgroupDir.back() == '/') {
+      this->CgroupDir.pop_back();
+    }
+  }
+
+  // Prefer the pressure of the cgroup over that of the whole system.
+  auto locate = [this, &root](Resource& resource, char const* name) {
+    std::string file = cmStrCat(this->CgroupDir, '/', name, ".pressure");
+    if (this->CgroupDir.empty() || !cmSystemTools::FileExists(file)) {
+      file = cmStrCat(root, "/proc/pressure/", name);
+    }
+    resource.File = std::move(file);
+  };
+  locate(this->Cpu, "cpu");
+  locate(this->Memory, "memory");
+  locate(this->Io, "io");
+}
+
+cmCTestSystemPressure::Sample cmCTestSystemPressure::Take()
+{
+  auto const now = std::chrono::steady_clock::now();
+  double const elapsed =
+    this->Last == std::chrono::steady_clock::time_point()
+    ? 0
+    : std::chrono::duration<double>(now - this->Last).count();
+  this->Last = now;
+
+  Sample sample;
+  sample.Cpu = this->TakeStall(this->Cpu, elapsed);
+  sample.Memory = this->TakeStall(this->Memory, elapsed);
+  sample.Io = this->TakeStall(this->Io, elapsed);
+  sample.CpuLimit = this->GetCpuLimit();
+  sample.MemoryUsage = this->GetMemoryUsage();
+  return sample;
+}
+
+bool cmCTestSystemPressure::ParsePressure(std::string const& content,
+                                          char const* prefix, double& avg10,
+                                          unsigned long long& total)
+{
+  std::string const start = cmStrCat(prefix, ' ');
+  for (std::string const& line : cmTokenize(content, "\n")) {
+    if (!cmHasPrefix(line, start)) {
+      continue;
+    }
+    bool haveAvg10 = false;
+    bool haveTotal = false;
+    for (std::string const& field : cmTokenize(line, " ")) {
+      char* end = nullptr;
+      if (cmHasLiteralPrefix(field, "avg10=")) {
+        avg10 = std::strtod(field.c_str() + 6, &end);
+        haveAvg10 = *end == '\0';
+      } else if (cmHasLiteralPrefix(field, "total=")) {
+        total = std::strtoull(field.c_str() + 6, &end, 10);
+        haveTotal = *end == '\0';
+      }
+    }
+    return haveAvg10 && haveTotal;
+  }
+  return false;
+}
+
+cm::optional<double> cmCTestSystemPressure::TakeStall(Resource& resource,
+                                                      double elapsed)
+{
+  std::string content;
+  {
+    cmsys::ifstream fin(resource.File.c_str());
+    std::string line;
+    while (cmSystemTools::GetLineFromStream(fin, line)) {
+      content += line;
+      content += '\n';
+    }
+  }
+  double avg10 = 0;
+  unsigned long long total = 0;
+  if (!ParsePressure(content, "some", avg10, total)) {
+    resource.Total = cm::nullopt;
+    return cm::nullopt;
+  }
+
+  // The total stall time in microseconds tells the pressure since the
+  // previous sample, which follows changes faster than the averages.
+  double stall = avg10;
+  if (resource.Total && elapsed > 0 && total >= *resource.Total) {
+    stall = static_cast<double>(total - *resource.Total) / (elapsed * 1e4);
+  }
+  resource.Total = total;
+  return std::min(stall, 100.0);
+}
+
+cm::optional<double> cmCTestSystemPressure::GetCpuLimit() const
+{
+  // The limit of a cgroup also applies to its descendants.
+  cm::optional<double> limit;
+  for (std::string dir = this->CgroupDir;
+       !dir.empty() && dir.size() >= this->CgroupMount.size();
+       dir = cmSystemTools::GetParentDirectory(dir)) {
+    std::string period;
+    cm::optional<double> const quota =
+      ReadLimit(cmStrCat(dir, "/cpu.max"), &period);
+    double const periodValue = std::strtod(period.c_str(), nullptr);
+    if (quota && periodValue > 0) {
+      double const cpus = *quota / periodValue;
+      limit = limit ? std::min(*limit, cpus) : cpus;
+    }
+    if (dir.size() == this->CgroupMount.size()) {
+      break;
+    }
+  }
+  return limit;
+}
+
+cm::optional<double> cmCTestSystemPressure::GetMemoryUsage() const
+{
+  if (this->CgroupDir.empty()) {
+    return cm::nullopt;
+  }
+  cm::optional<double> const current =
+    ReadLimit(cmStrCat(this->CgroupDir, "/memory.current"));
+  cm::optional<double> limit;
+  for (std::string dir = this->CgroupDir;
+       dir.size() >= this->CgroupMount.size();
+       dir = cmSystemTools::GetParentDirectory(dir)) {
+    cm::optional<double> const max = ReadLimit(cmStrCat(dir, "/memory.max"));
+    if (max && *max > 0) {
+      limit = limit ? std::min(*limit, *max) : *max;
+    }
+    if (dir.size() == this->CgroupMount.size()) {
+      break;
+    }
+  }
+  if (!current || !limit) {
+    return cm::nullopt;
+  }
+  return *current / *limit;
+}
@@ -0,0 +1,64 @@
+/* Distributed under the OSI-approved BSD 3-Clause License.  See accompanying
+   file Copyright.txt or https://cmake.org/licensing for details.  */
+#pragma once
+
+#include "cmConfigure.h" // IWYU pragma: keep
+
+#include <chrono>
+#include <string>
+
+#include <cm/optional>
+
+/** \class cmCTestSystemPressure
+ * \brief Sample how much the tasks of the system stall on resources.
+ *
+ * Reads the Linux pressure stall information of the cgroup in which ctest
+ * runs, or else of the whole system, and the CPU and memory limits of the
+ * cgroup.  Only the unified (v2) cgroup hierarchy is supported.  On other
+ * systems no values are available.
+ */
+class cmCTestSystemPressure
+{
+public:
+  struct Sample
+  {
+    // Percentage of time in which some tasks stalled on each resource.
+    cm::optional<double> Cpu;
+    cm::optional<double> Memory;
+    cm::optional<double> Io;
+    // Number of CPUs the cgroup may use.
+    cm::optional<double> CpuLimit;
+    // Fraction of the memory limit of the cgroup in use.
+    cm::optional<double> MemoryUsage;
+  };
+
+  /** Read the files under the given root instead of '/', for testing.  */
+  explicit cmCTestSystemPressure(std::string root = std::string());
+
+  /** Take a sample.  The stall percentages cover the time since the
+      previous sample, or the last ten seconds for the first one.  */
+  Sample Take();
+
+  /** Parse the line of a pressure file with the given prefix, such as
+      "some avg10=1.50 avg60=0.80 avg300=0.20 total=123456".  */
+  static bool ParsePressure(std::string const& content, char const* prefix,
+                            double& avg10, unsigned long long& total);
+
+private:
+  struct Resource
+  {
+    std::string File;
+    cm::optional<unsigned long long> Total;
+  };
+
+  cm::optional<double> TakeStall(Resource& resource, double elapsed);
+  cm::optional<double> GetCpuLimit() const;
+  cm::optional<double> GetMemoryUsage() const;
+
+  std::string CgroupMount;
+  std::string CgroupDir;
+  Resource Cpu;
+  Resource Memory;
+  Resource Io;
+  std::chrono::steady_clock::time_point Last;
+};
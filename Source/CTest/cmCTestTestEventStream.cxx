@@ -0,0 +1,132 @@
+/* Distributed under the OSI-approved BSD 3-Clause License.  See accompanying
+   file Copyright.txt or https://cmake.org/licensing for details.  */
+#include "cmCTestTestEventStream.h"
+
+#include <chrono>
+#include <ios>
+#include <utility>
+
+#include <cm3p/json/writer.h>
+
+cmCTestTestEventStream::cmCTestTestEventStream() = default;
+
+cmCTestTestEventStream::~cmCTestTestEventStream() = default;
+
+bool cmCTestTestEventStream::Open(std::string const& fileName)
+{
+  // Opening a FIFO waits for a reader to open it.
+  this->Stream.open(fileName.c_str(), std::ios::out | std::ios::trunc);
+  if (!this->Stream) {
+    return false;
+  }
+  Json::StreamWriterBuilder builder;
+  builder["indentation"] = "";
+  this->Writer.reset(builder.newStreamWriter());
+  return true;
+}
+
+void cmCTestTestEventStream::RunStarted(std::size_t tests)
+{
+  Json::Value event = this->MakeEvent("runStarted");
+  Json::Value version = Json::objectValue;
+  version["major"] = 1;
+  version["minor"] = 0;
+  event["version"] = std::move(version);
+  event["tests"] = static_cast<Json::UInt64>(tests);
+  this->Write(event);
+}
+
+void cmCTestTestEventStream::RunFinished()
+{
+  this->Write(this->MakeEvent("runFinished"));
+}
+
+void cmCTestTestEventStream::TestResourcesAllocated(
+  cmCTestTestHandler::cmCTestTestProperties const& test,
+  Allocations const& allocations)
+{
+  Json::Value event = this->MakeTestEvent("testResourcesAllocated", test);
+  Json::Value groups = Json::arrayValue;
+  for (auto const& group : allocations) {
+    Json::Value types = Json::objectValue;
+    for (auto const& type : group) {
+      Json::Value resources = Json::arrayValue;
+      for (auto const& resource : type.second) {
+        Json::Value r = Json::objectValue;
+        r["id"] = resource.Id;
+        r["slots"] = resource.Slots;
+        resources.append(std::move(r));
+      }
+      types[type.first] = std::move(resources);
+    }
+    groups.append(std::move(types));
+  }
+  event["resourceGroups"] = std::move(groups);
+  this->Write(event);
+}
+
+void cmCTestTestEventStream::TestStarted(
+  cmCTestTestHandler::cmCTestTestProperties const& test)
+{
+  this->Write(this->MakeTestEvent("testStarted", test));
+}
+
+void cmCTestTestEventStream::TestOutput(
+  cmCTestTestHandler::cmCTestTestProperties const& test, cm::string_view text)
+{
+  Json::Value event = this->MakeTestEvent("testOutput", test);
+  event["text"] = Json::Value(text.data(), text.data() + text.size());
+  this->Write(event);
+}
+
+void cmCTestTestEventStream::TestFinished(
+  cmCTestTestHandler::cmCTestTestResult const& result)
+{
+  Json::Value event = this->MakeTestEvent("testFinished", *result.Properties);
+  if (result.Status == cmCTestTestHandler::COMPLETED) {
+    event["status"] = "passed";
+  } else if (result.Status == cmCTestTestHandler::NOT_RUN) {
+    event["status"] = "notrun";
+  } else {
+    event["status"] = "failed";
+  }
+  event["completionStatus"] = result.CustomCompletionStatus.empty()
+    ? result.CompletionStatus
+    : result.CustomCompletionStatus;
+  if (!result.Reason.empty()) {
+    event["reason"] = result.Reason;
+  }
+  event["returnValue"] = static_cast<Json::Int64>(result.ReturnValue);
+  event["executionTime"] =
+    std::chrono::duration<double>(result.ExecutionTime).count();
+  this->Write(event);
+}
+
+Json::Value cmCTestTestEventStream::MakeEvent(char const* event)
+{
+  Json::Value value = Json::objectValue;
+  value["event"] = event;
+  value["time"] = std::chrono::duration<double>(
+                    std::chrono::system_clock::now().time_since_epoch())
+                    .count();
+  return value;
+}
+
+Json::Value cmCTestTestEventStream::MakeTestEvent(
+  char const* event, cmCTestTestHandler::cmCTestTestProperties const& test)
+{
+  Json::Value value = this->MakeEvent(event);
+  value["index"] = test.Index;
+  value["name"] = test.Name;
+  return value;
+}
+
+void cmCTestTestEventStream::Write(Json::Value const& event)
+{
+  if (!this->Writer || !this->Stream) {
+    return;
+  }
+  this->Writer->write(event, &this->Stream);
+  this->Stream << '\n';
+  this->Stream.flush();
+}
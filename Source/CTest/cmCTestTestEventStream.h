@@ -0,0 +1,67 @@
+/* Distributed under the OSI-approved BSD 3-Clause License.  See accompanying
+   file Copyright.txt or https://cmake.org/licensing for details.  */
+#pragma once
+
+#include "cmConfigure.h" // IWYU pragma: keep
+
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <cm/string_view>
+
+#include <cm3p/json/value.h> // IWYU pragma: keep
+
+#include "cmsys/FStream.hxx"
+
+#include "cmCTestMultiProcessHandler.h"
+#include "cmCTestTestHandler.h"
+
+namespace Json {
+class StreamWriter;
+}
+
+/** \class cmCTestTestEventStream
+ * \brief Write the events of a test run while it runs.
+ *
+ * Each event is a JSON object on a line of its own, written and flushed
+ * when it happens, so that a process reading the file or a FIFO can
+ * follow the run.
+ */
+class cmCTestTestEventStream
+{
+public:
+  using Allocations = std::vector<std::map<
+    std::string, std::vector<cmCTestMultiProcessHandler::ResourceAllocation>>>;
+
+  cmCTestTestEventStream();
+  ~cmCTestTestEventStream();
+
+  cmCTestTestEventStream(cmCTestTestEventStream const&) = delete;
+  cmCTestTestEventStream& operator=(cmCTestTestEventStream const&) = delete;
+
+  /** Open the file, which may be a FIFO.  Returns false on failure.  */
+  bool Open(std::string const& fileName);
+
+  void RunStarted(std::size_t tests);
+  void RunFinished();
+
+  void TestResourcesAllocated(
+    cmCTestTestHandler::cmCTestTestProperties const& test,
+    Allocations const& allocations);
+  void TestStarted(cmCTestTestHandler::cmCTestTestProperties const& test);
+  void TestOutput(cmCTestTestHandler::cmCTestTestProperties const& test,
+                  cm::string_view text);
+  void TestFinished(cmCTestTestHandler::cmCTestTestResult const& result);
+
+private:
+  Json::Value MakeEvent(char const* event);
+  Json::Value MakeTestEvent(
+    char const* event, cmCTestTestHandler::cmCTestTestProperties const& test);
+  void Write(Json::Value const& event);
+
+  cmsys::ofstream Stream;
+  std::unique_ptr<Json::StreamWriter> Writer;
+};
@@ -13,6 +13,7 @@
 #include <functional>
 #include <iomanip>
 #include <iterator>
+#include <map>
 #include <ratio>
 #include <set>
 #include <sstream>
@@ -23,6 +24,7 @@
 #endif
 
 #include <cm/memory>
+#include <cm/optional>
 #include <cm/string_view>
 #include <cmext/algorithm>
 #include <cmext/string_view>
@@ -35,6 +37,7 @@
 #include "cm_utf8.h"
 
 #include "cmCTest.h"
+#include "cmCTestGIT.h"
 #include "cmCTestMultiProcessHandler.h"
 #include "cmCTestResourceGroupsLexerHelper.h"
 #include "cmCTestTestMeasurementXMLParser.h"
@@ -48,6 +51,8 @@
 #include "cmStateSnapshot.h"
 #include "cmStringAlgorithms.h"
 #include "cmSystemTools.h"
+#include "cmTestImpact.h"
+#include "cmTestManifest.h"
 #include "cmTimestamp.h"
 #include "cmValue.h"
 #include "cmWorkingDirectory.h"
@@ -274,6 +279,59 @@ inline int GetNextRealNumber(std::string const& in, double& val,
   return 0;
 }
 
+// Decide whether changes to a set of files affect a test, using the
+// impact files the generator writes next to CTestTestfile.cmake.
+class cmCTestAffectedTests
+{
+public:
+  explicit cmCTestAffectedTests(std::set<std::string> const& changed)
+    : Changed(changed)
+  {
+  }
+
+  bool IsAffected(cmCTestTestHandler::cmCTestTestProperties const& tp)
+  {
+    // Without information about the test, assume it is affected.
+    cm::optional<cmTestImpact> const& impact =
+      this->GetImpact(tp.ImpactDirectory);
+    if (!impact) {
+      return true;
+    }
+    std::set<std::string> const* targets = impact->GetTestTargets(tp.Name);
+    if (!targets) {
+      return true;
+    }
+    for (std::string const& file : tp.RequiredFiles) {
+      if (this->Changed.count(cmSystemTools::GetRealPath(
+            cmSystemTools::CollapseFullPath(file, tp.Directory)))) {
+        return true;
+      }
+    }
+    return std::any_of(targets->begin(), targets->end(),
+                       [this, &impact](std::string const& target) {
+                         return impact->IsAffected(target, this->Changed);
+                       });
+  }
+
+private:
+  cm::optional<cmTestImpact> const& GetImpact(std::string const& dir)
+  {
+    auto it = this->Impacts.find(dir);
+    if (it == this->Impacts.end()) {
+      cm::optional<cmTestImpact> impact;
+      impact.emplace();
+      if (!impact->Load(dir)) {
+        impact.reset();
+      }
+      it = this->Impacts.emplace(dir, std::move(impact)).first;
+    }
+    return it->second;
+  }
+
+  std::set<std::string> const& Changed;
+  std::map<std::string, cm::optional<cmTestImpact>> Impacts;
+};
+
 } // namespace
 
 cmCTestTestHandler::cmCTestTestHandler()
@@ -349,6 +407,9 @@ void cmCTestTestHandler::Initialize()
   this->ExcludeTestListFile.clear();
   this->TestsToRunByName.reset();
   this->TestsToExcludeByName.reset();
+  this->AffectedByFile.clear();
+  this->AffectedByGit.clear();
+  this->ChangedFiles.reset();
 
   this->TestsToRunString.clear();
   this->UseUnion = false;
@@ -425,10 +486,29 @@ int cmCTestTestHandler::ProcessHandler()
   std::vector<std::string> passed;
   std::vector<std::string> failed;
 
+  // Write the results of tests to a Test.xml fragment as they finish
+  // so that their output need not be kept until the end.  Tests compare
+  // the result with that of keeping the output.
+  cmGeneratedFileStream resultsFragment;
+  this->TestResultsFragmentName.clear();
+  if (this->CTest->GetProduceXML() && !this->MemCheck &&
+      !cmSystemTools::HasEnv("__CTEST_NO_RESULTS_FRAGMENT_FOR_TESTING")) {
+    std::string const name = "TestResults.xml.part";
+    if (this->CTest->OpenOutputFile("Temporary", name, resultsFragment)) {
+      this->TestResultsFragment = &resultsFragment;
+      this->TestResultsFragmentName =
+        cmStrCat(this->CTest->GetBinaryDir(), "/Testing/Temporary/", name);
+    }
+  }
+
   // start the real time clock
   auto clock_start = std::chrono::steady_clock::now();
 
-  if (!this->ProcessDirectory(passed, failed)) {
+  bool const processed = this->ProcessDirectory(passed, failed);
+  this->TestResultsFragment = nullptr;
+  resultsFragment.Close();
+  if (!processed) {
+    this->RemoveTestResultsFragment();
     return -1;
   }
 
@@ -475,7 +555,9 @@ int cmCTestTestHandler::ProcessHandler()
     this->LogFailedTests(failed, resultsSet);
   }
 
-  if (!this->GenerateXML()) {
+  bool const generated = this->GenerateXML();
+  this->RemoveTestResultsFragment();
+  if (!generated) {
     return 1;
   }
 
@@ -601,6 +683,18 @@ bool cmCTestTestHandler::ProcessOptions()
   if (val) {
     this->ResourceSpecFile = *val;
   }
+  val = this->GetOption("ShardCoordinator");
+  if (val) {
+    this->ShardCoordinator = *val;
+  }
+  val = this->GetOption("TestEventsFile");
+  if (val) {
+    this->TestEventsFile = *val;
+  }
+  val = this->GetOption("TestPressure");
+  if (val) {
+    this->TestPressure = std::strtod(val->c_str(), nullptr);
+  }
   val = this->GetOption("TestListFile");
   if (val) {
     this->TestListFile = val;
@@ -609,11 +703,27 @@ bool cmCTestTestHandler::ProcessOptions()
   if (val) {
     this->ExcludeTestListFile = val;
   }
+  val = this->GetOption("AffectedByFile");
+  if (val) {
+    this->AffectedByFile = *val;
+  }
+  val = this->GetOption("AffectedByGit");
+  if (val) {
+    this->AffectedByGit = *val;
+  }
   this->SetRerunFailed(this->GetOption("RerunFailed").IsOn());
 
   return true;
 }
 
+void cmCTestTestHandler::RemoveTestResultsFragment()
+{
+  if (!this->TestResultsFragmentName.empty()) {
+    cmSystemTools::RemoveFile(this->TestResultsFragmentName);
+    this->TestResultsFragmentName.clear();
+  }
+}
+
 void cmCTestTestHandler::LogTestSummary(const std::vector<std::string>& passed,
                                         const std::vector<std::string>& failed,
                                         const cmDuration& durationInSecs)
@@ -949,6 +1059,10 @@ bool cmCTestTestHandler::ComputeTestList()
   int cnt = 0;
   inREcnt = 0;
   ListOfTests finalList;
+  cm::optional<cmCTestAffectedTests> affected;
+  if (this->ChangedFiles) {
+    affected.emplace(*this->ChangedFiles);
+  }
   for (cmCTestTestProperties& tp : this->TestList) {
     cnt++;
     if (tp.IsInBasedOnREOptions) {
@@ -985,6 +1099,10 @@ bool cmCTestTestHandler::ComputeTestList()
       }
     }
 
+    if (affected && !affected->IsAffected(tp)) {
+      continue;
+    }
+
     tp.Index = cnt; // save the index into the test list for this test
     finalList.push_back(tp);
   }
@@ -1401,6 +1519,9 @@ bool cmCTestTestHandler::ProcessDirectory(std::vector<std::string>& passed,
   } else {
     parallel->SetTestLoad(this->CTest->GetTestLoad());
   }
+  if (this->TestPressure) {
+    parallel->SetTestPressure(*this->TestPressure);
+  }
 
   *this->LogFile
     << "Start testing: " << this->CTest->CurrentTime() << std::endl
@@ -1436,6 +1557,8 @@ bool cmCTestTestHandler::ProcessDirectory(std::vector<std::string>& passed,
     properties[p.Index] = &p;
   }
   parallel->SetResourceSpecFile(this->ResourceSpecFile);
+  parallel->SetShardCoordinator(this->ShardCoordinator);
+  parallel->SetTestEventsFile(this->TestEventsFile);
   if (!parallel->SetTests(std::move(tests), std::move(properties))) {
     return false;
   }
@@ -1482,101 +1605,124 @@ void cmCTestTestHandler::GenerateCTestXML(cmXMLWriter& xml)
     xml.Element("Test", this->CTest->GetShortPathToFile(testPath));
   }
   xml.EndElement(); // TestList
-  for (cmCTestTestResult& result : this->TestResults) {
-    this->WriteTestResultHeader(xml, result);
-    xml.StartElement("Results");
+  if (!this->TestResultsFragmentName.empty()) {
+    xml.FragmentFile(this->TestResultsFragmentName.c_str());
+  } else {
+    for (cmCTestTestResult& result : this->TestResults) {
+      this->WriteTestResult(xml, result);
+    }
+  }
 
-    if (result.Status != cmCTestTestHandler::NOT_RUN) {
-      if (result.Status != cmCTestTestHandler::COMPLETED ||
-          result.ReturnValue) {
-        xml.StartElement("NamedMeasurement");
-        xml.Attribute("type", "text/string");
-        xml.Attribute("name", "Exit Code");
-        xml.Element("Value", this->GetTestStatus(result));
-        xml.EndElement(); // NamedMeasurement
+  xml.Element("EndDateTime", this->EndTest);
+  xml.Element("EndTestTime", this->EndTestTime);
+  xml.Element(
+    "ElapsedMinutes",
+    std::chrono::duration_cast<std::chrono::minutes>(this->ElapsedTestingTime)
+      .count());
+  xml.EndElement(); // Testing
+  this->CTest->EndXML(xml);
+}
 
-        xml.StartElement("NamedMeasurement");
-        xml.Attribute("type", "text/string");
-        xml.Attribute("name", "Exit Value");
-        xml.Element("Value", result.ReturnValue);
-        xml.EndElement(); // NamedMeasurement
-      }
-      this->RecordCustomTestMeasurements(xml, result.TestMeasurementsOutput);
+void cmCTestTestHandler::RecordTestResult(cmCTestTestResult result)
+{
+  if (this->TestResultsFragment) {
+    cmXMLWriter xml(*this->TestResultsFragment, 2);
+    this->WriteTestResult(xml, result);
+    // Only the JUnit output still needs the output of the test.
+    if (this->JUnitXMLFileName.empty()) {
+      std::string().swap(result.Output);
+    }
+  }
+  this->TestResults.push_back(std::move(result));
+}
+
+void cmCTestTestHandler::WriteTestResult(cmXMLWriter& xml,
+                                         cmCTestTestResult& result)
+{
+  this->WriteTestResultHeader(xml, result);
+  xml.StartElement("Results");
+
+  if (result.Status != cmCTestTestHandler::NOT_RUN) {
+    if (result.Status != cmCTestTestHandler::COMPLETED ||
+        result.ReturnValue) {
       xml.StartElement("NamedMeasurement");
-      xml.Attribute("type", "numeric/double");
-      xml.Attribute("name", "Execution Time");
-      xml.Element("Value", result.ExecutionTime.count());
+      xml.Attribute("type", "text/string");
+      xml.Attribute("name", "Exit Code");
+      xml.Element("Value", this->GetTestStatus(result));
       xml.EndElement(); // NamedMeasurement
-      if (!result.Reason.empty()) {
-        const char* reasonType = "Pass Reason";
-        if (result.Status != cmCTestTestHandler::COMPLETED) {
-          reasonType = "Fail Reason";
-        }
-        xml.StartElement("NamedMeasurement");
-        xml.Attribute("type", "text/string");
-        xml.Attribute("name", reasonType);
-        xml.Element("Value", result.Reason);
-        xml.EndElement(); // NamedMeasurement
-      }
-    }
 
+      xml.StartElement("NamedMeasurement");
+      xml.Attribute("type", "text/string");
+      xml.Attribute("name", "Exit Value");
+      xml.Element("Value", result.ReturnValue);
+      xml.EndElement(); // NamedMeasurement
+    }
+    this->RecordCustomTestMeasurements(xml, result.TestMeasurementsOutput);
     xml.StartElement("NamedMeasurement");
     xml.Attribute("type", "numeric/double");
-    xml.Attribute("name", "Processors");
-    xml.Element("Value", result.Properties->Processors);
+    xml.Attribute("name", "Execution Time");
+    xml.Element("Value", result.ExecutionTime.count());
     xml.EndElement(); // NamedMeasurement
-
-    xml.StartElement("NamedMeasurement");
-    xml.Attribute("type", "text/string");
-    xml.Attribute("name", "Completion Status");
-    if (result.CustomCompletionStatus.empty()) {
-      xml.Element("Value", result.CompletionStatus);
-    } else {
-      xml.Element("Value", result.CustomCompletionStatus);
+    if (!result.Reason.empty()) {
+      const char* reasonType = "Pass Reason";
+      if (result.Status != cmCTestTestHandler::COMPLETED) {
+        reasonType = "Fail Reason";
+      }
+      xml.StartElement("NamedMeasurement");
+      xml.Attribute("type", "text/string");
+      xml.Attribute("name", reasonType);
+      xml.Element("Value", result.Reason);
+      xml.EndElement(); // NamedMeasurement
     }
-    xml.EndElement(); // NamedMeasurement
+  }
 
-    xml.StartElement("NamedMeasurement");
-    xml.Attribute("type", "text/string");
-    xml.Attribute("name", "Command Line");
-    xml.Element("Value", result.FullCommandLine);
-    xml.EndElement(); // NamedMeasurement
+  xml.StartElement("NamedMeasurement");
+  xml.Attribute("type", "numeric/double");
+  xml.Attribute("name", "Processors");
+  xml.Element("Value", result.Properties->Processors);
+  xml.EndElement(); // NamedMeasurement
 
+  xml.StartElement("NamedMeasurement");
+  xml.Attribute("type", "text/string");
+  xml.Attribute("name", "Completion Status");
+  if (result.CustomCompletionStatus.empty()) {
+    xml.Element("Value", result.CompletionStatus);
+  } else {
+    xml.Element("Value", result.CustomCompletionStatus);
+  }
+  xml.EndElement(); // NamedMeasurement
+
+  xml.StartElement("NamedMeasurement");
+  xml.Attribute("type", "text/string");
+  xml.Attribute("name", "Command Line");
+  xml.Element("Value", result.FullCommandLine);
+  xml.EndElement(); // NamedMeasurement
+
+  xml.StartElement("NamedMeasurement");
+  xml.Attribute("type", "text/string");
+  xml.Attribute("name", "Environment");
+  xml.Element("Value", result.Environment);
+  xml.EndElement(); // NamedMeasurement
+  for (auto const& measure : result.Properties->Measurements) {
     xml.StartElement("NamedMeasurement");
     xml.Attribute("type", "text/string");
-    xml.Attribute("name", "Environment");
-    xml.Element("Value", result.Environment);
+    xml.Attribute("name", measure.first);
+    xml.Element("Value", measure.second);
     xml.EndElement(); // NamedMeasurement
-    for (auto const& measure : result.Properties->Measurements) {
-      xml.StartElement("NamedMeasurement");
-      xml.Attribute("type", "text/string");
-      xml.Attribute("name", measure.first);
-      xml.Element("Value", measure.second);
-      xml.EndElement(); // NamedMeasurement
-    }
-    xml.StartElement("Measurement");
-    xml.StartElement("Value");
-    if (result.CompressOutput) {
-      xml.Attribute("encoding", "base64");
-      xml.Attribute("compression", "gzip");
-    }
-    xml.Content(result.Output);
-    xml.EndElement(); // Value
-    xml.EndElement(); // Measurement
-    xml.EndElement(); // Results
-
-    this->AttachFiles(xml, result);
-    this->WriteTestResultFooter(xml, result);
   }
+  xml.StartElement("Measurement");
+  xml.StartElement("Value");
+  if (result.CompressOutput) {
+    xml.Attribute("encoding", "base64");
+    xml.Attribute("compression", "gzip");
+  }
+  xml.Content(result.Output);
+  xml.EndElement(); // Value
+  xml.EndElement(); // Measurement
+  xml.EndElement(); // Results
 
-  xml.Element("EndDateTime", this->EndTest);
-  xml.Element("EndTestTime", this->EndTestTime);
-  xml.Element(
-    "ElapsedMinutes",
-    std::chrono::duration_cast<std::chrono::minutes>(this->ElapsedTestingTime)
-      .count());
-  xml.EndElement(); // Testing
-  this->CTest->EndXML(xml);
+  this->AttachFiles(xml, result);
+  this->WriteTestResultFooter(xml, result);
 }
 
 void cmCTestTestHandler::WriteTestResultHeader(cmXMLWriter& xml,
@@ -1822,52 +1968,70 @@ bool cmCTestTestHandler::GetListOfTests()
   }
   cmCTestOptionalLog(this->CTest, HANDLER_VERBOSE_OUTPUT,
                      "Constructing a list of tests" << std::endl, this->Quiet);
-  cmake cm(cmake::RoleScript, cmState::CTest);
-  cm.SetHomeDirectory("");
-  cm.SetHomeOutputDirectory("");
-  cm.GetCurrentSnapshot().SetDefaultDefinitions();
-  cmGlobalGenerator gg(&cm);
-  cmMakefile mf(&gg, cm.GetCurrentSnapshot());
-  mf.AddDefinition("CTEST_CONFIGURATION_TYPE", this->CTest->GetConfigType());
-
-  // Add handler for ADD_TEST
-  cm.GetState()->AddBuiltinCommand("add_test", cmCTestAddTestCommand(this));
-
-  // Add handler for SUBDIRS
-  cm.GetState()->AddBuiltinCommand("subdirs", cmCTestSubdirCommand);
-
-  // Add handler for ADD_SUBDIRECTORY
-  cm.GetState()->AddBuiltinCommand("add_subdirectory",
-                                   cmCTestAddSubdirectoryCommand);
-
-  // Add handler for SET_TESTS_PROPERTIES
-  cm.GetState()->AddBuiltinCommand("set_tests_properties",
-                                   cmCTestSetTestsPropertiesCommand(this));
-
-  // Add handler for SET_DIRECTORY_PROPERTIES
-  cm.GetState()->RemoveBuiltinCommand("set_directory_properties");
-  cm.GetState()->AddBuiltinCommand("set_directory_properties",
-                                   cmCTestSetDirectoryPropertiesCommand(this));
-
-  const char* testFilename;
-  if (cmSystemTools::FileExists("CTestTestfile.cmake")) {
-    // does the CTestTestfile.cmake exist ?
-    testFilename = "CTestTestfile.cmake";
-  } else if (cmSystemTools::FileExists("DartTestfile.txt")) {
-    // does the DartTestfile.txt exist ?
-    testFilename = "DartTestfile.txt";
+  // Replay the precompiled manifests if they are all up to date.
+  // Otherwise evaluate the CTestTestfile.cmake scripts.
+  cm::optional<std::string> specFile;
+  if (this->LoadTestManifest(cmSystemTools::GetCurrentWorkingDirectory(),
+                             specFile)) {
+    cmCTestOptionalLog(this->CTest, HANDLER_VERBOSE_OUTPUT,
+                       "Loaded tests from manifest" << std::endl,
+                       this->Quiet);
   } else {
-    return true;
-  }
+    this->TestList.clear();
+    specFile = cm::nullopt;
+
+    cmake cm(cmake::RoleScript, cmState::CTest);
+    cm.SetHomeDirectory("");
+    cm.SetHomeOutputDirectory("");
+    cm.GetCurrentSnapshot().SetDefaultDefinitions();
+    cmGlobalGenerator gg(&cm);
+    cmMakefile mf(&gg, cm.GetCurrentSnapshot());
+    mf.AddDefinition("CTEST_CONFIGURATION_TYPE",
+                     this->CTest->GetConfigType());
+
+    // Add handler for ADD_TEST
+    cm.GetState()->AddBuiltinCommand("add_test",
+                                     cmCTestAddTestCommand(this));
+
+    // Add handler for SUBDIRS
+    cm.GetState()->AddBuiltinCommand("subdirs", cmCTestSubdirCommand);
+
+    // Add handler for ADD_SUBDIRECTORY
+    cm.GetState()->AddBuiltinCommand("add_subdirectory",
+                                     cmCTestAddSubdirectoryCommand);
+
+    // Add handler for SET_TESTS_PROPERTIES
+    cm.GetState()->AddBuiltinCommand("set_tests_properties",
+                                     cmCTestSetTestsPropertiesCommand(this));
+
+    // Add handler for SET_DIRECTORY_PROPERTIES
+    cm.GetState()->RemoveBuiltinCommand("set_directory_properties");
+    cm.GetState()->AddBuiltinCommand(
+      "set_directory_properties", cmCTestSetDirectoryPropertiesCommand(this));
 
-  if (!mf.ReadListFile(testFilename)) {
-    return false;
+    const char* testFilename;
+    if (cmSystemTools::FileExists("CTestTestfile.cmake")) {
+      // does the CTestTestfile.cmake exist ?
+      testFilename = "CTestTestfile.cmake";
+    } else if (cmSystemTools::FileExists("DartTestfile.txt")) {
+      // does the DartTestfile.txt exist ?
+      testFilename = "DartTestfile.txt";
+    } else {
+      return true;
+    }
+
+    if (!mf.ReadListFile(testFilename)) {
+      return false;
+    }
+    if (cmValue spec = mf.GetDefinition("CTEST_RESOURCE_SPEC_FILE")) {
+      specFile = *spec;
+    }
   }
   if (cmSystemTools::GetErrorOccurredFlag()) {
-    // SEND_ERROR or FATAL_ERROR in CTestTestfile or TEST_INCLUDE_FILES
+    // SEND_ERROR or FATAL_ERROR in CTestTestfile or TEST_INCLUDE_FILES,
+    // or an error reported earlier
     return false;
   }
-  cmValue specFile = mf.GetDefinition("CTEST_RESOURCE_SPEC_FILE");
   if (this->ResourceSpecFile.empty() && specFile) {
     this->ResourceSpecFile = *specFile;
   }
@@ -1885,6 +2049,12 @@ bool cmCTestTestHandler::GetListOfTests()
       return false;
     }
   }
+  if (!this->AffectedByFile.empty() || !this->AffectedByGit.empty()) {
+    this->ChangedFiles = this->ReadChangedFiles();
+    if (!this->ChangedFiles) {
+      return false;
+    }
+  }
 
   cmCTestOptionalLog(this->CTest, HANDLER_VERBOSE_OUTPUT,
                      "Done constructing a list of tests" << std::endl,
@@ -1892,6 +2062,73 @@ bool cmCTestTestHandler::GetListOfTests()
   return true;
 }
 
+bool cmCTestTestHandler::LoadTestManifest(std::string const& dir,
+                                          cm::optional<std::string>& specFile)
+{
+  cmTestManifest manifest;
+  if (!manifest.Load(dir)) {
+    return false;
+  }
+  cmWorkingDirectory workdir(dir);
+  if (workdir.Failed()) {
+    return false;
+  }
+
+  std::string const& config = this->CTest->GetConfigType();
+  for (cmTestManifest::Record const& record : manifest.GetRecords()) {
+    if (!record.AppliesTo(config)) {
+      continue;
+    }
+    switch (record.Cmd) {
+      case cmTestManifest::Command::AddTest:
+        if (record.Args.size() < 2 || !this->AddTest(record.Args)) {
+          return false;
+        }
+        break;
+      case cmTestManifest::Command::SetTestsProperties:
+        if (!this->SetTestsProperties(record.Args)) {
+          return false;
+        }
+        break;
+      case cmTestManifest::Command::SetDirectoryProperties:
+        if (!this->SetDirectoryProperties(record.Args)) {
+          return false;
+        }
+        break;
+      case cmTestManifest::Command::Subdirs:
+        for (std::string const& arg : record.Args) {
+          // Resolve the subdirectory the same way the subdirs() command
+          // does.  Directories without tests are skipped.
+          std::string subdir = cmSystemTools::FileIsFullPath(arg)
+            ? arg
+            : cmStrCat(cmSystemTools::GetCurrentWorkingDirectory(), '/', arg);
+          if (!cmSystemTools::FileExists(subdir)) {
+            continue;
+          }
+          if (!cmSystemTools::FileExists(
+                cmStrCat(subdir, "/CTestTestfile.cmake"))) {
+            if (cmSystemTools::FileExists(
+                  cmStrCat(subdir, "/DartTestfile.txt"))) {
+              return false;
+            }
+            continue;
+          }
+          if (!this->LoadTestManifest(subdir, specFile)) {
+            return false;
+          }
+        }
+        break;
+      case cmTestManifest::Command::SetResourceSpecFile:
+        if (record.Args.empty()) {
+          return false;
+        }
+        specFile = record.Args.front();
+        break;
+    }
+  }
+  return true;
+}
+
 void cmCTestTestHandler::UseIncludeRegExp()
 {
   this->UseIncludeRegExpFlag = true;
@@ -2077,6 +2314,73 @@ cm::optional<std::set<std::string>> cmCTestTestHandler::ReadTestListFile(
   return result;
 }
 
+cm::optional<std::set<std::string>> cmCTestTestHandler::ReadChangedFiles()
+  const
+{
+  std::vector<std::string> files;
+  if (!this->AffectedByFile.empty()) {
+    cmsys::ifstream ifs(this->AffectedByFile.c_str());
+    if (!ifs) {
+      cmCTestLog(this->CTest, ERROR_MESSAGE,
+                 "Problem reading changed files list: "
+                   << this->AffectedByFile
+                   << " while generating list of tests to run." << std::endl);
+      return cm::nullopt;
+    }
+    std::string line;
+    while (cmSystemTools::GetLineFromStream(ifs, line)) {
+      if (!line.empty()) {
+        files.push_back(line);
+      }
+    }
+  }
+  if (!this->AffectedByGit.empty()) {
+    std::string git = this->CTest->GetCTestConfiguration("GITCommand");
+    if (git.empty()) {
+      git = cmSystemTools::FindProgram("git");
+    }
+    // Without a dashboard configuration, use the source tree of the
+    // build tree, or assume the build tree is inside the source tree.
+    std::string source = this->CTest->GetCTestConfiguration("SourceDirectory");
+    if (source.empty()) {
+      std::string const binary = cmSystemTools::GetCurrentWorkingDirectory();
+      cmState state(cmState::Unknown);
+      std::set<std::string> excludes;
+      std::set<std::string> includes;
+      cmValue home;
+      if (state.LoadCache(binary, true, excludes, includes)) {
+        home = state.GetCacheEntryValue("CMAKE_HOME_DIRECTORY");
+      }
+      source = home ? *home : binary;
+    }
+    std::ostringstream log;
+    cmCTestGIT vc(this->CTest, log);
+    vc.SetCommandLineTool(git);
+    vc.SetSourceDirectory(source);
+    if (git.empty() || !vc.GetChangedFiles(this->AffectedByGit, files)) {
+      cmCTestLog(this->CTest, ERROR_MESSAGE,
+                 "Problem getting the files changed by git revisions: "
+                   << this->AffectedByGit << std::endl
+                   << log.str());
+      return cm::nullopt;
+    }
+  }
+
+  // Relative paths are relative to the current directory.  Resolve
+  // links so that the paths compare equal to those in the impact files.
+  std::set<std::string> changed;
+  for (std::string const& file : files) {
+    changed.insert(
+      cmSystemTools::GetRealPath(cmSystemTools::CollapseFullPath(file)));
+  }
+  cmCTestOptionalLog(this->CTest, HANDLER_VERBOSE_OUTPUT,
+                     "Selecting tests affected by " << changed.size()
+                                                    << " changed files"
+                                                    << std::endl,
+                     this->Quiet);
+  return changed;
+}
+
 void cmCTestTestHandler::RecordCustomTestMeasurements(cmXMLWriter& xml,
                                                       std::string content)
 {
@@ -2564,6 +2868,7 @@ bool cmCTestTestHandler::AddTest(const std::vector<std::string>& args)
   test.Name = testname;
   test.Args = args;
   test.Directory = cmSystemTools::GetCurrentWorkingDirectory();
+  test.ImpactDirectory = test.Directory;
   cmCTestOptionalLog(this->CTest, DEBUG,
                      "Set test directory: " << test.Directory << std::endl,
                      this->Quiet);
@@ -150,6 +150,8 @@ public:
     bool WillFail = false;
     bool Disabled = false;
     float Cost = 0;
+    // Variance of the durations that Cost averages over PreviousRuns
+    float CostVariance = 0;
     int PreviousRuns = 0;
     bool RunSerial = false;
     cm::optional<cmDuration> Timeout;
@@ -175,6 +177,8 @@ public:
     std::string GeneratedResourceSpecFile;
     // Private test generator properties used to track backtraces
     cmListFileBacktrace Backtrace;
+    // The directory of the impact file that describes the test
+    std::string ImpactDirectory;
   };
 
   struct cmCTestTestResult
@@ -239,6 +243,7 @@ protected:
   int ExecuteCommands(std::vector<std::string>& vec);
 
   bool ProcessOptions();
+  void RemoveTestResultsFragment();
   void LogTestSummary(const std::vector<std::string>& passed,
                       const std::vector<std::string>& failed,
                       const cmDuration& durationInSecs);
@@ -247,6 +252,11 @@ protected:
                       const SetOfTests& resultsSet);
   bool GenerateXML();
 
+  // Keep the result of a finished test, streaming it to the Test.xml
+  // fragment if there is one.
+  void RecordTestResult(cmCTestTestResult result);
+  void WriteTestResult(cmXMLWriter& xml, cmCTestTestResult& result);
+
   void WriteTestResultHeader(cmXMLWriter& xml,
                              cmCTestTestResult const& result);
   void WriteTestResultFooter(cmXMLWriter& xml,
@@ -314,6 +324,13 @@ private:
    * Get the list of tests in directory and subdirectories.
    */
   bool GetListOfTests();
+
+  /**
+   * Get the list of tests from the manifests of a directory and its
+   * subdirectories.  Fails if any of them has no up-to-date manifest.
+   */
+  bool LoadTestManifest(std::string const& dir,
+                        cm::optional<std::string>& specFile);
   // compute the lists of tests that will actually run
   // based on union regex and -I stuff
   bool ComputeTestList();
@@ -344,6 +361,7 @@ private:
   void ExpandTestsToRunInformationForRerunFailed();
   cm::optional<std::set<std::string>> ReadTestListFile(
     std::string const& testListFileName) const;
+  cm::optional<std::set<std::string>> ReadChangedFiles() const;
 
   std::vector<std::string> CustomPreTest;
   std::vector<std::string> CustomPostTest;
@@ -366,8 +384,14 @@ private:
   std::string ExcludeTestListFile;
   cm::optional<std::set<std::string>> TestsToRunByName;
   cm::optional<std::set<std::string>> TestsToExcludeByName;
+  std::string AffectedByFile;
+  std::string AffectedByGit;
+  cm::optional<std::set<std::string>> ChangedFiles;
 
   std::string ResourceSpecFile;
+  std::string ShardCoordinator;
+  std::string TestEventsFile;
+  cm::optional<double> TestPressure;
 
   void RecordCustomTestMeasurements(cmXMLWriter& xml, std::string content);
   void CheckLabelFilter(cmCTestTestProperties& it);
@@ -385,6 +409,10 @@ private:
 
   std::ostream* LogFile;
 
+  // Test.xml results of finished tests, written as they finish.
+  std::ostream* TestResultsFragment = nullptr;
+  std::string TestResultsFragmentName;
+
   cmCTest::Repeat RepeatMode = cmCTest::Repeat::Never;
   int RepeatCount = 1;
   bool RerunFailed;
@@ -14,6 +14,7 @@
 
 #include "cmCTest.h"
 #include "cmCTestRunTest.h"
+#include "cmCTestShardCoordinator.h"
 #include "cmCTestTestHandler.h"
 #include "cmGetPipes.h"
 #include "cmStringAlgorithms.h"
@@ -33,7 +34,12 @@ cmProcess::cmProcess(std::unique_ptr<cmCTestRunTest> runner)
   this->StartTime = std::chrono::steady_clock::time_point();
 }
 
-cmProcess::~cmProcess() = default;
+cmProcess::~cmProcess()
+{
+  if (this->Coordinator) {
+    this->Coordinator->ForgetJob(this->Job);
+  }
+}
 
 void cmProcess::SetCommand(std::string const& command)
 {
@@ -150,6 +156,69 @@ bool cmProcess::StartProcess(uv_loop_t& loop, std::vector<size_t>* affinity)
   return true;
 }
 
+bool cmProcess::StartRemoteProcess(
+  uv_loop_t& loop, cmCTestShardCoordinator& coordinator,
+  std::vector<std::string> const& environment,
+  std::vector<std::string> const& environmentModification)
+{
+  this->ProcessState = cmProcess::State::Error;
+  if (this->Command.empty()) {
+    return false;
+  }
+  this->StartTime = std::chrono::steady_clock::now();
+
+  cm::uv_timer_ptr timer;
+  int status = timer.init(loop, this);
+  if (status != 0) {
+    cmCTestLog(this->Runner->GetCTest(), ERROR_MESSAGE,
+               "Error initializing timer: " << uv_strerror(status)
+                                            << std::endl);
+    return false;
+  }
+
+  uint32_t job = coordinator.StartJob(
+    this->Id, this, this->Command, this->Arguments, this->WorkingDirectory,
+    environment, environmentModification);
+  if (job == 0) {
+    return false;
+  }
+  this->Coordinator = &coordinator;
+  this->Job = job;
+  this->Timer = std::move(timer);
+
+  this->StartTimer();
+
+  this->ProcessState = cmProcess::State::Executing;
+  return true;
+}
+
+void cmProcess::OnRemoteOutput(cm::string_view data)
+{
+  if (this->ReadHandleClosed || data.empty()) {
+    return;
+  }
+  uv_buf_t buf = uv_buf_init(const_cast<char*>(data.data()),
+                             static_cast<unsigned int>(data.size()));
+  this->OnRead(static_cast<ssize_t>(data.size()), &buf);
+}
+
+void cmProcess::OnRemoteExit(bool started, int64_t exit_status,
+                             int term_signal)
+{
+  this->Coordinator = nullptr;
+  if (!this->ReadHandleClosed) {
+    this->OnRead(UV_EOF, nullptr);
+  }
+  if (!started) {
+    this->ProcessState = cmProcess::State::Error;
+    this->ProcessHandleClosed = true;
+    uv_timer_stop(this->Timer);
+    this->Finish();
+    return;
+  }
+  this->OnExit(exit_status, term_signal);
+}
+
 void cmProcess::StartTimer()
 {
   if (this->Timeout) {
@@ -286,7 +355,11 @@ void cmProcess::OnTimeout()
       this->Runner->GetTestProperties();
     if (p->TimeoutSignal) {
       this->TerminationStyle = Termination::Custom;
-      uv_process_kill(this->Process, p->TimeoutSignal->Number);
+      if (this->Coordinator) {
+        this->Coordinator->KillJob(this->Job, p->TimeoutSignal->Number);
+      } else {
+        uv_process_kill(this->Process, p->TimeoutSignal->Number);
+      }
       if (p->TimeoutGracePeriod) {
         this->Timeout = *p->TimeoutGracePeriod;
       } else {
@@ -306,7 +379,11 @@ void cmProcess::OnTimeout()
   }
   if (!this->ProcessHandleClosed) {
     // Kill the child and let our on-exit handler finish the test.
-    cmsysProcess_KillPID(static_cast<unsigned long>(this->Process->pid));
+    if (this->Coordinator) {
+      this->Coordinator->KillJob(this->Job, 0);
+    } else {
+      cmsysProcess_KillPID(static_cast<unsigned long>(this->Process->pid));
+    }
   } else if (was_still_reading) {
     // Our on-exit handler already ran but did not finish the test
     // because we were still reading output.  We've just dropped
@@ -13,6 +13,7 @@
 #include <vector>
 
 #include <cm/optional>
+#include <cm/string_view>
 
 #include <cm3p/uv.h>
 
@@ -21,6 +22,7 @@
 #include "cmUVHandlePtr.h"
 
 class cmCTestRunTest;
+class cmCTestShardCoordinator;
 
 /** \class cmProcess
  * \brief run a process with c++
@@ -40,6 +42,15 @@ public:
   void ResetStartTime();
   // Return true if the process starts
   bool StartProcess(uv_loop_t& loop, std::vector<size_t>* affinity);
+  // Return true if the process is handed to a shard worker, which runs
+  // it with the given changes to its own environment
+  bool StartRemoteProcess(
+    uv_loop_t& loop, cmCTestShardCoordinator& coordinator,
+    std::vector<std::string> const& environment,
+    std::vector<std::string> const& environmentModification);
+  // Called by the coordinator as the shard worker reports on the process
+  void OnRemoteOutput(cm::string_view data);
+  void OnRemoteExit(bool started, int64_t exit_status, int term_signal);
 
   enum class TimeoutReason
   {
@@ -102,6 +113,8 @@ private:
   bool ProcessHandleClosed = false;
 
   cm::uv_process_ptr Process;
+  cmCTestShardCoordinator* Coordinator = nullptr;
+  uint32_t Job = 0;
   cm::uv_pipe_ptr PipeReader;
   cm::uv_timer_ptr Timer;
   std::vector<char> Buf;
@@ -214,14 +214,23 @@ if(NOT CMAKE_USE_SYSTEM_LIBARCHIVE)
 endif()
 
 #---------------------------------------------------------------------
-# Build or use system zstd for libarchive.
-if(NOT CMAKE_USE_SYSTEM_LIBARCHIVE)
-  if(NOT CMAKE_USE_SYSTEM_ZSTD)
-    set(ZSTD_INCLUDE_DIR "${CMAKE_CURRENT_SOURCE_DIR}/Utilities/cmzstd")
-    set(ZSTD_LIBRARY cmzstd)
-    add_subdirectory(Utilities/cmzstd)
-    CMAKE_SET_TARGET_FOLDER(cmzstd "Utilities/3rdParty")
+# Build or use system zstd for libarchive and seekable archives.
+if(CMAKE_USE_SYSTEM_ZSTD)
+  find_path(ZSTD_INCLUDE_DIR zstd.h)
+  find_library(ZSTD_LIBRARY NAMES zstd libzstd)
+  if(NOT ZSTD_INCLUDE_DIR OR NOT ZSTD_LIBRARY)
+    message(FATAL_ERROR "CMAKE_USE_SYSTEM_ZSTD is ON but zstd is not found!")
   endif()
+  add_library(zstd::libzstd UNKNOWN IMPORTED)
+  set_target_properties(zstd::libzstd PROPERTIES
+    IMPORTED_LOCATION "${ZSTD_LIBRARY}"
+    INTERFACE_INCLUDE_DIRECTORIES "${ZSTD_INCLUDE_DIR}")
+else()
+  set(ZSTD_INCLUDE_DIR "${CMAKE_CURRENT_SOURCE_DIR}/Utilities/cmzstd")
+  set(ZSTD_LIBRARY cmzstd)
+  add_subdirectory(Utilities/cmzstd)
+  add_library(zstd::libzstd ALIAS cmzstd)
+  CMAKE_SET_TARGET_FOLDER(cmzstd "Utilities/3rdParty")
 endif()
 
 #---------------------------------------------------------------------
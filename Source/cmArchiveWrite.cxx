@@ -2,6 +2,8 @@
    file Copyright.txt or https://cmake.org/licensing for details.  */
 #include "cmArchiveWrite.h"
 
+#include <algorithm>
+#include <cstdint>
 #include <cstdlib>
 #include <cstring>
 #include <ctime>
@@ -10,11 +12,14 @@
 #include <sstream>
 #include <string>
 #include <thread>
+#include <utility>
+#include <vector>
 
 #include <cm/algorithm>
 
 #include <cm3p/archive.h>
 #include <cm3p/archive_entry.h>
+#include <cm3p/zstd.h>
 
 #include "cmsys/Directory.hxx"
 #include "cmsys/Encoding.hxx"
@@ -23,6 +28,7 @@
 #include "cm_get_date.h"
 
 #include "cmLocale.h"
+#include "cmParallelFor.h"
 #include "cmStringAlgorithms.h"
 #include "cmSystemTools.h"
 
@@ -71,13 +77,180 @@ public:
   operator struct archive_entry *() { return this->Object; }
 };
 
+// Writes the archive in the zstd seekable format: independent frames
+// of a fixed uncompressed size, followed by a skippable frame holding
+// the compressed and uncompressed size of each.  Readers may start to
+// decompress at any frame.  Frames are compressed in parallel, but the
+// output does not depend on the number of threads.
+class cmArchiveWrite::SeekableZstd
+{
+public:
+  SeekableZstd(std::ostream& os, int compressionLevel, int numThreads)
+    : Stream(os)
+    , CompressionLevel(compressionLevel)
+    , Contexts(static_cast<size_t>(numThreads < 1 ? 1 : numThreads))
+  {
+  }
+  ~SeekableZstd()
+  {
+    for (ZSTD_CCtx* cctx : this->Contexts) {
+      ZSTD_freeCCtx(cctx);
+    }
+  }
+  SeekableZstd(const SeekableZstd&) = delete;
+  SeekableZstd& operator=(const SeekableZstd&) = delete;
+
+  bool Write(const char* data, size_t size)
+  {
+    while (size > 0) {
+      size_t const n = std::min(size, FrameSize - this->Pending.size());
+      this->Pending.append(data, n);
+      data += n;
+      size -= n;
+      if (this->Pending.size() == FrameSize && !this->Queue()) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  bool Finish()
+  {
+    if ((!this->Pending.empty() && !this->Queue()) || !this->Flush()) {
+      return false;
+    }
+    std::string table;
+    AppendLE32(table, SkippableMagic);
+    AppendLE32(table,
+               static_cast<std::uint32_t>(this->SeekTable.size() * 8 + 9));
+    for (auto const& entry : this->SeekTable) {
+      AppendLE32(table, entry.first);
+      AppendLE32(table, entry.second);
+    }
+    AppendLE32(table, static_cast<std::uint32_t>(this->SeekTable.size()));
+    table += '\0'; // No checksums in the table.
+    AppendLE32(table, SeekableMagic);
+    return this->Output(table);
+  }
+
+  std::string const& GetError() const { return this->Error; }
+
+private:
+  // Frames must be small enough to seek quickly, and large enough not to
+  // hurt the compression ratio much.
+  static size_t const FrameSize = 1 << 20;
+  static std::uint32_t const MaxFrames = 0x8000000;
+  static std::uint32_t const SkippableMagic = 0x184D2A5E;
+  static std::uint32_t const SeekableMagic = 0x8F92EAB1;
+
+  struct Frame
+  {
+    std::string Input;
+    std::string Output;
+    std::string Error;
+  };
+
+  static void AppendLE32(std::string& out, std::uint32_t value)
+  {
+    for (int i = 0; i < 4; ++i) {
+      out += static_cast<char>((value >> (8 * i)) & 0xFF);
+    }
+  }
+
+  bool Output(std::string const& data)
+  {
+    if (!this->Stream.write(data.data(),
+                            static_cast<std::streamsize>(data.size()))) {
+      this->Error = "Cannot write seekable zstd output";
+      return false;
+    }
+    return true;
+  }
+
+  bool Queue()
+  {
+    if (this->SeekTable.size() + this->Frames.size() >= MaxFrames) {
+      this->Error = "Too many frames for the seekable zstd format";
+      return false;
+    }
+    this->Frames.emplace_back();
+    this->Frames.back().Input.swap(this->Pending);
+    return this->Frames.size() < this->Contexts.size() || this->Flush();
+  }
+
+  void Compress(size_t i)
+  {
+    Frame& frame = this->Frames[i];
+    ZSTD_CCtx*& cctx = this->Contexts[i];
+    if (!cctx) {
+      cctx = ZSTD_createCCtx();
+      if (!cctx) {
+        frame.Error = "Cannot create zstd compression context";
+        return;
+      }
+      ZSTD_CCtx_setParameter(cctx, ZSTD_c_compressionLevel,
+                             this->CompressionLevel);
+      ZSTD_CCtx_setParameter(cctx, ZSTD_c_checksumFlag, 1);
+    }
+    frame.Output.resize(ZSTD_compressBound(frame.Input.size()));
+    size_t const n =
+      ZSTD_compress2(cctx, &frame.Output[0], frame.Output.size(),
+                     frame.Input.data(), frame.Input.size());
+    if (ZSTD_isError(n)) {
+      frame.Error = cmStrCat("ZSTD_compress2: ", ZSTD_getErrorName(n));
+      return;
+    }
+    frame.Output.resize(n);
+  }
+
+  // Compress the queued frames and write them out in order.
+  bool Flush()
+  {
+    cmParallelFor(this->Frames.size(),
+                  static_cast<unsigned int>(this->Frames.size()),
+                  [this](std::size_t i) {
+                    this->Compress(i);
+                    return true;
+                  });
+    for (Frame const& frame : this->Frames) {
+      if (!frame.Error.empty()) {
+        this->Error = frame.Error;
+        return false;
+      }
+      if (!this->Output(frame.Output)) {
+        return false;
+      }
+      this->SeekTable.emplace_back(
+        static_cast<std::uint32_t>(frame.Output.size()),
+        static_cast<std::uint32_t>(frame.Input.size()));
+    }
+    this->Frames.clear();
+    return true;
+  }
+
+  std::ostream& Stream;
+  int CompressionLevel;
+  std::vector<ZSTD_CCtx*> Contexts;
+  std::string Pending;
+  std::vector<Frame> Frames;
+  std::vector<std::pair<std::uint32_t, std::uint32_t>> SeekTable;
+  std::string Error;
+};
+
 struct cmArchiveWrite::Callback
 {
   // archive_write_callback
-  static __LA_SSIZE_T Write(struct archive* /*unused*/, void* cd,
-                            const void* b, size_t n)
+  static __LA_SSIZE_T Write(struct archive* a, void* cd, const void* b,
+                            size_t n)
   {
     cmArchiveWrite* self = static_cast<cmArchiveWrite*>(cd);
+    if (self->Seekable) {
+      if (self->Seekable->Write(static_cast<const char*>(b), n)) {
+        return static_cast<__LA_SSIZE_T>(n);
+      }
+      archive_set_error(a, -1, "%s", self->Seekable->GetError().c_str());
+      return static_cast<__LA_SSIZE_T>(-1);
+    }
     if (self->Stream.write(static_cast<const char*>(b),
                            static_cast<std::streamsize>(n))) {
       return static_cast<__LA_SSIZE_T>(n);
@@ -197,6 +370,16 @@ cmArchiveWrite::cmArchiveWrite(std::ostream& os, Compress c,
       }
 #endif
       break;
+    case CompressZstdSeekable:
+      // The archive is compressed as it is written out.
+      if (archive_write_add_filter_none(this->Archive) != ARCHIVE_OK) {
+        this->Error = cmStrCat("archive_write_add_filter_none: ",
+                               cm_archive_error_string(this->Archive));
+        return;
+      }
+      this->Seekable =
+        cm::make_unique<SeekableZstd>(os, compressionLevel, numThreads);
+      break;
   }
 
   if (compressionLevel != 0) {
@@ -205,6 +388,7 @@ cmArchiveWrite::cmArchiveWrite(std::ostream& os, Compress c,
     switch (c) {
       case CompressNone:
       case CompressCompress:
+      case CompressZstdSeekable:
         break;
       case CompressGZip:
         archiveFilterName = "gzip";
@@ -278,6 +462,18 @@ cmArchiveWrite::~cmArchiveWrite()
   archive_write_free(this->Archive);
 }
 
+bool cmArchiveWrite::Close()
+{
+  if (archive_write_close(this->Archive) != ARCHIVE_OK && this->Okay()) {
+    this->Error = cmStrCat("archive_write_close: ",
+                           cm_archive_error_string(this->Archive));
+  }
+  if (this->Seekable && this->Okay() && !this->Seekable->Finish()) {
+    this->Error = this->Seekable->GetError();
+  }
+  return this->Okay();
+}
+
 bool cmArchiveWrite::Add(std::string path, size_t skip, const char* prefix,
                          bool recursive)
 {
@@ -417,15 +613,26 @@ bool cmArchiveWrite::AddFile(const char* file, size_t skip, const char* prefix)
 
   // do not copy content of symlink
   if (!archive_entry_symlink(e)) {
+    cmCryptoHash* hash = nullptr;
+    if (this->ContentHash && archive_entry_filetype(e) == AE_IFREG) {
+      hash = this->ContentHash.get();
+      hash->Initialize();
+    }
     // Content.
     if (size_t size = static_cast<size_t>(archive_entry_size(e))) {
-      return this->AddData(file, size);
+      if (!this->AddData(file, size, hash)) {
+        return false;
+      }
+    }
+    if (hash) {
+      this->ContentHashes[file] = hash->FinalizeHex();
     }
   }
   return true;
 }
 
-bool cmArchiveWrite::AddData(const char* file, size_t size)
+bool cmArchiveWrite::AddData(const char* file, size_t size,
+                             cmCryptoHash* hash)
 {
   cmsys::ifstream fin(file, std::ios::in | std::ios::binary);
   if (!fin) {
@@ -447,6 +654,9 @@ bool cmArchiveWrite::AddData(const char* file, size_t size)
     if (static_cast<size_t>(fin.gcount()) != nnext) {
       break;
     }
+    if (hash) {
+      hash->Append(buffer, nnext);
+    }
     if (archive_write_data(this->Archive, buffer, nnext) != nnext_s) {
       this->Error = cmStrCat("archive_write_data: ",
                              cm_archive_error_string(this->Archive));
@@ -6,8 +6,14 @@
 
 #include <cstddef>
 #include <iosfwd>
+#include <map>
+#include <memory>
 #include <string>
 
+#include <cm/memory>
+
+#include "cmCryptoHash.h"
+
 #if defined(CMAKE_BOOTSTRAP)
 #  error "cmArchiveWrite not allowed during bootstrap build!"
 #endif
@@ -49,7 +55,9 @@ public:
     CompressBZip2,
     CompressLZMA,
     CompressXZ,
-    CompressZstd
+    CompressZstd,
+    // Independent zstd frames followed by a seek table.
+    CompressZstdSeekable
   };
 
   /** Construct with output stream to which to write archive.  */
@@ -57,6 +65,8 @@ public:
                  std::string const& format = "paxr", int compressionLevel = 0,
                  int numThreads = 1);
 
+  /** Release the archive.  An archive that was not closed with Close()
+      may be incomplete.  */
   ~cmArchiveWrite();
 
   cmArchiveWrite(const cmArchiveWrite&) = delete;
@@ -75,6 +85,13 @@ public:
   bool Add(std::string path, size_t skip = 0, const char* prefix = nullptr,
            bool recursive = true);
 
+  /**
+   * Finish writing the archive after all paths have been added.  Returns
+   * false if the end of the archive could not be written, in which case
+   * the output is incomplete.
+   */
+  bool Close();
+
   /** Returns true if there has been no error.  */
   explicit operator bool() const { return this->Okay(); }
 
@@ -141,17 +158,32 @@ public:
     this->Gname = "";
   }
 
+  //! Hashes the content of regular files while adding them, so that
+  //! each file is read only once
+  void SetContentHash(cmCryptoHash::Algo algo)
+  {
+    this->ContentHash = cm::make_unique<cmCryptoHash>(algo);
+  }
+
+  //! Gets the content hashes of the regular files added so far, by their
+  //! path on disk
+  std::map<std::string, std::string> const& GetContentHashes() const
+  {
+    return this->ContentHashes;
+  }
+
 private:
   bool Okay() const { return this->Error.empty(); }
   bool AddPath(const char* path, size_t skip, const char* prefix,
                bool recursive = true);
   bool AddFile(const char* file, size_t skip, const char* prefix);
-  bool AddData(const char* file, size_t size);
+  bool AddData(const char* file, size_t size, cmCryptoHash* hash);
 
   struct Callback;
   friend struct Callback;
 
   class Entry;
+  class SeekableZstd;
 
   std::ostream& Stream;
   struct archive* Archive;
@@ -176,4 +208,11 @@ private:
   //! Permissions on files/folders
   cmArchiveWriteOptional<int> Permissions;
   cmArchiveWriteOptional<int> PermissionsMask;
+
+  //! Hashes of the content of regular files
+  std::unique_ptr<cmCryptoHash> ContentHash;
+  std::map<std::string, std::string> ContentHashes;
+
+  //! Compressor of the CompressZstdSeekable mode
+  std::unique_ptr<SeekableZstd> Seekable;
 };
@@ -4,6 +4,7 @@
 #pragma once
 
 #include <string>
+#include <vector>
 
 #include "cmStateTypes.h"
 
@@ -17,6 +18,10 @@ public:
 
   virtual bool Prepare() { return true; }
 
+  /** Called with all files to be scanned before the first of them is,
+      so that their dependencies may be read ahead of time.  */
+  virtual void PrepareScan(std::vector<std::string> const& /*files*/) {}
+
   virtual bool ScanDependencies(std::string const& file,
                                 cmStateEnums::TargetType type) = 0;
 
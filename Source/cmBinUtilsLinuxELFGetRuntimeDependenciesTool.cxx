@@ -12,6 +12,13 @@ cmBinUtilsLinuxELFGetRuntimeDependenciesTool::
 {
 }
 
+cmBinUtilsLinuxELFGetRuntimeDependenciesTool::FileInfoList
+cmBinUtilsLinuxELFGetRuntimeDependenciesTool::GetFilesInfo(
+  std::vector<std::string> const& files, unsigned int /*threads*/)
+{
+  return FileInfoList(files.size());
+}
+
 void cmBinUtilsLinuxELFGetRuntimeDependenciesTool::SetError(
   const std::string& error)
 {
@@ -6,6 +6,8 @@
 #include <string>
 #include <vector>
 
+#include <cm/optional>
+
 class cmRuntimeDependencyArchive;
 
 class cmBinUtilsLinuxELFGetRuntimeDependenciesTool
@@ -20,6 +22,21 @@ public:
                            std::vector<std::string>& rpaths,
                            std::vector<std::string>& runpaths) = 0;
 
+  struct FileInfo
+  {
+    std::vector<std::string> Needed;
+    std::vector<std::string> RPaths;
+    std::vector<std::string> RunPaths;
+  };
+  using FileInfoList = std::vector<cm::optional<FileInfo>>;
+
+  /** Get the information of several files at once, using up to the given
+      number of threads, or one per processor for 0.  Failures are not
+      reported; the entry of a file that could not be read is left empty,
+      and GetFileInfo() reports the error when called for it.  */
+  virtual FileInfoList GetFilesInfo(std::vector<std::string> const& files,
+                                    unsigned int threads);
+
 protected:
   cmRuntimeDependencyArchive* Archive;
 
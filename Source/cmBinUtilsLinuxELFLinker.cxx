@@ -3,7 +3,7 @@
 
 #include "cmBinUtilsLinuxELFLinker.h"
 
-#include <queue>
+#include <deque>
 #include <sstream>
 #include <unordered_set>
 #include <utility>
@@ -11,10 +11,12 @@
 #include <cm/memory>
 #include <cm/string_view>
 
+#include <cmsys/Directory.hxx>
 #include <cmsys/RegularExpression.hxx>
 
 #include "cmBinUtilsLinuxELFObjdumpGetRuntimeDependenciesTool.h"
 #include "cmELF.h"
+#include "cmFileTime.h"
 #include "cmLDConfigLDConfigTool.h"
 #include "cmMakefile.h"
 #include "cmMessageType.h"
@@ -45,6 +47,49 @@ static std::string ReplaceOrigin(const std::string& rpath,
   return rpath;
 }
 
+namespace {
+struct FileStamp
+{
+  cmFileTime Time;
+  unsigned long Size = 0;
+
+  bool Load(std::string const& file)
+  {
+    if (!this->Time.Load(file)) {
+      return false;
+    }
+    this->Size = cmSystemTools::FileLength(file);
+    return true;
+  }
+
+  bool Equal(FileStamp const& other) const
+  {
+    return this->Time.Equal(other.Time) && this->Size == other.Size;
+  }
+};
+
+struct CachedFileInfo
+{
+  FileStamp Stamp;
+  cmBinUtilsLinuxELFGetRuntimeDependenciesTool::FileInfo Info;
+};
+
+// Information read by any file(GET_RUNTIME_DEPENDENCIES) call in this
+// process.  An entry is used only while its file is unchanged.
+std::unordered_map<std::string, CachedFileInfo>& FileInfoCache()
+{
+  static std::unordered_map<std::string, CachedFileInfo> cache;
+  return cache;
+}
+
+bool IsCached(std::string const& file, FileStamp const& stamp)
+{
+  auto const& cache = FileInfoCache();
+  auto it = cache.find(file);
+  return it != cache.end() && it->second.Stamp.Equal(stamp);
+}
+}
+
 cmBinUtilsLinuxELFLinker::cmBinUtilsLinuxELFLinker(
   cmRuntimeDependencyArchive* archive)
   : cmBinUtilsLinker(archive)
@@ -89,6 +134,12 @@ bool cmBinUtilsLinuxELFLinker::Prepare()
   return true;
 }
 
+void cmBinUtilsLinuxELFLinker::PrepareScan(
+  std::vector<std::string> const& files)
+{
+  this->ReadFilesInfo(files);
+}
+
 bool cmBinUtilsLinuxELFLinker::ScanDependencies(
   std::string const& file, cmStateEnums::TargetType /* unused */)
 {
@@ -113,20 +164,34 @@ bool cmBinUtilsLinuxELFLinker::ScanDependencies(
 bool cmBinUtilsLinuxELFLinker::ScanDependencies(std::string const& mainFile)
 {
   std::unordered_set<std::string> resolvedDependencies;
-  std::queue<std::pair<std::string, std::vector<std::string>>> queueToResolve;
-  queueToResolve.push(std::make_pair(mainFile, std::vector<std::string>{}));
+  std::deque<std::pair<std::string, std::vector<std::string>>> queueToResolve;
+  queueToResolve.emplace_back(mainFile, std::vector<std::string>{});
+  std::size_t remainingInLevel = 0;
 
   while (!queueToResolve.empty()) {
+    // The queue holds exactly one level of the graph when the previous
+    // level is done.  Read all of its files at once.
+    if (remainingInLevel == 0) {
+      std::vector<std::string> files;
+      files.reserve(queueToResolve.size());
+      for (auto const& entry : queueToResolve) {
+        files.push_back(entry.first);
+      }
+      this->ReadFilesInfo(files);
+      remainingInLevel = queueToResolve.size();
+    }
+    --remainingInLevel;
+
     std::string file = std::move(queueToResolve.front().first);
     std::vector<std::string> parentRpaths =
       std::move(queueToResolve.front().second);
-    queueToResolve.pop();
+    queueToResolve.pop_front();
 
     std::string origin = cmSystemTools::GetFilenamePath(file);
     std::vector<std::string> needed;
     std::vector<std::string> rpaths;
     std::vector<std::string> runpaths;
-    if (!this->Tool->GetFileInfo(file, needed, rpaths, runpaths)) {
+    if (!this->GetFileInfo(file, needed, rpaths, runpaths)) {
       return false;
     }
     for (auto& runpath : runpaths) {
@@ -173,7 +238,7 @@ bool cmBinUtilsLinuxELFLinker::ScanDependencies(std::string const& mainFile)
             combinedParentRpaths.insert(combinedParentRpaths.end(),
                                         rpaths.begin(), rpaths.end());
 
-            queueToResolve.push(std::make_pair(path, combinedParentRpaths));
+            queueToResolve.emplace_back(path, combinedParentRpaths);
           }
         }
       } else {
@@ -185,15 +250,94 @@ bool cmBinUtilsLinuxELFLinker::ScanDependencies(std::string const& mainFile)
   return true;
 }
 
-namespace {
-bool FileHasArchitecture(const char* filename, std::uint16_t machine)
+bool cmBinUtilsLinuxELFLinker::GetFileInfo(
+  std::string const& file, std::vector<std::string>& needed,
+  std::vector<std::string>& rpaths, std::vector<std::string>& runpaths)
 {
-  cmELF elf(filename);
-  if (!elf) {
+  FileStamp stamp;
+  bool const haveStamp = stamp.Load(file);
+  if (haveStamp && IsCached(file, stamp)) {
+    auto const& info = FileInfoCache()[file].Info;
+    needed = info.Needed;
+    rpaths = info.RPaths;
+    runpaths = info.RunPaths;
+    return true;
+  }
+
+  if (!this->Tool->GetFileInfo(file, needed, rpaths, runpaths)) {
     return false;
   }
-  return machine == 0 || machine == elf.GetMachine();
+  if (haveStamp) {
+    FileInfoCache()[file] = { stamp, { needed, rpaths, runpaths } };
+  }
+  return true;
+}
+
+void cmBinUtilsLinuxELFLinker::ReadFilesInfo(
+  std::vector<std::string> const& files)
+{
+  std::unordered_set<std::string> seen;
+  std::vector<std::string> toRead;
+  std::vector<FileStamp> stamps;
+  for (std::string const& file : files) {
+    FileStamp stamp;
+    if (seen.insert(file).second && stamp.Load(file) &&
+        !IsCached(file, stamp)) {
+      toRead.push_back(file);
+      stamps.push_back(stamp);
+    }
+  }
+  // A single file is read when it is needed.
+  if (toRead.size() < 2) {
+    return;
+  }
+
+  auto infos = this->Tool->GetFilesInfo(toRead, 0);
+  for (std::size_t i = 0; i < toRead.size(); ++i) {
+    if (infos[i]) {
+      FileInfoCache()[toRead[i]] = { stamps[i], std::move(*infos[i]) };
+    }
+  }
 }
+
+bool cmBinUtilsLinuxELFLinker::FileIsCandidate(std::string const& dir,
+                                               std::string const& name,
+                                               std::string& path)
+{
+  path = cmStrCat(dir, '/', name);
+
+  // List each directory once instead of looking for every name in it.
+  std::string const listDir = dir.empty() ? "/" : dir;
+  auto dirIt = this->DirectoryContents.find(listDir);
+  if (dirIt == this->DirectoryContents.end()) {
+    std::unique_ptr<std::unordered_set<std::string>> contents;
+    cmsys::Directory listing;
+    if (!cmSystemTools::FileIsDirectory(listDir)) {
+      contents = cm::make_unique<std::unordered_set<std::string>>();
+    } else if (listing.Load(listDir)) {
+      contents = cm::make_unique<std::unordered_set<std::string>>();
+      for (unsigned long i = 0; i < listing.GetNumberOfFiles(); ++i) {
+        contents->insert(listing.GetFileName(i));
+      }
+    }
+    dirIt =
+      this->DirectoryContents.emplace(listDir, std::move(contents)).first;
+  }
+  // A name with a slash is not a directory entry of its own.
+  bool const listed = dirIt->second && name.find('/') == std::string::npos;
+  if (listed ? dirIt->second->count(name) == 0
+             : !cmSystemTools::PathExists(path)) {
+    return false;
+  }
+
+  auto machineIt = this->FileMachines.find(path);
+  if (machineIt == this->FileMachines.end()) {
+    cmELF elf(path.c_str());
+    machineIt =
+      this->FileMachines.emplace(path, elf ? elf.GetMachine() : -1).first;
+  }
+  return machineIt->second != -1 &&
+    (this->Machine == 0 || this->Machine == machineIt->second);
 }
 
 bool cmBinUtilsLinuxELFLinker::ResolveDependency(
@@ -201,18 +345,14 @@ bool cmBinUtilsLinuxELFLinker::ResolveDependency(
   std::string& path, bool& resolved)
 {
   for (auto const& searchPath : searchPaths) {
-    path = cmStrCat(searchPath, '/', name);
-    if (cmSystemTools::PathExists(path) &&
-        FileHasArchitecture(path.c_str(), this->Machine)) {
+    if (this->FileIsCandidate(searchPath, name, path)) {
       resolved = true;
       return true;
     }
   }
 
   for (auto const& searchPath : this->Archive->GetSearchDirectories()) {
-    path = cmStrCat(searchPath, '/', name);
-    if (cmSystemTools::PathExists(path) &&
-        FileHasArchitecture(path.c_str(), this->Machine)) {
+    if (this->FileIsCandidate(searchPath, name, path)) {
       std::ostringstream warning;
       warning << "Dependency " << name << " found in search directory:\n  "
               << searchPath
@@ -8,6 +8,8 @@
 #include <cstdint>
 #include <memory>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include "cmBinUtilsLinker.h"
@@ -24,6 +26,8 @@ public:
 
   bool Prepare() override;
 
+  void PrepareScan(std::vector<std::string> const& files) override;
+
   bool ScanDependencies(std::string const& file,
                         cmStateEnums::TargetType type) override;
 
@@ -34,8 +38,23 @@ private:
   std::vector<std::string> LDConfigPaths;
   std::uint16_t Machine = 0;
 
+  // Names in each directory searched, or null if it could not be listed.
+  std::unordered_map<std::string,
+                     std::unique_ptr<std::unordered_set<std::string>>>
+    DirectoryContents;
+  // Machine of each candidate dependency, or -1 if it is not ELF.
+  std::unordered_map<std::string, int> FileMachines;
+
   bool ScanDependencies(std::string const& mainFile);
 
+  bool GetFileInfo(std::string const& file, std::vector<std::string>& needed,
+                   std::vector<std::string>& rpaths,
+                   std::vector<std::string>& runpaths);
+  void ReadFilesInfo(std::vector<std::string> const& files);
+
+  bool FileIsCandidate(std::string const& dir, std::string const& name,
+                       std::string& path);
+
   bool ResolveDependency(std::string const& name,
                          std::vector<std::string> const& searchPaths,
                          std::string& path, bool& resolved);
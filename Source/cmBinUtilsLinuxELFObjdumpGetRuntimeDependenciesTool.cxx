@@ -3,10 +3,13 @@
 
 #include "cmBinUtilsLinuxELFObjdumpGetRuntimeDependenciesTool.h"
 
+#include <cstddef>
 #include <sstream>
+#include <utility>
 
 #include <cmsys/RegularExpression.hxx>
 
+#include "cmParallelFor.h"
 #include "cmRuntimeDependencyArchive.h"
 #include "cmSystemTools.h"
 #include "cmUVProcessChain.h"
@@ -19,18 +22,15 @@ cmBinUtilsLinuxELFObjdumpGetRuntimeDependenciesTool::
 {
 }
 
-bool cmBinUtilsLinuxELFObjdumpGetRuntimeDependenciesTool::GetFileInfo(
-  std::string const& file, std::vector<std::string>& needed,
-  std::vector<std::string>& rpaths, std::vector<std::string>& runpaths)
+namespace {
+bool ReadFileInfo(std::vector<std::string> command, std::string const& file,
+                  std::vector<std::string>& needed,
+                  std::vector<std::string>& rpaths,
+                  std::vector<std::string>& runpaths, std::string& error)
 {
   cmUVProcessChainBuilder builder;
   builder.SetBuiltinStream(cmUVProcessChainBuilder::Stream_OUTPUT);
 
-  std::vector<std::string> command;
-  if (!this->Archive->GetGetRuntimeDependenciesCommand("objdump", command)) {
-    this->SetError("Could not find objdump");
-    return false;
-  }
   command.emplace_back("-p");
   command.push_back(file);
   builder.AddCommand(command);
@@ -39,7 +39,7 @@ bool cmBinUtilsLinuxELFObjdumpGetRuntimeDependenciesTool::GetFileInfo(
   if (!process.Valid() || process.GetStatus(0).SpawnResult != 0) {
     std::ostringstream e;
     e << "Failed to start objdump process for:\n  " << file;
-    this->SetError(e.str());
+    error = e.str();
     return false;
   }
 
@@ -72,15 +72,58 @@ bool cmBinUtilsLinuxELFObjdumpGetRuntimeDependenciesTool::GetFileInfo(
   if (!process.Wait()) {
     std::ostringstream e;
     e << "Failed to wait on objdump process for:\n  " << file;
-    this->SetError(e.str());
+    error = e.str();
     return false;
   }
   if (process.GetStatus(0).ExitStatus != 0) {
     std::ostringstream e;
     e << "Failed to run objdump on:\n  " << file;
-    this->SetError(e.str());
+    error = e.str();
     return false;
   }
 
   return true;
 }
+}
+
+bool cmBinUtilsLinuxELFObjdumpGetRuntimeDependenciesTool::GetFileInfo(
+  std::string const& file, std::vector<std::string>& needed,
+  std::vector<std::string>& rpaths, std::vector<std::string>& runpaths)
+{
+  std::vector<std::string> command;
+  if (!this->Archive->GetGetRuntimeDependenciesCommand("objdump", command)) {
+    this->SetError("Could not find objdump");
+    return false;
+  }
+
+  std::string error;
+  if (!ReadFileInfo(std::move(command), file, needed, rpaths, runpaths,
+                    error)) {
+    this->SetError(error);
+    return false;
+  }
+  return true;
+}
+
+cmBinUtilsLinuxELFGetRuntimeDependenciesTool::FileInfoList
+cmBinUtilsLinuxELFObjdumpGetRuntimeDependenciesTool::GetFilesInfo(
+  std::vector<std::string> const& files, unsigned int threads)
+{
+  FileInfoList infos(files.size());
+  std::vector<std::string> command;
+  if (!this->Archive->GetGetRuntimeDependenciesCommand("objdump", command)) {
+    return infos;
+  }
+
+  cmParallelFor(files.size(), threads,
+                [&command, &files, &infos](std::size_t i) {
+                  FileInfo info;
+                  std::string error;
+                  if (ReadFileInfo(command, files[i], info.Needed,
+                                   info.RPaths, info.RunPaths, error)) {
+                    infos[i] = std::move(info);
+                  }
+                  return true;
+                });
+  return infos;
+}
@@ -20,4 +20,7 @@ public:
   bool GetFileInfo(std::string const& file, std::vector<std::string>& needed,
                    std::vector<std::string>& rpaths,
                    std::vector<std::string>& runpaths) override;
+
+  FileInfoList GetFilesInfo(std::vector<std::string> const& files,
+                            unsigned int threads) override;
 };
@@ -48,6 +48,7 @@
 #include "cmCTestGenericHandler.h"
 #include "cmCTestMemCheckHandler.h"
 #include "cmCTestScriptHandler.h"
+#include "cmCTestShardWorker.h"
 #include "cmCTestStartCommand.h"
 #include "cmCTestSubmitHandler.h"
 #include "cmCTestTestHandler.h"
@@ -184,6 +185,9 @@ struct cmCTest::Private
 
   unsigned long TestLoad = 0;
 
+  // Endpoint of the coordinator to run tests for with --shard-worker.
+  std::string ShardWorkerEndpoint;
+
   int CompatibilityMode;
 
   // information for the --build-and-test options
@@ -1974,6 +1978,22 @@ bool cmCTest::HandleCommandLineArguments(size_t& i,
     }
   }
 
+  else if (this->CheckArgument(arg, "--test-pressure"_s) &&
+           i < args.size() - 1) {
+    i++;
+    char* end = nullptr;
+    double const pressure = std::strtod(args[i].c_str(), &end);
+    if (!args[i].empty() && *end == '\0' && pressure > 0 &&
+        pressure <= 100) {
+      this->GetTestHandler()->SetPersistentOption("TestPressure", args[i]);
+      this->GetMemCheckHandler()->SetPersistentOption("TestPressure",
+                                                      args[i]);
+    } else {
+      cmCTestLog(this, WARNING,
+                 "Invalid value for 'Test Pressure' : " << args[i] << '\n');
+    }
+  }
+
   else if (this->CheckArgument(arg, "--no-compress-output"_s)) {
     this->Impl->CompressTestOutput = false;
   }
@@ -2227,6 +2247,28 @@ bool cmCTest::HandleCommandLineArguments(size_t& i,
                                                     args[i]);
   }
 
+  else if (this->CheckArgument(arg, "--shard-coordinator"_s) &&
+           i < args.size() - 1) {
+    i++;
+    this->GetTestHandler()->SetPersistentOption("ShardCoordinator", args[i]);
+    this->GetMemCheckHandler()->SetPersistentOption("ShardCoordinator",
+                                                    args[i]);
+  }
+
+  else if (this->CheckArgument(arg, "--output-events"_s) &&
+           i < args.size() - 1) {
+    i++;
+    this->GetTestHandler()->SetPersistentOption("TestEventsFile", args[i]);
+    this->GetMemCheckHandler()->SetPersistentOption("TestEventsFile",
+                                                    args[i]);
+  }
+
+  else if (this->CheckArgument(arg, "--shard-worker"_s) &&
+           i < args.size() - 1) {
+    i++;
+    this->Impl->ShardWorkerEndpoint = args[i];
+  }
+
   else if (this->CheckArgument(arg, "--tests-from-file"_s) &&
            i < args.size() - 1) {
     i++;
@@ -2243,6 +2285,21 @@ bool cmCTest::HandleCommandLineArguments(size_t& i,
                                                     args[i]);
   }
 
+  else if (this->CheckArgument(arg, "--affected-by"_s) &&
+           i < args.size() - 1) {
+    i++;
+    this->GetTestHandler()->SetPersistentOption("AffectedByFile", args[i]);
+    this->GetMemCheckHandler()->SetPersistentOption("AffectedByFile",
+                                                    args[i]);
+  }
+
+  else if (this->CheckArgument(arg, "--affected-by-git"_s) &&
+           i < args.size() - 1) {
+    i++;
+    this->GetTestHandler()->SetPersistentOption("AffectedByGit", args[i]);
+    this->GetMemCheckHandler()->SetPersistentOption("AffectedByGit", args[i]);
+  }
+
   else if (this->CheckArgument(arg, "--rerun-failed"_s)) {
     this->GetTestHandler()->SetPersistentOption("RerunFailed", "true");
     this->GetMemCheckHandler()->SetPersistentOption("RerunFailed", "true");
@@ -2875,6 +2932,12 @@ int cmCTest::Run(std::vector<std::string>& args, std::string* output)
     return this->RunCMakeAndTest(output);
   }
 
+  // if --shard-worker was specified then we run the tests a coordinator
+  // sends us and return
+  if (!this->Impl->ShardWorkerEndpoint.empty()) {
+    return this->RunShardWorker();
+  }
+
   if (executeTests) {
     return this->ExecuteTests();
   }
@@ -3026,6 +3089,21 @@ int cmCTest::RunCMakeAndTest(std::string* output)
   return retv;
 }
 
+int cmCTest::RunShardWorker()
+{
+  // Offer as many slots as tests would run in parallel here, but at
+  // least one.
+  cm::optional<size_t> parallelLevel = this->GetParallelLevel();
+  size_t slots = parallelLevel ? *parallelLevel : 0;
+  if (slots == 0) {
+    cmsys::SystemInformation info;
+    info.RunCPUCheck();
+    slots = std::max<size_t>(info.GetNumberOfLogicalCPU(), 1);
+  }
+  cmCTestShardWorker worker(this, this->Impl->ShardWorkerEndpoint, slots);
+  return worker.Run();
+}
+
 void cmCTest::SetNotesFiles(const std::string& notes)
 {
   this->Impl->NotesFiles = notes;
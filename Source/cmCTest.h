@@ -540,6 +540,7 @@ private:
                                bool& validArg);
 
   int RunCMakeAndTest(std::string* output);
+  int RunShardWorker();
   int ExecuteTests();
 
   /** return true iff change directory was successful */
@@ -2,6 +2,7 @@
    file Copyright.txt or https://cmake.org/licensing for details.  */
 #include "cmCryptoHash.h"
 
+#include <algorithm>
 #include <cassert>
 
 #include <cm/memory>
@@ -11,6 +12,18 @@
 
 #include "cmsys/FStream.hxx"
 
+#include "cmCryptoHashAccel.h"
+#include "cmParallelFor.h"
+#include "cmSystemTools.h"
+
+#if !defined(_WIN32)
+#  include <cerrno>
+
+#  include <fcntl.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#endif
+
 static unsigned int const cmCryptoHashAlgoToId[] = {
   /* clang-format needs this comment to break after the opening brace */
   RHASH_MD5,      //
@@ -25,59 +38,86 @@ static unsigned int const cmCryptoHashAlgoToId[] = {
   RHASH_SHA3_512
 };
 
-static int cmCryptoHash_rhash_library_initialized;
-
 static rhash cmCryptoHash_rhash_init(unsigned int id)
 {
-  if (!cmCryptoHash_rhash_library_initialized) {
-    cmCryptoHash_rhash_library_initialized = 1;
-    rhash_library_init();
-  }
+  // Hashes may be created by several threads at once.
+  static bool const initialized = (rhash_library_init(), true);
+  static_cast<void>(initialized);
   return rhash_init(id);
 }
 
+static std::unique_ptr<cmCryptoHashAccel> cmCryptoHash_accel_init(
+  cmCryptoHash::Algo algo)
+{
+  switch (algo) {
+    case cmCryptoHash::AlgoSHA1:
+      return cmCryptoHashAccel::New(cmCryptoHashAccel::Algo::SHA1);
+    case cmCryptoHash::AlgoSHA224:
+      return cmCryptoHashAccel::New(cmCryptoHashAccel::Algo::SHA224);
+    case cmCryptoHash::AlgoSHA256:
+      return cmCryptoHashAccel::New(cmCryptoHashAccel::Algo::SHA256);
+    default:
+      break;
+  }
+  return std::unique_ptr<cmCryptoHashAccel>();
+}
+
 cmCryptoHash::cmCryptoHash(Algo algo)
   : Id(cmCryptoHashAlgoToId[algo])
-  , CTX(cmCryptoHash_rhash_init(this->Id))
+  , Accel(cmCryptoHash_accel_init(algo))
 {
+  if (!this->Accel) {
+    this->CTX = cmCryptoHash_rhash_init(this->Id);
+  }
 }
 
 cmCryptoHash::~cmCryptoHash()
 {
-  rhash_free(this->CTX);
+  if (this->CTX) {
+    rhash_free(this->CTX);
+  }
 }
 
-std::unique_ptr<cmCryptoHash> cmCryptoHash::New(cm::string_view algo)
+cm::optional<cmCryptoHash::Algo> cmCryptoHash::AlgoFromName(
+  cm::string_view name)
 {
-  if (algo == "MD5") {
-    return cm::make_unique<cmCryptoHash>(AlgoMD5);
+  if (name == "MD5") {
+    return AlgoMD5;
+  }
+  if (name == "SHA1") {
+    return AlgoSHA1;
   }
-  if (algo == "SHA1") {
-    return cm::make_unique<cmCryptoHash>(AlgoSHA1);
+  if (name == "SHA224") {
+    return AlgoSHA224;
   }
-  if (algo == "SHA224") {
-    return cm::make_unique<cmCryptoHash>(AlgoSHA224);
+  if (name == "SHA256") {
+    return AlgoSHA256;
   }
-  if (algo == "SHA256") {
-    return cm::make_unique<cmCryptoHash>(AlgoSHA256);
+  if (name == "SHA384") {
+    return AlgoSHA384;
   }
-  if (algo == "SHA384") {
-    return cm::make_unique<cmCryptoHash>(AlgoSHA384);
+  if (name == "SHA512") {
+    return AlgoSHA512;
   }
-  if (algo == "SHA512") {
-    return cm::make_unique<cmCryptoHash>(AlgoSHA512);
+  if (name == "SHA3_224") {
+    return AlgoSHA3_224;
   }
-  if (algo == "SHA3_224") {
-    return cm::make_unique<cmCryptoHash>(AlgoSHA3_224);
+  if (name == "SHA3_256") {
+    return AlgoSHA3_256;
   }
-  if (algo == "SHA3_256") {
-    return cm::make_unique<cmCryptoHash>(AlgoSHA3_256);
+  if (name == "SHA3_384") {
+    return AlgoSHA3_384;
   }
-  if (algo == "SHA3_384") {
-    return cm::make_unique<cmCryptoHash>(AlgoSHA3_384);
+  if (name == "SHA3_512") {
+    return AlgoSHA3_512;
   }
-  if (algo == "SHA3_512") {
-    return cm::make_unique<cmCryptoHash>(AlgoSHA3_512);
+  return cm::nullopt;
+}
+
+std::unique_ptr<cmCryptoHash> cmCryptoHash::New(cm::string_view algo)
+{
+  if (cm::optional<Algo> a = AlgoFromName(algo)) {
+    return cm::make_unique<cmCryptoHash>(*a);
   }
   return std::unique_ptr<cmCryptoHash>();
 }
@@ -153,36 +193,84 @@ std::vector<unsigned char> cmCryptoHash::ByteHashString(cm::string_view input)
   return this->Finalize();
 }
 
-std::vector<unsigned char> cmCryptoHash::ByteHashFile(const std::string& file)
+#if !defined(_WIN32)
+namespace {
+// Files at least this large are read in larger blocks.  They are not
+// mapped into memory: a file truncated by another process while mapped
+// would raise SIGBUS instead of a read error.
+off_t const kLargeFile = 256 * 1024;
+
+bool AppendRead(cmCryptoHash& hash, int fd, size_t blockSize)
 {
-  cmsys::ifstream fin(file.c_str(), std::ios::in | std::ios::binary);
-  if (fin) {
-    this->Initialize();
-    {
-      // Should be efficient enough on most system:
-      KWIML_INT_uint64_t buffer[512];
-      char* buffer_c = reinterpret_cast<char*>(buffer);
-      unsigned char const* buffer_uc =
-        reinterpret_cast<unsigned char const*>(buffer);
-      // This copy loop is very sensitive on certain platforms with
-      // slightly broken stream libraries (like HPUX).  Normally, it is
-      // incorrect to not check the error condition on the fin.read()
-      // before using the data, but the fin.gcount() will be zero if an
-      // error occurred.  Therefore, the loop should be safe everywhere.
-      while (fin) {
-        fin.read(buffer_c, sizeof(buffer));
-        if (int gcount = static_cast<int>(fin.gcount())) {
-          this->Append(buffer_uc, gcount);
-        }
-      }
+  std::vector<unsigned char> buffer(blockSize);
+  for (;;) {
+    ssize_t const n = read(fd, buffer.data(), buffer.size());
+    if (n > 0) {
+      hash.Append(buffer.data(), static_cast<size_t>(n));
+    } else if (n == 0) {
+      return true;
+    } else if (errno != EINTR) {
+      return false;
     }
-    if (fin.eof()) {
-      // Success
-      return this->Finalize();
+  }
+}
+}
+#endif
+
+bool cmCryptoHash::AppendFile(const std::string& file)
+{
+#if !defined(_WIN32)
+  int const fd = open(file.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+  struct stat st;
+  bool const large = fstat(fd, &st) == 0 && S_ISREG(st.st_mode) &&
+    st.st_size >= kLargeFile;
+#  ifdef POSIX_FADV_SEQUENTIAL
+  if (large) {
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+  }
+#  endif
+  bool const okay = AppendRead(*this, fd, large ? 1024 * 1024 : 64 * 1024);
+  int const error = errno;
+  close(fd);
+  errno = error;
+  return okay;
+#else
+  cmsys::ifstream fin(file.c_str(), std::ios::in | std::ios::binary);
+  if (!fin) {
+    return false;
+  }
+  // Should be efficient enough on most system:
+  KWIML_INT_uint64_t buffer[8192];
+  char* buffer_c = reinterpret_cast<char*>(buffer);
+  unsigned char const* buffer_uc =
+    reinterpret_cast<unsigned char const*>(buffer);
+  // This copy loop is very sensitive on certain platforms with
+  // slightly broken stream libraries (like HPUX).  Normally, it is
+  // incorrect to not check the error condition on the fin.read()
+  // before using the data, but the fin.gcount() will be zero if an
+  // error occurred.  Therefore, the loop should be safe everywhere.
+  while (fin) {
+    fin.read(buffer_c, sizeof(buffer));
+    if (int gcount = static_cast<int>(fin.gcount())) {
+      this->Append(buffer_uc, gcount);
     }
-    // Finalize anyway
-    this->Finalize();
   }
+  return fin.eof();
+#endif
+}
+
+std::vector<unsigned char> cmCryptoHash::ByteHashFile(const std::string& file)
+{
+  this->Initialize();
+  if (this->AppendFile(file)) {
+    // Success
+    return this->Finalize();
+  }
+  // Finalize anyway
+  this->Finalize();
   // Return without success
   return std::vector<unsigned char>();
 }
@@ -197,23 +285,56 @@ std::string cmCryptoHash::HashFile(const std::string& file)
   return ByteHashToString(this->ByteHashFile(file));
 }
 
+std::vector<std::string> cmCryptoHash::HashFiles(
+  Algo algo, std::vector<std::string> const& files, unsigned int threads,
+  std::vector<std::string>* errors)
+{
+  std::vector<std::string> hashes(files.size());
+  if (errors) {
+    errors->assign(files.size(), std::string());
+  }
+
+  cmParallelFor(files.size(), threads,
+                [algo, &files, &hashes, errors](std::size_t i) {
+                  hashes[i] = cmCryptoHash(algo).HashFile(files[i]);
+                  if (hashes[i].empty() && errors) {
+                    (*errors)[i] = cmSystemTools::GetLastSystemError();
+                  }
+                  return true;
+                });
+  return hashes;
+}
+
 void cmCryptoHash::Initialize()
 {
+  if (this->Accel) {
+    this->Accel->Initialize();
+    return;
+  }
   rhash_reset(this->CTX);
 }
 
 void cmCryptoHash::Append(void const* buf, size_t sz)
 {
+  if (this->Accel) {
+    this->Accel->Append(static_cast<unsigned char const*>(buf), sz);
+    return;
+  }
   rhash_update(this->CTX, buf, sz);
 }
 
 void cmCryptoHash::Append(cm::string_view input)
 {
-  rhash_update(this->CTX, input.data(), input.size());
+  this->Append(input.data(), input.size());
 }
 
 std::vector<unsigned char> cmCryptoHash::Finalize()
 {
+  if (this->Accel) {
+    std::vector<unsigned char> hash(this->Accel->GetDigestSize(), 0);
+    this->Accel->Finalize(hash.data());
+    return hash;
+  }
   std::vector<unsigned char> hash(rhash_get_digest_size(this->Id), 0);
   rhash_final(this->CTX, hash.data());
   return hash;
@@ -9,8 +9,11 @@
 #include <string>
 #include <vector>
 
+#include <cm/optional>
 #include <cm/string_view>
 
+class cmCryptoHashAccel;
+
 /**
  * @brief Abstract base class for cryptographic hash generators
  */
@@ -45,6 +48,9 @@ public:
   ///         an invalid/NULL pointer otherwise
   static std::unique_ptr<cmCryptoHash> New(cm::string_view algo);
 
+  /// @brief Returns the hash type of the given name, as for New()
+  static cm::optional<Algo> AlgoFromName(cm::string_view name);
+
   /// @brief Converts a hex character to its binary value (4 bits)
   /// @arg input Hex character [0-9a-fA-F].
   /// @arg output Binary value of the input character (4 bits)
@@ -74,6 +80,17 @@ public:
   ///         An empty string otherwise.
   std::string HashFile(const std::string& file);
 
+  /// @brief Calculates hash strings of many files in parallel
+  /// @arg algo Hash type, as for the constructor
+  /// @arg files Files to hash
+  /// @arg threads Number of threads, or 0 for one per processor
+  /// @return One hash string per file, in order.  The hash string of a
+  ///         file that could not be read is empty, and the error is
+  ///         stored in the corresponding element of errors, if given.
+  static std::vector<std::string> HashFiles(
+    Algo algo, std::vector<std::string> const& files, unsigned int threads,
+    std::vector<std::string>* errors = nullptr);
+
   /// @brief Returns the name of the hash type.
   /// @return The name of the hash type associated with this hash generator.
   std::string GetHashAlgoName() const;
@@ -85,6 +102,10 @@ public:
   std::string FinalizeHex();
 
 private:
+  bool AppendFile(const std::string& file);
+
   unsigned int Id;
-  struct rhash_context* CTX;
+  struct rhash_context* CTX = nullptr;
+  // SHA-1 and SHA-2 computed with processor extensions, if available.
+  std::unique_ptr<cmCryptoHashAccel> Accel;
 };
@@ -0,0 +1,356 @@
+/* Distributed under the OSI-approved BSD 3-Clause License.  See accompanying
+   file Copyright.txt or https://cmake.org/licensing for details.  */
+#include "cmCryptoHashAccel.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+
+#if (defined(__x86_64__) || defined(_M_X64)) &&                               \
+  ((defined(__clang__) && __clang_major__ >= 9) ||                            \
+   (defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 5) ||             \
+   (defined(_MSC_VER) && !defined(__clang__) && _MSC_VER >= 1900))
+#  define CM_CRYPTO_HASH_X86_SHA
+#endif
+
+#ifdef CM_CRYPTO_HASH_X86_SHA
+#  include <immintrin.h>
+#  if defined(_MSC_VER)
+#    include <intrin.h>
+#  else
+#    include <cpuid.h>
+#  endif
+#  if defined(__GNUC__) || defined(__clang__)
+#    define CM_TARGET_SHA __attribute__((target("sha,sse4.1,ssse3")))
+#  else
+#    define CM_TARGET_SHA
+#  endif
+#endif
+
+namespace {
+std::uint32_t const kSHA1Init[5] = {
+  0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476, 0xc3d2e1f0,
+};
+
+std::uint32_t const kSHA224Init[8] = {
+  0xc1059ed8, 0x367cd507, 0x3070dd17, 0xf70e5939,
+  0xffc00b31, 0x68581511, 0x64f98fa7, 0xbefa4fa4,
+};
+
+std::uint32_t const kSHA256Init[8] = {
+  0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+  0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+};
+
+#ifdef CM_CRYPTO_HASH_X86_SHA
+alignas(16) std::uint32_t const kSHA256Rounds[64] = {
+  0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1,
+  0x923f82a4, 0xab1c5ed5, 0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+  0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174, 0xe49b69c1, 0xefbe4786,
+  0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+  0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147,
+  0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+  0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85, 0xa2bfe8a1, 0xa81a664b,
+  0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+  0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a,
+  0x5b9cca4f, 0x682e6ff3, 0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+  0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+bool HaveSHAExtensions()
+{
+  unsigned int ecx1 = 0;
+  unsigned int ebx7 = 0;
+#  if defined(_MSC_VER)
+  int info[4];
+  __cpuid(info, 0);
+  if (info[0] < 7) {
+    return false;
+  }
+  __cpuid(info, 1);
+  ecx1 = static_cast<unsigned int>(info[2]);
+  __cpuidex(info, 7, 0);
+  ebx7 = static_cast<unsigned int>(info[1]);
+#  else
+  unsigned int eax = 0;
+  unsigned int ebx = 0;
+  unsigned int ecx = 0;
+  unsigned int edx = 0;
+  if (__get_cpuid_max(0, nullptr) < 7) {
+    return false;
+  }
+  __cpuid(1, eax, ebx, ecx, edx);
+  ecx1 = ecx;
+  __cpuid_count(7, 0, eax, ebx, ecx, edx);
+  ebx7 = ebx;
+#  endif
+  // SSSE3, SSE4.1 and SHA.
+  return (ecx1 & (1u << 9)) && (ecx1 & (1u << 19)) && (ebx7 & (1u << 29));
+}
+
+CM_TARGET_SHA inline __m128i SHA1Schedule(__m128i w0, __m128i w1, __m128i w2,
+                                          __m128i w3)
+{
+  return _mm_sha1msg2_epu32(
+    _mm_xor_si128(_mm_sha1msg1_epu32(w0, w1), w2), w3);
+}
+
+// Run four rounds.  The E value of the rounds derives from the state saved
+// before the previous four.
+template <int F>
+CM_TARGET_SHA inline void SHA1Rounds(__m128i& abcd, __m128i& saved, __m128i w)
+{
+  __m128i const e = _mm_sha1nexte_epu32(saved, w);
+  saved = abcd;
+  abcd = _mm_sha1rnds4_epu32(abcd, e, F);
+}
+
+CM_TARGET_SHA void SHA1Blocks(std::uint32_t* state, unsigned char const* data,
+                              std::size_t blocks)
+{
+  __m128i const mask =
+    _mm_set_epi64x(0x0001020304050607LL, 0x08090a0b0c0d0e0fLL);
+
+  __m128i abcd = _mm_shuffle_epi32(
+    _mm_loadu_si128(reinterpret_cast<__m128i const*>(state)), 0x1b);
+  __m128i e0 = _mm_set_epi32(static_cast<int>(state[4]), 0, 0, 0);
+
+  for (; blocks; --blocks, data += 64) {
+    __m128i const abcdSave = abcd;
+    __m128i const e0Save = e0;
+
+    __m128i w0 = _mm_shuffle_epi8(
+      _mm_loadu_si128(reinterpret_cast<__m128i const*>(data)), mask);
+    __m128i w1 = _mm_shuffle_epi8(
+      _mm_loadu_si128(reinterpret_cast<__m128i const*>(data + 16)), mask);
+    __m128i w2 = _mm_shuffle_epi8(
+      _mm_loadu_si128(reinterpret_cast<__m128i const*>(data + 32)), mask);
+    __m128i w3 = _mm_shuffle_epi8(
+      _mm_loadu_si128(reinterpret_cast<__m128i const*>(data + 48)), mask);
+
+    __m128i saved = abcd;
+    abcd = _mm_sha1rnds4_epu32(abcd, _mm_add_epi32(e0, w0), 0);
+    SHA1Rounds<0>(abcd, saved, w1);
+    SHA1Rounds<0>(abcd, saved, w2);
+    SHA1Rounds<0>(abcd, saved, w3);
+    w0 = SHA1Schedule(w0, w1, w2, w3);
+    SHA1Rounds<0>(abcd, saved, w0);
+    w1 = SHA1Schedule(w1, w2, w3, w0);
+    SHA1Rounds<1>(abcd, saved, w1);
+    w2 = SHA1Schedule(w2, w3, w0, w1);
+    SHA1Rounds<1>(abcd, saved, w2);
+    w3 = SHA1Schedule(w3, w0, w1, w2);
+    SHA1Rounds<1>(abcd, saved, w3);
+    w0 = SHA1Schedule(w0, w1, w2, w3);
+    SHA1Rounds<1>(abcd, saved, w0);
+    w1 = SHA1Schedule(w1, w2, w3, w0);
+    SHA1Rounds<1>(abcd, saved, w1);
+    w2 = SHA1Schedule(w2, w3, w0, w1);
+    SHA1Rounds<2>(abcd, saved, w2);
+    w3 = SHA1Schedule(w3, w0, w1, w2);
+    SHA1Rounds<2>(abcd, saved, w3);
+    w0 = SHA1Schedule(w0, w1, w2, w3);
+    SHA1Rounds<2>(abcd, saved, w0);
+    w1 = SHA1Schedule(w1, w2, w3, w0);
+    SHA1Rounds<2>(abcd, saved, w1);
+    w2 = SHA1Schedule(w2, w3, w0, w1);
+    SHA1Rounds<2>(abcd, saved, w2);
+    w3 = SHA1Schedule(w3, w0, w1, w2);
+    SHA1Rounds<3>(abcd, saved, w3);
+    w0 = SHA1Schedule(w0, w1, w2, w3);
+    SHA1Rounds<3>(abcd, saved, w0);
+    w1 = SHA1Schedule(w1, w2, w3, w0);
+    SHA1Rounds<3>(abcd, saved, w1);
+    w2 = SHA1Schedule(w2, w3, w0, w1);
+    SHA1Rounds<3>(abcd, saved, w2);
+    w3 = SHA1Schedule(w3, w0, w1, w2);
+    SHA1Rounds<3>(abcd, saved, w3);
+
+    e0 = _mm_sha1nexte_epu32(saved, e0Save);
+    abcd = _mm_add_epi32(abcd, abcdSave);
+  }
+
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(state),
+                   _mm_shuffle_epi32(abcd, 0x1b));
+  state[4] = static_cast<std::uint32_t>(_mm_extract_epi32(e0, 3));
+}
+
+CM_TARGET_SHA inline __m128i SHA256Schedule(__m128i w0, __m128i w1,
+                                            __m128i w2, __m128i w3)
+{
+  return _mm_sha256msg2_epu32(
+    _mm_add_epi32(_mm_sha256msg1_epu32(w0, w1), _mm_alignr_epi8(w3, w2, 4)),
+    w3);
+}
+
+CM_TARGET_SHA inline void SHA256Rounds(__m128i& abef, __m128i& cdgh,
+                                       __m128i w, int group)
+{
+  __m128i msg = _mm_add_epi32(
+    w,
+    _mm_load_si128(
+      reinterpret_cast<__m128i const*>(kSHA256Rounds + 4 * group)));
+  cdgh = _mm_sha256rnds2_epu32(cdgh, abef, msg);
+  msg = _mm_shuffle_epi32(msg, 0x0e);
+  abef = _mm_sha256rnds2_epu32(abef, cdgh, msg);
+}
+
+CM_TARGET_SHA void SHA256Blocks(std::uint32_t* state,
+                                unsigned char const* data, std::size_t blocks)
+{
+  __m128i const mask =
+    _mm_set_epi64x(0x0c0d0e0f08090a0bLL, 0x0405060700010203LL);
+
+  // The instructions take the state as ABEF and CDGH.
+  __m128i tmp = _mm_shuffle_epi32(
+    _mm_loadu_si128(reinterpret_cast<__m128i const*>(state)), 0xb1);
+  __m128i cdgh = _mm_shuffle_epi32(
+    _mm_loadu_si128(reinterpret_cast<__m128i const*>(state + 4)), 0x1b);
+  __m128i abef = _mm_alignr_epi8(tmp, cdgh, 8);
+  cdgh = _mm_blend_epi16(cdgh, tmp, 0xf0);
+
+  for (; blocks; --blocks, data += 64) {
+    __m128i const abefSave = abef;
+    __m128i const cdghSave = cdgh;
+
+    __m128i w0 = _mm_shuffle_epi8(
+      _mm_loadu_si128(reinterpret_cast<__m128i const*>(data)), mask);
+    __m128i w1 = _mm_shuffle_epi8(
+      _mm_loadu_si128(reinterpret_cast<__m128i const*>(data + 16)), mask);
+    __m128i w2 = _mm_shuffle_epi8(
+      _mm_loadu_si128(reinterpret_cast<__m128i const*>(data + 32)), mask);
+    __m128i w3 = _mm_shuffle_epi8(
+      _mm_loadu_si128(reinterpret_cast<__m128i const*>(data + 48)), mask);
+
+    SHA256Rounds(abef, cdgh, w0, 0);
+    SHA256Rounds(abef, cdgh, w1, 1);
+    SHA256Rounds(abef, cdgh, w2, 2);
+    SHA256Rounds(abef, cdgh, w3, 3);
+    for (int group = 4; group < 16; group += 4) {
+      w0 = SHA256Schedule(w0, w1, w2, w3);
+      SHA256Rounds(abef, cdgh, w0, group);
+      w1 = SHA256Schedule(w1, w2, w3, w0);
+      SHA256Rounds(abef, cdgh, w1, group + 1);
+      w2 = SHA256Schedule(w2, w3, w0, w1);
+      SHA256Rounds(abef, cdgh, w2, group + 2);
+      w3 = SHA256Schedule(w3, w0, w1, w2);
+      SHA256Rounds(abef, cdgh, w3, group + 3);
+    }
+
+    abef = _mm_add_epi32(abef, abefSave);
+    cdgh = _mm_add_epi32(cdgh, cdghSave);
+  }
+
+  tmp = _mm_shuffle_epi32(abef, 0x1b);
+  cdgh = _mm_shuffle_epi32(cdgh, 0xb1);
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(state),
+                   _mm_blend_epi16(tmp, cdgh, 0xf0));
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(state + 4),
+                   _mm_alignr_epi8(cdgh, tmp, 8));
+}
+#endif
+}
+
+std::unique_ptr<cmCryptoHashAccel> cmCryptoHashAccel::New(Algo algo)
+{
+#ifdef CM_CRYPTO_HASH_X86_SHA
+  static bool const haveSHA = HaveSHAExtensions();
+  if (haveSHA) {
+    std::unique_ptr<cmCryptoHashAccel> hash(new cmCryptoHashAccel(
+      algo, algo == Algo::SHA1 ? SHA1Blocks : SHA256Blocks));
+    return hash;
+  }
+#else
+  static_cast<void>(algo);
+#endif
+  return std::unique_ptr<cmCryptoHashAccel>();
+}
+
+cmCryptoHashAccel::cmCryptoHashAccel(Algo algo, BlockFunction blocks)
+  : TheAlgo(algo)
+  , Blocks(blocks)
+{
+  this->Initialize();
+}
+
+void cmCryptoHashAccel::Initialize()
+{
+  switch (this->TheAlgo) {
+    case Algo::SHA1:
+      std::copy(std::begin(kSHA1Init), std::end(kSHA1Init), this->State);
+      break;
+    case Algo::SHA224:
+      std::copy(std::begin(kSHA224Init), std::end(kSHA224Init), this->State);
+      break;
+    case Algo::SHA256:
+      std::copy(std::begin(kSHA256Init), std::end(kSHA256Init), this->State);
+      break;
+  }
+  this->Used = 0;
+  this->Length = 0;
+}
+
+void cmCryptoHashAccel::Append(unsigned char const* data, std::size_t size)
+{
+  if (!size) {
+    return;
+  }
+  this->Length += size;
+  if (this->Used) {
+    std::size_t const n = std::min(sizeof(this->Buffer) - this->Used, size);
+    std::memcpy(this->Buffer + this->Used, data, n);
+    this->Used += n;
+    data += n;
+    size -= n;
+    if (this->Used < sizeof(this->Buffer)) {
+      return;
+    }
+    this->Blocks(this->State, this->Buffer, 1);
+    this->Used = 0;
+  }
+  std::size_t const blocks = size / 64;
+  if (blocks) {
+    this->Blocks(this->State, data, blocks);
+    data += blocks * 64;
+    size -= blocks * 64;
+  }
+  if (size) {
+    std::memcpy(this->Buffer, data, size);
+    this->Used = size;
+  }
+}
+
+void cmCryptoHashAccel::Finalize(unsigned char* digest)
+{
+  // Pad with a one bit and zeros up to the length in bits, big-endian.
+  std::uint64_t const bits = this->Length * 8;
+  unsigned char pad[72] = { 0x80 };
+  std::size_t const padSize =
+    (this->Used < 56 ? 56 - this->Used : 120 - this->Used);
+  for (int i = 0; i < 8; ++i) {
+    pad[padSize + i] = static_cast<unsigned char>(bits >> (56 - 8 * i));
+  }
+  this->Append(pad, padSize + 8);
+
+  std::size_t const words = this->GetDigestSize() / 4;
+  for (std::size_t i = 0; i < words; ++i) {
+    std::uint32_t const word = this->State[i];
+    digest[4 * i] = static_cast<unsigned char>(word >> 24);
+    digest[4 * i + 1] = static_cast<unsigned char>(word >> 16);
+    digest[4 * i + 2] = static_cast<unsigned char>(word >> 8);
+    digest[4 * i + 3] = static_cast<unsigned char>(word);
+  }
+}
+
+std::size_t cmCryptoHashAccel::GetDigestSize() const
+{
+  switch (this->TheAlgo) {
+    case Algo::SHA1:
+      return 20;
+    case Algo::SHA224:
+      return 28;
+    case Algo::SHA256:
+      break;
+  }
+  return 32;
+}
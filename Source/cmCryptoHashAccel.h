@@ -0,0 +1,54 @@
+/* Distributed under the OSI-approved BSD 3-Clause License.  See accompanying
+   file Copyright.txt or https://cmake.org/licensing for details.  */
+#pragma once
+
+#include "cmConfigure.h" // IWYU pragma: keep
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+/** \class cmCryptoHashAccel
+ * \brief SHA-1 and SHA-256 computed with the processor's SHA instructions.
+ *
+ * The x86 SHA extensions run the block functions of SHA-1 and SHA-256
+ * several times faster than portable code.  An instance is available
+ * only if the compiler supports the extensions and the processor running
+ * CMake has them, see New().
+ */
+class cmCryptoHashAccel
+{
+public:
+  enum class Algo
+  {
+    SHA1,
+    SHA224,
+    SHA256,
+  };
+
+  /** Return a hash context for the algorithm, or null if the processor
+      cannot accelerate it.  */
+  static std::unique_ptr<cmCryptoHashAccel> New(Algo algo);
+
+  void Initialize();
+  void Append(unsigned char const* data, std::size_t size);
+
+  /** Write the digest, of GetDigestSize() bytes.  */
+  void Finalize(unsigned char* digest);
+
+  std::size_t GetDigestSize() const;
+
+private:
+  using BlockFunction = void (*)(std::uint32_t* state,
+                                 unsigned char const* data,
+                                 std::size_t blocks);
+
+  cmCryptoHashAccel(Algo algo, BlockFunction blocks);
+
+  Algo TheAlgo;
+  BlockFunction Blocks;
+  std::uint32_t State[8];
+  unsigned char Buffer[64];
+  std::size_t Used = 0;
+  std::uint64_t Length = 0;
+};
@@ -0,0 +1,158 @@
+/* Distributed under the OSI-approved BSD 3-Clause License.  See accompanying
+   file Copyright.txt or https://cmake.org/licensing for details.  */
+#include "cmDownloadCache.h"
+
+#include <algorithm>
+#include <set>
+#include <utility>
+
+#include "cmsys/FStream.hxx"
+
+#include "cmCryptoHash.h"
+#include "cmStringAlgorithms.h"
+#include "cmSystemTools.h"
+
+namespace {
+// URLs served from the cache by this process.
+std::set<std::string>& ServedURLs()
+{
+  static std::set<std::string> served;
+  return served;
+}
+
+bool IsHex(std::string const& value)
+{
+  return !value.empty() &&
+    std::all_of(value.begin(), value.end(), [](char c) {
+           return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f');
+         });
+}
+
+// Copy between the cache and a downloaded file.  A hard link would let
+// an edit of the downloaded file change the cache entry.  The copy
+// clones the content where the file system supports it.
+bool Copy(std::string const& from, std::string const& to)
+{
+  return cmSystemTools::CopySingleFile(from, to,
+                                       cmSystemTools::CopyWhen::Always,
+                                       cmSystemTools::CopyInputRecent::No) ==
+    cmSystemTools::CopyResult::Success;
+}
+
+std::string HashURL(std::string const& url)
+{
+  return cmCryptoHash(cmCryptoHash::AlgoSHA256).HashString(url);
+}
+}
+
+cmDownloadCache::cmDownloadCache(std::string dir)
+  : Dir(std::move(dir))
+{
+}
+
+bool cmDownloadCache::Fetch(cmCryptoHash& hash, std::string const& algo,
+                            std::string const& value,
+                            std::string const& file) const
+{
+  std::string const entry = this->GetEntry(algo, value);
+  if (entry.empty() || !cmSystemTools::FileExists(entry, true)) {
+    return false;
+  }
+  if (hash.HashFile(entry) != value) {
+    cmSystemTools::RemoveFile(entry);
+    return false;
+  }
+  cmSystemTools::RemoveFile(file);
+  return Copy(entry, file);
+}
+
+bool cmDownloadCache::FetchURL(std::string const& url,
+                               std::string const& file) const
+{
+  if (!ServedURLs().insert(url).second) {
+    return false;
+  }
+  std::string line;
+  {
+    cmsys::ifstream fin(
+      cmStrCat(this->Dir, "/url/", HashURL(url)).c_str());
+    if (!fin || !cmSystemTools::GetLineFromStream(fin, line) ||
+        !cmHasLiteralPrefix(line, "SHA256=")) {
+      return false;
+    }
+  }
+  cmCryptoHash hash(cmCryptoHash::AlgoSHA256);
+  return this->Fetch(hash, "SHA256", line.substr(7), file);
+}
+
+void cmDownloadCache::Store(std::string const& algo, std::string const& value,
+                            std::string const& file) const
+{
+  std::string const entry = this->GetEntry(algo, value);
+  if (!entry.empty()) {
+    this->Add(entry, file);
+  }
+}
+
+void cmDownloadCache::StoreURL(std::string const& url,
+                               std::string const& file) const
+{
+  std::string const value =
+    cmCryptoHash(cmCryptoHash::AlgoSHA256).HashFile(file);
+  if (value.empty() || !this->Add(this->GetEntry("SHA256", value), file)) {
+    return;
+  }
+
+  // Write the alias beside its final name and rename it into place so
+  // that concurrent readers never see a partial line.
+  std::string const dir = cmStrCat(this->Dir, "/url");
+  std::string const alias = cmStrCat(dir, '/', HashURL(url));
+  std::string const temp =
+    cmStrCat(alias, ".tmp", cmSystemTools::RandomSeed());
+  if (!cmSystemTools::MakeDirectory(dir)) {
+    return;
+  }
+  {
+    cmsys::ofstream fout(temp.c_str());
+    fout << "SHA256=" << value << '\n';
+    fout.close();
+    if (!fout) {
+      cmSystemTools::RemoveFile(temp);
+      return;
+    }
+  }
+  if (!cmSystemTools::RenameFile(temp, alias)) {
+    cmSystemTools::RemoveFile(temp);
+  }
+}
+
+std::string cmDownloadCache::GetEntry(std::string const& algo,
+                                      std::string const& value) const
+{
+  // The hash is given by the caller, so only accept plain hex digits.
+  if (!IsHex(value)) {
+    return std::string();
+  }
+  return cmStrCat(this->Dir, '/', cmSystemTools::LowerCase(algo), '/',
+                  value);
+}
+
+bool cmDownloadCache::Add(std::string const& entry,
+                          std::string const& file) const
+{
+  if (cmSystemTools::FileExists(entry, true)) {
+    return true;
+  }
+  if (!cmSystemTools::MakeDirectory(cmSystemTools::GetFilenamePath(entry))) {
+    return false;
+  }
+  // Add the entry under a temporary name first so that a concurrent
+  // reader never sees it partially written.
+  std::string const temp =
+    cmStrCat(entry, ".tmp", cmSystemTools::RandomSeed());
+  if (Copy(file, temp) && cmSystemTools::RenameFile(temp, entry)) {
+    return true;
+  }
+  cmSystemTools::RemoveFile(temp);
+  return false;
+}
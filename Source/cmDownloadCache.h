@@ -0,0 +1,49 @@
+/* Distributed under the OSI-approved BSD 3-Clause License.  See accompanying
+   file Copyright.txt or https://cmake.org/licensing for details.  */
+#pragma once
+
+#include "cmConfigure.h" // IWYU pragma: keep
+
+#include <string>
+
+class cmCryptoHash;
+
+/** \class cmDownloadCache
+ * \brief Local store of downloaded files, addressed by their content.
+ *
+ * Each entry is a file named "<algo>/<hash>" in the cache directory, where
+ * <algo> is the lower-case name of the hash algorithm.  Files downloaded
+ * without an expected hash are stored under their SHA256 hash, and an
+ * alias named "url/<SHA256 hash of the URL>" records which entry the URL
+ * gave.  Entries are copied in and out of the cache, so that editing a
+ * downloaded file never changes an entry.
+ */
+class cmDownloadCache
+{
+public:
+  explicit cmDownloadCache(std::string dir);
+
+  /** Place the entry with the given hash at the file.  The entry is
+      checked against the hash first, and removed if it does not match.  */
+  bool Fetch(cmCryptoHash& hash, std::string const& algo,
+             std::string const& value, std::string const& file) const;
+
+  /** Place the entry last downloaded from the URL at the file.  A URL is
+      served from the cache at most once per process, so that a caller
+      that rejects the content gets a fresh download on retry.  */
+  bool FetchURL(std::string const& url, std::string const& file) const;
+
+  /** Store a file downloaded with the given expected hash.  */
+  void Store(std::string const& algo, std::string const& value,
+             std::string const& file) const;
+
+  /** Store a file downloaded from the URL without an expected hash.  */
+  void StoreURL(std::string const& url, std::string const& file) const;
+
+private:
+  std::string GetEntry(std::string const& algo,
+                       std::string const& value) const;
+  bool Add(std::string const& entry, std::string const& file) const;
+
+  std::string Dir;
+};
@@ -2,8 +2,11 @@
    file Copyright.txt or https://cmake.org/licensing for details.  */
 #include "cmELF.h"
 
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
+#include <ios>
 #include <map>
 #include <memory>
 #include <sstream>
@@ -109,6 +112,7 @@ public:
   virtual std::vector<char> EncodeDynamicEntries(
     const cmELF::DynamicEntryList&) = 0;
   virtual StringEntry const* GetDynamicSectionString(unsigned int tag) = 0;
+  virtual bool EncodeStripped(std::vector<char>& content) = 0;
   virtual bool IsMips() const = 0;
   virtual void PrintInfo(std::ostream& os) const = 0;
 
@@ -178,6 +182,7 @@ protected:
 struct cmELFTypes32
 {
   using ELF_Ehdr = Elf32_Ehdr;
+  using ELF_Phdr = Elf32_Phdr;
   using ELF_Shdr = Elf32_Shdr;
   using ELF_Dyn = Elf32_Dyn;
   using ELF_Half = Elf32_Half;
@@ -189,6 +194,7 @@ struct cmELFTypes32
 struct cmELFTypes64
 {
   using ELF_Ehdr = Elf64_Ehdr;
+  using ELF_Phdr = Elf64_Phdr;
   using ELF_Shdr = Elf64_Shdr;
   using ELF_Dyn = Elf64_Dyn;
   using ELF_Half = Elf64_Half;
@@ -203,6 +209,7 @@ class cmELFInternalImpl : public cmELFInternal
 public:
   // Copy the ELF file format types from our configuration parameter.
   using ELF_Ehdr = typename Types::ELF_Ehdr;
+  using ELF_Phdr = typename Types::ELF_Phdr;
   using ELF_Shdr = typename Types::ELF_Shdr;
   using ELF_Dyn = typename Types::ELF_Dyn;
   using ELF_Half = typename Types::ELF_Half;
@@ -229,6 +236,8 @@ public:
   // Lookup a string from the dynamic section with the given tag.
   StringEntry const* GetDynamicSectionString(unsigned int tag) override;
 
+  bool EncodeStripped(std::vector<char>& content) override;
+
   bool IsMips() const override { return this->ELFHeader.e_machine == EM_MIPS; }
 
   // Print information about the ELF file.
@@ -287,6 +296,18 @@ private:
     cmELFByteSwap(elf_header.e_shstrndx);
   }
 
+  void ByteSwap(ELF_Phdr& prog_header)
+  {
+    cmELFByteSwap(prog_header.p_type);
+    cmELFByteSwap(prog_header.p_flags);
+    cmELFByteSwap(prog_header.p_offset);
+    cmELFByteSwap(prog_header.p_vaddr);
+    cmELFByteSwap(prog_header.p_paddr);
+    cmELFByteSwap(prog_header.p_filesz);
+    cmELFByteSwap(prog_header.p_memsz);
+    cmELFByteSwap(prog_header.p_align);
+  }
+
   void ByteSwap(ELF_Shdr& sec_header)
   {
     cmELFByteSwap(sec_header.sh_name);
@@ -362,6 +383,14 @@ private:
     }
     return !this->Stream->fail();
   }
+  bool Read(ELF_Phdr& x)
+  {
+    if (this->Stream->read(reinterpret_cast<char*>(&x), sizeof(x)) &&
+        this->NeedSwap) {
+      this->ByteSwap(x);
+    }
+    return !this->Stream->fail();
+  }
   bool Read(ELF_Dyn& x)
   {
     if (this->Stream->read(reinterpret_cast<char*>(&x), sizeof(x)) &&
@@ -555,6 +584,184 @@ std::vector<char> cmELFInternalImpl<Types>::EncodeDynamicEntries(
   return result;
 }
 
+template <class Types>
+bool cmELFInternalImpl<Types>::EncodeStripped(std::vector<char>& content)
+{
+  content.clear();
+
+  // Only linked files are stripped.  Sections are renumbered below, so
+  // give up on files using extended section numbering.
+  ELF_Ehdr const& eh = this->ELFHeader;
+  std::size_t const n = this->SectionHeaders.size();
+  if ((this->ELFType != cmELF::FileTypeExecutable &&
+       this->ELFType != cmELF::FileTypeSharedLibrary) ||
+      eh.e_shnum == 0 || n >= SHN_LORESERVE || eh.e_shstrndx == SHN_UNDEF ||
+      eh.e_shstrndx >= n || eh.e_shentsize != sizeof(ELF_Shdr) ||
+      (eh.e_phnum > 0 && eh.e_phentsize != sizeof(ELF_Phdr))) {
+    return false;
+  }
+
+  // Read the whole file.
+  this->Stream->clear();
+  if (!this->Stream->seekg(0, std::ios::end)) {
+    return false;
+  }
+  std::streamoff const size = this->Stream->tellg();
+  std::vector<char> file(static_cast<std::size_t>(size));
+  if (!this->Stream->seekg(0) ||
+      !this->Stream->read(file.data(), static_cast<std::streamsize>(size))) {
+    return false;
+  }
+  auto inFile = [size](std::uint64_t offset, std::uint64_t length) {
+    return offset <= static_cast<std::uint64_t>(size) &&
+      length <= static_cast<std::uint64_t>(size) - offset;
+  };
+  ELF_Shdr const& names = this->SectionHeaders[eh.e_shstrndx];
+  if (!inFile(names.sh_offset, names.sh_size)) {
+    return false;
+  }
+  auto nameOf = [&file, &names](ELF_Shdr const& sh) -> std::string {
+    if (sh.sh_name >= names.sh_size) {
+      return std::string();
+    }
+    char const* name = file.data() + names.sh_offset + sh.sh_name;
+    char const* end = name + (names.sh_size - sh.sh_name);
+    return std::string(name, std::find(name, end, '\0'));
+  };
+
+  // Drop the symbol table, its strings, and the debugging information,
+  // all of which are not loaded at runtime.
+  std::vector<bool> drop(n, false);
+  bool dropAny = false;
+  std::size_t lastAlloc = 0;
+  for (std::size_t i = 1; i < n; ++i) {
+    ELF_Shdr const& sh = this->SectionHeaders[i];
+    if (sh.sh_flags & SHF_ALLOC) {
+      lastAlloc = i;
+      continue;
+    }
+    std::string const name = nameOf(sh);
+    if (sh.sh_type == SHT_SYMTAB || name.compare(0, 6, ".debug") == 0 ||
+        name.compare(0, 7, ".zdebug") == 0) {
+      drop[i] = true;
+      dropAny = true;
+    }
+  }
+  for (std::size_t i = 1; i < n; ++i) {
+    ELF_Shdr const& sh = this->SectionHeaders[i];
+    if (drop[i] && sh.sh_type == SHT_SYMTAB && sh.sh_link < n &&
+        sh.sh_link != eh.e_shstrndx &&
+        !(this->SectionHeaders[sh.sh_link].sh_flags & SHF_ALLOC)) {
+      drop[sh.sh_link] = true;
+    }
+  }
+  if (!dropAny) {
+    return true;
+  }
+
+  // Keep the loaded part of the file as it is.  That requires all
+  // loaded sections to keep their index, and no kept section to refer
+  // to a dropped one.
+  std::uint64_t imageEnd = eh.e_ehsize;
+  if (eh.e_phnum > 0) {
+    if (!inFile(eh.e_phoff, std::uint64_t(eh.e_phnum) * sizeof(ELF_Phdr))) {
+      return false;
+    }
+    imageEnd = std::max<std::uint64_t>(
+      imageEnd, eh.e_phoff + std::uint64_t(eh.e_phnum) * sizeof(ELF_Phdr));
+    this->Stream->seekg(eh.e_phoff);
+    for (unsigned int i = 0; i < eh.e_phnum; ++i) {
+      ELF_Phdr ph;
+      if (!this->Read(ph) || !inFile(ph.p_offset, ph.p_filesz)) {
+        return false;
+      }
+      imageEnd =
+        std::max<std::uint64_t>(imageEnd, ph.p_offset + ph.p_filesz);
+    }
+  }
+  std::vector<std::uint32_t> index(n, 0);
+  std::uint32_t kept = 0;
+  for (std::size_t i = 0; i < n; ++i) {
+    ELF_Shdr const& sh = this->SectionHeaders[i];
+    bool const relocs = sh.sh_type == SHT_REL || sh.sh_type == SHT_RELA;
+    bool const infoLink = relocs || (sh.sh_flags & SHF_INFO_LINK);
+    if (drop[i]) {
+      if (i < lastAlloc) {
+        return false;
+      }
+      continue;
+    }
+    // Relocations in static executables may refer to the symbol table,
+    // but need no symbols at runtime.  "strip" unlinks them too.
+    if ((sh.sh_link < n && drop[sh.sh_link] &&
+         !(relocs &&
+           this->SectionHeaders[sh.sh_link].sh_type == SHT_SYMTAB)) ||
+        (infoLink && sh.sh_info < n && drop[sh.sh_info])) {
+      return false;
+    }
+    if (sh.sh_type != SHT_NOBITS && !inFile(sh.sh_offset, sh.sh_size)) {
+      return false;
+    }
+    if (i > 0 && (sh.sh_flags & SHF_ALLOC) && sh.sh_type != SHT_NOBITS) {
+      imageEnd = std::max<std::uint64_t>(imageEnd, sh.sh_offset + sh.sh_size);
+    }
+    index[i] = kept++;
+  }
+  for (std::size_t i = 1; i < n; ++i) {
+    ELF_Shdr const& sh = this->SectionHeaders[i];
+    if (!(sh.sh_flags & SHF_ALLOC) && sh.sh_type != SHT_NOBITS &&
+        sh.sh_size > 0 && sh.sh_offset < imageEnd) {
+      return false;
+    }
+  }
+
+  // Append the kept sections that are not loaded, then the new section
+  // header table.
+  content.assign(file.begin(), file.begin() + imageEnd);
+  std::vector<ELF_Shdr> headers;
+  headers.reserve(kept);
+  for (std::size_t i = 0; i < n; ++i) {
+    if (drop[i]) {
+      continue;
+    }
+    ELF_Shdr sh = this->SectionHeaders[i];
+    if (i > 0 && !(sh.sh_flags & SHF_ALLOC) && sh.sh_type != SHT_NOBITS) {
+      std::uint64_t const align = sh.sh_addralign ? sh.sh_addralign : 1;
+      content.resize((content.size() + align - 1) / align * align, 0);
+      char const* data = file.data() + sh.sh_offset;
+      sh.sh_offset = content.size();
+      content.insert(content.end(), data, data + sh.sh_size);
+    }
+    if (sh.sh_link < n) {
+      sh.sh_link = drop[sh.sh_link] ? 0 : index[sh.sh_link];
+    }
+    bool const infoLink = sh.sh_type == SHT_REL || sh.sh_type == SHT_RELA ||
+      (sh.sh_flags & SHF_INFO_LINK);
+    if (infoLink && sh.sh_info < n) {
+      sh.sh_info = index[sh.sh_info];
+    }
+    headers.push_back(sh);
+  }
+  std::size_t const word = sizeof(eh.e_shoff);
+  content.resize((content.size() + word - 1) / word * word, 0);
+  ELF_Ehdr header = eh;
+  header.e_shoff = content.size();
+  header.e_shnum = static_cast<ELF_Half>(kept);
+  header.e_shstrndx = static_cast<ELF_Half>(index[eh.e_shstrndx]);
+  for (ELF_Shdr& sh : headers) {
+    if (this->NeedSwap) {
+      this->ByteSwap(sh);
+    }
+    char const* data = reinterpret_cast<char const*>(&sh);
+    content.insert(content.end(), data, data + sizeof(sh));
+  }
+  if (this->NeedSwap) {
+    this->ByteSwap(header);
+  }
+  std::memcpy(content.data(), &header, sizeof(header));
+  return true;
+}
+
 template <class Types>
 cmELF::StringEntry const* cmELFInternalImpl<Types>::GetDynamicSectionString(
   unsigned int tag)
@@ -775,6 +982,12 @@ std::vector<char> cmELF::EncodeDynamicEntries(
   return std::vector<char>();
 }
 
+bool cmELF::EncodeStripped(std::vector<char>& content)
+{
+  content.clear();
+  return this->Valid() && this->Internal->EncodeStripped(content);
+}
+
 bool cmELF::HasDynamicSection() const
 {
   return this->Valid() && this->Internal->HasDynamicSection();
@@ -88,6 +88,12 @@ public:
   std::vector<char> EncodeDynamicEntries(
     const DynamicEntryList& entries) const;
 
+  /** Encode the file without its symbol table and debugging sections,
+      as "strip" leaves an executable or shared library.  The content is
+      empty if there is nothing to remove.  Returns false if the layout
+      of the file does not allow this without moving loaded sections.  */
+  bool EncodeStripped(std::vector<char>& content);
+
   /** Returns true if the ELF file has a dynamic section **/
   bool HasDynamicSection() const;
 
@@ -67,6 +67,7 @@
 #  include <cm3p/curl/curl.h>
 
 #  include "cmCurl.h"
+#  include "cmDownloadCache.h"
 #  include "cmFileLockResult.h"
 #endif
 
@@ -285,6 +286,81 @@ bool HandleHashCommand(std::vector<std::string> const& args,
 #endif
 }
 
+bool HandleHashManyCommand(std::vector<std::string> const& args,
+                           cmExecutionStatus& status)
+{
+#if !defined(CMAKE_BOOTSTRAP)
+  if (args.size() < 3) {
+    status.SetError("HASH_MANY requires an algorithm and output variable");
+    return false;
+  }
+
+  cm::optional<cmCryptoHash::Algo> algo =
+    cmCryptoHash::AlgoFromName(args[1]);
+  if (!algo) {
+    status.SetError(cmStrCat("HASH_MANY given unknown algorithm: ", args[1]));
+    return false;
+  }
+
+  struct Arguments : public ArgumentParser::ParseResult
+  {
+    ArgumentParser::MaybeEmpty<std::vector<std::string>> Files;
+    std::string ParallelLevel;
+  };
+
+  static auto const parser =
+    cmArgumentParser<Arguments>{}
+      .Bind("FILES"_s, &Arguments::Files)
+      .Bind("PARALLEL_LEVEL"_s, &Arguments::ParallelLevel);
+
+  std::vector<std::string> unrecognizedArguments;
+  auto parsedArgs =
+    parser.Parse(cmMakeRange(args).advance(3), &unrecognizedArguments);
+  auto argIt = unrecognizedArguments.begin();
+  if (argIt != unrecognizedArguments.end()) {
+    status.SetError(cmStrCat("Unrecognized argument: \"", *argIt, "\""));
+    cmSystemTools::SetFatalErrorOccurred();
+    return false;
+  }
+
+  if (parsedArgs.MaybeReportError(status.GetMakefile())) {
+    cmSystemTools::SetFatalErrorOccurred();
+    return true;
+  }
+
+  unsigned long threads = 0;
+  if (!parsedArgs.ParallelLevel.empty() &&
+      (!cmStrToULong(parsedArgs.ParallelLevel, &threads) || threads == 0)) {
+    status.SetError(cmStrCat("HASH_MANY given invalid PARALLEL_LEVEL: ",
+                             parsedArgs.ParallelLevel));
+    return false;
+  }
+
+  std::vector<std::string> files;
+  files.reserve(parsedArgs.Files.size());
+  for (std::string const& file : parsedArgs.Files) {
+    files.emplace_back(cmSystemTools::CollapseFullPath(
+      file, status.GetMakefile().GetCurrentSourceDirectory()));
+  }
+
+  std::vector<std::string> errors;
+  std::vector<std::string> const hashes = cmCryptoHash::HashFiles(
+    *algo, files, static_cast<unsigned int>(threads), &errors);
+  for (size_t i = 0; i < files.size(); ++i) {
+    if (hashes[i].empty()) {
+      status.SetError(cmStrCat("HASH_MANY failed to read file \"", files[i],
+                               "\": ", errors[i]));
+      return false;
+    }
+  }
+  status.GetMakefile().AddDefinition(args[2], cmList::to_string(hashes));
+  return true;
+#else
+  status.SetError("HASH_MANY not available during bootstrap");
+  return false;
+#endif
+}
+
 bool HandleStringsCommand(std::vector<std::string> const& args,
                           cmExecutionStatus& status)
 {
@@ -1266,6 +1342,50 @@ bool HandleRPathCheckCommand(std::vector<std::string> const& args,
   return true;
 }
 
+bool HandleStripCommand(std::vector<std::string> const& args,
+                        cmExecutionStatus& status)
+{
+  // Evaluate arguments.
+  std::string file;
+  ArgumentParser::NonEmpty<std::vector<std::string>> command;
+  cmArgumentParser<void> parser;
+  std::vector<std::string> unknownArgs;
+  parser.Bind("FILE"_s, file).Bind("COMMAND"_s, command);
+  ArgumentParser::ParseResult parseResult =
+    parser.Parse(cmMakeRange(args).advance(1), &unknownArgs);
+  if (!unknownArgs.empty()) {
+    status.SetError(
+      cmStrCat("STRIP given unknown argument ", unknownArgs.front()));
+    return false;
+  }
+  if (parseResult.MaybeReportError(status.GetMakefile())) {
+    return true;
+  }
+  if (file.empty()) {
+    status.SetError("STRIP not given FILE option.");
+    return false;
+  }
+  if (!cmSystemTools::FileExists(file, true)) {
+    status.SetError(
+      cmStrCat("STRIP given FILE \"", file, "\" that does not exist."));
+    return false;
+  }
+
+  // Strip ELF binaries in-process.  Run the strip tool for other files,
+  // ignoring its result like the install scripts always have.
+  if (cmSystemTools::StripELF(file)) {
+    return true;
+  }
+  if (!command.empty()) {
+    command.push_back(file);
+    int retVal;
+    cmSystemTools::RunSingleCommand(command, nullptr, nullptr, &retVal,
+                                    nullptr,
+                                    cmSystemTools::OUTPUT_PASSTHROUGH);
+  }
+  return true;
+}
+
 bool HandleReadElfCommand(std::vector<std::string> const& args,
                           cmExecutionStatus& status)
 {
@@ -1941,6 +2061,7 @@ bool HandleDownloadCommand(std::vector<std::string> const& args,
   std::string netrc_file =
     status.GetMakefile().GetSafeDefinition("CMAKE_NETRC_FILE");
   std::string expectedHash;
+  std::string hashAlgo;
   std::string hashMatchMSG;
   std::unique_ptr<cmCryptoHash> hash;
   bool showProgress = false;
@@ -2027,6 +2148,7 @@ bool HandleDownloadCommand(std::vector<std::string> const& args,
         return false;
       }
       hash = cm::make_unique<cmCryptoHash>(cmCryptoHash::AlgoMD5);
+      hashAlgo = "MD5";
       hashMatchMSG = "MD5 sum";
       expectedHash = cmSystemTools::LowerCase(*i);
     } else if (*i == "SHOW_PROGRESS") {
@@ -2053,6 +2175,7 @@ bool HandleDownloadCommand(std::vector<std::string> const& args,
         status.SetError(err);
         return false;
       }
+      hashAlgo = algo;
       hashMatchMSG = algo + " hash";
     } else if (*i == "USERPWD") {
       ++i;
@@ -2133,6 +2256,19 @@ bool HandleDownloadCommand(std::vector<std::string> const& args,
     tlsVersionDefaulted = true;
   }
 
+  // Only whole files saved to disk are shared through the download cache.
+  cm::optional<cmDownloadCache> cache;
+  if (!file.empty() && curl_ranges.empty()) {
+    std::string cacheDir =
+      status.GetMakefile().GetSafeDefinition("CMAKE_DOWNLOAD_CACHE");
+    if (cacheDir.empty()) {
+      cmSystemTools::GetEnv("CMAKE_DOWNLOAD_CACHE", cacheDir);
+    }
+    if (!cacheDir.empty()) {
+      cache.emplace(std::move(cacheDir));
+    }
+  }
+
   // Can't calculate hash if we don't save the file.
   // TODO Incrementally calculate hash in the write callback as the file is
   // being downloaded so this check can be relaxed.
@@ -2172,6 +2308,22 @@ bool HandleDownloadCommand(std::vector<std::string> const& args,
     }
   }
 
+  url = cmCurlFixFileURL(url);
+
+  // Take the file from the download cache if it has the content.
+  if (cache &&
+      (hash ? cache->Fetch(*hash, hashAlgo, expectedHash, file)
+            : cache->FetchURL(url, file))) {
+    if (!statusVar.empty()) {
+      status.GetMakefile().AddDefinition(
+        statusVar, "0;\"using file from download cache\"");
+    }
+    if (!logVar.empty()) {
+      status.GetMakefile().AddDefinition(logVar, "");
+    }
+    return true;
+  }
+
   cmsys::ofstream fout;
   if (!file.empty()) {
     fout.open(file.c_str(), std::ios::binary);
@@ -2181,8 +2333,6 @@ bool HandleDownloadCommand(std::vector<std::string> const& args,
     }
   }
 
-  url = cmCurlFixFileURL(url);
-
   ::CURL* curl;
   cmCurlInitOnce();
   ::curl_global_init(CURL_GLOBAL_DEFAULT);
@@ -2399,6 +2549,14 @@ bool HandleDownloadCommand(std::vector<std::string> const& args,
     }
   }
 
+  if (cache && res == CURLE_OK) {
+    if (hash) {
+      cache->Store(hashAlgo, expectedHash, file);
+    } else {
+      cache->StoreURL(url, file);
+    }
+  }
+
   return true;
 #else
   status.SetError("DOWNLOAD not supported by bootstrap cmake.");
@@ -4058,6 +4216,7 @@ bool cmFileCommand(std::vector<std::string> const& args,
     { "SHA3_256"_s, HandleHashCommand },
     { "SHA3_384"_s, HandleHashCommand },
     { "SHA3_512"_s, HandleHashCommand },
+    { "HASH_MANY"_s, HandleHashManyCommand },
     { "STRINGS"_s, HandleStringsCommand },
     { "GLOB"_s, HandleGlobCommand },
     { "GLOB_RECURSE"_s, HandleGlobRecurseCommand },
@@ -4074,6 +4233,7 @@ bool cmFileCommand(std::vector<std::string> const& args,
     { "RPATH_SET"_s, HandleRPathSetCommand },
     { "RPATH_CHECK"_s, HandleRPathCheckCommand },
     { "RPATH_REMOVE"_s, HandleRPathRemoveCommand },
+    { "STRIP"_s, HandleStripCommand },
     { "READ_ELF"_s, HandleReadElfCommand },
     { "READ_MACHO"_s, HandleReadMachoCommand },
     { "REAL_PATH"_s, HandleRealPathCommand },
@@ -3,6 +3,14 @@
 
 #include "cmFileCopier.h"
 
+#include <algorithm>
+#include <set>
+#include <thread>
+#include <utility>
+
+#include <cm/algorithm>
+#include <cm/memory>
+
 #include "cmsys/Directory.hxx"
 #include "cmsys/Glob.hxx"
 
@@ -11,6 +19,7 @@
 #include "cmFileTimes.h"
 #include "cmList.h"
 #include "cmMakefile.h"
+#include "cmParallelFor.h"
 #include "cmStringAlgorithms.h"
 #include "cmSystemTools.h"
 #include "cmValue.h"
@@ -23,11 +32,192 @@
 #  include <cerrno>
 #endif
 
+#ifdef __linux__
+#  include <fcntl.h>
+#  include <linux/fs.h>
+#  include <sys/ioctl.h>
+#  include <sys/syscall.h>
+#  include <unistd.h>
+#endif
+
+#include <cstdlib>
 #include <cstring>
 #include <sstream>
 
 using namespace cmFSPermissions;
 
+namespace {
+struct InstallJob
+{
+  std::string From;
+  std::string To;
+  mode_t Permissions = 0;
+  bool Copy = false;
+  // Whether the job was run, which it is not after another one failed.
+  bool Done = false;
+  std::string Error;
+};
+
+#ifdef __linux__
+bool WriteAll(int out, char const* data, std::size_t size)
+{
+  while (size > 0) {
+    ssize_t const n = write(out, data, size);
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    data += n;
+    size -= static_cast<std::size_t>(n);
+  }
+  return true;
+}
+
+// Copy the content of one open file to another.  Prefer a copy-on-write
+// clone, then a copy within the kernel, then plain reads and writes.
+bool CopyContent(int in, int out)
+{
+#  ifdef FICLONE
+  if (ioctl(out, FICLONE, in) == 0) {
+    return true;
+  }
+#  endif
+#  ifdef SYS_copy_file_range
+  {
+    bool copied = false;
+    for (;;) {
+      ssize_t const n = syscall(SYS_copy_file_range, in, nullptr, out,
+                                nullptr, std::size_t(1) << 30, 0u);
+      if (n > 0) {
+        copied = true;
+        continue;
+      }
+      if (n == 0 && copied) {
+        return true;
+      }
+      if (n < 0 && errno == EINTR) {
+        continue;
+      }
+      if (n < 0 && copied) {
+        return false;
+      }
+      // Nothing was copied because the call is not supported for these
+      // files, or the source is empty or does not report its size.
+      break;
+    }
+  }
+#  endif
+  std::vector<char> buffer(std::size_t(256) << 10);
+  for (;;) {
+    ssize_t const n = read(in, buffer.data(), buffer.size());
+    if (n == 0) {
+      return true;
+    }
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    if (!WriteAll(out, buffer.data(), static_cast<std::size_t>(n))) {
+      return false;
+    }
+  }
+}
+
+long long ModificationTime(struct stat const& st)
+{
+  return st.st_mtim.tv_sec * 1000000000LL + st.st_mtim.tv_nsec;
+}
+
+// Install a regular file using its open descriptors, and so without
+// looking up the paths again for each step.
+void RunJob(InstallJob& job, char const* name, bool always)
+{
+  job.Done = true;
+  int const in = open(job.From.c_str(), O_RDONLY | O_CLOEXEC);
+  struct stat from;
+  if (in < 0 || fstat(in, &from) != 0) {
+    job.Error = cmStrCat(name, " cannot copy file \"", job.From, "\" to \"",
+                         job.To, "\": ", cmSystemTools::GetLastSystemError(),
+                         '.');
+    if (in >= 0) {
+      close(in);
+    }
+    return;
+  }
+  mode_t const permissions =
+    job.Permissions ? job.Permissions : (from.st_mode & 07777);
+
+  // If both files have the same size and time do not copy.
+  job.Copy = true;
+  struct stat to;
+  if (!always && stat(job.To.c_str(), &to) == 0 &&
+      to.st_size == from.st_size &&
+      std::abs(ModificationTime(to) - ModificationTime(from)) < 1000000000LL) {
+    job.Copy = false;
+    close(in);
+    if (chmod(job.To.c_str(), permissions) != 0) {
+      job.Error = cmStrCat(name, " cannot set permissions on \"", job.To,
+                           "\": ", cmSystemTools::GetLastSystemError(), '.');
+    }
+    return;
+  }
+
+  // Remove the destination first so that a read-only file is replaced.
+  unlink(job.To.c_str());
+  int out = open(job.To.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+                 S_IRUSR | S_IWUSR);
+  if (out < 0 && errno == ENOENT) {
+    cmSystemTools::MakeDirectory(cmSystemTools::GetFilenamePath(job.To));
+    out = open(job.To.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+               S_IRUSR | S_IWUSR);
+  }
+  if (out < 0 || !CopyContent(in, out)) {
+    job.Error = cmStrCat(name, " cannot copy file \"", job.From, "\" to \"",
+                         job.To, "\": ", cmSystemTools::GetLastSystemError(),
+                         '.');
+  } else if (!always) {
+    struct timespec const times[2] = { from.st_atim, from.st_mtim };
+    if (futimens(out, times) != 0) {
+      job.Error =
+        cmStrCat(name, " cannot set modification time on \"", job.To,
+                 "\": ", cmSystemTools::GetLastSystemError(), '.');
+    }
+  }
+  if (out >= 0 && job.Error.empty() && fchmod(out, permissions) != 0) {
+    job.Error = cmStrCat(name, " cannot set permissions on \"", job.To,
+                         "\": ", cmSystemTools::GetLastSystemError(), '.');
+  }
+  if (out >= 0) {
+    close(out);
+  }
+  close(in);
+}
+#endif
+}
+
+struct cmFileCopier::Batch
+{
+  struct Entry
+  {
+    std::string ToFile;
+    Type FileType;
+    bool Copy;
+    // Index of the job that decides whether the file is copied, if any.
+    std::size_t JobIndex;
+  };
+  static std::size_t const NoJob = static_cast<std::size_t>(-1);
+
+  std::vector<InstallJob> Jobs;
+  std::vector<Entry> Entries;
+  std::set<std::string> Destinations;
+  // Final permissions of directories, which may deny writing to them.
+  std::vector<std::pair<std::string, mode_t>> DirPermissions;
+};
+
 cmFileCopier::cmFileCopier(cmExecutionStatus& status, const char* name)
   : Status(status)
   , Makefile(&status.GetMakefile())
@@ -383,6 +573,23 @@ bool cmFileCopier::Run(std::vector<std::string> const& args)
     return false;
   }
 
+#ifdef __linux__
+  // Queue regular files to copy them together after the traversal.
+  this->Queue = cm::make_unique<Batch>();
+#endif
+  bool result = this->InstallFiles();
+  if (this->Queue) {
+    // Install the files queued before any error, as if copied in order.
+    if (!this->FlushQueue()) {
+      result = false;
+    }
+    this->Queue.reset();
+  }
+  return result;
+}
+
+bool cmFileCopier::InstallFiles()
+{
   for (std::string const& f : this->Files) {
     std::string file;
     if (!f.empty() && !cmSystemTools::FileIsFullPath(f)) {
@@ -502,7 +709,9 @@ bool cmFileCopier::InstallSymlinkChain(std::string& fromFile,
       }
     }
 
-    this->ReportCopy(toFile, TypeLink, copy);
+    if (!this->Report(toFile, TypeLink, copy)) {
+      return false;
+    }
 
     if (copy) {
       cmSystemTools::RemoveFile(toFile);
@@ -554,7 +763,9 @@ bool cmFileCopier::InstallSymlink(const std::string& fromFile,
   }
 
   // Inform the user about this file installation.
-  this->ReportCopy(toFile, TypeLink, copy);
+  if (!this->Report(toFile, TypeLink, copy)) {
+    return false;
+  }
 
   if (copy) {
     // Remove the destination file so we can always create the symlink.
@@ -593,6 +804,13 @@ bool cmFileCopier::InstallFile(const std::string& fromFile,
                                const std::string& toFile,
                                MatchProperties match_properties)
 {
+  mode_t permissions =
+    (match_properties.Permissions ? match_properties.Permissions
+                                  : this->FilePermissions);
+  if (this->Queue) {
+    return this->QueueFile(fromFile, toFile, permissions);
+  }
+
   // Determine whether we will copy the file.
   bool copy = true;
   if (!this->Always) {
@@ -636,9 +854,6 @@ bool cmFileCopier::InstallFile(const std::string& fromFile,
   }
 
   // Set permissions of the destination file.
-  mode_t permissions =
-    (match_properties.Permissions ? match_properties.Permissions
-                                  : this->FilePermissions);
   if (!permissions) {
     // No permissions were explicitly provided but the user requested
     // that the source file permissions be used.
@@ -647,16 +862,107 @@ bool cmFileCopier::InstallFile(const std::string& fromFile,
   return this->SetPermissions(toFile, permissions);
 }
 
+bool cmFileCopier::Report(const std::string& toFile, Type type, bool copy)
+{
+  if (!this->Queue) {
+    this->ReportCopy(toFile, type, copy);
+    return true;
+  }
+  // Finish queued files at this destination before replacing them.
+  if (this->Queue->Destinations.count(toFile) && !this->FlushQueue()) {
+    return false;
+  }
+  this->Queue->Entries.push_back({ toFile, type, copy, Batch::NoJob });
+  return true;
+}
+
+bool cmFileCopier::QueueFile(const std::string& fromFile,
+                             const std::string& toFile, mode_t permissions)
+{
+  if (this->Queue->Destinations.count(toFile) && !this->FlushQueue()) {
+    return false;
+  }
+  InstallJob job;
+  job.From = fromFile;
+  job.To = toFile;
+  job.Permissions = permissions;
+  this->Queue->Entries.push_back(
+    { toFile, TypeFile, true, this->Queue->Jobs.size() });
+  this->Queue->Jobs.push_back(std::move(job));
+  this->Queue->Destinations.insert(toFile);
+  return true;
+}
+
+bool cmFileCopier::FlushQueue()
+{
+  Batch& batch = *this->Queue;
+
+#ifdef __linux__
+  // Copy files concurrently.  Small batches are not worth the threads.
+  // Stop starting jobs after one fails, but let the running ones finish.
+  // Pass one thread, not zero, for serial copies; cmParallelFor takes
+  // zero as one thread per processor.
+  std::size_t const numThreads = std::max<std::size_t>(
+    std::min<std::size_t>(
+      batch.Jobs.size() / 16,
+      cm::clamp<std::size_t>(std::thread::hardware_concurrency(), 1, 16)),
+    1);
+  cmParallelFor(batch.Jobs.size(), static_cast<unsigned int>(numThreads),
+                [this, &batch](std::size_t i) {
+                  InstallJob& job = batch.Jobs[i];
+                  RunJob(job, this->Name, this->Always);
+                  return job.Error.empty();
+                });
+#endif
+
+  // Report every file that was attempted in the order they were found,
+  // as if copied in order, so that the manifest lists every file written.
+  // Fail with the first error in that order.
+  bool result = true;
+  for (Batch::Entry const& entry : batch.Entries) {
+    if (entry.JobIndex == Batch::NoJob) {
+      this->ReportCopy(entry.ToFile, entry.FileType, entry.Copy);
+      continue;
+    }
+    InstallJob const& job = batch.Jobs[entry.JobIndex];
+    if (!job.Done) {
+      continue;
+    }
+    this->ReportCopy(entry.ToFile, entry.FileType, job.Copy);
+    if (!job.Error.empty() && result) {
+      this->Status.SetError(job.Error);
+      result = false;
+    }
+  }
+
+  if (result) {
+    for (auto const& dir : batch.DirPermissions) {
+      if (!this->SetPermissions(dir.first, dir.second)) {
+        result = false;
+        break;
+      }
+    }
+  }
+
+  batch.Jobs.clear();
+  batch.Entries.clear();
+  batch.Destinations.clear();
+  batch.DirPermissions.clear();
+  return result;
+}
+
 bool cmFileCopier::InstallDirectory(const std::string& source,
                                     const std::string& destination,
                                     MatchProperties match_properties)
 {
   // Inform the user about this directory installation.
-  this->ReportCopy(destination, TypeDir,
-                   !( // Report "Up-to-date:" for existing directories,
-                      // but not symlinks to them.
-                     cmSystemTools::FileIsDirectory(destination) &&
-                     !cmSystemTools::FileIsSymlink(destination)));
+  if (!this->Report(destination, TypeDir,
+                    !( // Report "Up-to-date:" for existing directories,
+                       // but not symlinks to them.
+                      cmSystemTools::FileIsDirectory(destination) &&
+                      !cmSystemTools::FileIsSymlink(destination)))) {
+    return false;
+  }
 
   // check if default dir creation permissions were set
   mode_t default_dir_mode_v = 0;
@@ -725,6 +1031,11 @@ bool cmFileCopier::InstallDirectory(const std::string& source,
     }
   }
 
-  // Set the requested permissions of the destination directory.
+  // Set the requested permissions of the destination directory.  Queued
+  // files must be installed first.
+  if (this->Queue && permissions_after) {
+    this->Queue->DirPermissions.emplace_back(destination, permissions_after);
+    return true;
+  }
   return this->SetPermissions(destination, permissions_after);
 }
@@ -4,6 +4,7 @@
 
 #include "cmConfigure.h" // IWYU pragma: keep
 
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -83,6 +84,8 @@ protected:
     TypeLink
   };
   virtual void ReportCopy(const std::string&, Type, bool) {}
+  // Report a copy now, or in order with the queued files if any.
+  bool Report(const std::string& toFile, Type type, bool copy);
   virtual bool ReportMissing(const std::string& fromFile);
 
   MatchRule* CurrentMatchRule = nullptr;
@@ -120,4 +123,14 @@ protected:
   virtual void DefaultDirectoryPermissions();
 
   bool GetDefaultDirectoryPermissions(mode_t** mode);
+
+private:
+  // Regular files queued to copy together, where supported.
+  struct Batch;
+  std::unique_ptr<Batch> Queue;
+
+  bool InstallFiles();
+  bool QueueFile(const std::string& fromFile, const std::string& toFile,
+                 mode_t permissions);
+  bool FlushQueue();
 };
@@ -40,6 +40,10 @@ cmFileInstaller::~cmFileInstaller()
   // Save the updated install manifest.
   this->Makefile->AddDefinition("CMAKE_INSTALL_MANIFEST_FILES",
                                 this->Manifest);
+  if (!this->ComponentManifestVar.empty()) {
+    this->Makefile->AddDefinition(this->ComponentManifestVar,
+                                  this->ComponentManifest);
+  }
 }
 
 void cmFileInstaller::ManifestAppend(std::string const& file)
@@ -67,6 +71,12 @@ void cmFileInstaller::ReportCopy(const std::string& toFile, Type type,
     // Add the file to the manifest.
     this->ManifestAppend(toFile);
   }
+  if (!this->ComponentManifestVar.empty()) {
+    if (!this->ComponentManifest.empty()) {
+      this->ComponentManifest += ";";
+    }
+    this->ComponentManifest += toFile;
+  }
 }
 bool cmFileInstaller::ReportMissing(const std::string& fromFile)
 {
@@ -139,7 +149,9 @@ bool cmFileInstaller::InstallFile(const std::string& fromFile,
   }
 
   // Inform the user about this file installation.
-  this->ReportCopy(toFile, TypeLink, copy);
+  if (!this->Report(toFile, TypeLink, copy)) {
+    return false;
+  }
 
   if (copy) {
     // Remove the destination file so we can always create the symlink.
@@ -228,6 +240,16 @@ bool cmFileInstaller::Parse(std::vector<std::string> const& args)
     return false;
   }
 
+  // Record the files of each component separately if requested.  Install
+  // scripts generated by older versions do not name the component.
+  if (!this->Component.empty() &&
+      this->Makefile->IsOn("CMAKE_INSTALL_RECORD_COMPONENTS")) {
+    this->ComponentManifestVar =
+      cmStrCat("CMAKE_INSTALL_COMPONENT_MANIFEST_", this->Component);
+    this->ComponentManifest =
+      this->Makefile->GetSafeDefinition(this->ComponentManifestVar);
+  }
+
   static const std::map<cm::string_view, cmInstallMode> install_mode_dict{
     { "ABS_SYMLINK"_s, cmInstallMode::ABS_SYMLINK },
     { "ABS_SYMLINK_OR_COPY"_s, cmInstallMode::ABS_SYMLINK_OR_COPY },
@@ -276,6 +298,12 @@ bool cmFileInstaller::CheckKeyword(std::string const& arg)
     } else {
       this->Doing = DoingRename;
     }
+  } else if (arg == "COMPONENT") {
+    if (this->CurrentMatchRule) {
+      this->NotAfterMatch(arg);
+    } else {
+      this->Doing = DoingComponent;
+    }
   } else if (arg == "OPTIONAL") {
     if (this->CurrentMatchRule) {
       this->NotAfterMatch(arg);
@@ -345,6 +373,9 @@ bool cmFileInstaller::CheckValue(std::string const& arg)
     case DoingRename:
       this->Rename = arg;
       break;
+    case DoingComponent:
+      this->Component = arg;
+      break;
     default:
       return this->cmFileCopier::CheckValue(arg);
   }
@@ -27,10 +27,15 @@ protected:
   bool MessageNever = false;
   int DestDirLength = 0;
   std::string Rename;
+  std::string Component;
 
   std::string Manifest;
   void ManifestAppend(std::string const& file);
 
+  // Files of the current component, when recorded for CPack.
+  std::string ComponentManifestVar;
+  std::string ComponentManifest;
+
   std::string const& ToName(std::string const& fromName) override;
 
   void ReportCopy(const std::string& toFile, Type type, bool copy) override;
@@ -44,6 +49,7 @@ protected:
   {
     DoingType = DoingLast1,
     DoingRename,
+    DoingComponent,
     DoingLast2
   };
   bool CheckKeyword(std::string const& arg) override;
@@ -3,7 +3,12 @@
 #include "cmGeneratedFileStream.h"
 
 #include <cstdio>
+#include <cstring>
+#include <ios>
 #include <locale>
+#include <streambuf>
+
+#include <cm/memory>
 
 #include "cmStringAlgorithms.h"
 #include "cmSystemTools.h"
@@ -14,11 +19,81 @@
 #  include "cm_codecvt.hxx"
 #endif
 
+// Stream buffer holding the generated content in memory.  Content that
+// grows beyond the limit is moved to the temporary file instead, and
+// written there from then on.
+class cmGeneratedFileStreamBase::MemoryBuffer : public std::streambuf
+{
+public:
+  MemoryBuffer(std::streambuf* file)
+    : File(file)
+  {
+  }
+
+  std::string Data;
+
+  // Whether the content was moved to the temporary file.
+  bool Spilled = false;
+
+protected:
+  int_type overflow(int_type c) override
+  {
+    if (traits_type::eq_int_type(c, traits_type::eof())) {
+      return traits_type::not_eof(c);
+    }
+    char const ch = traits_type::to_char_type(c);
+    return this->xsputn(&ch, 1) == 1 ? c : traits_type::eof();
+  }
+
+  std::streamsize xsputn(const char* s, std::streamsize n) override
+  {
+    if (!this->Spilled &&
+        this->Data.size() + static_cast<std::string::size_type>(n) >
+          Limit) {
+      auto const size = static_cast<std::streamsize>(this->Data.size());
+      if (this->File->sputn(this->Data.data(), size) != size) {
+        return 0;
+      }
+      this->Data = std::string();
+      this->Spilled = true;
+    }
+    if (this->Spilled) {
+      return this->File->sputn(s, n);
+    }
+    this->Data.append(s, static_cast<std::string::size_type>(n));
+    return n;
+  }
+
+  int sync() override { return this->Spilled ? this->File->pubsync() : 0; }
+
+  pos_type seekoff(off_type off, std::ios_base::seekdir dir,
+                   std::ios_base::openmode which) override
+  {
+    if (this->Spilled) {
+      return this->File->pubseekoff(off, dir, which);
+    }
+    // Only support querying the current position, as used by tellp.
+    if (off == 0 && dir == std::ios_base::cur &&
+        (which & std::ios_base::out)) {
+      return pos_type(static_cast<off_type>(this->Data.size()));
+    }
+    return pos_type(off_type(-1));
+  }
+
+private:
+  // Generated files are usually much smaller.  Larger ones are
+  // compared with the destination from the temporary file.
+  static std::string::size_type const Limit = 16 * 1024 * 1024;
+
+  std::streambuf* File;
+};
+
 cmGeneratedFileStream::cmGeneratedFileStream(Encoding encoding)
 {
 #ifndef CMAKE_BOOTSTRAP
   if (encoding != codecvt_Encoding::None) {
     this->imbue(std::locale(this->getloc(), new codecvt(encoding)));
+    this->Encoded = true;
   }
 #else
   static_cast<void>(encoding);
@@ -38,6 +113,7 @@ cmGeneratedFileStream::cmGeneratedFileStream(std::string const& name,
 #ifndef CMAKE_BOOTSTRAP
   if (encoding != codecvt_Encoding::None) {
     this->imbue(std::locale(this->getloc(), new codecvt(encoding)));
+    this->Encoded = true;
   }
 #else
   static_cast<void>(encoding);
@@ -65,6 +141,7 @@ cmGeneratedFileStream& cmGeneratedFileStream::Open(std::string const& name,
 {
   // Store the file name and construct the temporary file name.
   this->cmGeneratedFileStreamBase::Open(name);
+  this->Binary = binaryFlag;
 
   // Open the temporary output file.
   if (binaryFlag) {
@@ -80,6 +157,10 @@ cmGeneratedFileStream& cmGeneratedFileStream::Open(std::string const& name,
     cmSystemTools::Error("Cannot open file for write: " + this->TempName);
     cmSystemTools::ReportLastSystemError("");
   }
+
+  if (this->CopyIfDifferent) {
+    this->StartMemoryBuffer();
+  }
   return *this;
 }
 
@@ -88,6 +169,11 @@ bool cmGeneratedFileStream::Close()
   // Save whether the temporary output file is valid before closing.
   this->Okay = !this->fail();
 
+  if (this->Buffer) {
+    // Detach the in-memory content.  It is written out by the base.
+    this->std::ios::rdbuf(this->Stream::rdbuf());
+  }
+
   // Close the temporary output file.
   this->Stream::close(); // NOLINT(cmake-use-cmsys-fstream)
 
@@ -98,6 +184,24 @@ bool cmGeneratedFileStream::Close()
 void cmGeneratedFileStream::SetCopyIfDifferent(bool copy_if_different)
 {
   this->CopyIfDifferent = copy_if_different;
+  if (copy_if_different) {
+    this->StartMemoryBuffer();
+  }
+}
+
+void cmGeneratedFileStream::StartMemoryBuffer()
+{
+  // Content that was already written, or that needs an encoding
+  // conversion, stays in the temporary file.
+  if (this->Buffer || this->Encoded || !this->is_open() || this->fail() ||
+      this->tellp() != 0) {
+    return;
+  }
+
+  // The temporary file stays open, so the stream behaves as an open
+  // file stream, and receives the content if it grows too large.
+  this->Buffer = cm::make_unique<MemoryBuffer>(this->Stream::rdbuf());
+  this->std::ios::rdbuf(this->Buffer.get());
 }
 
 void cmGeneratedFileStream::SetCompression(bool compression)
@@ -161,9 +265,19 @@ bool cmGeneratedFileStreamBase::Close()
 
   // Only consider replacing the destination file if no error
   // occurred.
-  if (!this->Name.empty() && this->Okay &&
-      (!this->CopyIfDifferent ||
-       cmSystemTools::FilesDiffer(this->TempName, resname))) {
+  bool replace = !this->Name.empty() && this->Okay;
+  if (replace && this->Buffer && !this->Buffer->Spilled) {
+    // The content is in memory.  Compare it directly with the
+    // destination and write the temporary file only if it differs.
+    replace = (!this->CopyIfDifferent || this->BufferDiffers(resname)) &&
+      this->WriteBufferToTempFile();
+  } else if (replace) {
+    replace = !this->CopyIfDifferent ||
+      cmSystemTools::FilesDiffer(this->TempName, resname);
+  }
+  this->Buffer.reset();
+
+  if (replace) {
     // The destination is to be replaced.  Rename the temporary to the
     // destination atomically.
     if (this->Compress) {
@@ -189,6 +303,62 @@ bool cmGeneratedFileStreamBase::Close()
   return replaced;
 }
 
+bool cmGeneratedFileStreamBase::BufferDiffers(std::string const& name) const
+{
+  std::string const& data = this->Buffer->Data;
+
+#ifdef _WIN32
+  // Text mode translates line endings so the sizes do not match.
+  bool const sameSize = this->Binary;
+#else
+  bool const sameSize = true;
+#endif
+  if (sameSize &&
+      cmSystemTools::FileLength(name) !=
+        static_cast<unsigned long>(data.size())) {
+    return true;
+  }
+
+  cmsys::ifstream fin(name.c_str(),
+                      this->Binary ? (std::ios::in | std::ios::binary)
+                                   : std::ios::in);
+  if (!fin) {
+    return true;
+  }
+
+  char buffer[16384];
+  std::string::size_type pos = 0;
+  while (fin) {
+    fin.read(buffer, sizeof(buffer));
+    auto const count = static_cast<std::string::size_type>(fin.gcount());
+    if (count == 0) {
+      break;
+    }
+    if (count > data.size() - pos ||
+        std::memcmp(buffer, data.data() + pos, count) != 0) {
+      return true;
+    }
+    pos += count;
+  }
+  return pos != data.size();
+}
+
+bool cmGeneratedFileStreamBase::WriteBufferToTempFile()
+{
+  cmsys::ofstream fout(this->TempName.c_str(),
+                       this->Binary ? (std::ios::out | std::ios::binary)
+                                    : std::ios::out);
+  if (!fout) {
+    cmSystemTools::Error("Cannot open file for write: " + this->TempName);
+    cmSystemTools::ReportLastSystemError("");
+    return false;
+  }
+  std::string const& data = this->Buffer->Data;
+  fout.write(data.data(), static_cast<std::streamsize>(data.size()));
+  fout.close();
+  return !fout.fail();
+}
+
 #ifndef CMAKE_BOOTSTRAP
 int cmGeneratedFileStreamBase::CompressFile(std::string const& oldname,
                                             std::string const& newname)
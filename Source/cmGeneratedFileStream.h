@@ -4,6 +4,7 @@
 
 #include "cmConfigure.h" // IWYU pragma: keep
 
+#include <memory>
 #include <string>
 
 #include "cmsys/FStream.hxx"
@@ -39,6 +40,11 @@ protected:
   // Internal file compression implementation.
   int CompressFile(std::string const& oldname, std::string const& newname);
 
+  // Internal methods to handle content kept in memory.  They compare
+  // the content with the given file and write it to the temporary file.
+  bool BufferDiffers(std::string const& name) const;
+  bool WriteBufferToTempFile();
+
   // The name of the final destination file for the output.
   std::string Name;
 
@@ -59,6 +65,18 @@ protected:
 
   // Whether the destination file is compressed
   bool CompressExtraExtension = true;
+
+  // Whether the temporary file is opened in binary mode.
+  bool Binary = false;
+
+  // Whether the real stream converts its content to another encoding.
+  bool Encoded = false;
+
+  // The content of a copy-if-different stream.  It is kept in memory so
+  // that the temporary file is only written if the destination changed,
+  // unless it grows too large.
+  class MemoryBuffer;
+  std::unique_ptr<MemoryBuffer> Buffer;
 };
 
 /** \class cmGeneratedFileStream
@@ -121,7 +139,11 @@ public:
   bool Close();
 
   /**
-   * Set whether copy-if-different is done.
+   * Set whether copy-if-different is done.  If nothing was written yet,
+   * the content is then kept in memory and compared with the destination
+   * when the stream is closed.  The temporary file is only written if
+   * the destination needs to be replaced, or if the content grows too
+   * large to be kept in memory.
    */
   void SetCopyIfDifferent(bool copy_if_different);
 
@@ -135,6 +157,11 @@ public:
    */
   void SetCompressionExtraExtension(bool ext);
 
+  /**
+   * Get the name of the file that will hold the actual output.
+   */
+  std::string const& GetName() const { return this->Name; }
+
   /**
    * Set name of the file that will hold the actual output. This method allows
    * the output file to be changed during the use of cmGeneratedFileStream.
@@ -150,6 +177,11 @@ public:
   /**
    * Write a specific string using an alternate encoding.
    * Afterward, the original encoding is restored.
+   * This must not be used with a copy-if-different stream.
    */
   void WriteAltEncoding(std::string const& data, codecvt_Encoding encoding);
+
+private:
+  // Switch to keeping the content in memory, if possible.
+  void StartMemoryBuffer();
 };
@@ -1832,9 +1832,44 @@ void cmGlobalGenerator::WriteInstallJson() const
   if (this->GetCMakeInstance()->GetState()->GetGlobalPropertyAsBool(
         "INSTALL_PARALLEL")) {
     Json::Value index(Json::objectValue);
-    index["InstallScripts"] = Json::arrayValue;
-    for (const auto& file : this->InstallScripts) {
-      index["InstallScripts"].append(file);
+    Json::Value& scripts = index["InstallScripts"] = Json::arrayValue;
+    for (InstallScript const& script : this->InstallScripts) {
+      scripts.append(script.File);
+    }
+    // With INSTALL_PARALLEL_STEPS, list the steps of each script.
+    // Otherwise each script is installed as a whole.
+    if (this->GetCMakeInstance()->GetState()->GetGlobalPropertyAsBool(
+          "INSTALL_PARALLEL_STEPS")) {
+      Json::Value& steps = index["InstallSteps"] = Json::arrayValue;
+      for (InstallScript const& script : this->InstallScripts) {
+        // An ordered step depends on the steps since the previous ordered
+        // step, or on that step itself.  Other steps depend only on the
+        // previous ordered step.
+        cm::optional<Json::ArrayIndex> barrier;
+        std::vector<Json::ArrayIndex> since;
+        for (std::size_t i = 0; i < script.OrderedSteps.size(); ++i) {
+          Json::Value& step = steps.append(Json::objectValue);
+          step["Script"] = script.File;
+          step["Step"] = static_cast<Json::UInt64>(i);
+          Json::Value& depends = step["Depends"] = Json::arrayValue;
+          Json::ArrayIndex const self = steps.size() - 1;
+          if (script.OrderedSteps[i]) {
+            for (Json::ArrayIndex dep : since) {
+              depends.append(dep);
+            }
+            if (since.empty() && barrier) {
+              depends.append(*barrier);
+            }
+            barrier = self;
+            since.clear();
+          } else {
+            if (barrier) {
+              depends.append(*barrier);
+            }
+            since.push_back(self);
+          }
+        }
+      }
     }
     this->WriteJsonContent(
       cmStrCat(this->CMakeInstance->GetHomeOutputDirectory(),
@@ -4032,7 +4067,8 @@ cmGlobalGenerator::StripCommandStyle cmGlobalGenerator::GetStripCommandStyle(
 #endif
 }
 
-void cmGlobalGenerator::AddInstallScript(std::string const& file)
+void cmGlobalGenerator::AddInstallScript(std::string const& file,
+                                         std::vector<bool> orderedSteps)
 {
-  this->InstallScripts.push_back(file);
+  this->InstallScripts.push_back({ file, std::move(orderedSteps) });
 }
@@ -675,7 +675,11 @@ public:
 
   bool CheckCMP0171() const;
 
-  void AddInstallScript(std::string const& file);
+  /** Record the install script of a directory.  Each entry of
+      orderedSteps tells whether the corresponding step of the script
+      is ordered with its neighbours, see cmInstallGenerator::StepOrder.  */
+  void AddInstallScript(std::string const& file,
+                        std::vector<bool> orderedSteps);
 
 protected:
   // for a project collect all its targets by following depend
@@ -916,7 +920,12 @@ private:
   std::map<std::string, cmInstallRuntimeDependencySet*>
     RuntimeDependencySetsByName;
 
-  std::vector<std::string> InstallScripts;
+  struct InstallScript
+  {
+    std::string File;
+    std::vector<bool> OrderedSteps;
+  };
+  std::vector<InstallScript> InstallScripts;
 
 #if !defined(CMAKE_BOOTSTRAP)
   // Pool of file locks
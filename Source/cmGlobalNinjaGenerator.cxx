@@ -60,6 +60,8 @@
 const char* cmGlobalNinjaGenerator::NINJA_BUILD_FILE = "build.ninja";
 const char* cmGlobalNinjaGenerator::NINJA_RULES_FILE =
   "CMakeFiles/rules.ninja";
+const char* cmGlobalNinjaGenerator::NINJA_DIRECTORY_FILE =
+  "CMakeFiles/directory.ninja";
 const char* cmGlobalNinjaGenerator::INDENT = "  ";
 #ifdef _WIN32
 std::string const cmGlobalNinjaGenerator::SHELL_NOOP = "cd .";
@@ -141,6 +143,14 @@ void cmGlobalNinjaGenerator::WriteDivider(std::ostream& os)
 
 void cmGlobalNinjaGenerator::WriteComment(std::ostream& os,
                                           const std::string& comment)
+{
+  std::string buf;
+  cmGlobalNinjaGenerator::AppendComment(buf, comment);
+  os.write(buf.data(), static_cast<std::streamsize>(buf.size()));
+}
+
+void cmGlobalNinjaGenerator::AppendComment(std::string& buf,
+                                           const std::string& comment)
 {
   if (comment.empty()) {
     return;
@@ -148,12 +158,16 @@ void cmGlobalNinjaGenerator::WriteComment(std::ostream& os,
 
   std::string::size_type lpos = 0;
   std::string::size_type rpos;
-  os << "\n#############################################\n";
+  buf += "\n#############################################\n";
   while ((rpos = comment.find('\n', lpos)) != std::string::npos) {
-    os << "# " << comment.substr(lpos, rpos - lpos) << "\n";
+    buf += "# ";
+    buf.append(comment, lpos, rpos - lpos);
+    buf += '\n';
     lpos = rpos + 1;
   }
-  os << "# " << comment.substr(lpos) << "\n\n";
+  buf += "# ";
+  buf.append(comment, lpos, std::string::npos);
+  buf += "\n\n";
 }
 
 std::unique_ptr<cmLinkLineComputer>
@@ -203,17 +217,86 @@ std::string& cmGlobalNinjaGenerator::EncodeLiteral(std::string& lit)
 
 std::string cmGlobalNinjaGenerator::EncodePath(const std::string& path)
 {
-  std::string result = path;
+  std::string result;
+  this->AppendEncodedPath(result, path);
+  return result;
+}
+
+void cmGlobalNinjaGenerator::AppendEncodedPath(std::string& buf,
+                                               const std::string& path)
+{
+  // This is equivalent to EncodeLiteral followed by escaping of spaces
+  // and colons, but done in a single pass directly into the buffer.
+  cm::string_view const cfgIntDir =
+    this->IsMultiConfig() ? this->GetCMakeCFGIntDir() : cm::string_view();
 #ifdef _WIN32
-  if (this->IsGCCOnWindows())
-    std::replace(result.begin(), result.end(), '\\', '/');
-  else
-    std::replace(result.begin(), result.end(), '/', '\\');
+  char const* const specials = "$\n :/\\";
+  char const slash = this->IsGCCOnWindows() ? '/' : '\\';
+#else
+  char const* const specials = "$\n :";
 #endif
-  this->EncodeLiteral(result);
-  cmSystemTools::ReplaceString(result, " ", "$ ");
-  cmSystemTools::ReplaceString(result, ":", "$:");
-  return result;
+
+  buf.reserve(buf.size() + path.size());
+  std::string::size_type pos = 0;
+  while (pos < path.size()) {
+    std::string::size_type const next = path.find_first_of(specials, pos);
+    if (next == std::string::npos) {
+      buf.append(path, pos, std::string::npos);
+      break;
+    }
+    buf.append(path, pos, next - pos);
+    pos = next + 1;
+    switch (path[next]) {
+      case '$':
+        // The multi-config intermediate directory placeholder is left
+        // for Ninja to expand.
+        if (!cfgIntDir.empty() &&
+            cm::string_view(path).substr(next, cfgIntDir.size()) ==
+              cfgIntDir) {
+          buf.append(cfgIntDir.data(), cfgIntDir.size());
+          pos = next + cfgIntDir.size();
+        } else {
+          buf += "$$";
+        }
+        break;
+      case '\n':
+        buf += "$\n";
+        break;
+      case ' ':
+        buf += "$ ";
+        break;
+      case ':':
+        buf += "$:";
+        break;
+#ifdef _WIN32
+      default:
+        buf += slash;
+        break;
+#endif
+    }
+  }
+}
+
+namespace {
+cm::string_view NinjaVariableValue(const std::string& name,
+                                   const std::string& value)
+{
+  static std::unordered_set<std::string> const variablesShouldNotBeTrimmed = {
+    "CODE_CHECK", "LAUNCHER"
+  };
+  cm::string_view val = value;
+  if (variablesShouldNotBeTrimmed.find(name) !=
+      variablesShouldNotBeTrimmed.end()) {
+    return val;
+  }
+  while (!val.empty() && cmIsSpace(val.front())) {
+    val.remove_prefix(1);
+  }
+  while (!val.empty() && cmIsSpace(val.back())) {
+    val.remove_suffix(1);
+  }
+  return val;
+}
 }
 
 void cmGlobalNinjaGenerator::WriteBuild(std::ostream& os,
@@ -235,14 +318,45 @@ void cmGlobalNinjaGenerator::WriteBuild(std::ostream& os,
     return;
   }
 
-  cmGlobalNinjaGenerator::WriteComment(os, build.Comment);
+  // The whole statement is assembled in a buffer that is reused across
+  // calls and then handed to the stream with a single write.
+  std::string& buf = this->BuildStatementBuffer;
+  buf.clear();
+
+  // Compile flag sets are usually identical for many build statements.
+  // Define each one once per file and reference it from the statements.
+  std::map<std::string, std::string>& interned = this->InternedReferences;
+  interned.clear();
+  std::string::size_type internedSize = 0;
+  auto const* file = dynamic_cast<cmGeneratedFileStream const*>(&os);
+  for (auto const& variable : build.Variables) {
+    if (file &&
+        (variable.first == "FLAGS" || variable.first == "DEFINES" ||
+         variable.first == "INCLUDES")) {
+      cm::string_view const val =
+        NinjaVariableValue(variable.first, variable.second);
+      if (!val.empty()) {
+        interned.emplace(variable.first,
+                         this->InternVariable(buf, file->GetName(),
+                                              variable.first, val));
+        internedSize += val.size();
+      }
+    }
+  }
+  if (!buf.empty()) {
+    buf += '\n';
+  }
+
+  cmGlobalNinjaGenerator::AppendComment(buf, build.Comment);
+  std::string::size_type const statementStart = buf.size();
 
   // Write output files.
-  std::string buildStr("build");
+  buf += "build";
   {
     // Write explicit outputs
     for (std::string const& output : build.Outputs) {
-      buildStr = cmStrCat(buildStr, ' ', this->EncodePath(output));
+      buf += ' ';
+      this->AppendEncodedPath(buf, output);
       if (this->ComputingUnknownDependencies) {
         this->CombinedBuildOutputs.insert(output);
       }
@@ -251,9 +365,10 @@ void cmGlobalNinjaGenerator::WriteBuild(std::ostream& os,
     if (!build.ImplicitOuts.empty()) {
       // Assume Ninja is new enough to support implicit outputs.
       // Callers should not populate this field otherwise.
-      buildStr = cmStrCat(buildStr, " |");
+      buf += " |";
       for (std::string const& implicitOut : build.ImplicitOuts) {
-        buildStr = cmStrCat(buildStr, ' ', this->EncodePath(implicitOut));
+        buf += ' ';
+        this->AppendEncodedPath(buf, implicitOut);
         if (this->ComputingUnknownDependencies) {
           this->CombinedBuildOutputs.insert(implicitOut);
         }
@@ -267,66 +382,66 @@ void cmGlobalNinjaGenerator::WriteBuild(std::ostream& os,
     if (!build.WorkDirOuts.empty()) {
       if (this->SupportsImplicitOuts() && build.ImplicitOuts.empty()) {
         // Make them implicit outputs if supported by this version of Ninja.
-        buildStr = cmStrCat(buildStr, " |");
+        buf += " |";
       }
       for (std::string const& workdirOut : build.WorkDirOuts) {
-        buildStr = cmStrCat(buildStr, " ${cmake_ninja_workdir}",
-                            this->EncodePath(workdirOut));
+        buf += " ${cmake_ninja_workdir}";
+        this->AppendEncodedPath(buf, workdirOut);
       }
     }
 
     // Write the rule.
-    buildStr = cmStrCat(buildStr, ": ", build.Rule);
+    buf += ": ";
+    buf += build.Rule;
   }
 
-  std::string arguments;
   {
     // TODO: Better formatting for when there are multiple input/output files.
 
     // Write explicit dependencies.
     for (std::string const& explicitDep : build.ExplicitDeps) {
-      arguments += cmStrCat(' ', this->EncodePath(explicitDep));
+      buf += ' ';
+      this->AppendEncodedPath(buf, explicitDep);
     }
 
     // Write implicit dependencies.
     if (!build.ImplicitDeps.empty()) {
-      arguments += " |";
+      buf += " |";
       for (std::string const& implicitDep : build.ImplicitDeps) {
-        arguments += cmStrCat(' ', this->EncodePath(implicitDep));
+        buf += ' ';
+        this->AppendEncodedPath(buf, implicitDep);
       }
     }
 
     // Write order-only dependencies.
     if (!build.OrderOnlyDeps.empty()) {
-      arguments += " ||";
+      buf += " ||";
       for (std::string const& orderOnlyDep : build.OrderOnlyDeps) {
-        arguments += cmStrCat(' ', this->EncodePath(orderOnlyDep));
+        buf += ' ';
+        this->AppendEncodedPath(buf, orderOnlyDep);
       }
     }
 
-    arguments += '\n';
+    buf += '\n';
   }
 
   // Write the variables bound to this build statement.
-  std::string assignments;
   {
-    std::ostringstream variable_assignments;
     for (auto const& variable : build.Variables) {
-      cmGlobalNinjaGenerator::WriteVariable(
-        variable_assignments, variable.first, variable.second, "", 1);
+      auto const i = interned.find(variable.first);
+      cmGlobalNinjaGenerator::AppendVariable(
+        buf, variable.first,
+        i != interned.end() ? i->second : variable.second, 1);
     }
 
     // check if a response file rule should be used
-    assignments = variable_assignments.str();
     bool useResponseFile = false;
     if (cmdLineLimit < 0 ||
         (cmdLineLimit > 0 &&
-         (arguments.size() + buildStr.size() + assignments.size() + 1000) >
+         (buf.size() - statementStart + internedSize + 1000) >
            static_cast<size_t>(cmdLineLimit))) {
-      variable_assignments.str(std::string());
-      cmGlobalNinjaGenerator::WriteVariable(variable_assignments, "RSP_FILE",
-                                            build.RspFile, "", 1);
-      assignments += variable_assignments.str();
+      cmGlobalNinjaGenerator::AppendVariable(buf, "RSP_FILE", build.RspFile,
+                                             1);
       useResponseFile = true;
     }
     if (usedResponseFile) {
@@ -334,7 +449,30 @@ void cmGlobalNinjaGenerator::WriteBuild(std::ostream& os,
     }
   }
 
-  os << buildStr << arguments << assignments << "\n";
+  buf += '\n';
+  os.write(buf.data(), static_cast<std::streamsize>(buf.size()));
+}
+
+std::string cmGlobalNinjaGenerator::InternVariable(std::string& buf,
+                                                   std::string const& file,
+                                                   std::string const& name,
+                                                   cm::string_view value)
+{
+  std::unordered_map<std::string, std::string>& variables =
+    this->InternedVariables[file];
+  std::string key = cmStrCat(name, '=', value);
+  auto i = variables.find(key);
+  if (i == variables.end()) {
+    // Number the variables of each file on their own so that a change in
+    // one directory does not rename the variables of the others.
+    std::string internedName = cmStrCat(name, '_', variables.size() + 1);
+    buf += internedName;
+    buf += " = ";
+    buf.append(value.data(), value.size());
+    buf += '\n';
+    i = variables.emplace(std::move(key), std::move(internedName)).first;
+  }
+  return cmStrCat('$', i->second);
 }
 
 void cmGlobalNinjaGenerator::AddCustomCommandRule()
@@ -525,18 +663,8 @@ void cmGlobalNinjaGenerator::WriteVariable(std::ostream& os,
     return;
   }
 
-  std::string val;
-  static std::unordered_set<std::string> const variablesShouldNotBeTrimmed = {
-    "CODE_CHECK", "LAUNCHER"
-  };
-  if (variablesShouldNotBeTrimmed.find(name) ==
-      variablesShouldNotBeTrimmed.end()) {
-    val = cmTrimWhitespace(value);
-  } else {
-    val = value;
-  }
-
   // Do not add a variable if the value is empty.
+  cm::string_view const val = NinjaVariableValue(name, value);
   if (val.empty()) {
     return;
   }
@@ -546,6 +674,26 @@ void cmGlobalNinjaGenerator::WriteVariable(std::ostream& os,
   os << name << " = " << val << "\n";
 }
 
+void cmGlobalNinjaGenerator::AppendVariable(std::string& buf,
+                                            const std::string& name,
+                                            const std::string& value,
+                                            int indent)
+{
+  // Do not add a variable if the value is empty.
+  cm::string_view const val = NinjaVariableValue(name, value);
+  if (val.empty()) {
+    return;
+  }
+
+  for (int i = 0; i < indent; ++i) {
+    buf += cmGlobalNinjaGenerator::INDENT;
+  }
+  buf += name;
+  buf += " = ";
+  buf.append(val.data(), val.size());
+  buf += '\n';
+}
+
 void cmGlobalNinjaGenerator::WriteInclude(std::ostream& os,
                                           const std::string& filename,
                                           const std::string& comment)
@@ -554,6 +702,14 @@ void cmGlobalNinjaGenerator::WriteInclude(std::ostream& os,
   os << "include " << filename << "\n";
 }
 
+void cmGlobalNinjaGenerator::WriteSubninja(std::ostream& os,
+                                           const std::string& filename,
+                                           const std::string& comment)
+{
+  cmGlobalNinjaGenerator::WriteComment(os, comment);
+  os << "subninja " << filename << "\n";
+}
+
 void cmGlobalNinjaGenerator::WriteDefault(std::ostream& os,
                                           const cmNinjaDeps& targets,
                                           const std::string& comment)
@@ -624,6 +780,9 @@ void cmGlobalNinjaGenerator::Generate()
     return;
   }
   this->InitOutputPathPrefix();
+  this->DirectoryFiles = !this->IsMultiConfig() &&
+    this->LocalGenerators[0]->GetMakefile()->IsOn(
+      "CMAKE_NINJA_SUBNINJA_PER_DIRECTORY");
   if (!this->OpenBuildFileStreams()) {
     return;
   }
@@ -634,6 +793,7 @@ void cmGlobalNinjaGenerator::Generate()
   for (auto& it : this->Configs) {
     it.second.TargetDependsClosures.clear();
   }
+  this->InternedVariables.clear();
 
   this->TargetAll = this->NinjaOutputPath("all");
   this->CMakeCacheFile = this->NinjaOutputPath("CMakeCache.txt");
@@ -1140,6 +1300,53 @@ void cmGlobalNinjaGenerator::CloseBuildFileStreams()
   }
 }
 
+void cmGlobalNinjaGenerator::OpenDirectoryFileStream(
+  cmLocalGenerator const* lg)
+{
+  std::string const path =
+    cmStrCat(lg->GetCurrentBinaryDirectory(), '/', NINJA_DIRECTORY_FILE);
+  auto stream = cm::make_unique<cmGeneratedFileStream>(
+    path, false, this->GetMakefileEncoding());
+  if (!*stream) {
+    // An error message is generated by the constructor if it cannot
+    // open the file.  Keep writing to the main build file.
+    return;
+  }
+
+  // Most directories do not change between two generations.  Do not
+  // re-write their file in that case.
+  stream->SetCopyIfDifferent(true);
+  this->WriteDisclaimer(*stream);
+  *stream << "# This file contains the build statements of directory\n"
+          << "# " << lg->GetCurrentSourceDirectory() << "\n"
+          << "# It is included in the main '" << NINJA_BUILD_FILE << "'.\n\n";
+
+  cmGlobalNinjaGenerator::WriteSubninja(
+    *this->BuildFileStream, this->EncodePath(this->ConvertToNinjaPath(path)));
+  this->DirectoryFileStream = std::move(stream);
+}
+
+void cmGlobalNinjaGenerator::CloseDirectoryFileStream()
+{
+  if (!this->DirectoryFileStream) {
+    return;
+  }
+  // Do not replace a previous version of the file after an error.
+  if (cmSystemTools::GetErrorOccurredFlag()) {
+    this->DirectoryFileStream->setstate(std::ios::failbit);
+  }
+  std::string const name = this->DirectoryFileStream->GetName();
+  this->InternedVariables.erase(name);
+  // The file is an output of the rule that re-runs CMake.  Update its
+  // timestamp even if its content did not change so that Ninja does
+  // not consider it out of date.
+  if (!this->DirectoryFileStream->Close() &&
+      !cmSystemTools::GetErrorOccurredFlag()) {
+    cmSystemTools::Touch(name, false);
+  }
+  this->DirectoryFileStream.reset();
+}
+
 bool cmGlobalNinjaGenerator::OpenRulesFileStream()
 {
   if (!this->OpenFileStream(this->RulesFileStream,
@@ -1945,6 +2152,18 @@ void cmGlobalNinjaGenerator::WriteTargetDefault(std::ostream& os)
   }
 }
 
+void cmGlobalNinjaGenerator::AddRebuildManifestOutputs(
+  cmNinjaDeps& outputs) const
+{
+  outputs.push_back(this->NinjaOutputPath(NINJA_BUILD_FILE));
+  if (this->DirectoryFiles) {
+    for (auto const& lg : this->LocalGenerators) {
+      outputs.push_back(this->ConvertToNinjaPath(cmStrCat(
+        lg->GetCurrentBinaryDirectory(), '/', NINJA_DIRECTORY_FILE)));
+    }
+  }
+}
+
 void cmGlobalNinjaGenerator::WriteTargetRebuildManifest(std::ostream& os)
 {
   if (this->GlobalSettingIsOn("CMAKE_SUPPRESS_REGENERATION")) {
@@ -15,6 +15,7 @@
 #include <vector>
 
 #include <cm/optional>
+#include <cm/string_view>
 
 #include "cm_codecvt_Encoding.hxx"
 
@@ -64,6 +65,11 @@ public:
   /// It is included in the main build.ninja file.
   static const char* NINJA_RULES_FILE;
 
+  /// The name of the per-directory Ninja build file, relative to each
+  /// binary directory.  Typically: CMakeFiles/directory.ninja.
+  /// It is included in the main build.ninja file with 'subninja'.
+  static const char* NINJA_DIRECTORY_FILE;
+
   /// The indentation string used when generating Ninja's build file.
   static const char* INDENT;
 
@@ -81,6 +87,12 @@ public:
   std::string GetEncodedLiteral(const std::string& lit);
   std::string EncodePath(const std::string& path);
 
+  /**
+   * Append the escaped form of @a path to @a buf.  This produces the same
+   * result as EncodePath() without creating an intermediate string.
+   */
+  void AppendEncodedPath(std::string& buf, const std::string& path);
+
   std::unique_ptr<cmLinkLineComputer> CreateLinkLineComputer(
     cmOutputConverter* outputConverter,
     cmStateDirectory const& stateDir) const override;
@@ -90,6 +102,7 @@ public:
    * handles new line character properly.
    */
   static void WriteComment(std::ostream& os, const std::string& comment);
+  static void AppendComment(std::string& buf, const std::string& comment);
 
   /**
    * Utilized by the generator factory to determine if this generator
@@ -154,6 +167,13 @@ public:
                             const std::string& value,
                             const std::string& comment = "", int indent = 0);
 
+  /**
+   * Append a variable named @a name with value @a value to @a buf, in the
+   * same format as WriteVariable() but without a comment.
+   */
+  static void AppendVariable(std::string& buf, const std::string& name,
+                             const std::string& value, int indent = 0);
+
   /**
    * Write an include statement including @a filename with an optional
    * @a comment to the @a os stream.
@@ -161,6 +181,13 @@ public:
   static void WriteInclude(std::ostream& os, const std::string& filename,
                            const std::string& comment = "");
 
+  /**
+   * Write a subninja statement including @a filename with an optional
+   * @a comment to the @a os stream.
+   */
+  static void WriteSubninja(std::ostream& os, const std::string& filename,
+                            const std::string& comment = "");
+
   /**
    * Write a default target statement specifying @a targets as
    * the default targets.
@@ -245,23 +272,23 @@ public:
   virtual cmGeneratedFileStream* GetImplFileStream(
     const std::string& /*config*/) const
   {
-    return this->BuildFileStream.get();
+    return this->GetBuildFileStream();
   }
 
   virtual cmGeneratedFileStream* GetConfigFileStream(
     const std::string& /*config*/) const
   {
-    return this->BuildFileStream.get();
+    return this->GetBuildFileStream();
   }
 
   virtual cmGeneratedFileStream* GetDefaultFileStream() const
   {
-    return this->BuildFileStream.get();
+    return this->GetBuildFileStream();
   }
 
   virtual cmGeneratedFileStream* GetCommonFileStream() const
   {
-    return this->BuildFileStream.get();
+    return this->GetBuildFileStream();
   }
 
   cmGeneratedFileStream* GetRulesFileStream() const
@@ -269,6 +296,21 @@ public:
     return this->RulesFileStream.get();
   }
 
+  /// Whether the statements of each directory are written to their own
+  /// file.  See CMAKE_NINJA_SUBNINJA_PER_DIRECTORY.
+  bool UseDirectoryFiles() const { return this->DirectoryFiles; }
+
+  /**
+   * Redirect the build statements written for local generator @a lg to
+   * its own file and reference that file from the main build file.
+   * The file is only replaced if its content changed.
+   */
+  void OpenDirectoryFileStream(cmLocalGenerator const* lg);
+  void CloseDirectoryFileStream();
+
+  std::string InternVariable(std::string& buf, std::string const& file,
+                             std::string const& name, cm::string_view value);
+
   std::string const& ConvertToNinjaPath(const std::string& path) const;
   std::string ConvertToNinjaAbsPath(std::string path) const;
 
@@ -379,10 +421,7 @@ public:
   {
   }
 
-  virtual void AddRebuildManifestOutputs(cmNinjaDeps& outputs) const
-  {
-    outputs.push_back(this->NinjaOutputPath(NINJA_BUILD_FILE));
-  }
+  virtual void AddRebuildManifestOutputs(cmNinjaDeps& outputs) const;
 
   int GetRuleCmdLength(const std::string& name)
   {
@@ -546,6 +585,14 @@ private:
   std::string CMakeCmd() const;
   std::string NinjaCmd() const;
 
+  cmGeneratedFileStream* GetBuildFileStream() const
+  {
+    if (this->DirectoryFileStream) {
+      return this->DirectoryFileStream.get();
+    }
+    return this->BuildFileStream.get();
+  }
+
   /// The file containing the build statement. (the relationship of the
   /// compilation DAG).
   std::unique_ptr<cmGeneratedFileStream> BuildFileStream;
@@ -553,6 +600,21 @@ private:
   /// edge of the compilation DAG).
   std::unique_ptr<cmGeneratedFileStream> RulesFileStream;
   std::unique_ptr<cmGeneratedFileStream> CompileCommandsStream;
+  /// The file containing the build statements of the directory currently
+  /// being generated, if per-directory files are enabled.
+  std::unique_ptr<cmGeneratedFileStream> DirectoryFileStream;
+  bool DirectoryFiles = false;
+
+  /// Reusable buffer in which WriteBuild assembles each build statement.
+  std::string BuildStatementBuffer;
+
+  /// Compile flag sets shared by build statements, keyed by the path of
+  /// the output file, then by variable name and value, and mapped to the
+  /// name of the file-level variable holding them.
+  std::map<std::string, std::unordered_map<std::string, std::string>>
+    InternedVariables;
+  /// Reusable map of build variables replaced by interned references.
+  std::map<std::string, std::string> InternedReferences;
 
   /// The set of rules added to the generated build system.
   std::unordered_set<std::string> Rules;
@@ -29,6 +29,8 @@ public:
 
   bool Compute(cmLocalGenerator* lg) override;
 
+  StepOrder GetStepOrder() const override { return StepOrder::Independent; }
+
   std::string const& GetFilePermissions() const
   {
     return this->FilePermissions;
@@ -29,6 +29,8 @@ public:
 
   bool Compute(cmLocalGenerator* lg) override;
 
+  StepOrder GetStepOrder() const override { return StepOrder::Independent; }
+
   std::string GetDestination(std::string const& config) const;
   std::vector<std::string> GetDirectories(std::string const& config) const;
 
@@ -42,6 +42,8 @@ public:
 
   bool Compute(cmLocalGenerator* lg) override;
 
+  StepOrder GetStepOrder() const override { return StepOrder::Independent; }
+
   cmLocalGenerator* GetLocalGenerator() const { return this->LocalGenerator; }
 
   const std::string& GetNamespace() const { return this->Namespace; }
@@ -28,6 +28,8 @@ public:
 
   bool Compute(cmLocalGenerator* lg) override;
 
+  StepOrder GetStepOrder() const override { return StepOrder::Independent; }
+
   std::string GetDestination(std::string const& config) const;
   std::string GetDestination() const { return this->Destination; }
   bool GetOptional() const { return this->Optional; }
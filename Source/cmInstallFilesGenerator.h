@@ -30,6 +30,8 @@ public:
 
   bool Compute(cmLocalGenerator* lg) override;
 
+  StepOrder GetStepOrder() const override { return StepOrder::Independent; }
+
   std::string GetDestination(std::string const& config) const;
   std::string GetRename(std::string const& config) const;
   std::vector<std::string> GetFiles(std::string const& config) const;
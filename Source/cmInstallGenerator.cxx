@@ -134,6 +134,11 @@ void cmInstallGenerator::AddInstallRule(
       os << " MESSAGE_NEVER";
       break;
   }
+  // Name the component so that CPack can record which one installs
+  // each file.
+  if (!this->AllComponents) {
+    os << " COMPONENT \"" << this->Component << "\"";
+  }
   if (permissions_file && *permissions_file) {
     os << " PERMISSIONS" << permissions_file;
   }
@@ -169,7 +174,7 @@ std::string cmInstallGenerator::CreateComponentTest(
 {
   if (all_components) {
     if (exclude_from_all) {
-      return "CMAKE_INSTALL_COMPONENT";
+      return "CMAKE_INSTALL_COMPONENT OR CMAKE_INSTALL_RECORD_COMPONENTS";
     }
     return {};
   }
@@ -179,7 +184,13 @@ std::string cmInstallGenerator::CreateComponentTest(
   result += "\"";
   if (!exclude_from_all) {
     result += " OR NOT CMAKE_INSTALL_COMPONENT";
+    result += " AND NOT CMAKE_INSTALL_RECORD_COMPONENTS";
   }
+  // CPack installs several components at once when it records which
+  // component installs each file.
+  result += " OR DEFINED \"CMAKE_INSTALL_RECORD_COMPONENT_";
+  result += component;
+  result += "\"";
 
   return result;
 }
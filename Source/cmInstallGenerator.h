@@ -65,6 +65,21 @@ public:
 
   virtual bool Compute(cmLocalGenerator*) { return true; }
 
+  /** How the code of this generator may run relative to the code of the
+      other generators in its directory when the directory is installed
+      in separate steps, see the INSTALL_PARALLEL global property.  */
+  enum class StepOrder
+  {
+    // A step of its own that may run concurrently with other steps.
+    Independent,
+    // A step that runs after all earlier steps and before all later ones.
+    // Consecutive ordered generators share one step.
+    Ordered,
+    // No step; the code does nothing in a local-only install.
+    None,
+  };
+  virtual StepOrder GetStepOrder() const { return StepOrder::Ordered; }
+
   std::string const& GetComponent() const { return this->Component; }
 
   bool GetExcludeFromAll() const { return this->ExcludeFromAll; }
@@ -25,6 +25,8 @@ public:
 
   bool Compute(cmLocalGenerator* lg) override;
 
+  StepOrder GetStepOrder() const override { return StepOrder::Independent; }
+
   cmGeneratorTarget* GetTarget() const { return this->Target; }
 
   bool GetOptional() const { return this->Optional; }
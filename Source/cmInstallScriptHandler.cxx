@@ -5,6 +5,9 @@
 
 #include <algorithm>
 #include <cstddef>
+#include <deque>
+#include <functional>
+#include <map>
 #include <memory>
 #include <string>
 #include <utility>
@@ -45,18 +48,55 @@ cmInstallScriptHandler::cmInstallScriptHandler(std::string _binaryDir,
       cmStrCat(this->binaryDir, "/CMakeFiles/cmake.check_cache"), file,
       &compare);
     if (compare < 1) {
-      args.insert(args.end() - 1, "-DCMAKE_INSTALL_LOCAL_ONLY=1");
       Json::CharReaderBuilder rbuilder;
       auto JsonReader =
         std::unique_ptr<Json::CharReader>(rbuilder.newCharReader());
       std::vector<char> content;
       Json::Value value;
       cmJSONState state(file, &value);
-      for (auto const& script : value["InstallScripts"]) {
-        this->commands.push_back(args);
-        this->commands.back().emplace_back(script.asCString());
-        this->directories.push_back(
-          cmSystemTools::GetFilenamePath(script.asCString()));
+      // Without steps, install each script as a whole.
+      if (!value.isMember("InstallSteps")) {
+        for (auto const& script : value["InstallScripts"]) {
+          Step entry;
+          entry.command = args;
+          entry.command.insert(entry.command.end() - 1,
+                               "-DCMAKE_INSTALL_LOCAL_ONLY=1");
+          entry.command.emplace_back(script.asString());
+          entry.manifest =
+            cmStrCat(cmSystemTools::GetFilenamePath(script.asString()),
+                     "/install_local_manifest.txt");
+          this->steps.push_back(std::move(entry));
+        }
+        return;
+      }
+      std::map<std::string, std::size_t> stepsPerScript;
+      for (auto const& step : value["InstallSteps"]) {
+        std::string const script = step["Script"].asString();
+        std::string const index = std::to_string(step["Step"].asUInt64());
+        Step entry;
+        entry.command = args;
+        entry.command.insert(entry.command.end() - 1,
+                             { "-DCMAKE_INSTALL_LOCAL_ONLY=1",
+                               cmStrCat("-DCMAKE_INSTALL_STEP=", index) });
+        entry.command.push_back(script);
+        entry.manifest =
+          cmStrCat(cmSystemTools::GetFilenamePath(script),
+                   "/install_local_manifest_", index, ".txt");
+        entry.name = cmStrCat(" (step ", index, ')');
+        for (auto const& dep : step["Depends"]) {
+          // A step may only wait for an earlier one.
+          if (dep.asUInt() < this->steps.size()) {
+            entry.depends.push_back(dep.asUInt());
+          }
+        }
+        this->steps.push_back(std::move(entry));
+        ++stepsPerScript[script];
+      }
+      // Name a step by its script alone if the script has only one.
+      for (Step& step : this->steps) {
+        if (stepsPerScript[step.command.back()] == 1) {
+          step.name.clear();
+        }
       }
     }
   }
@@ -64,7 +104,7 @@ cmInstallScriptHandler::cmInstallScriptHandler(std::string _binaryDir,
 
 bool cmInstallScriptHandler::isParallel()
 {
-  return !this->commands.empty();
+  return !this->steps.empty();
 }
 
 int cmInstallScriptHandler::install(unsigned int j)
@@ -72,27 +112,45 @@ int cmInstallScriptHandler::install(unsigned int j)
   cm::uv_loop_ptr loop;
   loop.init();
   std::vector<InstallScript> scripts;
-  scripts.reserve(this->commands.size());
-  for (auto const& cmd : this->commands) {
-    scripts.emplace_back(cmd);
+  scripts.reserve(this->steps.size());
+  std::vector<std::size_t> waiting;
+  std::vector<std::vector<std::size_t>> dependents(this->steps.size());
+  std::deque<std::size_t> ready;
+  for (std::size_t i = 0; i < this->steps.size(); ++i) {
+    Step const& step = this->steps[i];
+    scripts.emplace_back(step.command, step.name);
+    waiting.push_back(step.depends.size());
+    for (std::size_t dep : step.depends) {
+      dependents[dep].push_back(i);
+    }
+    if (step.depends.empty()) {
+      ready.push_back(i);
+    }
+    // Do not merge the manifest of an earlier run if this step fails.
+    cmSystemTools::RemoveFile(step.manifest);
   }
   std::size_t working = 0;
   std::size_t installed = 0;
-  std::size_t i = 0;
 
+  // Start steps as the steps they depend on finish.
   std::function<void()> queueScripts;
-  queueScripts = [&scripts, &working, &installed, &i, &loop, j,
-                  &queueScripts]() {
-    for (auto queue = std::min(j - working, scripts.size() - i); queue > 0;
-         --queue) {
+  queueScripts = [&scripts, &working, &installed, &ready, &waiting,
+                  &dependents, &loop, j, &queueScripts]() {
+    while (working < j && !ready.empty()) {
+      std::size_t const i = ready.front();
+      ready.pop_front();
       ++working;
-      scripts[i].start(loop,
-                       [&scripts, &working, &installed, i, &queueScripts]() {
-                         scripts[i].printResult(++installed, scripts.size());
-                         --working;
-                         queueScripts();
-                       });
-      ++i;
+      scripts[i].start(loop, [&scripts, &working, &installed, &ready,
+                              &waiting, &dependents, i, &queueScripts]() {
+        scripts[i].printResult(++installed, scripts.size());
+        --working;
+        for (std::size_t d : dependents[i]) {
+          if (--waiting[d] == 0) {
+            ready.push_back(d);
+          }
+        }
+        queueScripts();
+      });
     }
   };
   queueScripts();
@@ -117,10 +175,9 @@ int cmInstallScriptHandler::install(unsigned int j)
   }
   cmGeneratedFileStream fout(cmStrCat(this->binaryDir, "/", install_manifest));
   fout.SetCopyIfDifferent(true);
-  for (auto const& dir : this->directories) {
-    auto local_manifest = cmStrCat(dir, "/install_local_manifest.txt");
-    if (cmSystemTools::FileExists(local_manifest)) {
-      cmsys::ifstream fin(local_manifest.c_str());
+  for (Step const& step : this->steps) {
+    if (cmSystemTools::FileExists(step.manifest)) {
+      cmsys::ifstream fin(step.manifest.c_str());
       std::string line;
       while (std::getline(fin, line)) {
         fout << line << "\n";
@@ -130,10 +187,13 @@ int cmInstallScriptHandler::install(unsigned int j)
   return 0;
 }
 
-InstallScript::InstallScript(const std::vector<std::string>& cmd)
+InstallScript::InstallScript(const std::vector<std::string>& cmd,
+                             std::string step)
 {
-  this->name = cmSystemTools::RelativePath(
-    cmSystemTools::GetCurrentWorkingDirectory(), cmd.back());
+  this->name = cmStrCat(
+    cmSystemTools::RelativePath(cmSystemTools::GetCurrentWorkingDirectory(),
+                                cmd.back()),
+    step);
   this->command = cmd;
 }
 
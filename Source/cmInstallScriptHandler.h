@@ -22,7 +22,7 @@ public:
   class InstallScript
   {
   public:
-    InstallScript(const std::vector<std::string>&);
+    InstallScript(const std::vector<std::string>&, std::string);
     void start(cm::uv_loop_ptr&, std::function<void()>);
     void printResult(std::size_t n, std::size_t total);
 
@@ -36,8 +36,15 @@ public:
   };
 
 private:
-  std::vector<std::vector<std::string>> commands;
-  std::vector<std::string> directories;
+  // One step of a directory's install script and the steps it waits for.
+  struct Step
+  {
+    std::vector<std::string> command;
+    std::string manifest;
+    std::string name;
+    std::vector<std::size_t> depends;
+  };
+  std::vector<Step> steps;
   std::string binaryDir;
   std::string component;
 };
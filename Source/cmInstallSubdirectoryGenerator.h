@@ -30,6 +30,8 @@ public:
 
   bool Compute(cmLocalGenerator* lg) override;
 
+  StepOrder GetStepOrder() const override { return StepOrder::None; }
+
 protected:
   void GenerateScript(std::ostream& os) override;
 
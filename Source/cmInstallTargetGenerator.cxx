@@ -853,9 +853,19 @@ void cmInstallTargetGenerator::AddStripRule(std::ostream& os, Indent indent,
     }
   }
 
+  // If requested, ELF binaries are stripped in-process and the strip
+  // tool handles the others.  Otherwise the strip tool handles all.
+  bool const stripInProcess = !this->Target->IsApple() &&
+    this->Target->Target->GetMakefile()->IsOn(
+      "CMAKE_INSTALL_STRIP_IN_PROCESS");
   os << indent << "if(CMAKE_INSTALL_DO_STRIP)\n";
-  os << indent << "  execute_process(COMMAND \"" << strip << "\" " << stripArgs
-     << "\"" << toDestDirPath << "\")\n";
+  if (stripInProcess) {
+    os << indent << "  file(STRIP FILE \"" << toDestDirPath
+       << "\" COMMAND \"" << strip << "\")\n";
+  } else {
+    os << indent << "  execute_process(COMMAND \"" << strip << "\" "
+       << stripArgs << "\"" << toDestDirPath << "\")\n";
+  }
   os << indent << "endif()\n";
 }
 
@@ -63,6 +63,8 @@ public:
 
   bool Compute(cmLocalGenerator* lg) override;
 
+  StepOrder GetStepOrder() const override { return StepOrder::Independent; }
+
   cmGeneratorTarget* GetTarget() const { return this->Target; }
 
   bool IsImportLibrary() const { return this->ImportLibrary; }
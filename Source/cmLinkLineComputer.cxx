@@ -84,7 +84,8 @@ void cmLinkLineComputer::ComputeLinkLibs(
   }
 }
 
-std::string cmLinkLineComputer::ConvertToOutputFormat(std::string const& input)
+std::string const& cmLinkLineComputer::ConvertToOutputFormat(
+  std::string const& input)
 {
   cmOutputConverter::OutputFormat shellFormat = cmOutputConverter::SHELL;
   if (this->ForResponse) {
@@ -93,11 +94,11 @@ std::string cmLinkLineComputer::ConvertToOutputFormat(std::string const& input)
     shellFormat = cmOutputConverter::NINJAMULTI;
   }
 
-  return this->OutputConverter->ConvertToOutputFormat(input, shellFormat,
-                                                      this->UseWatcomQuote);
+  return this->OutputConverter->ConvertToOutputFormatCached(
+    input, shellFormat, this->UseWatcomQuote);
 }
 
-std::string cmLinkLineComputer::ConvertToOutputForExisting(
+std::string const& cmLinkLineComputer::ConvertToOutputForExisting(
   std::string const& input)
 {
   cmOutputConverter::OutputFormat shellFormat = cmOutputConverter::SHELL;
@@ -107,7 +108,7 @@ std::string cmLinkLineComputer::ConvertToOutputForExisting(
     shellFormat = cmOutputConverter::NINJAMULTI;
   }
 
-  return this->OutputConverter->ConvertToOutputForExisting(
+  return this->OutputConverter->ConvertToOutputForExistingCached(
     input, shellFormat, this->UseWatcomQuote);
 }
 
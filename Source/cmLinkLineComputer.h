@@ -64,8 +64,8 @@ protected:
                        std::vector<BT<std::string>>& linkLibraries);
   std::string ComputeRPath(cmComputeLinkInformation& cli);
 
-  std::string ConvertToOutputFormat(std::string const& input);
-  std::string ConvertToOutputForExisting(std::string const& input);
+  std::string const& ConvertToOutputFormat(std::string const& input);
+  std::string const& ConvertToOutputForExisting(std::string const& input);
 
   cmStateDirectory StateDir;
   cmOutputConverter* OutputConverter;
@@ -10,6 +10,7 @@
 #include <cstdlib>
 #include <initializer_list>
 #include <iterator>
+#include <set>
 #include <sstream>
 #include <type_traits>
 #include <unordered_set>
@@ -56,7 +57,10 @@
 #include "cmStringAlgorithms.h"
 #include "cmSystemTools.h"
 #include "cmTarget.h"
+#include "cmTest.h"
 #include "cmTestGenerator.h"
+#include "cmTestImpact.h"
+#include "cmTestManifest.h"
 #include "cmValue.h"
 #include "cmVersion.h"
 #include "cmake.h"
@@ -313,19 +317,30 @@ void cmLocalGenerator::GenerateTestFiles()
     this->Makefile->GetGeneratorConfigs(cmMakefile::OnlyMultiConfig);
   std::string config = this->Makefile->GetDefaultConfiguration();
 
-  std::string file =
-    cmStrCat(this->StateSnapshot.GetDirectory().GetCurrentBinary(),
-             "/CTestTestfile.cmake");
+  std::string const& binaryDir =
+    this->StateSnapshot.GetDirectory().GetCurrentBinary();
+  std::string file = cmStrCat(binaryDir, "/CTestTestfile.cmake");
 
-  cmGeneratedFileStream fout(file);
-  fout.SetCopyIfDifferent(true);
+  // Generate the script in memory so that the manifest can record the
+  // exact content it was generated alongside.
+  std::ostringstream fout;
+  cmTestManifest manifest;
+  std::set<std::string> configsUpper;
+  for (std::string const& c : configurationTypes) {
+    // The manifest matches configurations by name, so each must be
+    // distinct and plain enough to match the script's condition.
+    if (!cmTestManifest::IsLiteralConfigName(c) ||
+        !configsUpper.insert(cmSystemTools::UpperCase(c)).second) {
+      manifest.SetUnsupported();
+    }
+  }
 
   fout << "# CMake generated Testfile for \n"
           "# Source directory: "
        << this->StateSnapshot.GetDirectory().GetCurrentSource()
        << "\n"
           "# Build directory: "
-       << this->StateSnapshot.GetDirectory().GetCurrentBinary()
+       << binaryDir
        << "\n"
           "# \n"
           "# This file includes the relevant testing commands "
@@ -337,11 +352,19 @@ void cmLocalGenerator::GenerateTestFiles()
     this->Makefile->GetSafeDefinition("CTEST_RESOURCE_SPEC_FILE");
   if (!resourceSpecFile.empty()) {
     fout << "set(CTEST_RESOURCE_SPEC_FILE \"" << resourceSpecFile << "\")\n";
+    if (!cmTestManifest::IsLiteralQuotedArgument(resourceSpecFile)) {
+      manifest.SetUnsupported();
+    }
+    manifest
+      .AddRecord(cmTestManifest::Command::SetResourceSpecFile,
+                 cmTestManifest::Condition::Always)
+      .Args.emplace_back(std::move(resourceSpecFile));
   }
 
   cmValue testIncludeFile = this->Makefile->GetProperty("TEST_INCLUDE_FILE");
   if (testIncludeFile) {
     fout << "include(\"" << *testIncludeFile << "\")\n";
+    manifest.SetUnsupported();
   }
 
   cmValue testIncludeFiles = this->Makefile->GetProperty("TEST_INCLUDE_FILES");
@@ -350,12 +373,19 @@ void cmLocalGenerator::GenerateTestFiles()
     for (std::string const& i : includesList) {
       fout << "include(\"" << i << "\")\n";
     }
+    manifest.SetUnsupported();
   }
 
   // Ask each test generator to write its code.
+  std::map<std::string, std::set<cmGeneratorTarget*>> impactTests;
   for (const auto& tester : this->Makefile->GetTestGenerators()) {
     tester->Compute(this);
+    tester->SetManifest(&manifest);
     tester->Generate(fout, config, configurationTypes);
+    tester->SetManifest(nullptr);
+    if (!tester->GetImpactTargets().empty()) {
+      impactTests[tester->GetTest()->GetName()] = tester->GetImpactTargets();
+    }
   }
   using vec_t = std::vector<cmStateSnapshot>;
   vec_t const& children = this->Makefile->GetStateSnapshot().GetChildren();
@@ -363,8 +393,11 @@ void cmLocalGenerator::GenerateTestFiles()
     // TODO: Use add_subdirectory instead?
     std::string outP = i.GetDirectory().GetCurrentBinary();
     outP = this->MaybeRelativeToCurBinDir(outP);
-    outP = cmOutputConverter::EscapeForCMake(outP);
-    fout << "subdirs(" << outP << ")\n";
+    fout << "subdirs(" << cmOutputConverter::EscapeForCMake(outP) << ")\n";
+    manifest
+      .AddRecord(cmTestManifest::Command::Subdirs,
+                 cmTestManifest::Condition::Always)
+      .Args.emplace_back(std::move(outP));
   }
 
   // Add directory labels property
@@ -379,12 +412,86 @@ void cmLocalGenerator::GenerateTestFiles()
     }
     if (labels && directoryLabels) {
       fout << ";";
+      // The script concatenates two quoted arguments, which does not
+      // read back as a single value.
+      manifest.SetUnsupported();
     }
     if (directoryLabels) {
       fout << cmOutputConverter::EscapeForCMake(*directoryLabels);
     }
     fout << ")\n";
+    manifest
+      .AddRecord(cmTestManifest::Command::SetDirectoryProperties,
+                 cmTestManifest::Condition::Always)
+      .Args = { "PROPERTIES", "LABELS", labels ? *labels : *directoryLabels };
+  }
+
+  std::string const script = fout.str();
+  {
+    cmGeneratedFileStream testFile(file);
+    testFile.SetCopyIfDifferent(true);
+    testFile << script;
+  }
+  manifest.Write(binaryDir, script);
+
+  this->GenerateTestImpact(impactTests, configurationTypes, config);
+}
+
+void cmLocalGenerator::GenerateTestImpact(
+  std::map<std::string, std::set<cmGeneratorTarget*>> const& tests,
+  std::vector<std::string> const& configurationTypes,
+  std::string const& defaultConfig)
+{
+  std::vector<std::string> configs = configurationTypes;
+  if (configs.empty()) {
+    configs.emplace_back(defaultConfig);
+  }
+
+  // Record the targets of each test, and the sources of those targets
+  // and of the targets they link to, in all configurations.  Paths are
+  // resolved so that they compare equal to the resolved changed files.
+  cmTestImpact impact;
+  auto addSources = [&impact, &configs](cmGeneratorTarget const* gt) {
+    cmTestImpact::Target& entry = impact.AddTarget(gt->GetName());
+    for (std::string const& c : configs) {
+      std::vector<cmSourceFile*> sources;
+      gt->GetSourceFiles(sources, c);
+      for (cmSourceFile* sf : sources) {
+        std::string const& path = sf->GetFullPath();
+        if (!path.empty()) {
+          entry.Sources.insert(cmSystemTools::GetRealPath(
+            cmSystemTools::CollapseFullPath(path)));
+        }
+      }
+    }
+    return &entry;
+  };
+  std::set<cmGeneratorTarget*> targets;
+  for (auto const& test : tests) {
+    // Names that do not fit on one line of the file are left out, and the
+    // test is then always selected.
+    if (test.first.find_first_of("\r\n") != std::string::npos) {
+      continue;
+    }
+    std::set<std::string>& testTargets = impact.AddTest(test.first);
+    for (cmGeneratorTarget* target : test.second) {
+      testTargets.insert(target->GetName());
+      targets.insert(target);
+    }
+  }
+  for (cmGeneratorTarget* target : targets) {
+    std::set<std::string> links;
+    for (std::string const& c : configs) {
+      for (cmGeneratorTarget const* dep : target->GetLinkImplementationClosure(
+             c, cmGeneratorTarget::UseTo::Link)) {
+        if (!dep->IsImported() && links.insert(dep->GetName()).second) {
+          addSources(dep);
+        }
+      }
+    }
+    addSources(target)->Links = std::move(links);
   }
+  impact.Write(this->StateSnapshot.GetDirectory().GetCurrentBinary());
 }
 
 void cmLocalGenerator::CreateEvaluationFileOutputs()
@@ -432,6 +539,63 @@ void cmLocalGenerator::ProcessEvaluationFiles(
   }
 }
 
+namespace {
+// Writes the code of install generators, grouped into steps that
+// cmInstallScriptHandler can run in separate processes.  A step runs
+// when CMAKE_INSTALL_STEP names it, or when CMAKE_INSTALL_STEP is not
+// defined.
+class InstallStepWriter
+{
+public:
+  InstallStepWriter(std::ostream& os, bool enabled)
+    : OS(os)
+    , Enabled(enabled)
+  {
+  }
+
+  // Get the stream to which code with the given order is written.
+  std::ostream& Begin(cmInstallGenerator::StepOrder order)
+  {
+    if (!this->Enabled) {
+      return this->OS;
+    }
+    bool const ordered = order == cmInstallGenerator::StepOrder::Ordered;
+    if (!ordered || !this->StepOrdered) {
+      this->Finish();
+    }
+    if (order == cmInstallGenerator::StepOrder::None) {
+      return this->OS;
+    }
+    this->StepOrdered = ordered;
+    return this->Step;
+  }
+
+  void Finish()
+  {
+    std::string const code = this->Step.str();
+    if (!code.empty()) {
+      /* clang-format off */
+      this->OS <<
+        "if(NOT DEFINED CMAKE_INSTALL_STEP OR CMAKE_INSTALL_STEP EQUAL " <<
+        this->OrderedSteps.size() << ")\n" << code << "endif()\n\n";
+      /* clang-format on */
+      this->OrderedSteps.push_back(this->StepOrdered);
+    }
+    this->Step.str(std::string());
+    this->StepOrdered = false;
+  }
+
+  std::vector<bool>& GetOrderedSteps() { return this->OrderedSteps; }
+
+private:
+  std::ostream& OS;
+  bool const Enabled;
+  std::ostringstream Step;
+  bool StepOrdered = false;
+  std::vector<bool> OrderedSteps;
+};
+}
+
 void cmLocalGenerator::GenerateInstallRules()
 {
   // Compute the install prefix.
@@ -500,7 +664,6 @@ void cmLocalGenerator::GenerateInstallRules()
     toplevel_install = 1;
   }
   file += "/cmake_install.cmake";
-  this->GetGlobalGenerator()->AddInstallScript(file);
   cmGeneratedFileStream fout(file);
   fout.SetCopyIfDifferent(true);
 
@@ -656,7 +819,12 @@ void cmLocalGenerator::GenerateInstallRules()
 
   this->AddGeneratorSpecificInstallSetup(fout);
 
-  // Ask each install generator to write its code.
+  // Ask each install generator to write its code.  For a parallel
+  // install in steps, group the code into steps.
+  bool const parallel =
+    this->GetState()->GetGlobalPropertyAsBool("INSTALL_PARALLEL") &&
+    this->GetState()->GetGlobalPropertyAsBool("INSTALL_PARALLEL_STEPS");
+  InstallStepWriter steps(fout, parallel);
   cmPolicies::PolicyStatus status = this->GetPolicyStatus(cmPolicies::CMP0082);
   auto const& installers = this->Makefile->GetInstallGenerators();
   bool haveSubdirectoryInstall = false;
@@ -665,16 +833,23 @@ void cmLocalGenerator::GenerateInstallRules()
     for (const auto& installer : installers) {
       installer->CheckCMP0082(haveSubdirectoryInstall,
                               haveInstallAfterSubdirectory);
-      installer->Generate(fout, config, configurationTypes);
+      installer->Generate(steps.Begin(installer->GetStepOrder()), config,
+                          configurationTypes);
     }
   } else {
     for (const auto& installer : installers) {
-      installer->Generate(fout, config, configurationTypes);
+      installer->Generate(steps.Begin(installer->GetStepOrder()), config,
+                          configurationTypes);
     }
   }
 
   // Write rules from old-style specification stored in targets.
-  this->GenerateTargetInstallRules(fout, config, configurationTypes);
+  this->GenerateTargetInstallRules(
+    steps.Begin(cmInstallGenerator::StepOrder::Ordered), config,
+    configurationTypes);
+  steps.Finish();
+  this->GetGlobalGenerator()->AddInstallScript(
+    file, std::move(steps.GetOrderedSteps()));
 
   // Include install scripts from subdirectories.
   switch (status) {
@@ -717,8 +892,21 @@ void cmLocalGenerator::GenerateInstallRules()
 
     fout <<
       "string(REPLACE \";\" \"\\n\" CMAKE_INSTALL_MANIFEST_CONTENT\n"
-      "       \"${CMAKE_INSTALL_MANIFEST_FILES}\")\n"
-      "if(CMAKE_INSTALL_LOCAL_ONLY)\n"
+      "       \"${CMAKE_INSTALL_MANIFEST_FILES}\")\n";
+    if (parallel) {
+      // Each step run by cmInstallScriptHandler has its own manifest.
+      fout <<
+        "if(CMAKE_INSTALL_LOCAL_ONLY AND DEFINED CMAKE_INSTALL_STEP)\n"
+        "  file(WRITE \"" <<
+        this->StateSnapshot.GetDirectory().GetCurrentBinary() <<
+        "/install_local_manifest_${CMAKE_INSTALL_STEP}.txt\"\n"
+        "     \"${CMAKE_INSTALL_MANIFEST_CONTENT}\")\n"
+        "elseif(CMAKE_INSTALL_LOCAL_ONLY)\n";
+    } else {
+      fout <<
+        "if(CMAKE_INSTALL_LOCAL_ONLY)\n";
+    }
+    fout <<
       "  file(WRITE \"" <<
       this->StateSnapshot.GetDirectory().GetCurrentBinary() <<
       "/install_local_manifest.txt\"\n"
@@ -741,7 +929,8 @@ void cmLocalGenerator::GenerateInstallRules()
         "  set(CMAKE_INSTALL_MANIFEST \"install_manifest.txt\")\n"
         "endif()\n"
         "\n"
-        "if(NOT CMAKE_INSTALL_LOCAL_ONLY)\n"
+        "if(NOT CMAKE_INSTALL_LOCAL_ONLY AND "
+        "NOT CMAKE_INSTALL_RECORD_COMPONENTS)\n"
         "  file(WRITE \"" << homedir << "/${CMAKE_INSTALL_MANIFEST}\"\n"
         "     \"${CMAKE_INSTALL_MANIFEST_CONTENT}\")\n"
         "endif()\n";
@@ -866,10 +1055,10 @@ std::string cmLocalGenerator::GetRuleLauncher(cmGeneratorTarget* target,
   return "";
 }
 
-std::string cmLocalGenerator::ConvertToIncludeReference(
+std::string const& cmLocalGenerator::ConvertToIncludeReference(
   std::string const& path, OutputFormat format)
 {
-  return this->ConvertToOutputForExisting(path, format);
+  return this->ConvertToOutputForExistingCached(path, format);
 }
 
 std::string cmLocalGenerator::GetIncludeFlags(
@@ -936,7 +1125,8 @@ std::string cmLocalGenerator::GetIncludeFlags(
         } else {
           includeFlags << *fwSearchFlag;
         }
-        includeFlags << this->ConvertToOutputFormat(frameworkDir, shellFormat)
+        includeFlags << this->ConvertToOutputFormatCached(frameworkDir,
+                                                          shellFormat)
                      << " ";
       }
       continue;
@@ -952,7 +1142,8 @@ std::string cmLocalGenerator::GetIncludeFlags(
       }
       flagUsed = true;
     }
-    std::string includePath = this->ConvertToIncludeReference(i, shellFormat);
+    std::string const& includePath =
+      this->ConvertToIncludeReference(i, shellFormat);
     if (quotePaths && !includePath.empty() && includePath.front() != '\"') {
       includeFlags << "\"";
     }
@@ -570,7 +570,7 @@ protected:
   // The default implementation converts to a Windows shortpath to
   // help older toolchains handle spaces and such.  A generator may
   // override this to avoid that conversion.
-  virtual std::string ConvertToIncludeReference(
+  virtual std::string const& ConvertToIncludeReference(
     std::string const& path, cmOutputConverter::OutputFormat format);
 
   //! put all the libraries for a target on into the given stream
@@ -629,6 +629,13 @@ protected:
   bool BackwardsCompatibilityFinal;
 
 private:
+  /** Write the impact file ctest uses to select the tests that changes
+      to a set of source files affect.  */
+  void GenerateTestImpact(
+    std::map<std::string, std::set<cmGeneratorTarget*>> const& tests,
+    std::vector<std::string> const& configurationTypes,
+    std::string const& defaultConfig);
+
   /**
    * See LinearGetSourceFileWithOutput for background information
    */
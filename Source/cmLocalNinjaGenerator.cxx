@@ -69,6 +69,17 @@ void cmLocalNinjaGenerator::Generate()
     this->HomeRelativeOutputPath.clear();
   }
 
+  bool const directoryFile =
+    this->GetGlobalNinjaGenerator()->UseDirectoryFiles();
+  if (directoryFile) {
+    // The top of the main build file must precede the 'subninja'
+    // statements so that its bindings are visible in every directory.
+    if (this->IsRootMakefile()) {
+      this->WriteBuildFileTop();
+    }
+    this->GetGlobalNinjaGenerator()->OpenDirectoryFileStream(this);
+  }
+
   if (this->GetGlobalGenerator()->IsMultiConfig()) {
     for (auto const& config : this->GetConfigNames()) {
       this->WriteProcessedMakefile(this->GetImplFileStream(config));
@@ -80,24 +91,8 @@ void cmLocalNinjaGenerator::Generate()
 #endif
 
   // We do that only once for the top CMakeLists.txt file.
-  if (this->IsRootMakefile()) {
+  if (this->IsRootMakefile() && !directoryFile) {
     this->WriteBuildFileTop();
-
-    this->WritePools(this->GetRulesFileStream());
-
-    const std::string& showIncludesPrefix =
-      this->GetMakefile()->GetSafeDefinition("CMAKE_CL_SHOWINCLUDES_PREFIX");
-    if (!showIncludesPrefix.empty()) {
-      cmGlobalNinjaGenerator::WriteComment(this->GetRulesFileStream(),
-                                           "localized /showIncludes string");
-      this->GetRulesFileStream() << "msvc_deps_prefix = ";
-      // 'cl /showIncludes' encodes output in the console output code page.
-      // It may differ from the encoding used for file paths in 'build.ninja'.
-      // Ninja matches the showIncludes prefix using its raw byte sequence.
-      this->GetRulesFileStream().WriteAltEncoding(
-        showIncludesPrefix, cmGeneratedFileStream::Encoding::ConsoleOutput);
-      this->GetRulesFileStream() << "\n\n";
-    }
   }
 
   for (const auto& target : this->GetGeneratorTargets()) {
@@ -160,6 +155,10 @@ void cmLocalNinjaGenerator::Generate()
     this->WriteCustomCommandBuildStatements(config);
     this->AdditionalCleanFiles(config);
   }
+
+  if (directoryFile) {
+    this->GetGlobalNinjaGenerator()->CloseDirectoryFileStream();
+  }
 }
 
 // TODO: Picked up from cmLocalUnixMakefileGenerator3.  Refactor it.
@@ -211,10 +210,10 @@ std::string cmLocalNinjaGenerator::GetLinkDependencyFile(
 
 // Virtual protected methods.
 
-std::string cmLocalNinjaGenerator::ConvertToIncludeReference(
+std::string const& cmLocalNinjaGenerator::ConvertToIncludeReference(
   std::string const& path, cmOutputConverter::OutputFormat format)
 {
-  return this->ConvertToOutputFormat(path, format);
+  return this->ConvertToOutputFormatCached(path, format);
 }
 
 // Private methods.
@@ -267,6 +266,22 @@ void cmLocalNinjaGenerator::WriteBuildFileTop()
 
   // For the rule file.
   this->WriteProjectHeader(this->GetRulesFileStream());
+
+  this->WritePools(this->GetRulesFileStream());
+
+  const std::string& showIncludesPrefix =
+    this->GetMakefile()->GetSafeDefinition("CMAKE_CL_SHOWINCLUDES_PREFIX");
+  if (!showIncludesPrefix.empty()) {
+    cmGlobalNinjaGenerator::WriteComment(this->GetRulesFileStream(),
+                                         "localized /showIncludes string");
+    this->GetRulesFileStream() << "msvc_deps_prefix = ";
+    // 'cl /showIncludes' encodes output in the console output code page.
+    // It may differ from the encoding used for file paths in 'build.ninja'.
+    // Ninja matches the showIncludes prefix using its raw byte sequence.
+    this->GetRulesFileStream().WriteAltEncoding(
+      showIncludesPrefix, cmGeneratedFileStream::Encoding::ConsoleOutput);
+    this->GetRulesFileStream() << "\n\n";
+  }
 }
 
 void cmLocalNinjaGenerator::WriteProjectHeader(std::ostream& os)
@@ -100,7 +100,7 @@ public:
                                     std::string const& config) const override;
 
 protected:
-  std::string ConvertToIncludeReference(
+  std::string const& ConvertToIncludeReference(
     std::string const& path, cmOutputConverter::OutputFormat format) override;
 
 private:
@@ -6,13 +6,10 @@
 #include <cassert>
 #include <cctype>
 #include <set>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
-#ifdef _WIN32
-#  include <unordered_map>
-#  include <utility>
-#endif
-
 #include "cmList.h"
 #include "cmState.h"
 #include "cmStateDirectory.h"
@@ -153,8 +150,8 @@ std::string cmOutputConverter::MaybeRelativeToCurBinDir(
     this->StateSnapshot.GetDirectory().GetCurrentBinary(), path);
 }
 
-std::string cmOutputConverter::ConvertToOutputForExisting(
-  const std::string& remote, OutputFormat format, bool useWatcomQuote) const
+std::string const& cmOutputConverter::ShortPathForExisting(
+  std::string const& remote) const
 {
 #ifdef _WIN32
   // Cache the Short Paths since we only convert the same few paths anyway and
@@ -167,31 +164,38 @@ std::string cmOutputConverter::ConvertToOutputForExisting(
   if (this->GetState()->UseWindowsShell() &&
       remote.find_first_of(" #") != std::string::npos &&
       cmSystemTools::FileExists(remote)) {
+    auto cachedShortPathIt = shortPathCache.find(remote);
+    if (cachedShortPathIt != shortPathCache.end()) {
+      return cachedShortPathIt->second;
+    }
 
-    std::string shortPath = [&]() {
-      auto cachedShortPathIt = shortPathCache.find(remote);
-
-      if (cachedShortPathIt != shortPathCache.end()) {
-        return cachedShortPathIt->second;
-      }
-
-      std::string tmp{};
-      cmsys::Status status = cmSystemTools::GetShortPath(remote, tmp);
-      if (!status) {
-        // Fallback for cases when Windows refuses to resolve the short path,
-        // like for C:\Program Files\WindowsApps\...
-        tmp = remote;
-      }
-      shortPathCache[remote] = tmp;
-      return tmp;
-    }();
-
-    return this->ConvertToOutputFormat(shortPath, format, useWatcomQuote);
+    std::string tmp{};
+    cmsys::Status status = cmSystemTools::GetShortPath(remote, tmp);
+    if (!status) {
+      // Fallback for cases when Windows refuses to resolve the short path,
+      // like for C:\Program Files\WindowsApps\...
+      tmp = remote;
+    }
+    return shortPathCache.emplace(remote, std::move(tmp)).first->second;
   }
 #endif
 
-  // Otherwise, perform standard conversion.
-  return this->ConvertToOutputFormat(remote, format, useWatcomQuote);
+  // Otherwise, use the path as given.
+  return remote;
+}
+
+std::string cmOutputConverter::ConvertToOutputForExisting(
+  const std::string& remote, OutputFormat format, bool useWatcomQuote) const
+{
+  return this->ConvertToOutputFormat(this->ShortPathForExisting(remote),
+                                     format, useWatcomQuote);
+}
+
+std::string const& cmOutputConverter::ConvertToOutputForExistingCached(
+  const std::string& remote, OutputFormat format, bool useWatcomQuote) const
+{
+  return this->ConvertToOutputFormatCached(this->ShortPathForExisting(remote),
+                                           format, useWatcomQuote);
 }
 
 std::string cmOutputConverter::ConvertToOutputFormat(cm::string_view source,
@@ -211,6 +215,29 @@ std::string cmOutputConverter::ConvertToOutputFormat(cm::string_view source,
   return result;
 }
 
+std::string const& cmOutputConverter::ConvertToOutputFormatCached(
+  cm::string_view source, OutputFormat format, bool useWatcomQuote) const
+{
+  // The global shell settings are fixed for the lifetime of the
+  // generator, so only the per-call options need to be part of the key.
+  // Reuse the key buffer so that lookups do not allocate.
+  char const options = static_cast<char>('A' + format * 4 +
+                                         (useWatcomQuote ? 2 : 0) +
+                                         (this->LinkScriptShell ? 1 : 0));
+  std::string& key = this->OutputFormatCacheKey;
+  key.assign(1, options);
+  key.append(source.data(), source.size());
+
+  auto i = this->OutputFormatCache.find(key);
+  if (i == this->OutputFormatCache.end()) {
+    i = this->OutputFormatCache
+          .emplace(key,
+                   this->ConvertToOutputFormat(source, format, useWatcomQuote))
+          .first;
+  }
+  return i->second;
+}
+
 std::string cmOutputConverter::ConvertDirectorySeparatorsForShell(
   cm::string_view source) const
 {
@@ -5,6 +5,7 @@
 #include "cmConfigure.h" // IWYU pragma: keep
 
 #include <string>
+#include <unordered_map>
 
 #include <cm/string_view>
 
@@ -53,10 +54,23 @@ public:
                                     bool useWatcomQuote = false) const;
   std::string ConvertDirectorySeparatorsForShell(cm::string_view source) const;
 
+  /**
+   * Same as ConvertToOutputFormat, but the result is memoized.  The
+   * returned reference stays valid for the lifetime of this converter.
+   * Use this for paths that are converted repeatedly, such as include
+   * and link directories.
+   */
+  std::string const& ConvertToOutputFormatCached(
+    cm::string_view source, OutputFormat output,
+    bool useWatcomQuote = false) const;
+
   //! for existing files convert to output path and short path if spaces
   std::string ConvertToOutputForExisting(const std::string& remote,
                                          OutputFormat format = SHELL,
                                          bool useWatcomQuote = false) const;
+  std::string const& ConvertToOutputForExistingCached(
+    const std::string& remote, OutputFormat format = SHELL,
+    bool useWatcomQuote = false) const;
 
   void SetLinkScriptShell(bool linkScriptShell);
 
@@ -153,8 +167,15 @@ private:
   static bool Shell_ArgumentNeedsQuotes(cm::string_view in, int flags);
   static std::string Shell_GetArgument(cm::string_view in, int flags);
 
+  std::string const& ShortPathForExisting(std::string const& remote) const;
+
   bool LinkScriptShell = false;
 
+  // Memoized ConvertToOutputFormatCached results.  Each key is the source
+  // string prefixed by a character encoding the conversion options.
+  mutable std::unordered_map<std::string, std::string> OutputFormatCache;
+  mutable std::string OutputFormatCacheKey;
+
   // The top-most directories for relative path conversion.  Both the
   // source and destination location of a relative path conversion
   // must be underneath one of these directories (both under source or
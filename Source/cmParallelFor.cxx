@@ -0,0 +1,50 @@
+/* Distributed under the OSI-approved BSD 3-Clause License.  See accompanying
+   file Copyright.txt or https://cmake.org/licensing for details.  */
+#include "cmParallelFor.h"
+
+#include <atomic>
+#include <vector>
+
+#if !defined(CMAKE_BOOTSTRAP)
+#  include <thread>
+#endif
+
+bool cmParallelFor(std::size_t count, unsigned int threads,
+                   std::function<bool(std::size_t)> const& job)
+{
+  // Each worker takes the next job not yet started.
+  std::atomic<std::size_t> next(0);
+  std::atomic<bool> ok(true);
+  auto work = [count, &job, &next, &ok]() {
+    while (ok) {
+      std::size_t const i = next++;
+      if (i >= count) {
+        break;
+      }
+      if (!job(i)) {
+        ok = false;
+      }
+    }
+  };
+
+#if !defined(CMAKE_BOOTSTRAP)
+  if (threads == 0) {
+    threads = std::thread::hardware_concurrency();
+  }
+  if (threads > count) {
+    threads = static_cast<unsigned int>(count);
+  }
+  std::vector<std::thread> workers;
+  for (unsigned int i = 1; i < threads; ++i) {
+    workers.emplace_back(work);
+  }
+  work();
+  for (std::thread& worker : workers) {
+    worker.join();
+  }
+#else
+  static_cast<void>(threads);
+  work();
+#endif
+  return ok;
+}
@@ -0,0 +1,18 @@
+/* Distributed under the OSI-approved BSD 3-Clause License.  See accompanying
+   file Copyright.txt or https://cmake.org/licensing for details.  */
+#pragma once
+
+#include "cmConfigure.h" // IWYU pragma: keep
+
+#include <cstddef>
+#include <functional>
+
+/**
+ * Run job(i) for each i from 0 to count - 1 on up to the given number of
+ * threads, the calling thread included, or one thread per processor for
+ * 0.  Each job is run exactly once, and jobs are started in order.  Once
+ * a job returns false, no further jobs are started.  Return whether all
+ * jobs were run and returned true.
+ */
+bool cmParallelFor(std::size_t count, unsigned int threads,
+                   std::function<bool(std::size_t)> const& job);
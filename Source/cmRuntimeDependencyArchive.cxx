@@ -177,6 +177,11 @@ bool cmRuntimeDependencyArchive::GetRuntimeDependencies(
   const std::vector<std::string>& libraries,
   const std::vector<std::string>& modules)
 {
+  std::vector<std::string> files = executables;
+  files.insert(files.end(), libraries.begin(), libraries.end());
+  files.insert(files.end(), modules.begin(), modules.end());
+  this->Linker->PrepareScan(files);
+
   for (auto const& exe : executables) {
     if (!this->Linker->ScanDependencies(exe, cmStateEnums::EXECUTABLE)) {
       return false;
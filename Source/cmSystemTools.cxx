@@ -23,6 +23,8 @@
 
 #include "cmSystemTools.h"
 
+#include <cm/algorithm>
+#include <cm/memory>
 #include <cm/optional>
 #include <cmext/algorithm>
 #include <cmext/string_view>
@@ -47,6 +49,14 @@
 
 #  include "cmArchiveWrite.h"
 #  include "cmLocale.h"
+#  ifdef __linux__
+#    include <climits>
+#    include <condition_variable>
+#    include <deque>
+#    include <mutex>
+#    include <set>
+#    include <thread>
+#  endif
 #  ifndef __LA_INT64_T
 #    define __LA_INT64_T la_int64_t
 #  endif
@@ -1904,13 +1914,19 @@ bool cmSystemTools::CreateTar(const std::string& outFileName,
     case TarCompressZstd:
       compress = cmArchiveWrite::CompressZstd;
       break;
+    case TarCompressZstdSeekable:
+      compress = cmArchiveWrite::CompressZstdSeekable;
+      break;
     case TarCompressNone:
       compress = cmArchiveWrite::CompressNone;
       break;
   }
 
+  // The seekable frames do not depend on the number of threads.
+  int const numThreads =
+    compress == cmArchiveWrite::CompressZstdSeekable ? 0 : 1;
   cmArchiveWrite a(fout, compress, format.empty() ? "paxr" : format,
-                   compressionLevel);
+                   compressionLevel, numThreads);
 
   if (!a.Open()) {
     cmSystemTools::Error(a.GetError());
@@ -1929,6 +1945,10 @@ bool cmSystemTools::CreateTar(const std::string& outFileName,
       tarCreatedSuccessfully = false;
     }
   }
+  if (tarCreatedSuccessfully && !a.Close()) {
+    cmSystemTools::Error(a.GetError());
+    tarCreatedSuccessfully = false;
+  }
   return tarCreatedSuccessfully;
 #else
   (void)outFileName;
@@ -2111,6 +2131,344 @@ bool copy_data(struct archive* ar, struct archive* aw)
 #  endif
 }
 
+#  ifdef __linux__
+// Writes the regular files of an archive on a pool of threads, while the
+// calling thread reads and decodes the archive.  Small files are read
+// into memory and queued, with a bound on the queued bytes.  Threads are
+// started only while queued files outnumber idle threads.  Large files
+// are written directly by the calling thread, and preallocated unless
+// they are sparse.  The file modes and times are set as
+// archive_write_disk does without the ARCHIVE_EXTRACT_PERM and
+// ARCHIVE_EXTRACT_OWNER options.
+class FileWritePool
+{
+public:
+  explicit FileWritePool(bool extractTimestamps)
+    : ExtractTimestamps(extractTimestamps)
+    // Writing files mostly waits on the disk, so allow two threads or more.
+    , MaxThreads(std::max(
+        cm::clamp(std::thread::hardware_concurrency(), 1u, 16u), 2u))
+  {
+    // archive_write_disk queries the umask by changing it, so read it
+    // before starting threads that would see the change.
+    this->Umask = umask(0);
+    umask(this->Umask);
+  }
+
+  ~FileWritePool()
+  {
+    {
+      std::lock_guard<std::mutex> lock(this->Mutex);
+      this->Stop = true;
+    }
+    this->Ready.notify_all();
+    for (std::thread& thread : this->Threads) {
+      thread.join();
+    }
+  }
+
+  FileWritePool(FileWritePool const&) = delete;
+  FileWritePool& operator=(FileWritePool const&) = delete;
+
+  // Whether the pool can write an entry.  Other entries, and paths that
+  // archive_write_disk treats specially, are left to it.
+  static bool Accepts(struct archive_entry* entry, std::string const& path)
+  {
+    if (archive_entry_filetype(entry) != AE_IFREG ||
+        archive_entry_hardlink(entry) || path.empty() || path[0] == '/' ||
+        path.back() == '/' || path.size() >= PATH_MAX) {
+      return false;
+    }
+    for (std::string const& part : cmTokenize(path, "/")) {
+      if (part == "..") {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // Read the data of an entry from the archive and write it to the path.
+  bool Write(struct archive* a, struct archive_entry* entry,
+             std::string const& path)
+  {
+    if (this->IsPending(path) && !this->Wait()) {
+      return false;
+    }
+    Job job;
+    job.Path = path;
+    job.Mode = static_cast<mode_t>(archive_entry_perm(entry) & 0777 &
+                                   ~this->Umask);
+    job.Size = archive_entry_size(entry);
+    job.Times[0].tv_nsec = UTIME_OMIT;
+    job.Times[1].tv_nsec = UTIME_OMIT;
+    if (this->ExtractTimestamps) {
+      if (archive_entry_atime_is_set(entry)) {
+        job.Times[0].tv_sec = archive_entry_atime(entry);
+        job.Times[0].tv_nsec = archive_entry_atime_nsec(entry);
+      }
+      if (archive_entry_mtime_is_set(entry)) {
+        job.Times[1].tv_sec = archive_entry_mtime(entry);
+        job.Times[1].tv_nsec = archive_entry_mtime_nsec(entry);
+      }
+    }
+    if (!this->MakeParentDirectory(path)) {
+      return false;
+    }
+
+    if (job.Size > MaxQueuedFileSize) {
+      std::string error;
+      int const fd = OpenFile(job, error);
+      if (fd >= 0 && archive_entry_sparse_count(entry) == 0) {
+        // Let the file system reserve contiguous space.  Sparse files
+        // keep their holes.
+        fallocate(fd, 0, 0, job.Size);
+      }
+      bool const read = this->ReadData(
+        a, [&job, &error, fd](__LA_INT64_T offset, const void* data,
+                              size_t size) -> bool {
+          return fd < 0 || WriteBlock(job, fd, offset, data, size, error);
+        });
+      if (fd >= 0) {
+        CloseFile(job, fd, error);
+      }
+      return read && this->SetError(error);
+    }
+
+    if (!this->ReadData(a,
+                        [&job](__LA_INT64_T offset, const void* data,
+                               size_t size) -> bool {
+                          job.Blocks.emplace_back(
+                            offset,
+                            std::string(static_cast<const char*>(data), size));
+                          job.Bytes += size;
+                          return true;
+                        })) {
+      return false;
+    }
+    std::unique_lock<std::mutex> lock(this->Mutex);
+    this->Done.wait(lock, [this, &job]() {
+      return this->Pending.empty() ||
+        this->QueuedBytes + job.Bytes <= MaxQueuedBytes;
+    });
+    if (!this->Error.empty()) {
+      return false;
+    }
+    this->QueuedBytes += job.Bytes;
+    this->Pending.insert(job.Path);
+    this->Jobs.push_back(std::move(job));
+    bool const start = this->Jobs.size() > this->Idle &&
+      this->Threads.size() < this->MaxThreads;
+    lock.unlock();
+    if (start) {
+      this->Threads.emplace_back(&FileWritePool::Run, this);
+    } else {
+      this->Ready.notify_one();
+    }
+    return true;
+  }
+
+  // Whether a file is queued or being written at the path.
+  bool IsPending(std::string const& path)
+  {
+    std::lock_guard<std::mutex> lock(this->Mutex);
+    return this->Pending.count(path) != 0;
+  }
+
+  // Wait for all queued files to be written, before other entries may
+  // replace or link to them.  Those may also replace directories, so
+  // forget which ones are known to exist.
+  bool Wait()
+  {
+    this->Directories.clear();
+    std::unique_lock<std::mutex> lock(this->Mutex);
+    this->Done.wait(lock, [this]() { return this->Pending.empty(); });
+    return this->Error.empty();
+  }
+
+  std::string GetError()
+  {
+    std::lock_guard<std::mutex> lock(this->Mutex);
+    return this->Error;
+  }
+
+private:
+  static __LA_INT64_T const MaxQueuedFileSize = __LA_INT64_T(4) << 20;
+  static size_t const MaxQueuedBytes = size_t(64) << 20;
+
+  struct Job
+  {
+    std::string Path;
+    mode_t Mode = 0;
+    __LA_INT64_T Size = 0;
+    struct timespec Times[2];
+    std::vector<std::pair<__LA_INT64_T, std::string>> Blocks;
+    size_t Bytes = 0;
+  };
+
+  bool SetError(std::string const& error)
+  {
+    if (error.empty()) {
+      return true;
+    }
+    std::lock_guard<std::mutex> lock(this->Mutex);
+    if (this->Error.empty()) {
+      this->Error = error;
+    }
+    return false;
+  }
+
+  bool MakeParentDirectory(std::string const& path)
+  {
+    std::string::size_type const slash = path.rfind('/');
+    if (slash == std::string::npos) {
+      return true;
+    }
+    std::string const dir = path.substr(0, slash);
+    if (this->Directories.count(dir)) {
+      return true;
+    }
+    cmsys::Status const status = cmSystemTools::MakeDirectory(dir);
+    if (!status) {
+      return this->SetError(cmStrCat("Cannot create directory \"", dir,
+                                     "\": ", status.GetString()));
+    }
+    this->Directories.insert(dir);
+    return true;
+  }
+
+  template <typename F>
+  bool ReadData(struct archive* a, F const& write)
+  {
+    for (;;) {
+      const void* data;
+      size_t size;
+      __LA_INT64_T offset;
+      // See archive.h definition of ARCHIVE_OK for return values.
+      int const r = archive_read_data_block(a, &data, &size, &offset);
+      if (r == ARCHIVE_EOF) {
+        return true;
+      }
+      if (!la_diagnostic(a, r)) {
+        return this->SetError("Problem reading the archive");
+      }
+      if (!write(offset, data, size)) {
+        return true;
+      }
+    }
+  }
+
+  static int OpenFile(Job const& job, std::string& error)
+  {
+    // Replace an existing file, even if it is read-only.
+    unlink(job.Path.c_str());
+    int const fd = open(job.Path.c_str(),
+                        O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, S_IWUSR);
+    if (fd < 0) {
+      error = cmStrCat("Cannot create file \"", job.Path,
+                       "\": ", cmSystemTools::GetLastSystemError());
+    }
+    return fd;
+  }
+
+  static bool WriteBlock(Job const& job, int fd, __LA_INT64_T offset,
+                         const void* data, size_t size, std::string& error)
+  {
+    const char* p = static_cast<const char*>(data);
+    while (size > 0 && error.empty()) {
+      ssize_t const n = pwrite(fd, p, size, offset);
+      if (n < 0 && errno == EINTR) {
+        continue;
+      }
+      if (n < 0) {
+        error = cmStrCat("Cannot write file \"", job.Path,
+                         "\": ", cmSystemTools::GetLastSystemError());
+        break;
+      }
+      p += n;
+      size -= static_cast<size_t>(n);
+      offset += n;
+    }
+    return error.empty();
+  }
+
+  void CloseFile(Job const& job, int fd, std::string& error) const
+  {
+    // Sparse files may end in a hole, and preallocated space beyond the
+    // data must be released.
+    if (error.empty() && ftruncate(fd, job.Size) != 0) {
+      error = cmStrCat("Cannot set the size of file \"", job.Path,
+                       "\": ", cmSystemTools::GetLastSystemError());
+    }
+    if (error.empty() && fchmod(fd, job.Mode) != 0) {
+      error = cmStrCat("Cannot set permissions on \"", job.Path,
+                       "\": ", cmSystemTools::GetLastSystemError());
+    }
+    if (error.empty() && this->ExtractTimestamps &&
+        futimens(fd, job.Times) != 0) {
+      error = cmStrCat("Cannot set modification time on \"", job.Path,
+                       "\": ", cmSystemTools::GetLastSystemError());
+    }
+    close(fd);
+  }
+
+  void Run()
+  {
+    std::unique_lock<std::mutex> lock(this->Mutex);
+    for (;;) {
+      ++this->Idle;
+      this->Ready.wait(lock,
+                       [this]() { return this->Stop || !this->Jobs.empty(); });
+      --this->Idle;
+      if (this->Jobs.empty()) {
+        return;
+      }
+      Job job = std::move(this->Jobs.front());
+      this->Jobs.pop_front();
+      lock.unlock();
+
+      std::string error;
+      int const fd = OpenFile(job, error);
+      if (fd >= 0) {
+        for (auto const& block : job.Blocks) {
+          if (!WriteBlock(job, fd, block.first, block.second.data(),
+                          block.second.size(), error)) {
+            break;
+          }
+        }
+        this->CloseFile(job, fd, error);
+      }
+
+      lock.lock();
+      if (!error.empty() && this->Error.empty()) {
+        this->Error = std::move(error);
+      }
+      this->QueuedBytes -= job.Bytes;
+      this->Pending.erase(this->Pending.find(job.Path));
+      this->Done.notify_all();
+    }
+  }
+
+  bool ExtractTimestamps;
+  unsigned int MaxThreads;
+  mode_t Umask;
+  // Directories known to exist.  Only used by the calling thread.
+  std::set<std::string> Directories;
+
+  std::mutex Mutex;
+  std::condition_variable Ready;
+  std::condition_variable Done;
+  std::deque<Job> Jobs;
+  std::multiset<std::string> Pending;
+  size_t QueuedBytes = 0;
+  std::string Error;
+  bool Stop = false;
+  // Threads waiting for a job.
+  size_t Idle = 0;
+  // Only used by the calling thread.
+  std::vector<std::thread> Threads;
+};
+#  endif
+
 bool extract_tar(const std::string& outFileName,
                  const std::vector<std::string>& files, bool verbose,
                  cmSystemTools::cmTarExtractTimestamps extractTimestamps,
@@ -2145,6 +2503,13 @@ bool extract_tar(const std::string& outFileName,
     archive_read_close(a);
     return false;
   }
+#  ifdef __linux__
+  std::unique_ptr<FileWritePool> pool;
+  if (extract) {
+    pool = cm::make_unique<FileWritePool>(
+      extractTimestamps == cmSystemTools::cmTarExtractTimestamps::Yes);
+  }
+#  endif
   for (;;) {
     r = archive_read_next_header(a, &entry);
     if (r == ARCHIVE_EOF) {
@@ -2170,6 +2535,27 @@ bool extract_tar(const std::string& outFileName,
     } else if (!extract) {
       cmSystemTools::Stdout(cmStrCat(cm_archive_entry_pathname(entry), '\n'));
     }
+#  ifdef __linux__
+    if (pool) {
+      std::string const path = cm_archive_entry_pathname(entry);
+      if (FileWritePool::Accepts(entry, path)) {
+        if (!pool->Write(a, entry, path)) {
+          cmSystemTools::Error(pool->GetError());
+          r = ARCHIVE_FATAL;
+          break;
+        }
+        continue;
+      }
+      // Other entries may replace or link to the files being written.
+      if ((archive_entry_filetype(entry) != AE_IFDIR ||
+           pool->IsPending(path)) &&
+          !pool->Wait()) {
+        cmSystemTools::Error(pool->GetError());
+        r = ARCHIVE_FATAL;
+        break;
+      }
+    }
+#  endif
     if (extract) {
       if (extractTimestamps == cmSystemTools::cmTarExtractTimestamps::Yes) {
         r = archive_write_disk_set_options(ext, ARCHIVE_EXTRACT_TIME);
@@ -2206,6 +2592,18 @@ bool extract_tar(const std::string& outFileName,
     }
   }
 
+#  ifdef __linux__
+  // Write the queued files before archive_write_disk sets the final
+  // times and permissions of directories.
+  if (pool) {
+    if (!pool->Wait() && (r == ARCHIVE_EOF || r == ARCHIVE_OK)) {
+      cmSystemTools::Error(pool->GetError());
+      r = ARCHIVE_FATAL;
+    }
+    pool.reset();
+  }
+#  endif
+
   bool error_occured = false;
   if (matching) {
     const char* p;
@@ -2864,6 +3262,146 @@ struct cmSystemToolsRPathInfo
   std::string Value;
 };
 
+// The edits that remove the RPATH and RUNPATH entries from an ELF file.
+struct cmSystemToolsRPathRemoval
+{
+  int ZeroCount = 0;
+  unsigned long ZeroPosition[2] = { 0, 0 };
+  unsigned long ZeroSize[2] = { 0, 0 };
+  unsigned long BytesBegin = 0;
+  std::vector<char> Bytes;
+};
+
+// Compute the edits from the parsed file.  ZeroCount is left at zero if
+// there is nothing to remove.
+bool PlanRemoveRPathELF(cmELF& elf, cmSystemToolsRPathRemoval& removal,
+                        std::string* emsg)
+{
+  // Get the RPATH and RUNPATH entries from it and sort them by index
+  // in the dynamic section header.
+  int se_count = 0;
+  cmELF::StringEntry const* se[2] = { nullptr, nullptr };
+  if (cmELF::StringEntry const* se_rpath = elf.GetRPath()) {
+    se[se_count++] = se_rpath;
+  }
+  if (cmELF::StringEntry const* se_runpath = elf.GetRunPath()) {
+    se[se_count++] = se_runpath;
+  }
+  if (se_count == 0) {
+    // There is no RPATH or RUNPATH anyway.
+    return true;
+  }
+  if (se_count == 2 && se[1]->IndexInSection < se[0]->IndexInSection) {
+    std::swap(se[0], se[1]);
+  }
+
+  // Obtain a copy of the dynamic entries
+  cmELF::DynamicEntryList dentries = elf.GetDynamicEntries();
+  if (dentries.empty()) {
+    // This should happen only for invalid ELF files where a DT_NULL
+    // appears before the end of the table.
+    if (emsg) {
+      *emsg = "DYNAMIC section contains a DT_NULL before the end.";
+    }
+    return false;
+  }
+
+  // Save information about the string entries to be zeroed.
+  removal.ZeroCount = se_count;
+  for (int i = 0; i < se_count; ++i) {
+    removal.ZeroPosition[i] = se[i]->Position;
+    removal.ZeroSize[i] = se[i]->Size;
+  }
+
+  // Get size of one DYNAMIC entry
+  unsigned long const sizeof_dentry =
+    elf.GetDynamicEntryPosition(1) - elf.GetDynamicEntryPosition(0);
+
+  // Adjust the entry list as necessary to remove the run path
+  unsigned long entriesErased = 0;
+  for (auto it = dentries.begin(); it != dentries.end();) {
+    if (it->first == cmELF::TagRPath || it->first == cmELF::TagRunPath) {
+      it = dentries.erase(it);
+      entriesErased++;
+      continue;
+    }
+    if (it->first == cmELF::TagMipsRldMapRel && elf.IsMIPS()) {
+      // Background: debuggers need to know the "linker map" which contains
+      // the addresses each dynamic object is loaded at. Most arches use
+      // the DT_DEBUG tag which the dynamic linker writes to (directly) and
+      // contain the location of the linker map, however on MIPS the
+      // .dynamic section is always read-only so this is not possible. MIPS
+      // objects instead contain a DT_MIPS_RLD_MAP tag which contains the
+      // address where the dynamic linker will write to (an indirect
+      // version of DT_DEBUG). Since this doesn't work when using PIE, a
+      // relative equivalent was created - DT_MIPS_RLD_MAP_REL. Since this
+      // version contains a relative offset, moving it changes the
+      // calculated address. This may cause the dynamic linker to write
+      // into memory it should not be changing.
+      //
+      // To fix this, we adjust the value of DT_MIPS_RLD_MAP_REL here. If
+      // we move it up by n bytes, we add n bytes to the value of this tag.
+      it->second += entriesErased * sizeof_dentry;
+    }
+
+    it++;
+  }
+
+  // Encode new entries list
+  removal.Bytes = elf.EncodeDynamicEntries(dentries);
+  removal.BytesBegin = elf.GetDynamicEntryPosition(0);
+  return true;
+}
+
+bool ApplyRemoveRPathELF(std::string const& file,
+                         cmSystemToolsRPathRemoval const& removal,
+                         std::string* emsg)
+{
+  // Open the file for update.
+  cmsys::ofstream f(file.c_str(),
+                    std::ios::in | std::ios::out | std::ios::binary);
+  if (!f) {
+    if (emsg) {
+      *emsg = "Error opening file for update.";
+    }
+    return false;
+  }
+
+  // Write the new DYNAMIC table header.
+  if (!f.seekp(removal.BytesBegin)) {
+    if (emsg) {
+      *emsg = "Error seeking to DYNAMIC table header for RPATH.";
+    }
+    return false;
+  }
+  if (!f.write(removal.Bytes.data(), removal.Bytes.size())) {
+    if (emsg) {
+      *emsg = "Error replacing DYNAMIC table header.";
+    }
+    return false;
+  }
+
+  // Fill the RPATH and RUNPATH strings with zero bytes.
+  for (int i = 0; i < removal.ZeroCount; ++i) {
+    if (!f.seekp(removal.ZeroPosition[i])) {
+      if (emsg) {
+        *emsg = "Error seeking to RPATH position.";
+      }
+      return false;
+    }
+    for (unsigned long j = 0; j < removal.ZeroSize[i]; ++j) {
+      f << '\0';
+    }
+    if (!f) {
+      if (emsg) {
+        *emsg = "Error writing the empty rpath string to the file.";
+      }
+      return false;
+    }
+  }
+  return true;
+}
+
 using EmptyCallback = std::function<bool(std::string*, const cmELF&)>;
 using AdjustCallback = std::function<bool(
   cm::optional<std::string>&, const std::string&, const char*, std::string*)>;
@@ -2879,6 +3417,7 @@ cm::optional<bool> AdjustRPathELF(std::string const& file,
   int rp_count = 0;
   bool remove_rpath = true;
   cmSystemToolsRPathInfo rp[2];
+  cmSystemToolsRPathRemoval removal;
   {
     // Parse the ELF binary.
     cmELF elf(file.c_str());
@@ -2948,6 +3487,13 @@ cm::optional<bool> AdjustRPathELF(std::string const& file,
         remove_rpath = false;
       }
     }
+
+    // If the resulting rpath is empty, just remove the entire entry
+    // instead.  Use the file as parsed already.
+    if (rp_count > 0 && remove_rpath &&
+        !PlanRemoveRPathELF(elf, removal, emsg)) {
+      return false;
+    }
   }
 
   // If no runtime path needs to be changed, we are done.
@@ -2955,9 +3501,17 @@ cm::optional<bool> AdjustRPathELF(std::string const& file,
     return true;
   }
 
-  // If the resulting rpath is empty, just remove the entire entry instead.
   if (remove_rpath) {
-    return cmSystemTools::RemoveRPath(file, emsg, changed);
+    if (removal.ZeroCount == 0) {
+      return true;
+    }
+    if (!ApplyRemoveRPathELF(file, removal, emsg)) {
+      return false;
+    }
+    if (changed) {
+      *changed = true;
+    }
+    return true;
   }
 
   {
@@ -3405,136 +3959,25 @@ static cm::optional<bool> RemoveRPathELF(std::string const& file,
   if (removed) {
     *removed = false;
   }
-  int zeroCount = 0;
-  unsigned long zeroPosition[2] = { 0, 0 };
-  unsigned long zeroSize[2] = { 0, 0 };
-  unsigned long bytesBegin = 0;
-  std::vector<char> bytes;
+  cmSystemToolsRPathRemoval removal;
   {
     // Parse the ELF binary.
     cmELF elf(file.c_str());
     if (!elf) {
       return cm::nullopt; // Not a valid ELF file.
     }
-
-    // Get the RPATH and RUNPATH entries from it and sort them by index
-    // in the dynamic section header.
-    int se_count = 0;
-    cmELF::StringEntry const* se[2] = { nullptr, nullptr };
-    if (cmELF::StringEntry const* se_rpath = elf.GetRPath()) {
-      se[se_count++] = se_rpath;
-    }
-    if (cmELF::StringEntry const* se_runpath = elf.GetRunPath()) {
-      se[se_count++] = se_runpath;
-    }
-    if (se_count == 0) {
-      // There is no RPATH or RUNPATH anyway.
-      return true;
-    }
-    if (se_count == 2 && se[1]->IndexInSection < se[0]->IndexInSection) {
-      std::swap(se[0], se[1]);
-    }
-
-    // Obtain a copy of the dynamic entries
-    cmELF::DynamicEntryList dentries = elf.GetDynamicEntries();
-    if (dentries.empty()) {
-      // This should happen only for invalid ELF files where a DT_NULL
-      // appears before the end of the table.
-      if (emsg) {
-        *emsg = "DYNAMIC section contains a DT_NULL before the end.";
-      }
+    if (!PlanRemoveRPathELF(elf, removal, emsg)) {
       return false;
     }
-
-    // Save information about the string entries to be zeroed.
-    zeroCount = se_count;
-    for (int i = 0; i < se_count; ++i) {
-      zeroPosition[i] = se[i]->Position;
-      zeroSize[i] = se[i]->Size;
-    }
-
-    // Get size of one DYNAMIC entry
-    unsigned long const sizeof_dentry =
-      elf.GetDynamicEntryPosition(1) - elf.GetDynamicEntryPosition(0);
-
-    // Adjust the entry list as necessary to remove the run path
-    unsigned long entriesErased = 0;
-    for (auto it = dentries.begin(); it != dentries.end();) {
-      if (it->first == cmELF::TagRPath || it->first == cmELF::TagRunPath) {
-        it = dentries.erase(it);
-        entriesErased++;
-        continue;
-      }
-      if (it->first == cmELF::TagMipsRldMapRel && elf.IsMIPS()) {
-        // Background: debuggers need to know the "linker map" which contains
-        // the addresses each dynamic object is loaded at. Most arches use
-        // the DT_DEBUG tag which the dynamic linker writes to (directly) and
-        // contain the location of the linker map, however on MIPS the
-        // .dynamic section is always read-only so this is not possible. MIPS
-        // objects instead contain a DT_MIPS_RLD_MAP tag which contains the
-        // address where the dynamic linker will write to (an indirect
-        // version of DT_DEBUG). Since this doesn't work when using PIE, a
-        // relative equivalent was created - DT_MIPS_RLD_MAP_REL. Since this
-        // version contains a relative offset, moving it changes the
-        // calculated address. This may cause the dynamic linker to write
-        // into memory it should not be changing.
-        //
-        // To fix this, we adjust the value of DT_MIPS_RLD_MAP_REL here. If
-        // we move it up by n bytes, we add n bytes to the value of this tag.
-        it->second += entriesErased * sizeof_dentry;
-      }
-
-      it++;
-    }
-
-    // Encode new entries list
-    bytes = elf.EncodeDynamicEntries(dentries);
-    bytesBegin = elf.GetDynamicEntryPosition(0);
   }
-
-  // Open the file for update.
-  cmsys::ofstream f(file.c_str(),
-                    std::ios::in | std::ios::out | std::ios::binary);
-  if (!f) {
-    if (emsg) {
-      *emsg = "Error opening file for update.";
-    }
-    return false;
-  }
-
-  // Write the new DYNAMIC table header.
-  if (!f.seekp(bytesBegin)) {
-    if (emsg) {
-      *emsg = "Error seeking to DYNAMIC table header for RPATH.";
-    }
-    return false;
+  if (removal.ZeroCount == 0) {
+    // There is no RPATH or RUNPATH anyway.
+    return true;
   }
-  if (!f.write(bytes.data(), bytes.size())) {
-    if (emsg) {
-      *emsg = "Error replacing DYNAMIC table header.";
-    }
+  if (!ApplyRemoveRPathELF(file, removal, emsg)) {
     return false;
   }
 
-  // Fill the RPATH and RUNPATH strings with zero bytes.
-  for (int i = 0; i < zeroCount; ++i) {
-    if (!f.seekp(zeroPosition[i])) {
-      if (emsg) {
-        *emsg = "Error seeking to RPATH position.";
-      }
-      return false;
-    }
-    for (unsigned long j = 0; j < zeroSize[i]; ++j) {
-      f << '\0';
-    }
-    if (!f) {
-      if (emsg) {
-        *emsg = "Error writing the empty rpath string to the file.";
-      }
-      return false;
-    }
-  }
-
   // Everything was updated successfully.
   if (removed) {
     *removed = true;
@@ -3584,6 +4027,51 @@ bool cmSystemTools::RemoveRPath(std::string const& file, std::string* emsg,
   return true;
 }
 
+bool cmSystemTools::StripELF(std::string const& file, bool* stripped)
+{
+  if (stripped) {
+    *stripped = false;
+  }
+  std::vector<char> content;
+  {
+    cmELF elf(file.c_str());
+    if (!elf || !elf.EncodeStripped(content)) {
+      return false;
+    }
+  }
+  if (content.empty()) {
+    // There is nothing to strip.
+    return true;
+  }
+
+  // Write the result beside the file and move it into place so that a
+  // failure never leaves the file half written.
+  mode_t mode;
+  if (!cmSystemTools::GetPermissions(file, mode)) {
+    return false;
+  }
+  std::string const temp =
+    cmStrCat(file, ".strip", cmSystemTools::RandomSeed());
+  {
+    cmsys::ofstream fout(temp.c_str(), std::ios::out | std::ios::binary);
+    fout.write(content.data(), static_cast<std::streamsize>(content.size()));
+    fout.close();
+    if (!fout) {
+      cmSystemTools::RemoveFile(temp);
+      return false;
+    }
+  }
+  if (!cmSystemTools::SetPermissions(temp, mode) ||
+      !cmSystemTools::RenameFile(temp, file)) {
+    cmSystemTools::RemoveFile(temp);
+    return false;
+  }
+  if (stripped) {
+    *stripped = true;
+  }
+  return true;
+}
+
 bool cmSystemTools::CheckRPath(std::string const& file,
                                std::string const& newRPath)
 {
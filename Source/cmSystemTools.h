@@ -484,6 +484,7 @@ public:
     TarCompressBZip2,
     TarCompressXZ,
     TarCompressZstd,
+    TarCompressZstdSeekable,
     TarCompressNone
   };
 
@@ -559,6 +560,12 @@ public:
   static bool RemoveRPath(std::string const& file, std::string* emsg = nullptr,
                           bool* removed = nullptr);
 
+  /** Try to remove the symbol table and debugging information from an
+      ELF binary without running a strip tool.  Returns false if the
+      file is not an ELF binary whose layout allows this, or it could
+      not be replaced.  */
+  static bool StripELF(std::string const& file, bool* stripped = nullptr);
+
   /** Check whether the RPATH in an ELF binary contains the path
       given.  */
   static bool CheckRPath(std::string const& file, std::string const& newRPath);
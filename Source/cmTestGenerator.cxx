@@ -7,6 +7,7 @@
 #include <iterator>
 #include <memory>
 #include <ostream>
+#include <set>
 #include <string>
 #include <utility>
 #include <vector>
@@ -26,6 +27,7 @@
 #include "cmStringAlgorithms.h"
 #include "cmSystemTools.h"
 #include "cmTest.h"
+#include "cmTestManifest.h"
 #include "cmValue.h"
 
 namespace /* anonymous */
@@ -101,6 +103,11 @@ cmTest* cmTestGenerator::GetTest() const
   return this->Test;
 }
 
+void cmTestGenerator::SetManifest(cmTestManifest* manifest)
+{
+  this->Manifest = manifest;
+}
+
 void cmTestGenerator::GenerateScriptConfigs(std::ostream& os, Indent indent)
 {
   // Create the tests.
@@ -147,9 +154,11 @@ void cmTestGenerator::GenerateScriptForConfig(std::ostream& os,
     os << indent << "add_test(" << this->Test->GetName() << " ";
   }
 
-  // Evaluate command line arguments
+  // Evaluate command line arguments, noting the targets they refer to.
+  std::set<cmGeneratorTarget*> targets;
   cmList argv{
-    this->EvaluateCommandLineArguments(this->Test->GetCommand(), ge, config),
+    this->EvaluateCommandLineArguments(this->Test->GetCommand(), ge, config,
+                                       &targets),
     // Expand arguments if COMMAND_EXPAND_LISTS is set
     this->Test->GetCommandExpandLists() ? cmList::ExpandElements::Yes
                                         : cmList::ExpandElements::No,
@@ -160,6 +169,9 @@ void cmTestGenerator::GenerateScriptForConfig(std::ostream& os,
     argv.emplace_back();
   }
 
+  // Collect the final arguments for the test manifest.
+  std::vector<std::string> testArgs{ this->Test->GetName() };
+
   // Check whether the command executable is a target whose name is to
   // be translated.
   std::string exe = argv[0];
@@ -167,8 +179,9 @@ void cmTestGenerator::GenerateScriptForConfig(std::ostream& os,
   if (target && target->GetType() == cmStateEnums::EXECUTABLE) {
     // Use the target file on disk.
     exe = target->GetFullPath(config);
+    targets.insert(target);
 
-    auto addLauncher = [this, &config, &ge, &os,
+    auto addLauncher = [this, &config, &ge, &os, &testArgs,
                         target](std::string const& propertyName) {
       cmValue launcher = target->GetProperty(propertyName);
       if (!cmNonempty(launcher)) {
@@ -197,6 +210,7 @@ void cmTestGenerator::GenerateScriptForConfig(std::ostream& os,
         std::string launcherExe(launcherWithArgs[0]);
         cmSystemTools::ConvertToUnixSlashes(launcherExe);
         os << cmOutputConverter::EscapeForCMake(launcherExe) << " ";
+        testArgs.emplace_back(std::move(launcherExe));
         for (std::string const& arg :
              cmMakeRange(launcherWithArgs).advance(1)) {
           if (arg.empty()) {
@@ -204,6 +218,7 @@ void cmTestGenerator::GenerateScriptForConfig(std::ostream& os,
           } else {
             os << cmOutputConverter::EscapeForCMake(arg) << " ";
           }
+          testArgs.emplace_back(arg);
         }
       }
     };
@@ -223,9 +238,11 @@ void cmTestGenerator::GenerateScriptForConfig(std::ostream& os,
 
   // Generate the command line with full escapes.
   os << cmOutputConverter::EscapeForCMake(exe);
+  testArgs.emplace_back(std::move(exe));
 
   for (auto const& arg : cmMakeRange(argv).advance(1)) {
     os << " " << cmOutputConverter::EscapeForCMake(arg);
+    testArgs.emplace_back(arg);
   }
 
   // Finish the test command.
@@ -239,13 +256,26 @@ void cmTestGenerator::GenerateScriptForConfig(std::ostream& os,
     os << indent << "set_tests_properties(" << this->Test->GetName()
        << " PROPERTIES ";
   }
+  std::vector<std::string> propertyArgs{ this->Test->GetName(),
+                                         "PROPERTIES" };
   for (auto const& i : this->Test->GetProperties().GetList()) {
-    os << " " << i.first << " "
-       << cmOutputConverter::EscapeForCMake(
-            ge.Parse(i.second)->Evaluate(this->LG, config));
+    std::string value = ge.Parse(i.second)->Evaluate(this->LG, config);
+    os << " " << i.first << " " << cmOutputConverter::EscapeForCMake(value);
+    propertyArgs.emplace_back(i.first);
+    propertyArgs.emplace_back(std::move(value));
+  }
+  // Record the targets so that ctest can tell whether changes to their
+  // sources affect the test.  Imported targets have no sources here.
+  for (cmGeneratorTarget* t : targets) {
+    if (!t->IsImported()) {
+      this->ImpactTargets.insert(t);
+    }
   }
   this->GenerateInternalProperties(os);
   os << ")\n";
+
+  this->AddManifestRecords(config, false, quote_test_name,
+                           std::move(testArgs), std::move(propertyArgs));
 }
 
 void cmTestGenerator::GenerateScriptNoConfig(std::ostream& os, Indent indent)
@@ -265,6 +295,9 @@ void cmTestGenerator::GenerateScriptNoConfig(std::ostream& os, Indent indent)
     os << indent << "add_test(" << this->Test->GetName()
        << " NOT_AVAILABLE)\n";
   }
+
+  this->AddManifestRecords(std::string(), true, quote_test_name,
+                           { this->Test->GetName(), "NOT_AVAILABLE" }, {});
 }
 
 bool cmTestGenerator::NeedsScriptNoConfig() const
@@ -301,7 +334,16 @@ void cmTestGenerator::GenerateOldStyle(std::ostream& fout, Indent indent)
          << "\"";
   }
 
+  // The manifest can only represent arguments that the script below
+  // passes through unchanged.
+  std::vector<std::string> testArgs{ this->Test->GetName() };
+  bool literalArgs = cmTestManifest::IsLiteralQuotedArgument(exe);
+  testArgs.emplace_back(std::move(exe));
+
   for (std::string const& arg : cmMakeRange(command).advance(1)) {
+    literalArgs = literalArgs && arg.find_first_of("$\\") == std::string::npos;
+    testArgs.emplace_back(arg);
+
     // Just double-quote all arguments so they are re-parsed
     // correctly by the test system.
     fout << " \"";
@@ -326,47 +368,135 @@ void cmTestGenerator::GenerateOldStyle(std::ostream& fout, Indent indent)
     fout << indent << "set_tests_properties(" << this->Test->GetName()
          << " PROPERTIES ";
   }
+  std::vector<std::string> propertyArgs{ this->Test->GetName(),
+                                         "PROPERTIES" };
   for (auto const& i : this->Test->GetProperties().GetList()) {
     fout << " " << i.first << " "
          << cmOutputConverter::EscapeForCMake(i.second);
+    propertyArgs.emplace_back(i.first);
+    propertyArgs.emplace_back(i.second);
   }
   this->GenerateInternalProperties(fout);
   fout << ")\n";
+
+  if (this->Manifest && !literalArgs) {
+    this->Manifest->SetUnsupported();
+  }
+  this->AddManifestRecords(std::string(), false, quote_test_name,
+                           std::move(testArgs), std::move(propertyArgs));
 }
 
 void cmTestGenerator::GenerateInternalProperties(std::ostream& os)
 {
-  cmListFileBacktrace bt = this->Test->GetBacktrace();
-  if (bt.Empty()) {
+  std::string const triples = this->GetInternalProperties();
+  if (triples.empty()) {
     return;
   }
 
   os << " "
      << "_BACKTRACE_TRIPLES"
-     << " \"";
+     << " \"" << triples << '"';
+}
 
+std::string cmTestGenerator::GetInternalProperties() const
+{
+  std::string triples;
+  cmListFileBacktrace bt = this->Test->GetBacktrace();
   bool prependTripleSeparator = false;
   while (!bt.Empty()) {
     const auto& entry = bt.Top();
     if (prependTripleSeparator) {
-      os << ";";
+      triples += ";";
     }
-    os << entry.FilePath << ";" << entry.Line << ";" << entry.Name;
+    triples += cmStrCat(entry.FilePath, ';', entry.Line, ';', entry.Name);
     bt = bt.Pop();
     prependTripleSeparator = true;
   }
+  return triples;
+}
+
+void cmTestGenerator::AddManifestRecords(std::string const& config,
+                                         bool noConfig, bool quoteTestName,
+                                         std::vector<std::string> testArgs,
+                                         std::vector<std::string> propertyArgs)
+{
+  if (!this->Manifest) {
+    return;
+  }
+
+  // The test name must read back from the script as a single argument.
+  std::string const& name = this->Test->GetName();
+  if (quoteTestName
+        ? (!name.empty() && (name.front() == '\n' || name.front() == '\r'))
+        : !cmTestManifest::IsLiteralUnquotedArgument(name)) {
+    this->Manifest->SetUnsupported();
+    return;
+  }
 
-  os << '"';
+  // Match the condition of the enclosing block in the script.
+  using Condition = cmTestManifest::Condition;
+  Condition cond = Condition::Always;
+  std::vector<std::string> configs;
+  if (noConfig) {
+    cond = Condition::NoConfig;
+    for (std::string const& cfgType : *this->ConfigurationTypes) {
+      if (this->GeneratesForConfig(cfgType)) {
+        configs.emplace_back(cfgType);
+      }
+    }
+  } else if (this->ActionsPerConfig && !this->ConfigurationTypes->empty()) {
+    cond = Condition::AnyConfig;
+    configs.emplace_back(config);
+  } else if (!this->Configurations.empty()) {
+    cond = Condition::AnyConfig;
+    configs = this->Configurations;
+  }
+  if (!std::all_of(configs.begin(), configs.end(),
+                   cmTestManifest::IsLiteralConfigName)) {
+    this->Manifest->SetUnsupported();
+    return;
+  }
+
+  this->Manifest->AddRecord(cmTestManifest::Command::AddTest, cond, configs)
+    .Args = std::move(testArgs);
+  if (propertyArgs.empty()) {
+    return;
+  }
+
+  for (std::size_t i = 2; i < propertyArgs.size(); i += 2) {
+    if (!cmTestManifest::IsLiteralUnquotedArgument(propertyArgs[i])) {
+      this->Manifest->SetUnsupported();
+      return;
+    }
+  }
+  std::string triples = this->GetInternalProperties();
+  if (!triples.empty()) {
+    if (!cmTestManifest::IsLiteralQuotedArgument(triples)) {
+      this->Manifest->SetUnsupported();
+      return;
+    }
+    propertyArgs.emplace_back("_BACKTRACE_TRIPLES");
+    propertyArgs.emplace_back(std::move(triples));
+  }
+  this->Manifest
+    ->AddRecord(cmTestManifest::Command::SetTestsProperties, cond,
+                std::move(configs))
+    .Args = std::move(propertyArgs);
 }
 
 std::vector<std::string> cmTestGenerator::EvaluateCommandLineArguments(
   const std::vector<std::string>& argv, cmGeneratorExpression& ge,
-  const std::string& config) const
+  const std::string& config, std::set<cmGeneratorTarget*>* targets) const
 {
   // Evaluate executable name and arguments
   auto evaluatedRange =
     cmMakeRange(argv).transform([&](const std::string& arg) {
-      return ge.Parse(arg)->Evaluate(this->LG, config);
+      auto cge = ge.Parse(arg);
+      std::string value = cge->Evaluate(this->LG, config);
+      if (targets) {
+        targets->insert(cge->GetTargets().begin(), cge->GetTargets().end());
+      }
+      return value;
     });
 
   return { evaluatedRange.begin(), evaluatedRange.end() };
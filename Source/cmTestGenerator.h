@@ -5,14 +5,17 @@
 #include "cmConfigure.h" // IWYU pragma: keep
 
 #include <iosfwd>
+#include <set>
 #include <string>
 #include <vector>
 
 #include "cmScriptGenerator.h"
 
 class cmGeneratorExpression;
+class cmGeneratorTarget;
 class cmLocalGenerator;
 class cmTest;
+class cmTestManifest;
 
 /** \class cmTestGenerator
  * \brief Support class for generating install scripts.
@@ -36,11 +39,27 @@ public:
 
   cmTest* GetTest() const;
 
+  /** Also record the generated commands in the given manifest.  */
+  void SetManifest(cmTestManifest* manifest);
+
+  /** Targets the generated test commands refer to, by name or through
+      generator expressions, in any configuration.  */
+  std::set<cmGeneratorTarget*> const& GetImpactTargets() const
+  {
+    return this->ImpactTargets;
+  }
+
 private:
   void GenerateInternalProperties(std::ostream& os);
+  std::string GetInternalProperties() const;
+  void AddManifestRecords(std::string const& config, bool noConfig,
+                          bool quoteTestName,
+                          std::vector<std::string> testArgs,
+                          std::vector<std::string> propertyArgs);
   std::vector<std::string> EvaluateCommandLineArguments(
     const std::vector<std::string>& argv, cmGeneratorExpression& ge,
-    const std::string& config) const;
+    const std::string& config,
+    std::set<cmGeneratorTarget*>* targets = nullptr) const;
 
 protected:
   void GenerateScriptConfigs(std::ostream& os, Indent indent) override;
@@ -53,5 +72,7 @@ protected:
 
   cmLocalGenerator* LG;
   cmTest* Test;
+  cmTestManifest* Manifest = nullptr;
+  std::set<cmGeneratorTarget*> ImpactTargets;
   bool TestGenerated;
 };
@@ -0,0 +1,156 @@
+/* Distributed under the OSI-approved BSD 3-Clause License.  See accompanying
+   file Copyright.txt or https://cmake.org/licensing for details.  */
+#include "cmTestImpact.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "cmsys/FStream.hxx"
+
+#include "cmGeneratedFileStream.h"
+#include "cmStringAlgorithms.h"
+#include "cmSystemTools.h"
+
+namespace {
+// The file starts with this line.  Readers reject any other.
+char const kImpactHeader[] = "# CTest impact file, version 2";
+}
+
+std::string cmTestImpact::GetFileName(std::string const& dir)
+{
+  return cmStrCat(dir, "/CTestImpact.txt");
+}
+
+cmTestImpact::Target& cmTestImpact::AddTarget(std::string const& name)
+{
+  return this->Targets[name];
+}
+
+std::set<std::string>& cmTestImpact::AddTest(std::string const& name)
+{
+  return this->Tests[name];
+}
+
+std::set<std::string> const* cmTestImpact::GetTestTargets(
+  std::string const& name) const
+{
+  auto const it = this->Tests.find(name);
+  return it != this->Tests.end() ? &it->second : nullptr;
+}
+
+bool cmTestImpact::IsAffected(std::string const& target,
+                              std::set<std::string> const& changed) const
+{
+  auto const it = this->Targets.find(target);
+  if (it == this->Targets.end()) {
+    return true;
+  }
+  if (this->HasChangedSource(target, changed)) {
+    return true;
+  }
+  // The links are the closure of the target's link implementation.
+  return std::any_of(it->second.Links.begin(), it->second.Links.end(),
+                     [this, &changed](std::string const& link) {
+                       return this->HasChangedSource(link, changed);
+                     });
+}
+
+bool cmTestImpact::HasChangedSource(std::string const& target,
+                                    std::set<std::string> const& changed) const
+{
+  auto const it = this->Targets.find(target);
+  if (it == this->Targets.end()) {
+    return false;
+  }
+  std::set<std::string> const& sources = it->second.Sources;
+  // Walk the smaller of the two sets.
+  if (changed.size() < sources.size()) {
+    return std::any_of(changed.begin(), changed.end(),
+                       [&sources](std::string const& file) {
+                         return sources.count(file) != 0;
+                       });
+  }
+  return std::any_of(sources.begin(), sources.end(),
+                     [&changed](std::string const& file) {
+                       return changed.count(file) != 0;
+                     });
+}
+
+void cmTestImpact::Write(std::string const& dir) const
+{
+  std::string const file = cmTestImpact::GetFileName(dir);
+  if (this->Tests.empty()) {
+    if (cmSystemTools::FileExists(file)) {
+      cmSystemTools::RemoveFile(file);
+    }
+    return;
+  }
+
+  cmGeneratedFileStream fout(file);
+  fout.SetCopyIfDifferent(true);
+  fout << kImpactHeader << '\n';
+  for (auto const& test : this->Tests) {
+    fout << "test " << test.first << '\n';
+    for (std::string const& target : test.second) {
+      fout << "uses " << target << '\n';
+    }
+  }
+  for (auto const& target : this->Targets) {
+    fout << "target " << target.first << '\n';
+    for (std::string const& link : target.second.Links) {
+      fout << "link " << link << '\n';
+    }
+    for (std::string const& source : target.second.Sources) {
+      fout << "source " << source << '\n';
+    }
+  }
+}
+
+bool cmTestImpact::Load(std::string const& dir)
+{
+  this->Targets.clear();
+
+  cmsys::ifstream fin(cmTestImpact::GetFileName(dir).c_str());
+  std::string line;
+  if (!fin || !std::getline(fin, line) || line != kImpactHeader) {
+    return false;
+  }
+
+  std::map<std::string, Target> targets;
+  std::map<std::string, std::set<std::string>> tests;
+  Target* target = nullptr;
+  std::set<std::string>* test = nullptr;
+  while (std::getline(fin, line)) {
+    std::string::size_type const space = line.find(' ');
+    if (space == std::string::npos) {
+      return false;
+    }
+    std::string value = line.substr(space + 1);
+    if (cmHasLiteralPrefix(line, "test ")) {
+      test = &tests[std::move(value)];
+      target = nullptr;
+    } else if (cmHasLiteralPrefix(line, "uses ")) {
+      if (!test) {
+        return false;
+      }
+      test->insert(std::move(value));
+    } else if (cmHasLiteralPrefix(line, "target ")) {
+      target = &targets[std::move(value)];
+      test = nullptr;
+    } else if (!target) {
+      return false;
+    } else if (cmHasLiteralPrefix(line, "link ")) {
+      target->Links.insert(std::move(value));
+    } else if (cmHasLiteralPrefix(line, "source ")) {
+      target->Sources.insert(std::move(value));
+    } else {
+      return false;
+    }
+  }
+  if (fin.bad()) {
+    return false;
+  }
+  this->Targets = std::move(targets);
+  this->Tests = std::move(tests);
+  return true;
+}
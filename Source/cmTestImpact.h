@@ -0,0 +1,60 @@
+/* Distributed under the OSI-approved BSD 3-Clause License.  See accompanying
+   file Copyright.txt or https://cmake.org/licensing for details.  */
+#pragma once
+
+#include "cmConfigure.h" // IWYU pragma: keep
+
+#include <map>
+#include <set>
+#include <string>
+
+/** \class cmTestImpact
+ * \brief Sources on which the tests of a build directory depend.
+ *
+ * The generator records the targets each test refers to and, for each
+ * of those targets, its source files and the targets it links to.  ctest
+ * reads this to select the tests affected by a set of changed files.
+ */
+class cmTestImpact
+{
+public:
+  struct Target
+  {
+    std::set<std::string> Sources;
+    std::set<std::string> Links;
+  };
+
+  /** Name of the impact file in a build directory.  */
+  static std::string GetFileName(std::string const& dir);
+
+  /** Get the record of a target, adding it if needed.  */
+  Target& AddTarget(std::string const& name);
+
+  /** Get the targets a test refers to, adding the test if needed.  */
+  std::set<std::string>& AddTest(std::string const& name);
+
+  /** The targets a test refers to, or null if the test was not recorded.  */
+  std::set<std::string> const* GetTestTargets(std::string const& name) const;
+
+  bool IsEmpty() const { return this->Tests.empty(); }
+
+  /** Whether the target, or a target it links to, has one of the given
+      sources.  The paths must be in the form cmSystemTools::GetRealPath
+      produces for a full path.  A target that was not recorded is always affected.  */
+  bool IsAffected(std::string const& target,
+                  std::set<std::string> const& changed) const;
+
+  /** Write the impact file to the directory, or remove a stale file if
+      nothing was recorded.  */
+  void Write(std::string const& dir) const;
+
+  /** Load the impact file from the directory.  */
+  bool Load(std::string const& dir);
+
+private:
+  bool HasChangedSource(std::string const& target,
+                        std::set<std::string> const& changed) const;
+
+  std::map<std::string, Target> Targets;
+  std::map<std::string, std::set<std::string>> Tests;
+};
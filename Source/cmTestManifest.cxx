@@ -0,0 +1,317 @@
+/* Distributed under the OSI-approved BSD 3-Clause License.  See accompanying
+   file Copyright.txt or https://cmake.org/licensing for details.  */
+#include "cmTestManifest.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <ios>
+#include <iterator>
+#include <utility>
+
+#include "cmsys/FStream.hxx"
+
+#include "cmCryptoHash.h"
+#include "cmFileTime.h"
+#include "cmGeneratedFileStream.h"
+#include "cmStringAlgorithms.h"
+#include "cmSystemTools.h"
+
+namespace {
+// The manifest starts with this magic string followed by the format
+// version.  Readers reject any other version.
+char const kManifestMagic[] = "CTestManifest";
+std::uint32_t const kManifestVersion = 2;
+
+std::string ScriptName(std::string const& dir)
+{
+  return cmStrCat(dir, "/CTestTestfile.cmake");
+}
+
+std::string HashScript(std::string const& script)
+{
+  cmCryptoHash hasher(cmCryptoHash::AlgoSHA1);
+  return hasher.HashString(script);
+}
+
+bool ReadWholeFile(std::string const& path, std::string& content,
+                   std::ios::openmode mode)
+{
+  cmsys::ifstream fin(path.c_str(), mode);
+  if (!fin) {
+    return false;
+  }
+  content.assign(std::istreambuf_iterator<char>(fin),
+                 std::istreambuf_iterator<char>());
+  return !fin.bad();
+}
+
+void AppendInteger(std::string& out, std::uint32_t value)
+{
+  // Always little-endian so the file does not depend on the host.
+  for (int i = 0; i < 4; ++i) {
+    out += static_cast<char>((value >> (8 * i)) & 0xff);
+  }
+}
+
+void AppendInteger64(std::string& out, std::uint64_t value)
+{
+  AppendInteger(out, static_cast<std::uint32_t>(value & 0xffffffff));
+  AppendInteger(out, static_cast<std::uint32_t>(value >> 32));
+}
+
+// The size and modification time of a script.  A manifest recording the
+// same values as the current script is up to date without hashing it.
+struct ScriptStamp
+{
+  std::uint64_t Size = 0;
+  std::uint64_t Time = 0;
+
+  bool Load(std::string const& path)
+  {
+    cmFileTime time;
+    if (!time.Load(path)) {
+      return false;
+    }
+    this->Size = cmSystemTools::FileLength(path);
+    this->Time = static_cast<std::uint64_t>(time.GetTime());
+    return true;
+  }
+};
+
+void AppendString(std::string& out, cm::string_view value)
+{
+  AppendInteger(out, static_cast<std::uint32_t>(value.size()));
+  out.append(value.data(), value.size());
+}
+
+void AppendStrings(std::string& out, std::vector<std::string> const& values)
+{
+  AppendInteger(out, static_cast<std::uint32_t>(values.size()));
+  for (std::string const& value : values) {
+    AppendString(out, value);
+  }
+}
+
+class ManifestReader
+{
+public:
+  ManifestReader(std::string const& data, std::string::size_type pos)
+    : Data(data)
+    , Pos(pos)
+  {
+  }
+
+  bool ReadInteger(std::uint32_t& value)
+  {
+    if (this->Data.size() - this->Pos < 4) {
+      return false;
+    }
+    value = 0;
+    for (int i = 0; i < 4; ++i) {
+      value |= static_cast<std::uint32_t>(
+                 static_cast<unsigned char>(this->Data[this->Pos + i]))
+        << (8 * i);
+    }
+    this->Pos += 4;
+    return true;
+  }
+
+  bool ReadInteger64(std::uint64_t& value)
+  {
+    std::uint32_t low;
+    std::uint32_t high;
+    if (!this->ReadInteger(low) || !this->ReadInteger(high)) {
+      return false;
+    }
+    value = (static_cast<std::uint64_t>(high) << 32) | low;
+    return true;
+  }
+
+  bool ReadByte(unsigned char& value)
+  {
+    if (this->Pos >= this->Data.size()) {
+      return false;
+    }
+    value = static_cast<unsigned char>(this->Data[this->Pos++]);
+    return true;
+  }
+
+  bool ReadString(std::string& value)
+  {
+    std::uint32_t size;
+    if (!this->ReadInteger(size) || this->Data.size() - this->Pos < size) {
+      return false;
+    }
+    value.assign(this->Data, this->Pos, size);
+    this->Pos += size;
+    return true;
+  }
+
+  bool ReadStrings(std::vector<std::string>& values)
+  {
+    std::uint32_t count;
+    if (!this->ReadInteger(count) || this->Data.size() - this->Pos < count) {
+      return false;
+    }
+    values.resize(count);
+    return std::all_of(values.begin(), values.end(),
+                       [this](std::string& v) { return this->ReadString(v); });
+  }
+
+  bool AtEnd() const { return this->Pos == this->Data.size(); }
+
+private:
+  std::string const& Data;
+  std::string::size_type Pos;
+};
+}
+
+bool cmTestManifest::Record::AppliesTo(std::string const& config) const
+{
+  if (this->Cond == Condition::Always) {
+    return true;
+  }
+  std::string const configUpper = cmSystemTools::UpperCase(config);
+  bool const found =
+    std::any_of(this->Configs.begin(), this->Configs.end(),
+                [&configUpper](std::string const& c) {
+                  return cmSystemTools::UpperCase(c) == configUpper;
+                });
+  return this->Cond == Condition::AnyConfig ? found : !found;
+}
+
+std::string cmTestManifest::GetFileName(std::string const& dir)
+{
+  return cmStrCat(dir, "/CTestTestfile.manifest");
+}
+
+bool cmTestManifest::IsLiteralUnquotedArgument(cm::string_view arg)
+{
+  return !arg.empty() &&
+    arg.find_first_of("$[]#;()\"\\ \t\r\n") == cm::string_view::npos;
+}
+
+bool cmTestManifest::IsLiteralQuotedArgument(cm::string_view arg)
+{
+  return arg.find_first_of("$\"\\") == cm::string_view::npos;
+}
+
+bool cmTestManifest::IsLiteralConfigName(std::string const& config)
+{
+  return std::all_of(config.begin(), config.end(), [](char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+      (c >= '0' && c <= '9') || c == '_' || c == '-';
+  });
+}
+
+cmTestManifest::Record& cmTestManifest::AddRecord(
+  Command cmd, Condition cond, std::vector<std::string> configs)
+{
+  this->Records.emplace_back();
+  Record& record = this->Records.back();
+  record.Cmd = cmd;
+  record.Cond = cond;
+  record.Configs = std::move(configs);
+  return record;
+}
+
+void cmTestManifest::Write(std::string const& dir,
+                           std::string const& script) const
+{
+  std::string const file = cmTestManifest::GetFileName(dir);
+  if (!this->Supported) {
+    if (cmSystemTools::FileExists(file)) {
+      cmSystemTools::RemoveFile(file);
+    }
+    return;
+  }
+
+  ScriptStamp stamp;
+  stamp.Load(ScriptName(dir));
+
+  std::string data = kManifestMagic;
+  AppendInteger(data, kManifestVersion);
+  AppendString(data, HashScript(script));
+  AppendInteger64(data, stamp.Size);
+  AppendInteger64(data, stamp.Time);
+  AppendInteger(data, static_cast<std::uint32_t>(this->Records.size()));
+  for (Record const& record : this->Records) {
+    data += static_cast<char>(record.Cmd);
+    data += static_cast<char>(record.Cond);
+    AppendStrings(data, record.Configs);
+    AppendStrings(data, record.Args);
+  }
+
+  cmGeneratedFileStream fout;
+  fout.Open(file, false, true);
+  fout.SetCopyIfDifferent(true);
+  fout.write(data.data(), static_cast<std::streamsize>(data.size()));
+  fout.Close();
+}
+
+bool cmTestManifest::Load(std::string const& dir)
+{
+  this->Records.clear();
+
+  std::string data;
+  if (!ReadWholeFile(cmTestManifest::GetFileName(dir), data,
+                     std::ios::in | std::ios::binary)) {
+    return false;
+  }
+
+  std::size_t const magicSize = sizeof(kManifestMagic) - 1;
+  if (data.compare(0, magicSize, kManifestMagic) != 0) {
+    return false;
+  }
+  ManifestReader reader(data, magicSize);
+  std::uint32_t version;
+  std::string hash;
+  ScriptStamp recorded;
+  if (!reader.ReadInteger(version) || version != kManifestVersion ||
+      !reader.ReadString(hash) || !reader.ReadInteger64(recorded.Size) ||
+      !reader.ReadInteger64(recorded.Time)) {
+    return false;
+  }
+
+  // The manifest is only valid for the script it was generated with.
+  // Compare the script content only if its size or time changed.
+  std::string const scriptName = ScriptName(dir);
+  ScriptStamp current;
+  if (!current.Load(scriptName)) {
+    return false;
+  }
+  if (current.Size != recorded.Size || current.Time != recorded.Time) {
+    std::string script;
+    if (!ReadWholeFile(scriptName, script, std::ios::in) ||
+        HashScript(script) != hash) {
+      return false;
+    }
+  }
+
+  std::uint32_t count;
+  if (!reader.ReadInteger(count)) {
+    return false;
+  }
+  std::vector<Record> records;
+  for (std::uint32_t i = 0; i < count; ++i) {
+    Record record;
+    unsigned char cmd;
+    unsigned char cond;
+    if (!reader.ReadByte(cmd) ||
+        cmd > static_cast<unsigned char>(Command::SetResourceSpecFile) ||
+        !reader.ReadByte(cond) ||
+        cond > static_cast<unsigned char>(Condition::NoConfig) ||
+        !reader.ReadStrings(record.Configs) ||
+        !reader.ReadStrings(record.Args)) {
+      return false;
+    }
+    record.Cmd = static_cast<Command>(cmd);
+    record.Cond = static_cast<Condition>(cond);
+    records.emplace_back(std::move(record));
+  }
+  if (!reader.AtEnd()) {
+    return false;
+  }
+  this->Records = std::move(records);
+  return true;
+}
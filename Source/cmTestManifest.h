@@ -0,0 +1,91 @@
+/* Distributed under the OSI-approved BSD 3-Clause License.  See accompanying
+   file Copyright.txt or https://cmake.org/licensing for details.  */
+#pragma once
+
+#include "cmConfigure.h" // IWYU pragma: keep
+
+#include <string>
+#include <vector>
+
+#include <cm/string_view>
+
+/** \class cmTestManifest
+ * \brief Precompiled form of a CTestTestfile.cmake script.
+ *
+ * The generator records the commands it writes to each CTestTestfile.cmake
+ * with their arguments already in final form, together with the
+ * configurations for which they apply.  ctest replays these records
+ * instead of evaluating the script when the manifest is up to date.
+ * Directories whose script contains content that cannot be represented,
+ * such as TEST_INCLUDE_FILES, get no manifest.
+ */
+class cmTestManifest
+{
+public:
+  enum class Command : unsigned char
+  {
+    AddTest,
+    SetTestsProperties,
+    SetDirectoryProperties,
+    Subdirs,
+    SetResourceSpecFile,
+  };
+
+  enum class Condition : unsigned char
+  {
+    // The record applies for any configuration.
+    Always,
+    // The record applies if the configuration is one of Configs.
+    AnyConfig,
+    // The record applies if the configuration is none of Configs.
+    NoConfig,
+  };
+
+  struct Record
+  {
+    Command Cmd = Command::AddTest;
+    Condition Cond = Condition::Always;
+    std::vector<std::string> Configs;
+    std::vector<std::string> Args;
+
+    /** Whether the record applies to the given configuration, using the
+        same case-insensitive comparison as the generated script.  */
+    bool AppliesTo(std::string const& config) const;
+  };
+
+  /** Name of the manifest file in a build directory.  */
+  static std::string GetFileName(std::string const& dir);
+
+  /** Whether a value written unquoted, or inside a quoted argument
+      without escaping, reads back unchanged from a script.  */
+  static bool IsLiteralUnquotedArgument(cm::string_view arg);
+  static bool IsLiteralQuotedArgument(cm::string_view arg);
+
+  /** Whether a configuration name matches itself, ignoring case, in the
+      regular expression the script uses to test the configuration.  */
+  static bool IsLiteralConfigName(std::string const& config);
+
+  Record& AddRecord(Command cmd, Condition cond,
+                    std::vector<std::string> configs = {});
+
+  /** Mark this manifest as unable to represent its script.  */
+  void SetUnsupported() { this->Supported = false; }
+  bool IsSupported() const { return this->Supported; }
+
+  std::vector<Record> const& GetRecords() const { return this->Records; }
+
+  /** Write the manifest for the given script content to the directory, or
+      remove a stale manifest if this one is not supported.  The script
+      must already be written so that its size and time are recorded.  */
+  void Write(std::string const& dir, std::string const& script) const;
+
+  /** Load the manifest from the directory.  Fails if there is no manifest,
+      it has an unknown format, or it does not match the directory's
+      current CTestTestfile.cmake.  The script is only hashed if its size
+      or time differs from the recorded one.  */
+  bool Load(std::string const& dir);
+
+private:
+  bool Supported = true;
+  std::vector<Record> Records;
+};
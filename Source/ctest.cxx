@@ -54,6 +54,8 @@ const cmDocumentationEntry cmDocumentationOptions[] = {
   { "-Q,--quiet", "Make ctest quiet." },
   { "-O <file>, --output-log <file>", "Output to log file" },
   { "--output-junit <file>", "Output test results to JUnit XML file." },
+  { "--output-events <file>",
+    "Write test events as JSON lines to a file or FIFO while tests run." },
   { "-N,--show-only[=format]",
     "Disable actual execution of tests. The optional 'format' defines the "
     "format of the test information and can be 'human' for the current text "
@@ -110,6 +112,11 @@ const cmDocumentationEntry cmDocumentationOptions[] = {
   { "--tests-from-file <file>", "Run the tests listed in the given file" },
   { "--exclude-from-file <file>",
     "Run tests except those listed in the given file" },
+  { "--affected-by <file>",
+    "Run only tests affected by the changed files listed in the given file" },
+  { "--affected-by-git <revisions>",
+    "Run only tests affected by the files changed in the given git "
+    "revisions" },
   { "--repeat until-fail:<n>, --repeat-until-fail <n>",
     "Require each test to run <n> times without failing in order to pass" },
   { "--repeat until-pass:<n>",
@@ -119,6 +126,10 @@ const cmDocumentationEntry cmDocumentationOptions[] = {
   { "--max-width <width>", "Set the max width for a test name to output" },
   { "--interactive-debug-mode [0|1]", "Set the interactive mode to 0 or 1." },
   { "--resource-spec-file <file>", "Set the resource spec file to use." },
+  { "--shard-coordinator <endpoint>",
+    "Run tests on shard workers that connect to the given endpoint." },
+  { "--shard-worker <endpoint>",
+    "Run tests for the shard coordinator at the given endpoint." },
   { "--no-label-summary", "Disable timing summary information for labels." },
   { "--no-subproject-summary",
     "Disable timing summary information for "
@@ -143,6 +154,8 @@ const cmDocumentationEntry cmDocumentationOptions[] = {
   { "--test-command", "The test to run with the --build-and-test option." },
   { "--test-timeout", "The time limit in seconds, internal use only." },
   { "--test-load", "CPU load threshold for starting new parallel tests." },
+  { "--test-pressure <percent>",
+    "Adapt the number of parallel tests to the system stall percentage." },
   { "--tomorrow-tag", "Nightly or experimental starts with next day tag." },
   { "--overwrite", "Overwrite CTest configuration option." },
   { "--extra-submit <file>[;<file>]", "Submit extra files to the dashboard." },
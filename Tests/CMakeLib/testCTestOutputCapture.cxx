@@ -0,0 +1,145 @@
+#include <cstddef>
+#include <initializer_list>
+#include <iostream>
+#include <string>
+
+#include <cm/string_view>
+
+#include "cmCTestOutputCapture.h"
+#include "cmSystemTools.h"
+
+static std::string const spillFile = "testCTestOutputCapture.tmp";
+
+static std::string makeOutput(std::size_t size)
+{
+  std::string output;
+  for (std::size_t i = 0; i < size; ++i) {
+    output += static_cast<char>('a' + (i * 7) % 26);
+  }
+  return output;
+}
+
+static void append(cmCTestOutputCapture& capture, std::string const& output,
+                   std::size_t chunk)
+{
+  for (std::size_t i = 0; i < output.size(); i += chunk) {
+    capture.Append(cm::string_view(output).substr(i, chunk));
+  }
+}
+
+static bool testUnbounded()
+{
+  cmCTestOutputCapture capture;
+  capture.Start(0, spillFile);
+  std::string const output = makeOutput(1000);
+  append(capture, output, 7);
+  if (capture.GetText() != output || capture.IsTruncated()) {
+    std::cout << "Unbounded capture did not keep all output\n";
+    return false;
+  }
+  if (capture.Finish() != output) {
+    std::cout << "Unbounded capture did not return all output\n";
+    return false;
+  }
+  return true;
+}
+
+static bool testBounded()
+{
+  std::size_t const limit = 10;
+  // The capture keeps a few bytes of context beyond the limit.
+  std::size_t const kept = limit + 8;
+  for (std::size_t size : { 0, 5, 18, 30, 36, 37, 100, 1000 }) {
+    for (std::size_t chunk : { 1, 3, 17, 18, 19, 64 }) {
+      std::string const output = makeOutput(size);
+      cmCTestOutputCapture capture;
+      capture.Start(limit, spillFile);
+      append(capture, output, chunk);
+
+      std::string expect = output;
+      if (output.size() > 2 * kept) {
+        expect = output.substr(0, kept) + output.substr(output.size() - kept);
+      }
+      std::string const text = capture.Finish();
+      if (text != expect) {
+        std::cout << "Bounded capture of " << size << " bytes in chunks of "
+                  << chunk << " kept:\n " << text << "\nexpected:\n "
+                  << expect << "\n";
+        return false;
+      }
+      if (capture.IsTruncated() != (output.size() > 2 * kept)) {
+        std::cout << "Bounded capture of " << size
+                  << " bytes has wrong truncation state\n";
+        return false;
+      }
+      if (capture.GetFull(text) != output) {
+        std::cout << "Bounded capture of " << size << " bytes in chunks of "
+                  << chunk << " lost output\n";
+        return false;
+      }
+    }
+  }
+  return !cmSystemTools::FileExists(spillFile);
+}
+
+static bool testKeepAll()
+{
+  cmCTestOutputCapture capture;
+  capture.Start(10, spillFile);
+  std::string const output = makeOutput(200);
+  append(capture, output, 13);
+  capture.KeepAll();
+  if (capture.GetText() != output || capture.IsTruncated()) {
+    std::cout << "KeepAll did not bring back all output\n";
+    return false;
+  }
+  append(capture, output, 13);
+  if (capture.Finish() != output + output) {
+    std::cout << "Capture after KeepAll did not keep all output\n";
+    return false;
+  }
+  return !cmSystemTools::FileExists(spillFile);
+}
+
+static bool testNoSpill()
+{
+  cmCTestOutputCapture capture;
+  capture.Start(10);
+  append(capture, makeOutput(100), 100);
+  std::string const text = capture.Finish();
+  std::string const full = capture.GetFull(text);
+  if (full.find("64 bytes of the test output could not be kept") ==
+      std::string::npos) {
+    std::cout << "Capture without spill file did not report lost output:\n "
+              << full << "\n";
+    return false;
+  }
+  return true;
+}
+
+int testCTestOutputCapture(int /*unused*/, char* /*unused*/[])
+{
+  int retval = 0;
+
+  if (!testUnbounded()) {
+    std::cout << "in testUnbounded()\n";
+    retval = -1;
+  }
+
+  if (!testBounded()) {
+    std::cout << "in testBounded()\n";
+    retval = -1;
+  }
+
+  if (!testKeepAll()) {
+    std::cout << "in testKeepAll()\n";
+    retval = -1;
+  }
+
+  if (!testNoSpill()) {
+    std::cout << "in testNoSpill()\n";
+    retval = -1;
+  }
+
+  return retval;
+}
@@ -0,0 +1,160 @@
+#include <cstddef>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "cmsys/RegularExpression.hxx"
+
+#include "cmCTestRegexSet.h"
+
+#include "testCommon.h"
+
+// Some of the expressions ctest_build matches by default.
+static char const* const patterns[] = {
+  "^[Bb]us [Ee]rror",
+  ":.*[Pp]ermission [Dd]enied",
+  "([^ :]+):([0-9]+): ([^ \\t])",
+  "([^:]+): error[ \\t]*[0-9]+[ \\t]*:",
+  "^Error ([0-9]+):",
+  "^Fatal",
+  R"(^"[^"]+", line [0-9]+: [^Ww])",
+  "^ld([^:])*:([ \\t])*ERROR([^:])*:",
+  "([^ :]+) : (error|fatal error|catastrophic error)",
+  "([^:]+): (Error:|error|undefined reference|multiply defined)",
+  R"(([^:]+)\(([^\)]+)\) ?: (error|fatal error|catastrophic error))",
+  "^CMake Error.*:",
+  R"(: \*\*\* No rule to make target [`'].*\'.  Stop)",
+  R"(make\[.*\]: \*\*\*.*Error)",
+  "^\\[ERROR\\]",
+  "instantiated from ",
+  "candidates are:",
+  ": warning",
+  ": \\(Warning\\)",
+  "([^ :]+) : warning",
+  "([^:]+): warning ([0-9]+):",
+  "^(Warning|Remark)",
+  "[Ww][Aa][Rr][Nn][Ii][Nn][Gg]",
+  "ab+c*d?e",
+  "x(yz)+w",
+  "(foo|bar)baz",
+  "(foo|)bar",
+  "a.b$",
+};
+
+static std::vector<std::string> const lines = {
+  "",
+  "Bus error",
+  "main.c:12: error: expected ';'",
+  "main.c:12:3: warning: unused variable 'x'",
+  "src/file.cxx(42) : error C2065: undeclared identifier",
+  "ld: ERROR: undefined symbol",
+  "make[2]: *** [all] Error 2",
+  "CMake Error at CMakeLists.txt:3 (foo):",
+  "[ERROR] something failed",
+  "-- Build files have been written",
+  "Warning: this is a warning",
+  "WaRnInG in mixed case",
+  "foo: Permission denied",
+  "abbbccde abe abcc",
+  "xyzyzw xw",
+  "foobaz barbaz baz",
+  "bar",
+  "axb",
+  "axbc",
+  "\"file.c\", line 3: Error",
+  "/usr/include/foo.h:10: candidates are: int f()",
+};
+
+static std::vector<cmsys::RegularExpression> compileAll()
+{
+  std::vector<cmsys::RegularExpression> regexes;
+  for (char const* pattern : patterns) {
+    regexes.emplace_back(pattern);
+  }
+  return regexes;
+}
+
+static void addAll(cmCTestRegexSet& set)
+{
+  for (char const* pattern : patterns) {
+    set.Add(pattern);
+  }
+}
+
+static std::size_t findFirst(std::vector<cmsys::RegularExpression>& regexes,
+                             std::string const& line, std::size_t begin,
+                             std::size_t end)
+{
+  for (std::size_t i = begin; i < end; ++i) {
+    if (regexes[i].find(line)) {
+      return i;
+    }
+  }
+  return end;
+}
+
+static bool testGetLiterals()
+{
+  using literals = std::vector<std::string>;
+  ASSERT_TRUE(cmCTestRegexSet::GetLiterals("^Fatal") == literals{ "Fatal" });
+  ASSERT_TRUE(cmCTestRegexSet::GetLiterals("ab+c*d") == literals{ "ab" });
+  ASSERT_TRUE(cmCTestRegexSet::GetLiterals("(foo|bar)baz") ==
+              literals{ "baz" });
+  ASSERT_TRUE(cmCTestRegexSet::GetLiterals("(foo|bar)z") ==
+              (literals{ "foo", "bar" }));
+  ASSERT_TRUE(cmCTestRegexSet::GetLiterals("(foo|)bar") ==
+              literals{ "bar" });
+  ASSERT_TRUE(cmCTestRegexSet::GetLiterals("(foo|)").empty());
+  ASSERT_TRUE(cmCTestRegexSet::GetLiterals("(foo)*").empty());
+  ASSERT_TRUE(cmCTestRegexSet::GetLiterals("[a-z]+").empty());
+  ASSERT_TRUE(cmCTestRegexSet::GetLiterals("\\(Warning\\)") ==
+              literals{ "(Warning)" });
+  ASSERT_TRUE(cmCTestRegexSet::GetLiterals("a[bc]d") == literals{ "a" });
+  return true;
+}
+
+static bool testFind()
+{
+  std::vector<cmsys::RegularExpression> regexes = compileAll();
+  cmCTestRegexSet set;
+  addAll(set);
+  ASSERT_EQUAL(set.Size(), regexes.size());
+
+  std::size_t const size = set.Size();
+  for (std::string const& line : lines) {
+    set.Scan(line);
+    for (std::size_t begin = 0; begin < size; ++begin) {
+      for (std::size_t end = begin; end <= size; ++end) {
+        std::size_t const expect = findFirst(regexes, line, begin, end);
+        std::size_t const actual = set.Find(begin, end);
+        if (actual != expect) {
+          std::cout << "Line \"" << line << "\" in [" << begin << ", " << end
+                    << ") matched " << actual << " instead of " << expect
+                    << '\n';
+          return false;
+        }
+      }
+    }
+  }
+  return true;
+}
+
+static bool testClear()
+{
+  cmCTestRegexSet set;
+  addAll(set);
+  set.Clear();
+  ASSERT_EQUAL(set.Size(), 0);
+  std::string const line = "main.c:12: error: expected ';'";
+  set.Scan(line);
+  ASSERT_EQUAL(set.Find(0, 0), 0);
+  ASSERT_EQUAL(set.Add("error"), 0);
+  set.Scan(line);
+  ASSERT_EQUAL(set.Find(0, 1), 0);
+  return true;
+}
+
+int testCTestRegexSet(int /*unused*/, char* /*unused*/[])
+{
+  return runTests({ testGetLiterals, testFind, testClear });
+}
@@ -0,0 +1,138 @@
+/* Distributed under the OSI-approved BSD 3-Clause License.  See accompanying
+   file Copyright.txt or https://cmake.org/licensing for details.  */
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include <cm3p/rhash.h>
+
+#include "cmsys/FStream.hxx"
+
+#include "cmCryptoHash.h"
+#include "cmSystemTools.h"
+
+#include "testCommon.h"
+
+namespace {
+
+struct AlgoInfo
+{
+  cmCryptoHash::Algo Algo;
+  unsigned int Id;
+};
+
+AlgoInfo const algos[] = {
+  { cmCryptoHash::AlgoMD5, RHASH_MD5 },
+  { cmCryptoHash::AlgoSHA1, RHASH_SHA1 },
+  { cmCryptoHash::AlgoSHA224, RHASH_SHA224 },
+  { cmCryptoHash::AlgoSHA256, RHASH_SHA256 },
+  { cmCryptoHash::AlgoSHA512, RHASH_SHA512 },
+};
+
+std::string MakeData(std::size_t size)
+{
+  std::string data(size, '\0');
+  for (std::size_t i = 0; i < size; ++i) {
+    data[i] = static_cast<char>((i * 131 + 7) & 0xff);
+  }
+  return data;
+}
+
+// Hash with the portable rhash implementation for reference.
+std::string Reference(unsigned int id, std::string const& data)
+{
+  std::vector<unsigned char> digest(rhash_get_digest_size(id));
+  rhash_msg(id, data.data(), data.size(), digest.data());
+  return cmCryptoHash::ByteHashToString(digest);
+}
+
+bool testKnownDigests()
+{
+  std::cout << "testKnownDigests()";
+
+  ASSERT_EQUAL(cmCryptoHash(cmCryptoHash::AlgoSHA1).HashString("abc"),
+               "a9993e364706816aba3e25717850c26c9cd0d89d");
+  ASSERT_EQUAL(cmCryptoHash(cmCryptoHash::AlgoSHA224).HashString("abc"),
+               "23097d223405d8228642a477bda255b3"
+               "2aadbce4bda0b3f7e36c9da7");
+  ASSERT_EQUAL(cmCryptoHash(cmCryptoHash::AlgoSHA256).HashString("abc"),
+               "ba7816bf8f01cfea414140de5dae2223"
+               "b00361a396177a9cb410ff61f20015ad");
+  ASSERT_EQUAL(cmCryptoHash(cmCryptoHash::AlgoSHA256).HashString(""),
+               "e3b0c44298fc1c149afbf4c8996fb924"
+               "27ae41e4649b934ca495991b7852b855");
+  return true;
+}
+
+bool testLengths()
+{
+  std::cout << "testLengths()";
+
+  // Cover every position of the final block, and data given in pieces
+  // that do not line up with blocks.
+  std::string const data = MakeData(300);
+  for (AlgoInfo const& info : algos) {
+    cmCryptoHash hash(info.Algo);
+    for (std::size_t size = 0; size <= data.size(); ++size) {
+      std::string const part = data.substr(0, size);
+      std::string const expect = Reference(info.Id, part);
+      ASSERT_EQUAL(hash.HashString(part), expect);
+      for (std::size_t chunk : { 1, 7, 64, 65 }) {
+        hash.Initialize();
+        for (std::size_t i = 0; i < size; i += chunk) {
+          hash.Append(cm::string_view(part).substr(i, chunk));
+        }
+        ASSERT_EQUAL(hash.FinalizeHex(), expect);
+      }
+    }
+  }
+  return true;
+}
+
+bool testHashFiles()
+{
+  std::cout << "testHashFiles()";
+
+  // Sizes below and above the 256 KiB from which files are read in
+  // larger blocks.
+  std::vector<std::size_t> const sizes = { 0, 1, 4096, 256 * 1024 + 3,
+                                           1024 * 1024 };
+  std::vector<std::string> files;
+  std::vector<std::string> contents;
+  for (std::size_t size : sizes) {
+    files.push_back("testCryptoHash" + std::to_string(size) + ".bin");
+    contents.push_back(MakeData(size));
+    cmsys::ofstream fout(files.back().c_str(), std::ios::binary);
+    fout << contents.back();
+  }
+  files.emplace_back("testCryptoHash-missing.bin");
+
+  for (AlgoInfo const& info : algos) {
+    std::vector<std::string> errors;
+    std::vector<std::string> const hashes =
+      cmCryptoHash::HashFiles(info.Algo, files, 3, &errors);
+    ASSERT_EQUAL(hashes.size(), files.size());
+    for (std::size_t i = 0; i < contents.size(); ++i) {
+      std::string const expect = Reference(info.Id, contents[i]);
+      ASSERT_EQUAL(hashes[i], expect);
+      ASSERT_EQUAL(cmCryptoHash(info.Algo).HashFile(files[i]), expect);
+    }
+    ASSERT_TRUE(hashes.back().empty());
+    ASSERT_TRUE(!errors.back().empty());
+  }
+
+  for (std::string const& file : files) {
+    cmSystemTools::RemoveFile(file);
+  }
+  return true;
+}
+}
+
+int testCryptoHash(int /*unused*/, char* /*unused*/[])
+{
+  return runTests({
+    testKnownDigests,
+    testLengths,
+    testHashFiles,
+  });
+}
@@ -3,6 +3,8 @@
 #include <iostream>
 #include <string>
 
+#include "cmsys/FStream.hxx"
+
 #include "cmGeneratedFileStream.h"
 #include "cmSystemTools.h"
 
@@ -75,6 +77,81 @@ int testGeneratedFileStream(int /*unused*/, char* /*unused*/[])
     cmFailed("Something wrong with cmGeneratedFileStream. Cannot find file: ",
              file1.c_str());
   }
+
+  // A copy-if-different stream only replaces the destination if the
+  // content changed, and never leaves its temporary file behind.
+  std::string file5 = "generatedFile5";
+  std::string file5tmp = file5 + ".tmp";
+  cmSystemTools::RemoveFile(file5);
+  gm.SetTempExt("tmp");
+  for (int i = 0; i < 4; ++i) {
+    std::string const content = i < 2 ? "Content 1\n" : "Content 2\n";
+    bool const expectReplaced = i != 1 && i != 3;
+    gm.Open(file5);
+    gm.SetCopyIfDifferent(true);
+    gm << content;
+    if (gm.Close() != expectReplaced) {
+      cmFailed("Copy-if-different stream replaced the file incorrectly: ",
+               file5.c_str());
+    }
+    if (cmSystemTools::FileExists(file5tmp)) {
+      cmFailed("Temporary file is still here: ", file5tmp.c_str());
+    }
+    cmsys::ifstream fin(file5.c_str());
+    std::string actual;
+    if (!cmSystemTools::GetLineFromStream(fin, actual) ||
+        actual + "\n" != content) {
+      cmFailed("Copy-if-different stream produced wrong content: ",
+               file5.c_str());
+    }
+  }
+  gm.SetCopyIfDifferent(false);
+
+  // Closing the stream with the ofstream close() leaves the destination
+  // to be replaced when the stream is destroyed.
+  std::string file6 = "generatedFile6";
+  cmSystemTools::RemoveFile(file6);
+  {
+    cmGeneratedFileStream gfout;
+    gfout.Open(file6);
+    gfout.SetCopyIfDifferent(true);
+    cmsys::ofstream& fout = gfout;
+    if (!fout.is_open()) {
+      cmFailed("Copy-if-different stream is not open: ", file6.c_str());
+    }
+    fout << "Content 6\n";
+    fout.close();
+    if (!fout) {
+      cmFailed("Closing copy-if-different stream failed: ", file6.c_str());
+    }
+  }
+  if (!cmSystemTools::FileExists(file6)) {
+    cmFailed("Stream closed by close() did not write file: ", file6.c_str());
+  }
+
+  // Content too large to be kept in memory is still compared with the
+  // destination.
+  std::string file7 = "generatedFile7";
+  cmSystemTools::RemoveFile(file7);
+  std::string const line(1023, 'x');
+  for (int i = 0; i < 2; ++i) {
+    gm.Open(file7);
+    gm.SetCopyIfDifferent(true);
+    for (int j = 0; j < 17 * 1024; ++j) {
+      gm << line << '\n';
+    }
+    if (gm.Close() != (i == 0)) {
+      cmFailed("Large copy-if-different stream replaced the file "
+               "incorrectly: ",
+               file7.c_str());
+    }
+  }
+  if (cmSystemTools::FileLength(file7) != 17 * 1024 * 1024) {
+    cmFailed("Large copy-if-different stream produced wrong content: ",
+             file7.c_str());
+  }
+  gm.SetCopyIfDifferent(false);
+
   cmSystemTools::RemoveFile(file1);
   cmSystemTools::RemoveFile(file2);
   cmSystemTools::RemoveFile(file3);
@@ -83,6 +160,9 @@ int testGeneratedFileStream(int /*unused*/, char* /*unused*/[])
   cmSystemTools::RemoveFile(file2tmp);
   cmSystemTools::RemoveFile(file3tmp);
   cmSystemTools::RemoveFile(file4tmp);
+  cmSystemTools::RemoveFile(file5);
+  cmSystemTools::RemoveFile(file6);
+  cmSystemTools::RemoveFile(file7);
 
   return failed;
 }
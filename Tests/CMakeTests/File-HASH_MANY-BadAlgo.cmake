@@ -0,0 +1 @@
+file(HASH_MANY SHA0 sha0 FILES ${CMAKE_CURRENT_LIST_DIR}/File-HASH-Input.txt)
@@ -0,0 +1,4 @@
+file(HASH_MANY SHA256 sha256 FILES
+  ${CMAKE_CURRENT_LIST_DIR}/File-HASH-Input.txt
+  ${CMAKE_CURRENT_LIST_DIR}/DoesNotExist.cmake
+  )
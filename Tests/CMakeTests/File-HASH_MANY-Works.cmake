@@ -0,0 +1,7 @@
+file(HASH_MANY SHA256 sha256 FILES
+  ${CMAKE_CURRENT_LIST_DIR}/File-HASH-Input.txt
+  ${CMAKE_CURRENT_LIST_DIR}/File-HASH-Input.txt
+  PARALLEL_LEVEL 2
+  )
+file(HASH_MANY MD5 md5 FILES ${CMAKE_CURRENT_LIST_DIR}/File-HASH-Input.txt)
+message("${sha256};${md5}")
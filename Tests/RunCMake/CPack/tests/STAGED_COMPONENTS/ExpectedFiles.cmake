@@ -0,0 +1,9 @@
+set(EXPECTED_FILES_COUNT "2")
+set(EXPECTED_FILE_1_COMPONENT "c1")
+set(EXPECTED_FILE_CONTENT_1_LIST "/files;/files/c1.txt")
+set(EXPECTED_FILE_2_COMPONENT "c2")
+set(EXPECTED_FILE_CONTENT_2_LIST "/files;/files/c2.txt")
+
+if(RunCMake_SUBTEST_SUFFIX STREQUAL "fallback")
+  list(APPEND EXPECTED_FILE_CONTENT_1_LIST "/files/code.txt")
+endif()
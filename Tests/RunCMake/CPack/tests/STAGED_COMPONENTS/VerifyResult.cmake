@@ -0,0 +1,22 @@
+# The code of each rule runs once without a component when the components
+# are installed at once, and again with its own component when they are
+# then installed one at a time.
+set(expected_log "c1:\nc2:\n")
+if(NOT RunCMake_SUBTEST_SUFFIX STREQUAL "staged")
+  string(APPEND expected_log "c1:c1\nc2:c2\n")
+endif()
+file(READ "${bin_dir}/code.log" log)
+if(NOT log STREQUAL expected_log)
+  message(FATAL_ERROR "Unexpected install code log:\n${log}\n"
+    "Expected:\n${expected_log}\n${output_error_message}")
+endif()
+
+# Installing the components at once writes no install manifest into the
+# build tree.
+if(RunCMake_SUBTEST_SUFFIX STREQUAL "staged")
+  file(GLOB manifests "${bin_dir}/install_manifest*.txt")
+  if(manifests)
+    message(FATAL_ERROR "Unexpected install manifests:\n${manifests}\n"
+      "${output_error_message}")
+  endif()
+endif()
@@ -0,0 +1,30 @@
+# Components c2 and c4 are excluded from the default installation, and
+# only c1 and c2 are packaged.
+foreach(c c1 c2 c3 c4)
+  file(WRITE "${CMAKE_CURRENT_BINARY_DIR}/${c}.txt" "This is file ${c}")
+  if(c STREQUAL "c2" OR c STREQUAL "c4")
+    set(exclude EXCLUDE_FROM_ALL)
+  else()
+    set(exclude "")
+  endif()
+  install(FILES "${CMAKE_CURRENT_BINARY_DIR}/${c}.txt" DESTINATION files
+    COMPONENT ${c} ${exclude})
+  # Log the component seen by the code of each rule that runs.
+  install(CODE "file(APPEND \"${CMAKE_CURRENT_BINARY_DIR}/code.log\" \"${c}:\${CMAKE_INSTALL_COMPONENT}\\n\")"
+    COMPONENT ${c} ${exclude})
+endforeach()
+
+if(RunCMake_SUBTEST_SUFFIX STREQUAL "fallback")
+  # A file not installed by file(INSTALL) cannot be assigned to a
+  # component, so the components are installed one at a time.
+  install(CODE "file(WRITE \"\$ENV{DESTDIR}\${CMAKE_INSTALL_PREFIX}/files/code.txt\" \"code\")"
+    COMPONENT c1)
+elseif(RunCMake_SUBTEST_SUFFIX STREQUAL "error")
+  # The components are installed one at a time if installing them at once
+  # fails.
+  install(CODE "if(CMAKE_INSTALL_RECORD_COMPONENTS)
+  message(FATAL_ERROR \"Cannot install components at once.\")
+endif()" COMPONENT c2 EXCLUDE_FROM_ALL)
+endif()
+
+set(CPACK_COMPONENTS_ALL c1 c2)
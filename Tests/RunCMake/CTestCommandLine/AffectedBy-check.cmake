@@ -0,0 +1,10 @@
+file(READ "${RunCMake_TEST_BINARY_DIR}/CTestTestfile.cmake" ctest_testfile)
+if(ctest_testfile MATCHES "_IMPACT_TARGETS")
+  set(RunCMake_TEST_FAILED
+    "CTestTestfile.cmake names the targets of the tests.")
+endif()
+file(READ "${RunCMake_TEST_BINARY_DIR}/CTestImpact.txt" ctest_impact)
+if(NOT ctest_impact MATCHES "\ntest App\nuses app\n")
+  string(APPEND RunCMake_TEST_FAILED
+    "CTestImpact.txt does not name the targets of test App.")
+endif()
@@ -0,0 +1,19 @@
+enable_language(C)
+enable_testing()
+
+foreach(src IN ITEMS lib.c app.c other.c)
+  file(WRITE "${CMAKE_CURRENT_BINARY_DIR}/${src}" "")
+endforeach()
+
+add_library(lib STATIC lib.c)
+add_executable(app app.c)
+target_link_libraries(app PRIVATE lib)
+add_executable(other other.c)
+
+add_test(NAME App COMMAND app)
+add_test(NAME Other COMMAND other)
+add_test(NAME Genex COMMAND ${CMAKE_COMMAND} -E echo $<TARGET_FILE:other>)
+add_test(NAME NoTarget COMMAND ${CMAKE_COMMAND} -E true)
+add_test(NAME Required COMMAND other)
+set_tests_properties(Required PROPERTIES
+  REQUIRED_FILES "${CMAKE_CURRENT_BINARY_DIR}/data.txt")
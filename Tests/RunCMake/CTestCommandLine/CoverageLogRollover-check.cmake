@@ -0,0 +1,17 @@
+file(GLOB logs "${RunCMake_TEST_BINARY_DIR}/Testing/*/CoverageLog-*.xml")
+list(LENGTH logs count)
+if(NOT count EQUAL 2)
+  set(RunCMake_TEST_FAILED
+    "Expected 2 coverage logs, found ${count}:\n  ${logs}\n")
+  return()
+endif()
+foreach(check "0;a.src" "1;b.src")
+  list(GET check 0 n)
+  list(GET check 1 file)
+  file(GLOB log "${RunCMake_TEST_BINARY_DIR}/Testing/*/CoverageLog-${n}.xml")
+  file(READ "${log}" content)
+  if(NOT content MATCHES "<File Name=\"${file}\"")
+    string(APPEND RunCMake_TEST_FAILED
+      "CoverageLog-${n}.xml does not contain ${file}.\n")
+  endif()
+endforeach()
@@ -278,6 +278,87 @@ add_test(Echo \"${CMAKE_COMMAND}\" -E echo \"EchoTest\")
 endfunction()
 run_SerialFailed()
 
+function(run_CriticalPath)
+  set(RunCMake_TEST_BINARY_DIR ${RunCMake_BINARY_DIR}/CriticalPath)
+  set(RunCMake_TEST_NO_CLEAN 1)
+  file(REMOVE_RECURSE "${RunCMake_TEST_BINARY_DIR}")
+  file(MAKE_DIRECTORY "${RunCMake_TEST_BINARY_DIR}")
+  file(WRITE "${RunCMake_TEST_BINARY_DIR}/CTestTestfile.cmake" "
+add_test(Short \"${CMAKE_COMMAND}\" -E true)
+add_test(AfterShort \"${CMAKE_COMMAND}\" -E true)
+set_tests_properties(AfterShort PROPERTIES DEPENDS Short)
+add_test(Long \"${CMAKE_COMMAND}\" -E true)
+")
+  # The chain Short -> AfterShort is shorter than Long, so Long starts first.
+  file(WRITE "${RunCMake_TEST_BINARY_DIR}/Testing/Temporary/CTestCostData.txt"
+    "Short 1 0.5 0\nAfterShort 1 1 0\nLong 1 3 0\n---\n")
+  run_cmake_command(CriticalPath ${CMAKE_CTEST_COMMAND} -j2)
+endfunction()
+run_CriticalPath()
+
+function(run_TestManifest)
+  set(RunCMake_TEST_BINARY_DIR ${RunCMake_BINARY_DIR}/TestManifest-build)
+  run_cmake(TestManifest)
+  set(RunCMake_TEST_NO_CLEAN 1)
+  run_cmake_command(TestManifest-ctest ${CMAKE_CTEST_COMMAND} -C Debug -N -V)
+  run_cmake_command(TestManifest-release ${CMAKE_CTEST_COMMAND} -C Release -N)
+  # A script with a new time but the same content keeps its manifest.
+  file(TOUCH "${RunCMake_TEST_BINARY_DIR}/CTestTestfile.cmake")
+  run_cmake_command(TestManifest-touched ${CMAKE_CTEST_COMMAND} -C Debug -N -V)
+  # A manifest that does not match its script is ignored.
+  file(APPEND "${RunCMake_TEST_BINARY_DIR}/CTestTestfile.cmake"
+    "add_test(Appended \"${CMAKE_COMMAND}\" -E true)\n")
+  run_cmake_command(TestManifest-stale ${CMAKE_CTEST_COMMAND} -C Debug -N -V)
+endfunction()
+run_TestManifest()
+
+function(run_AffectedBy)
+  set(RunCMake_TEST_BINARY_DIR ${RunCMake_BINARY_DIR}/AffectedBy-build)
+  run_cmake(AffectedBy)
+  set(RunCMake_TEST_NO_CLEAN 1)
+  foreach(case IN ITEMS lib other data)
+    # Relative paths are relative to the working directory.
+    file(WRITE "${RunCMake_TEST_BINARY_DIR}/changed-${case}.txt"
+      "${RunCMake_TEST_BINARY_DIR}/${case}.c\n${case}.txt\n")
+    run_cmake_command(AffectedBy-${case} ${CMAKE_CTEST_COMMAND}
+      -C Debug -N --affected-by changed-${case}.txt)
+  endforeach()
+  if(UNIX)
+    # Changed paths are compared after resolving symbolic links.
+    file(CREATE_LINK "${RunCMake_TEST_BINARY_DIR}"
+      "${RunCMake_TEST_BINARY_DIR}/link" SYMBOLIC)
+    file(WRITE "${RunCMake_TEST_BINARY_DIR}/changed-link.txt" "link/lib.c\n")
+    run_cmake_command(AffectedBy-link ${CMAKE_CTEST_COMMAND}
+      -C Debug -N --affected-by changed-link.txt)
+  endif()
+endfunction()
+run_AffectedBy()
+
+function(run_Shard)
+  set(RunCMake_TEST_BINARY_DIR ${RunCMake_BINARY_DIR}/Shard)
+  set(RunCMake_TEST_NO_CLEAN 1)
+  file(REMOVE_RECURSE "${RunCMake_TEST_BINARY_DIR}")
+  file(MAKE_DIRECTORY "${RunCMake_TEST_BINARY_DIR}")
+  file(WRITE "${RunCMake_TEST_BINARY_DIR}/CTestTestfile.cmake" "
+foreach(i RANGE 1 4)
+  add_test(test\${i} \"${CMAKE_COMMAND}\" -E echo \"output of test\${i}\")
+endforeach()
+add_test(Environment \"${CMAKE_COMMAND}\" -E environment)
+set_tests_properties(Environment PROPERTIES
+  ENVIRONMENT SHARD_TEST_VAR=forwarded
+  PASS_REGULAR_EXPRESSION SHARD_TEST_VAR=forwarded)
+add_test(EnvironmentModification \"${CMAKE_COMMAND}\" -E environment)
+set_tests_properties(EnvironmentModification PROPERTIES
+  ENVIRONMENT_MODIFICATION SHARD_TEST_MOD=set:modified
+  PASS_REGULAR_EXPRESSION SHARD_TEST_MOD=modified)
+add_test(Fail \"${CMAKE_COMMAND}\" -E false)
+set_tests_properties(Fail PROPERTIES WILL_FAIL 1 DEPENDS test1)
+")
+  run_cmake_command(Shard ${CMAKE_COMMAND}
+    -DCTEST=${CMAKE_CTEST_COMMAND} -P ${RunCMake_SOURCE_DIR}/Shard.cmake)
+endfunction()
+run_Shard()
+
 function(run_Parallel case)
   set(RunCMake_TEST_BINARY_DIR ${RunCMake_BINARY_DIR}/Parallel-${case})
   set(RunCMake_TEST_NO_CLEAN 1)
@@ -350,6 +431,32 @@ run_TestLoad(test-load-pass 12)
 
 unset(ENV{__CTEST_FAKE_LOAD_AVERAGE_FOR_TESTING})
 
+function(run_TestPressure name pressure)
+  set(RunCMake_TEST_BINARY_DIR ${RunCMake_BINARY_DIR}/TestPressure)
+  set(RunCMake_TEST_NO_CLEAN 1)
+  file(REMOVE_RECURSE "${RunCMake_TEST_BINARY_DIR}")
+  file(MAKE_DIRECTORY "${RunCMake_TEST_BINARY_DIR}")
+  file(WRITE "${RunCMake_TEST_BINARY_DIR}/CTestTestfile.cmake" "
+foreach(i RANGE 1 4)
+  add_test(TestPressure\${i} \"${CMAKE_COMMAND}\" -E echo \"pressure\")
+endforeach()
+")
+  # Spoof the pressure of a cgroup limited to two CPUs.
+  set(root "${RunCMake_TEST_BINARY_DIR}/root")
+  file(WRITE "${root}/proc/pressure/cpu"
+    "some avg10=90.00 avg60=50.00 avg300=10.00 total=1000\n"
+    "full avg10=0.00 avg60=0.00 avg300=0.00 total=0\n")
+  file(WRITE "${root}/proc/self/cgroup" "0::/ctest\n")
+  file(WRITE "${root}/sys/fs/cgroup/cgroup.controllers" "cpu memory io\n")
+  file(WRITE "${root}/sys/fs/cgroup/ctest/cpu.max" "200000 100000\n")
+  set(ENV{__CTEST_FAKE_PRESSURE_ROOT_FOR_TESTING} "${root}")
+  run_cmake_command(${name} ${CMAKE_CTEST_COMMAND} -V -j8
+    --test-pressure ${pressure})
+  unset(ENV{__CTEST_FAKE_PRESSURE_ROOT_FOR_TESTING})
+endfunction()
+run_TestPressure(test-pressure 50)
+run_TestPressure(test-pressure-invalid 'two')
+
 function(run_TestOutputSize)
   set(RunCMake_TEST_BINARY_DIR ${RunCMake_BINARY_DIR}/TestOutputSize)
   set(RunCMake_TEST_NO_CLEAN 1)
@@ -368,6 +475,54 @@ function(run_TestOutputSize)
 endfunction()
 run_TestOutputSize()
 
+# Test.xml is assembled from results written as tests finish.  It must
+# match the file written from results kept in memory.
+function(run_TestResultsFragment)
+  set(RunCMake_TEST_BINARY_DIR ${RunCMake_BINARY_DIR}/TestResultsFragment)
+  set(RunCMake_TEST_NO_CLEAN 1)
+  file(REMOVE_RECURSE "${RunCMake_TEST_BINARY_DIR}")
+  file(MAKE_DIRECTORY "${RunCMake_TEST_BINARY_DIR}")
+  file(WRITE "${RunCMake_TEST_BINARY_DIR}/DartConfiguration.tcl"
+    "BuildDirectory: ${RunCMake_TEST_BINARY_DIR}\n")
+  file(WRITE "${RunCMake_TEST_BINARY_DIR}/CTestTestfile.cmake" "
+  add_test(First \"${CMAKE_COMMAND}\" -E echo \"<First> & output\")
+  add_test(Second \"${CMAKE_COMMAND}\" -E echo SecondOutput)
+  set_tests_properties(Second PROPERTIES LABELS \"A;B\")
+  add_test(Third \"${CMAKE_COMMAND}\" -E true)
+")
+  run_cmake_command(TestResultsFragment
+    ${CMAKE_CTEST_COMMAND} -M Experimental -T Test --no-compress-output)
+  file(GLOB test_xml "${RunCMake_TEST_BINARY_DIR}/Testing/*/Test.xml")
+  file(RENAME "${test_xml}" "${RunCMake_TEST_BINARY_DIR}/Test-fragment.xml")
+  run_cmake_command(TestResultsFragment-memory
+    ${CMAKE_COMMAND} -E env __CTEST_NO_RESULTS_FRAGMENT_FOR_TESTING=1
+    ${CMAKE_CTEST_COMMAND} -M Experimental -T Test --no-compress-output)
+endfunction()
+run_TestResultsFragment()
+
+# Coverage logs roll over to a new CoverageLog-N.xml at 4 MiB.
+function(run_CoverageLogRollover)
+  set(RunCMake_TEST_BINARY_DIR ${RunCMake_BINARY_DIR}/CoverageLogRollover)
+  set(RunCMake_TEST_NO_CLEAN 1)
+  file(REMOVE_RECURSE "${RunCMake_TEST_BINARY_DIR}")
+  file(MAKE_DIRECTORY "${RunCMake_TEST_BINARY_DIR}/src")
+  file(WRITE "${RunCMake_TEST_BINARY_DIR}/DartConfiguration.tcl" "
+SourceDirectory: ${RunCMake_TEST_BINARY_DIR}/src
+BuildDirectory: ${RunCMake_TEST_BINARY_DIR}
+")
+  file(WRITE "${RunCMake_TEST_BINARY_DIR}/CTestCustom.cmake"
+    "set(CTEST_EXTRA_COVERAGE_GLOB \"*.src\")\n")
+  # Each line of a file without coverage data is logged as an element of
+  # about 45 bytes, so the first file alone fills more than 4 MiB.
+  string(REPEAT "int x;\n" 16 lines)
+  string(REPEAT "${lines}" 6000 lines)
+  file(WRITE "${RunCMake_TEST_BINARY_DIR}/src/a.src" "${lines}")
+  file(WRITE "${RunCMake_TEST_BINARY_DIR}/src/b.src" "int y;\n")
+  run_cmake_command(CoverageLogRollover
+    ${CMAKE_CTEST_COMMAND} -M Experimental -T Coverage)
+endfunction()
+run_CoverageLogRollover()
+
 # Test --test-output-truncation
 function(run_TestOutputTruncation mode expected)
   set(RunCMake_TEST_BINARY_DIR ${RunCMake_BINARY_DIR}/TestOutputTruncation_${mode})
@@ -612,6 +767,22 @@ set_tests_properties(test5 PROPERTIES  SKIP_REGULAR_EXPRESSION \"please skip\")
 endfunction()
 run_output_junit()
 
+# Test --output-events
+function(run_output_events)
+  set(RunCMake_TEST_BINARY_DIR ${RunCMake_BINARY_DIR}/output-events)
+  set(RunCMake_TEST_NO_CLEAN 1)
+  file(REMOVE_RECURSE "${RunCMake_TEST_BINARY_DIR}")
+  file(MAKE_DIRECTORY "${RunCMake_TEST_BINARY_DIR}")
+  file(WRITE "${RunCMake_TEST_BINARY_DIR}/CTestTestfile.cmake" "
+add_test(test1 \"${CMAKE_COMMAND}\" -E false)
+add_test(test2 \"${CMAKE_COMMAND}\" -E echo \"hello world\")
+add_test(test3 \"${CMAKE_COMMAND}\" -E true)
+set_tests_properties(test3 PROPERTIES  DISABLED \"ON\")
+")
+  run_cmake_command(output-events ${CMAKE_CTEST_COMMAND} --output-events "${RunCMake_TEST_BINARY_DIR}/events.json")
+endfunction()
+run_output_events()
+
 run_cmake_command(invalid-ctest-argument ${CMAKE_CTEST_COMMAND} --not-a-valid-ctest-argument)
 
 if(WIN32)
@@ -0,0 +1,9 @@
+file(READ "${RunCMake_TEST_BINARY_DIR}/junit.xml" junit)
+string(REGEX MATCHALL "<testcase name=\"[^\"]*\"" testcases "${junit}")
+list(LENGTH testcases count)
+if(NOT count EQUAL 7)
+  set(RunCMake_TEST_FAILED "Expected 7 tests in junit.xml, found ${count}:\n${testcases}")
+endif()
+if(EXISTS "${RunCMake_TEST_BINARY_DIR}/shard-endpoint")
+  string(APPEND RunCMake_TEST_FAILED "Coordinator did not remove its endpoint.\n")
+endif()
@@ -0,0 +1,8 @@
+# Run two workers and the coordinator at the same time.
+execute_process(
+  COMMAND ${CTEST} --shard-worker shard-endpoint -j2
+  COMMAND ${CTEST} --shard-worker shard-endpoint
+  COMMAND ${CTEST} --shard-coordinator shard-endpoint --output-junit junit.xml
+  RESULTS_VARIABLE results
+  )
+message("results: ${results}")
@@ -0,0 +1,3 @@
+if(actual_stdout MATCHES "Loaded tests from manifest")
+  set(RunCMake_TEST_FAILED "The stale manifest was used.")
+endif()
@@ -0,0 +1,7 @@
+enable_testing()
+
+set_property(DIRECTORY PROPERTY LABELS TopLabel)
+add_test(NAME Top COMMAND ${CMAKE_COMMAND} -E echo "$<CONFIG>")
+set_tests_properties(Top PROPERTIES LABELS "A;B" ENVIRONMENT "CONFIG=$<CONFIG>")
+add_test(NAME DebugOnly CONFIGURATIONS Debug COMMAND ${CMAKE_COMMAND} -E true)
+add_subdirectory(TestManifest)
@@ -0,0 +1,29 @@
+# Only the times may differ between the two files.
+function(read_test_xml var file)
+  file(READ "${file}" content)
+  string(REGEX REPLACE
+    "<(StartDateTime|StartTestTime|EndDateTime|EndTestTime|ElapsedMinutes)>[^<]*<"
+    "<\\1><" content "${content}")
+  string(REGEX REPLACE
+    "(name=\"Execution Time\">[\n\t ]*<Value>)[^<]*<" "\\1<"
+    content "${content}")
+  string(REGEX REPLACE " (BuildStamp|Generator)=\"[^\"]*\"" "" content
+    "${content}")
+  set("${var}" "${content}" PARENT_SCOPE)
+endfunction()
+
+file(GLOB test_xml "${RunCMake_TEST_BINARY_DIR}/Testing/*/Test.xml")
+read_test_xml(memory "${test_xml}")
+read_test_xml(fragment "${RunCMake_TEST_BINARY_DIR}/Test-fragment.xml")
+if(NOT fragment STREQUAL memory)
+  set(RunCMake_TEST_FAILED
+    "Test.xml assembled from fragments:\n${fragment}\n"
+    "differs from Test.xml written from memory:\n${memory}\n")
+endif()
+if(NOT memory MATCHES "&lt;First&gt; &amp; output")
+  string(APPEND RunCMake_TEST_FAILED
+    "Test.xml does not contain the output of the tests:\n${memory}\n")
+endif()
+if(EXISTS "${RunCMake_TEST_BINARY_DIR}/Testing/Temporary/TestResults.xml.part")
+  string(APPEND RunCMake_TEST_FAILED "The results fragment was not removed.\n")
+endif()
@@ -0,0 +1,35 @@
+file(STRINGS "${RunCMake_TEST_BINARY_DIR}/events.json" lines)
+set(events "")
+foreach(line IN LISTS lines)
+  string(JSON event GET "${line}" event)
+  string(JSON name ERROR_VARIABLE error GET "${line}" name)
+  if(NOT error)
+    string(APPEND event " ${name}")
+  endif()
+  if(event MATCHES "^testOutput ")
+    string(JSON text GET "${line}" text)
+    string(APPEND event " ${text}")
+  elseif(event MATCHES "^testFinished ")
+    string(JSON status GET "${line}" status)
+    string(APPEND event " ${status}")
+  elseif(event MATCHES "^runStarted")
+    string(JSON tests GET "${line}" tests)
+    string(APPEND event " ${tests}")
+  endif()
+  string(APPEND events "${event}\n")
+endforeach()
+set(expect [[
+runStarted 3
+testStarted test1
+testFinished test1 failed
+testStarted test2
+testOutput test2 hello world
+
+testFinished test2 passed
+testStarted test3
+testFinished test3 notrun
+runFinished
+]])
+if(NOT events STREQUAL expect)
+  set(RunCMake_TEST_FAILED "Expected events:\n${expect}\nActual events:\n${events}")
+endif()
@@ -1,6 +1,6 @@
 file(READ "${RunCMake_TEST_BINARY_DIR}/cmake_install.cmake" install_script)
 
-if (NOT install_script MATCHES [[\(CMAKE_INSTALL_COMPONENT STREQUAL "bmi" OR NOT CMAKE_INSTALL_COMPONENT\)]])
+if (NOT install_script MATCHES [[\(CMAKE_INSTALL_COMPONENT STREQUAL "bmi" OR NOT CMAKE_INSTALL_COMPONENT AND NOT CMAKE_INSTALL_RECORD_COMPONENTS OR DEFINED "CMAKE_INSTALL_RECORD_COMPONENT_bmi"\)]])
   list(APPEND RunCMake_TEST_FAILED
     "Could not find BMI install script component for `bmi`")
 endif ()
@@ -10,12 +10,12 @@ if (NOT install_script MATCHES [[include\("[^)]*/CMakeFiles/install-bmi\.dir/ins
     "Could not find BMI install script inclusion")
 endif ()
 
-if (NOT install_script MATCHES [[\(CMAKE_INSTALL_COMPONENT STREQUAL "bmi-optional"\)]])
+if (NOT install_script MATCHES [[\(CMAKE_INSTALL_COMPONENT STREQUAL "bmi-optional" OR DEFINED "CMAKE_INSTALL_RECORD_COMPONENT_bmi-optional"\)]])
   list(APPEND RunCMake_TEST_FAILED
     "Could not find BMI install script component for `bmi-optional`")
 endif ()
 
-if (NOT install_script MATCHES [[\(CMAKE_INSTALL_COMPONENT STREQUAL "bmi-only-debug" OR NOT CMAKE_INSTALL_COMPONENT\)
+if (NOT install_script MATCHES [[\(CMAKE_INSTALL_COMPONENT STREQUAL "bmi-only-debug" OR NOT CMAKE_INSTALL_COMPONENT AND NOT CMAKE_INSTALL_RECORD_COMPONENTS OR DEFINED "CMAKE_INSTALL_RECORD_COMPONENT_bmi-only-debug"\)
   if\(CMAKE_INSTALL_CONFIG_NAME MATCHES "\^\(\[Dd\]\[Ee\]\[Bb\]\[Uu\]\[Gg\]\)\$"\)]])
   list(APPEND RunCMake_TEST_FAILED
     "Could not find BMI install script component for `bmi-only-debug`")
@@ -1,6 +1,6 @@
 file(READ "${RunCMake_TEST_BINARY_DIR}/cmake_install.cmake" install_script)
 
-if (install_script MATCHES [[\(CMAKE_INSTALL_COMPONENT STREQUAL "bmi" OR NOT CMAKE_INSTALL_COMPONENT\)]])
+if (install_script MATCHES [[\(CMAKE_INSTALL_COMPONENT STREQUAL "bmi" OR NOT CMAKE_INSTALL_COMPONENT AND NOT CMAKE_INSTALL_RECORD_COMPONENTS OR DEFINED "CMAKE_INSTALL_RECORD_COMPONENT_bmi"\)]])
   list(APPEND RunCMake_TEST_FAILED
     "Found BMI install script component for `bmi`")
 endif ()
@@ -28,6 +28,7 @@ run_cmake(gnutar-gz)
 run_cmake(pax)
 run_cmake(pax-xz)
 run_cmake(pax-zstd)
+run_cmake(pax-zstd-seekable)
 run_cmake(paxr)
 run_cmake(paxr-bz2)
 run_cmake(zip)
@@ -40,3 +41,7 @@ run_cmake(set-mtime)
 
 # Use the --touch option to avoid extracting the mtime
 run_cmake(touch-mtime)
+
+# Extract files that are written out of order
+run_cmake(extract-large)
+run_cmake(extract-queued)
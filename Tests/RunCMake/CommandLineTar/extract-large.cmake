@@ -0,0 +1,46 @@
+set(COMPRESS_DIR ${CMAKE_CURRENT_BINARY_DIR}/compress_dir)
+set(DECOMPRESS_DIR ${CMAKE_CURRENT_BINARY_DIR}/decompress_dir)
+set(OUTPUT_NAME ${CMAKE_CURRENT_BINARY_DIR}/large.tar)
+file(REMOVE_RECURSE ${COMPRESS_DIR} ${DECOMPRESS_DIR})
+file(MAKE_DIRECTORY ${COMPRESS_DIR} ${DECOMPRESS_DIR})
+
+# Files larger than 4 MiB are written as they are read instead of being
+# queued.  Put small files around one to write them at the same time.
+string(REPEAT "0123456789abcdef" 65536 data)
+string(REPEAT "${data}" 5 data)
+file(WRITE ${COMPRESS_DIR}/a-small.txt "small\n")
+file(WRITE ${COMPRESS_DIR}/b-large.txt "${data}")
+file(WRITE ${COMPRESS_DIR}/c-small.txt "small\n")
+
+function(run_tar WORKING_DIRECTORY)
+  execute_process(COMMAND ${CMAKE_COMMAND} -E tar ${ARGN}
+    WORKING_DIRECTORY ${WORKING_DIRECTORY}
+    RESULT_VARIABLE result
+  )
+  if(NOT result STREQUAL "0")
+    message(FATAL_ERROR "tar failed with arguments [${ARGN}] result [${result}]")
+  endif()
+endfunction()
+
+run_tar(${COMPRESS_DIR} cf ${OUTPUT_NAME} a-small.txt b-large.txt c-small.txt)
+run_tar(${DECOMPRESS_DIR} xf ${OUTPUT_NAME})
+
+foreach(file a-small.txt b-large.txt c-small.txt)
+  file(SHA256 ${COMPRESS_DIR}/${file} input_hash)
+  file(SHA256 ${DECOMPRESS_DIR}/${file} output_hash)
+  if(NOT input_hash STREQUAL output_hash)
+    message(SEND_ERROR "Files \"${file}\" differ after extraction")
+  endif()
+endforeach()
+
+# A large sparse file is written without preallocating its holes.  The
+# archive was created with GNU tar as follows:
+#   printf 'head\n' > sparse.bin && truncate -s 5M sparse.bin
+#   printf 'tail\n' >> sparse.bin
+#   tar --format=gnu --sparse -cf sparse.tar sparse.bin && gzip -n sparse.tar
+run_tar(${DECOMPRESS_DIR} xf ${CMAKE_CURRENT_LIST_DIR}/sparse.tar.gz)
+file(SHA256 ${DECOMPRESS_DIR}/sparse.bin output_hash)
+if(NOT output_hash STREQUAL
+    "8658700eafc33e7beecd4d17189039bf7fc1a3c4b9331d7046082db39f53dbe3")
+  message(SEND_ERROR "File \"sparse.bin\" differs after extraction")
+endif()
@@ -0,0 +1,26 @@
+# The archive has a hardlink to a file written before it, and the same
+# file twice in a row.  It was created with GNU tar as follows:
+#   printf 'a\n' > a.txt && ln a.txt b.txt && printf 'one\n' > c.txt
+#   tar --format=pax -cf queued.tar a.txt b.txt c.txt
+#   printf 'two\n' > c.txt && tar --format=pax -rf queued.tar c.txt
+#   gzip -n queued.tar
+set(DECOMPRESS_DIR ${CMAKE_CURRENT_BINARY_DIR}/decompress_dir)
+file(REMOVE_RECURSE ${DECOMPRESS_DIR})
+file(MAKE_DIRECTORY ${DECOMPRESS_DIR})
+
+execute_process(COMMAND ${CMAKE_COMMAND} -E tar xf ${CMAKE_CURRENT_LIST_DIR}/queued.tar.gz
+  WORKING_DIRECTORY ${DECOMPRESS_DIR}
+  RESULT_VARIABLE result
+)
+if(NOT result STREQUAL "0")
+  message(FATAL_ERROR "tar failed with result [${result}]")
+endif()
+
+foreach(check "a.txt;a" "b.txt;a" "c.txt;two")
+  list(GET check 0 file)
+  list(GET check 1 expect)
+  file(READ ${DECOMPRESS_DIR}/${file} actual)
+  if(NOT actual STREQUAL "${expect}\n")
+    message(SEND_ERROR "File ${file} has [${actual}], expected [${expect}]")
+  endif()
+endforeach()
@@ -0,0 +1,15 @@
+set(OUTPUT_NAME "test.tar.zstd")
+
+set(COMPRESSION_FLAGS cvf)
+set(COMPRESSION_OPTIONS --format=pax --zstd-seekable)
+
+set(DECOMPRESSION_FLAGS xvf)
+
+include(${CMAKE_CURRENT_LIST_DIR}/roundtrip.cmake)
+
+check_magic("28b52ffd" LIMIT 4 HEX)
+
+# The archive ends in the footer of the seek table.
+file(SIZE ${FULL_OUTPUT_NAME} size)
+math(EXPR offset "${size} - 9")
+check_magic("0100000000b1ea928f" OFFSET ${offset} LIMIT 9 HEX)
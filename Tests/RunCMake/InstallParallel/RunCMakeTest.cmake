@@ -57,3 +57,34 @@ if(RunCMake_GENERATOR MATCHES "Ninja")
   install_test(ninja-parallel ARGS "-t install/parallel" NINJA PARALLEL)
   install_test(ninja-no-parallel ARGS "-t install" NINJA)
 endif()
+
+block()
+  set(RunCMake_TEST_BINARY_DIR ${RunCMake_BINARY_DIR}/steps-build)
+  set(RunCMake_TEST_OPTIONS -DCMAKE_INSTALL_PREFIX=install)
+  set(RunCMake_TEST_OUTPUT_MERGE 1)
+  if (NOT RunCMake_GENERATOR_IS_MULTI_CONFIG)
+    list(APPEND RunCMake_TEST_OPTIONS -DCMAKE_BUILD_TYPE=Debug)
+  endif()
+  run_cmake(steps)
+  set(RunCMake_TEST_NO_CLEAN 1)
+  set(INSTALL_MANIFEST ${RunCMake_TEST_BINARY_DIR}/install_manifest.txt)
+  set(INSTALL_COUNT 3)
+  set(RunCMake-check-file check-manifest.cmake)
+  run_cmake_command(steps-install ${CMAKE_COMMAND} --install . --config Debug -j 4)
+endblock()
+
+# Without INSTALL_PARALLEL_STEPS, each directory installs in one process.
+block()
+  set(RunCMake_TEST_BINARY_DIR ${RunCMake_BINARY_DIR}/steps-disabled-build)
+  set(RunCMake_TEST_OPTIONS -DCMAKE_INSTALL_PREFIX=install)
+  set(RunCMake_TEST_OUTPUT_MERGE 1)
+  if (NOT RunCMake_GENERATOR_IS_MULTI_CONFIG)
+    list(APPEND RunCMake_TEST_OPTIONS -DCMAKE_BUILD_TYPE=Debug)
+  endif()
+  run_cmake(steps-disabled)
+  set(RunCMake_TEST_NO_CLEAN 1)
+  set(INSTALL_MANIFEST ${RunCMake_TEST_BINARY_DIR}/install_manifest.txt)
+  set(INSTALL_COUNT 3)
+  set(RunCMake-check-file check-manifest.cmake)
+  run_cmake_command(steps-disabled-install ${CMAKE_COMMAND} --install . --config Debug -j 4)
+endblock()
@@ -0,0 +1,2 @@
+set(NO_STEPS 1)
+include(${CMAKE_CURRENT_LIST_DIR}/steps.cmake)
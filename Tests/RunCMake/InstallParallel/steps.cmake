@@ -0,0 +1,29 @@
+set_property(GLOBAL PROPERTY INSTALL_PARALLEL ON)
+if(NOT NO_STEPS)
+  set_property(GLOBAL PROPERTY INSTALL_PARALLEL_STEPS ON)
+endif()
+install(FILES ${CMAKE_CURRENT_LIST_FILE} DESTINATION data RENAME a.txt)
+install(FILES ${CMAKE_CURRENT_LIST_FILE} DESTINATION data RENAME b.txt)
+install(CODE [[
+set(data "$ENV{DESTDIR}${CMAKE_INSTALL_PREFIX}/data")
+if(EXISTS "${data}/a.txt" AND EXISTS "${data}/b.txt" AND
+   NOT EXISTS "${data}/c.txt")
+  message(STATUS "a and b installed, c not installed")
+endif()
+set(step_var 1)
+]])
+install(CODE [[
+if(step_var)
+  message(STATUS "variable shared")
+endif()
+]])
+install(FILES ${CMAKE_CURRENT_LIST_FILE} DESTINATION data RENAME c.txt)
+install(CODE [[
+if(NOT EXISTS "$ENV{DESTDIR}${CMAKE_INSTALL_PREFIX}/data/c.txt")
+  message(STATUS "c not installed")
+elseif(DEFINED step_var)
+  message(STATUS "c installed, variable shared")
+else()
+  message(STATUS "c installed, variable not shared")
+endif()
+]])
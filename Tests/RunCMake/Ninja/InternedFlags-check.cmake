@@ -0,0 +1,21 @@
+file(READ "${RunCMake_TEST_BINARY_DIR}/build.ninja" build_ninja)
+string(REGEX MATCHALL "\n  DEFINES = [^\n]*" defines_refs "${build_ninja}")
+list(LENGTH defines_refs defines_refs_count)
+if(NOT defines_refs_count EQUAL 3)
+  string(APPEND RunCMake_TEST_FAILED
+    "Expected 3 build statements with DEFINES, found ${defines_refs_count}.\n")
+endif()
+list(REMOVE_DUPLICATES defines_refs)
+if(NOT defines_refs MATCHES "^\n  DEFINES = \\$DEFINES_[0-9]+$")
+  string(APPEND RunCMake_TEST_FAILED
+    "Build statements do not share one interned DEFINES variable:\n"
+    "${defines_refs}\n")
+endif()
+string(REGEX MATCHALL "\nDEFINES_[0-9]+ = -DGREETING_SHARED_DEFINE\n"
+  defines_defs "${build_ninja}")
+list(LENGTH defines_defs defines_defs_count)
+if(NOT defines_defs_count EQUAL 1)
+  string(APPEND RunCMake_TEST_FAILED
+    "Expected the DEFINES value to be defined once, found "
+    "${defines_defs_count} definitions.\n")
+endif()
@@ -0,0 +1,9 @@
+enable_language(C)
+
+add_compile_definitions(GREETING_SHARED_DEFINE)
+include_directories(${CMAKE_CURRENT_SOURCE_DIR})
+
+add_library(greeting STATIC greeting.c)
+add_library(greeting2 STATIC greeting2.c)
+add_executable(hello hello_with_two_greetings.c)
+target_link_libraries(hello PRIVATE greeting greeting2)
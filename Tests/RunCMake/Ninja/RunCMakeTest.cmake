@@ -156,6 +156,25 @@ function(run_SubDir)
 endfunction()
 run_SubDir()
 
+function(run_SubninjaPerDirectory)
+  set(RunCMake_TEST_BINARY_DIR ${RunCMake_BINARY_DIR}/SubninjaPerDirectory-build)
+  run_cmake(SubninjaPerDirectory)
+  set(RunCMake_TEST_NO_CLEAN 1)
+  run_cmake_command(SubninjaPerDirectory-build ${CMAKE_COMMAND} --build .)
+  # Re-generating leaves the unchanged directory files in place.
+  run_cmake_command(SubninjaPerDirectory-regen ${CMAKE_COMMAND} .)
+  run_cmake_command(SubninjaPerDirectory-nowork ${CMAKE_COMMAND} --build .)
+endfunction()
+run_SubninjaPerDirectory()
+
+function(run_InternedFlags)
+  set(RunCMake_TEST_BINARY_DIR ${RunCMake_BINARY_DIR}/InternedFlags-build)
+  run_cmake(InternedFlags)
+  set(RunCMake_TEST_NO_CLEAN 1)
+  run_cmake_command(InternedFlags-build ${CMAKE_COMMAND} --build .)
+endfunction()
+run_InternedFlags()
+
 function(run_ninja dir)
   execute_process(
     COMMAND "${RunCMake_MAKE_PROGRAM}" ${ARGN}
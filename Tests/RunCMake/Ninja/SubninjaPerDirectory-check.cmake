@@ -0,0 +1,31 @@
+file(READ "${RunCMake_TEST_BINARY_DIR}/build.ninja" build_ninja)
+foreach(dir IN ITEMS "" "SubninjaPerDirectory[/\\]")
+  if(NOT build_ninja MATCHES "\nsubninja ${dir}CMakeFiles[/\\]directory\\.ninja\n")
+    string(APPEND RunCMake_TEST_FAILED
+      "build.ninja does not include the directory file of '${dir}'.\n")
+  endif()
+endforeach()
+if(NOT build_ninja MATCHES "\nbuild build\\.ninja CMakeFiles[/\\]directory\\.ninja SubninjaPerDirectory[/\\]CMakeFiles[/\\]directory\\.ninja: RERUN_CMAKE ")
+  string(APPEND RunCMake_TEST_FAILED
+    "build.ninja does not re-generate the directory files.\n")
+endif()
+if(build_ninja MATCHES "\nbuild [^\n]*hello_with_greeting")
+  string(APPEND RunCMake_TEST_FAILED
+    "build.ninja contains build statements of a subdirectory.\n")
+endif()
+
+set(sub_file
+  "${RunCMake_TEST_BINARY_DIR}/SubninjaPerDirectory/CMakeFiles/directory.ninja")
+if(NOT EXISTS "${sub_file}")
+  string(APPEND RunCMake_TEST_FAILED "Missing file:\n  ${sub_file}\n")
+else()
+  file(READ "${sub_file}" sub_ninja)
+  if(NOT sub_ninja MATCHES "\nbuild [^\n]*hello_with_greeting")
+    string(APPEND RunCMake_TEST_FAILED
+      "${sub_file}\ndoes not contain the build statements of hello_sub.\n")
+  endif()
+  if(NOT sub_ninja MATCHES "\nINCLUDES_1 = ")
+    string(APPEND RunCMake_TEST_FAILED
+      "${sub_file}\ndoes not number its interned variables on its own.\n")
+  endif()
+endif()
@@ -0,0 +1,7 @@
+enable_language(C)
+
+set(CMAKE_NINJA_SUBNINJA_PER_DIRECTORY 1)
+
+add_library(greeting SHARED greeting.c)
+target_include_directories(greeting PUBLIC ${CMAKE_CURRENT_SOURCE_DIR})
+add_subdirectory(SubninjaPerDirectory)
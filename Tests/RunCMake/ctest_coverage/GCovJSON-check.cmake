@@ -0,0 +1,27 @@
+file(GLOB coverage_xml_file "${RunCMake_TEST_BINARY_DIR}/Testing/*/Coverage.xml")
+if(coverage_xml_file)
+  file(READ "${coverage_xml_file}" coverage_xml)
+  foreach(i RANGE 1 4)
+    if(NOT coverage_xml MATCHES "<File Name=\"src${i}\\.c\"[^>]*>[ \t\n]*<LOCTested>1</LOCTested>[ \t\n]*<LOCUnTested>1</LOCUnTested>")
+      string(REPLACE "\n" "\n  " coverage_xml "  ${coverage_xml}")
+      set(RunCMake_TEST_FAILED
+        "Coverage.xml does not have expected coverage of src${i}.c:\n${coverage_xml}"
+        )
+      return()
+    endif()
+  endforeach()
+else()
+  set(RunCMake_TEST_FAILED "Coverage.xml not found")
+  return()
+endif()
+
+file(GLOB concurrent "${RunCMake_TEST_BINARY_DIR}/CMakeFiles/fake.dir/*.concurrent")
+if(NOT concurrent)
+  set(RunCMake_TEST_FAILED "gcov did not run on several files at a time")
+  return()
+endif()
+
+file(GLOB gcov_dirs "${RunCMake_TEST_BINARY_DIR}/Testing/CoverageInfo/gcov-*")
+if(gcov_dirs)
+  set(RunCMake_TEST_FAILED "gcov working directories not removed:\n  ${gcov_dirs}")
+endif()
@@ -7,4 +7,24 @@ function(run_ctest_coverage CASE_NAME)
   run_ctest(${CASE_NAME})
 endfunction()
 
-run_ctest_coverage(CoverageQuiet QUIET)
+if(COVERAGE_COMMAND)
+  run_ctest_coverage(CoverageQuiet QUIET)
+endif()
+
+if(UNIX)
+  block()
+    set(COVERAGE_COMMAND "${RunCMake_SOURCE_DIR}/fake-gcov.sh")
+    set(CASE_TEST_PREFIX_CODE [[
+set(CTEST_COVERAGE_EXTRA_FLAGS "--json-format")
+]])
+    set(CASE_CMAKELISTS_SUFFIX_CODE [[
+add_custom_target(fake)
+foreach(i RANGE 1 4)
+  file(WRITE "${CMAKE_CURRENT_SOURCE_DIR}/src${i}.c" "int a;\nint b;\n")
+  file(WRITE "${CMAKE_CURRENT_BINARY_DIR}/CMakeFiles/fake.dir/src${i}.gcda"
+    "${CMAKE_CURRENT_SOURCE_DIR} src${i}.c 1 ${i}\n")
+endforeach()
+]])
+    run_ctest(GCovJSON -j4)
+  endblock()
+endif()
@@ -0,0 +1,42 @@
+#!/bin/sh
+
+# This is a replacement for gcov that prints its JSON intermediate format
+# to stdout.  The data file given as the last argument holds the source
+# directory, a source file, a line number and an execution count.  Each
+# run waits a while for another run to be in progress and records if it
+# saw one.
+
+stdout=false
+while [ $# -gt 1 ]; do
+  case $1 in
+    --stdout)
+      stdout=true
+      ;;
+  esac
+  shift
+done
+data="$1"
+
+if ! $stdout; then
+  echo "fake-gcov: --stdout not given" >&2
+  exit 1
+fi
+
+name="${data%.gcda}"
+touch "${name}.running"
+i=0
+while [ $i -lt 5 ]; do
+  if [ "$(ls "$(dirname "${data}")" | grep -c '\.running$')" -gt 1 ]; then
+    touch "${name}.concurrent"
+    break
+  fi
+  sleep 1
+  i=$((i + 1))
+done
+rm "${name}.running"
+
+read dir source line count < "${data}"
+printf '{"format_version":"1","current_working_directory":"%s",' "${dir}"
+printf '"files":[{"file":"%s","lines":[' "${source}"
+printf '{"line_number":%s,"count":%s},' "${line}" "${count}"
+printf '{"line_number":%s,"count":0}]}]}\n' "$((line + 1))"
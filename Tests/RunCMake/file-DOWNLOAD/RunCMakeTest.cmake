@@ -23,6 +23,14 @@ run_cmake(no-file)
 run_cmake(range)
 run_cmake(SHOW_PROGRESS)
 
+set(RunCMake_TEST_OPTIONS -DCMAKE_DOWNLOAD_CACHE=${RunCMake_BINARY_DIR}/cache)
+file(REMOVE_RECURSE "${RunCMake_BINARY_DIR}/cache")
+run_cmake(download-cache)
+run_cmake(download-cache-url)
+run_cmake(download-cache-space)
+run_cmake(download-cache-space-hit)
+unset(RunCMake_TEST_OPTIONS)
+
 if(NOT CMake_TEST_NO_NETWORK)
   run_cmake(bad-hostname)
 endif()
@@ -0,0 +1,6 @@
+include(common.cmake)
+
+# Take the file stored for the URL by the download-cache-space case.
+get_filename_component(dir "${CMAKE_DOWNLOAD_CACHE}" DIRECTORY)
+set(url "file://${slash}${dir}/space input.png")
+file_download()
@@ -0,0 +1,7 @@
+include(common.cmake)
+
+# A file URL with a space is stored under the same key that is looked up.
+get_filename_component(dir "${CMAKE_DOWNLOAD_CACHE}" DIRECTORY)
+file(COPY_FILE "${CMAKE_CURRENT_SOURCE_DIR}/input.png" "${dir}/space input.png")
+set(url "file://${slash}${dir}/space input.png")
+file_download()
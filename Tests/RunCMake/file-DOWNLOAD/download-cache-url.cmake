@@ -0,0 +1,11 @@
+include(common.cmake)
+
+# Take the file stored for the URL by the download-cache case.
+file_download()
+file(SHA256 "${file}" actual)
+if(NOT actual STREQUAL "cf3334b1275071e1da6e8c396ccb72cf1b2388d8c937526f3af26230affb9423")
+  message(FATAL_ERROR "File not placed correctly:\n  ${file}")
+endif()
+
+# The URL is not served from the cache again in this process.
+file_download()
@@ -0,0 +1,36 @@
+include(common.cmake)
+set(hash cf3334b1275071e1da6e8c396ccb72cf1b2388d8c937526f3af26230affb9423)
+
+function(check_file)
+  file(SHA256 "${file}" actual)
+  if(NOT actual STREQUAL hash)
+    message(FATAL_ERROR "File not placed correctly:\n  ${file}")
+  endif()
+endfunction()
+
+# Download the file and store it in the cache under its hash.
+file_download(EXPECTED_HASH SHA256=${hash})
+
+# Take the file from the cache.
+set(file ${CMAKE_CURRENT_BINARY_DIR}/output-hit.png)
+file_download(EXPECTED_HASH SHA256=${hash})
+check_file()
+
+# Editing the file does not change the cache entry.
+file(APPEND "${file}" "edited")
+file(SHA256 "${CMAKE_DOWNLOAD_CACHE}/sha256/${hash}" actual)
+if(NOT actual STREQUAL hash)
+  message(FATAL_ERROR "Cache entry changed with the file:\n  ${file}")
+endif()
+
+# Download again if the entry is corrupt.
+file(WRITE "${CMAKE_DOWNLOAD_CACHE}/sha256/${hash}" "corrupt")
+set(file ${CMAKE_CURRENT_BINARY_DIR}/output-corrupt.png)
+file_download(EXPECTED_HASH SHA256=${hash})
+check_file()
+
+# Store a file downloaded without a hash under its URL.  A URL is taken
+# from the cache at most once per process, so both of these download.
+set(file ${CMAKE_CURRENT_BINARY_DIR}/output-url.png)
+file_download()
+file_download()
@@ -73,6 +73,7 @@ elseif(CMAKE_HOST_SYSTEM_NAME STREQUAL "Linux")
   run_install_test(linux-conflict)
   run_install_test(linux-notfile)
   run_install_test(linux-indirect-dependencies)
+  run_install_test(linux-changed-file)
   run_cmake(project)
   run_cmake(badargs1)
   run_cmake(badargs2)
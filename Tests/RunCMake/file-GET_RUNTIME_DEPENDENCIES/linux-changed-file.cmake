@@ -0,0 +1,59 @@
+enable_language(C)
+cmake_policy(SET CMP0095 NEW)
+
+file(WRITE "${CMAKE_BINARY_DIR}/A.c" "void libA(void) {}\n")
+file(WRITE "${CMAKE_BINARY_DIR}/C.c" "void libC(void) {}\n")
+file(WRITE "${CMAKE_BINARY_DIR}/AUseC.c" [[
+extern void libC(void);
+void libA(void)
+{
+    libC();
+}
+]])
+file(WRITE "${CMAKE_BINARY_DIR}/mainA.c" [[
+extern void libA(void);
+
+int main(void)
+{
+    libA();
+    return 0;
+}
+]])
+
+add_library(A SHARED "${CMAKE_BINARY_DIR}/A.c")
+set_property(TARGET A PROPERTY LIBRARY_OUTPUT_DIRECTORY "${CMAKE_BINARY_DIR}/libA")
+
+add_library(C SHARED "${CMAKE_BINARY_DIR}/C.c")
+set_property(TARGET C PROPERTY LIBRARY_OUTPUT_DIRECTORY "${CMAKE_BINARY_DIR}/libC")
+
+# A replacement for libA.so that needs libC.so.
+add_library(A2 SHARED "${CMAKE_BINARY_DIR}/AUseC.c")
+target_link_libraries(A2 PRIVATE C)
+set_target_properties(A2 PROPERTIES
+  OUTPUT_NAME A
+  LIBRARY_OUTPUT_DIRECTORY "${CMAKE_BINARY_DIR}/libA2"
+  )
+
+add_executable(exe "${CMAKE_BINARY_DIR}/mainA.c")
+target_link_libraries(exe A)
+
+install(CODE [[
+  function(get_deps var)
+    file(GET_RUNTIME_DEPENDENCIES
+      RESOLVED_DEPENDENCIES_VAR resolved
+      PRE_INCLUDE_REGEXES "^lib[AC]\\.so$"
+      PRE_EXCLUDE_REGEXES ".*"
+      EXECUTABLES "$<TARGET_FILE:exe>"
+      )
+    list(SORT resolved)
+    set(${var} "${resolved}" PARENT_SCOPE)
+  endfunction()
+
+  get_deps(before)
+  message(STATUS "Before: ${before}")
+
+  # Dependencies of a file changed since the previous call are read again.
+  file(COPY_FILE "$<TARGET_FILE:A2>" "$<TARGET_FILE:A>")
+  get_deps(after)
+  message(STATUS "After: ${after}")
+]])
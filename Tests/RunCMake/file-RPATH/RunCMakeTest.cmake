@@ -17,6 +17,8 @@ run_cmake_command(TextSetEmpty ${CMAKE_COMMAND} -P ${RunCMake_SOURCE_DIR}/TextSe
 
 run_cmake_command(TextRemove ${CMAKE_COMMAND} -P ${RunCMake_SOURCE_DIR}/TextRemove.cmake)
 
+run_cmake_command(Strip ${CMAKE_COMMAND} -P ${RunCMake_SOURCE_DIR}/Strip.cmake)
+
 # Test install RPATH for ELF files with more than 65536 sections.
 # This is supported only by certain platforms/toolchains, so run
 # this case only if explicitly enabled.
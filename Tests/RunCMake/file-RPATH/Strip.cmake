@@ -0,0 +1,41 @@
+set(in "${CMAKE_CURRENT_LIST_DIR}/ELF")
+set(out "${CMAKE_CURRENT_BINARY_DIR}")
+
+# These binaries have debugging information to remove.
+foreach(f elf32msb.bin elf64msb.bin)
+  file(COPY ${in}/${f} DESTINATION ${out} NO_SOURCE_PERMISSIONS)
+  set(f "${out}/${f}")
+  file(SIZE "${f}" size_before)
+  file(STRIP FILE "${f}" COMMAND "${CMAKE_COMMAND}" -E false)
+  file(SIZE "${f}" size_after)
+  if(NOT size_after LESS size_before)
+    message(FATAL_ERROR "STRIP did not shrink\n ${f}")
+  endif()
+  file(READ_ELF "${f}" RPATH rpath)
+  if(NOT rpath STREQUAL "/sample/rpath")
+    message(FATAL_ERROR "STRIP broke the dynamic section of\n ${f}")
+  endif()
+  file(RPATH_CHANGE FILE "${f}" OLD_RPATH "/sample/rpath" NEW_RPATH "/new")
+endforeach()
+
+# These binaries have nothing to remove.
+foreach(f elf32lsb.bin elf64lsb.bin)
+  file(COPY ${in}/${f} DESTINATION ${out} NO_SOURCE_PERMISSIONS)
+  set(f "${out}/${f}")
+  file(SHA256 "${f}" hash_before)
+  file(STRIP FILE "${f}" COMMAND "${CMAKE_COMMAND}" -E false)
+  file(SHA256 "${f}" hash_after)
+  if(NOT hash_after STREQUAL hash_before)
+    message(FATAL_ERROR "STRIP changed\n ${f}")
+  endif()
+endforeach()
+
+# Other files are given to the strip tool.
+set(f "${out}/not_a_binary.txt")
+set(marker "${out}/strip-tool-ran.txt")
+file(WRITE "${f}" "Not a binary.\n")
+file(REMOVE "${marker}")
+file(STRIP FILE "${f}" COMMAND "${CMAKE_COMMAND}" -E touch "${marker}")
+if(NOT EXISTS "${marker}")
+  message(FATAL_ERROR "STRIP did not run the strip tool for\n ${f}")
+endif()
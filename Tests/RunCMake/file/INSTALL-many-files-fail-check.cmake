@@ -0,0 +1,11 @@
+# Every file that was written must have been reported, so that it is
+# listed in the install manifest.
+set(dst "${RunCMake_TEST_BINARY_DIR}/many-dst")
+file(GLOB files RELATIVE "${dst}" "${dst}/f*.txt")
+foreach(f IN LISTS files)
+  if(NOT f STREQUAL "f20.txt" AND
+      NOT actual_stdout MATCHES "-- Installing: [^\n]*/many-dst/${f}\n")
+    string(APPEND RunCMake_TEST_FAILED
+      "File installed but not reported:\n  ${dst}/${f}\n")
+  endif()
+endforeach()
@@ -0,0 +1,11 @@
+# Install enough files to copy them on several threads, one of which
+# cannot be written because a directory is in its place.
+set(src "${CMAKE_CURRENT_BINARY_DIR}/many-src")
+set(dst "${CMAKE_CURRENT_BINARY_DIR}/many-dst")
+file(REMOVE_RECURSE "${src}" "${dst}")
+string(REPEAT "0123456789abcdef" 4096 content)
+foreach(i RANGE 1 40)
+  file(WRITE "${src}/f${i}.txt" "${i}:${content}")
+endforeach()
+file(MAKE_DIRECTORY "${dst}/f20.txt/blocker")
+file(INSTALL "${src}/" DESTINATION "${dst}")
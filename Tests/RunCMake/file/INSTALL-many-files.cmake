@@ -0,0 +1,30 @@
+# Install enough files to copy them on several threads.
+set(src "${CMAKE_CURRENT_BINARY_DIR}/many-src")
+set(dst "${CMAKE_CURRENT_BINARY_DIR}/many-dst")
+file(REMOVE_RECURSE "${src}" "${dst}")
+string(REPEAT "0123456789abcdef" 4096 content)
+foreach(i RANGE 1 40)
+  file(WRITE "${src}/f${i}.txt" "${i}:${content}")
+endforeach()
+file(WRITE "${src}/empty.txt" "")
+
+set(CMAKE_INSTALL_MANIFEST_FILES "")
+file(INSTALL "${src}/" DESTINATION "${dst}" MESSAGE_NEVER)
+list(LENGTH CMAKE_INSTALL_MANIFEST_FILES count)
+if(NOT count EQUAL 41)
+  message(FATAL_ERROR "Expected 41 files in the manifest, found ${count}:\n"
+    "${CMAKE_INSTALL_MANIFEST_FILES}")
+endif()
+file(GLOB files RELATIVE "${src}" "${src}/*")
+foreach(f IN LISTS files)
+  file(SHA256 "${src}/${f}" expect)
+  file(SHA256 "${dst}/${f}" actual)
+  if(NOT actual STREQUAL expect)
+    message(FATAL_ERROR "Installed file has wrong content:\n  ${dst}/${f}")
+  endif()
+endforeach()
+
+# A second installation finds every file up to date.
+message(STATUS "Before reinstalling")
+file(INSTALL "${src}/" DESTINATION "${dst}" MESSAGE_LAZY)
+message(STATUS "After reinstalling")
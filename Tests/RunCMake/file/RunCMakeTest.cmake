@@ -18,6 +18,10 @@ run_cmake(INSTALL-DIRECTORY)
 run_cmake(INSTALL-FILES_FROM_DIR)
 run_cmake(INSTALL-FILES_FROM_DIR-bad)
 run_cmake(INSTALL-MESSAGE-bad)
+run_cmake_script(INSTALL-many-files)
+if(NOT WIN32)
+  run_cmake_script(INSTALL-many-files-fail)
+endif()
 run_cmake(FileOpenFailRead)
 run_cmake(LOCK)
 run_cmake(LOCK-error-file-create-fail)
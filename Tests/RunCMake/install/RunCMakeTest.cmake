@@ -198,6 +198,26 @@ if(UNIX)
   run_install_test(DIRECTORY-symlink-clobber)
 endif()
 
+# Build, install with --strip, and run a real executable and library.
+function(run_install_strip_test case)
+  set(RunCMake_TEST_BINARY_DIR ${RunCMake_BINARY_DIR}/${case}-build)
+  set(RunCMake_TEST_NO_CLEAN 1)
+  file(REMOVE_RECURSE "${RunCMake_TEST_BINARY_DIR}")
+  file(MAKE_DIRECTORY "${RunCMake_TEST_BINARY_DIR}")
+  set(RunCMake_TEST_RAW_ARGS -DCMAKE_BUILD_TYPE:STRING=Debug)
+  run_cmake(${case})
+  unset(RunCMake_TEST_RAW_ARGS)
+  set(RunCMake_TEST_OUTPUT_MERGE 1)
+  run_cmake_command(${case}-build ${CMAKE_COMMAND} --build . --config Debug)
+  run_cmake_command(${case}-install ${CMAKE_COMMAND} --install . --config Debug --prefix ${RunCMake_TEST_BINARY_DIR}/root --strip)
+  unset(RunCMake_TEST_OUTPUT_MERGE)
+endfunction()
+
+if(CMAKE_EXECUTABLE_FORMAT STREQUAL "ELF")
+  run_install_strip_test(TARGETS-Strip-in-process)
+  run_install_strip_test(TARGETS-Strip-tool)
+endif()
+
 if(CMAKE_SYSTEM_NAME STREQUAL "Darwin")
   run_cmake(TARGETS-RUNTIME_DEPENDENCIES-macos-two-bundle)
   run_cmake(TARGETS-RUNTIME_DEPENDENCIES-macos-no-framework)
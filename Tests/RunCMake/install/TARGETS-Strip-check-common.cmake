@@ -0,0 +1,38 @@
+set(prefix "${RunCMake_TEST_BINARY_DIR}/root")
+
+execute_process(
+  COMMAND "${prefix}/bin/myexe"
+  RESULT_VARIABLE MYEXE_RESULT
+  OUTPUT_VARIABLE MYEXE_OUTPUT
+  ERROR_VARIABLE MYEXE_ERROR
+  )
+if(NOT MYEXE_RESULT EQUAL "0")
+  string(APPEND RunCMake_TEST_FAILED "myexe returned [${MYEXE_RESULT}], was expecting [0]\n${MYEXE_ERROR}\n")
+endif()
+
+set(log "${RunCMake_TEST_BINARY_DIR}/strip.log")
+foreach(name IN ITEMS myexe libmylib.so)
+  file(SIZE "${RunCMake_TEST_BINARY_DIR}/${name}" size_built)
+  file(SIZE "${prefix}/bin/${name}" size_installed)
+  if(expect_in_process)
+    if(NOT size_installed LESS size_built)
+      string(APPEND RunCMake_TEST_FAILED "${name} was not stripped in-process\n")
+    endif()
+  else()
+    if(NOT size_installed EQUAL size_built)
+      string(APPEND RunCMake_TEST_FAILED "${name} was changed by something other than the strip tool\n")
+    endif()
+    set(stripped "")
+    if(EXISTS "${log}")
+      file(STRINGS "${log}" stripped)
+    endif()
+    list(FIND stripped "${prefix}/bin/${name}" index)
+    if(index EQUAL -1)
+      string(APPEND RunCMake_TEST_FAILED "${name} was not given to CMAKE_STRIP\n")
+    endif()
+  endif()
+endforeach()
+if(expect_in_process AND EXISTS "${log}")
+  file(READ "${log}" stripped)
+  string(APPEND RunCMake_TEST_FAILED "CMAKE_STRIP was run on:\n${stripped}")
+endif()
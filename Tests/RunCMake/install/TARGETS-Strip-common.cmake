@@ -0,0 +1,17 @@
+enable_language(C)
+
+# Record the binaries given to the strip tool instead of stripping them.
+file(CONFIGURE OUTPUT "${CMAKE_CURRENT_BINARY_DIR}/fake-strip.sh" CONTENT [[
+#!/bin/sh
+echo "$1" >> "@CMAKE_CURRENT_BINARY_DIR@/strip.log"
+]] @ONLY)
+file(CHMOD "${CMAKE_CURRENT_BINARY_DIR}/fake-strip.sh"
+  FILE_PERMISSIONS OWNER_READ OWNER_WRITE OWNER_EXECUTE)
+set(CMAKE_STRIP "${CMAKE_CURRENT_BINARY_DIR}/fake-strip.sh")
+
+add_library(mylib SHARED obj1.c)
+add_executable(myexe testobj1.c)
+target_link_libraries(myexe mylib)
+set_property(TARGET myexe PROPERTY INSTALL_RPATH "\$ORIGIN")
+
+install(TARGETS mylib myexe DESTINATION bin)
@@ -0,0 +1,2 @@
+set(CMAKE_INSTALL_STRIP_IN_PROCESS 1)
+include(${CMAKE_CURRENT_LIST_DIR}/TARGETS-Strip-common.cmake)
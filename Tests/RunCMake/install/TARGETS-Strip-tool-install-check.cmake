@@ -0,0 +1,2 @@
+set(expect_in_process 0)
+include(${CMAKE_CURRENT_LIST_DIR}/TARGETS-Strip-check-common.cmake)